@@ -0,0 +1,674 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#include "BLAKE3.h"
+#include "DigestValue.h"
+#include <cstring>
+#include <algorithm>
+#include <system_error>
+#include <thread>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BLAKE3_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BLAKE3_TARGET(x) __attribute__((target(x)))
+#else
+#define BLAKE3_TARGET(x)
+#endif
+
+enum : uint8_t {
+	CHUNK_START = 1 << 0,
+	CHUNK_END = 1 << 1,
+	PARENT = 1 << 2,
+	ROOT = 1 << 3
+};
+
+static constexpr uint32_t IV[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// Message word order of each of the 7 rounds
+static constexpr uint8_t MSG_SCHEDULE[7][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+	{ 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+	{ 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+	{ 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+	{ 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+	{ 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 }
+};
+
+constexpr size_t PARALLEL_MIN_SUBTREE = 0x100000; ///< Subtrees below 1 MiB are not worth a thread.
+
+static inline uint32_t load32(const uint8_t* p) {
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline void store32(uint8_t* p, uint32_t x) {
+	p[0] = static_cast<uint8_t>(x);
+	p[1] = static_cast<uint8_t>(x >> 8);
+	p[2] = static_cast<uint8_t>(x >> 16);
+	p[3] = static_cast<uint8_t>(x >> 24);
+}
+
+static inline uint32_t rotr32(uint32_t x, int n) {
+	return (x >> n) | (x << (32 - n));
+}
+
+static inline void g(uint32_t* v, size_t a, size_t b, size_t c, size_t d, uint32_t x, uint32_t y) {
+	v[a] = v[a] + v[b] + x;
+	v[d] = rotr32(v[d] ^ v[a], 16);
+	v[c] = v[c] + v[d];
+	v[b] = rotr32(v[b] ^ v[c], 12);
+	v[a] = v[a] + v[b] + y;
+	v[d] = rotr32(v[d] ^ v[a], 8);
+	v[c] = v[c] + v[d];
+	v[b] = rotr32(v[b] ^ v[c], 7);
+}
+
+static void compressPre(uint32_t v[16], const uint32_t cv[8], const uint8_t* block, uint8_t blockLen, uint64_t counter, uint8_t flags) {
+	uint32_t m[16];
+	for (size_t i = 0; i < 16; i++) {
+		m[i] = load32(block + 4 * i);
+	}
+
+	std::copy(cv, cv + 8, v);
+	std::copy(IV, IV + 4, v + 8);
+	v[12] = static_cast<uint32_t>(counter);
+	v[13] = static_cast<uint32_t>(counter >> 32);
+	v[14] = blockLen;
+	v[15] = flags;
+
+	for (size_t r = 0; r < 7; r++) {
+		const uint8_t* s = MSG_SCHEDULE[r];
+		g(v, 0, 4, 8, 12, m[s[0]], m[s[1]]); // Columns
+		g(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+		g(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+		g(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+		g(v, 0, 5, 10, 15, m[s[8]], m[s[9]]); // Diagonals
+		g(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+		g(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+		g(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+	}
+}
+
+void BLAKE3::compressInPlace(uint32_t cv[8], const uint8_t block[BLOCK_LEN], uint8_t blockLen, uint64_t counter, uint8_t flags) {
+	uint32_t v[16];
+	compressPre(v, cv, block, blockLen, counter, flags);
+	for (size_t i = 0; i < 8; i++) {
+		cv[i] = v[i] ^ v[i + 8];
+	}
+}
+
+void BLAKE3::compressXof(const uint32_t cv[8], const uint8_t block[BLOCK_LEN], uint8_t blockLen, uint64_t counter, uint8_t flags, uint8_t out[64]) {
+	uint32_t v[16];
+	compressPre(v, cv, block, blockLen, counter, flags);
+	for (size_t i = 0; i < 8; i++) {
+		store32(out + 4 * i, v[i] ^ v[i + 8]);
+		store32(out + 4 * (i + 8), v[i + 8] ^ cv[i]);
+	}
+}
+
+void BLAKE3::Output::chainingValue(uint8_t out[32]) const {
+	uint32_t words[8];
+	std::copy(cv, cv + 8, words);
+	compressInPlace(words, block, blockLen, counter, flags);
+	for (size_t i = 0; i < 8; i++) {
+		store32(out + 4 * i, words[i]);
+	}
+}
+
+void BLAKE3::Output::rootBytes(uint8_t out[32]) const {
+	// The counter of root output blocks counts output blocks, and only the first one is needed
+	uint8_t wide[64];
+	compressXof(cv, block, blockLen, 0, flags | ROOT, wide);
+	memcpy(out, wide, 32);
+}
+
+void BLAKE3::ChunkState::reset(uint64_t chunkCounter) {
+	std::copy(IV, IV + 8, cv);
+	counter = chunkCounter;
+	memset(buffer, 0, BLOCK_LEN);
+	bufferLen = 0;
+	blocksCompressed = 0;
+}
+
+size_t BLAKE3::ChunkState::length() const {
+	return BLOCK_LEN * blocksCompressed + bufferLen;
+}
+
+void BLAKE3::ChunkState::update(const uint8_t* data, size_t length) {
+	// The last block of a chunk is kept back, since it needs the CHUNK_END flag (and perhaps ROOT)
+	if (bufferLen > 0) {
+		const size_t take = (std::min)(length, BLOCK_LEN - bufferLen);
+		memcpy(buffer + bufferLen, data, take);
+		bufferLen += static_cast<uint8_t>(take);
+		data += take;
+		length -= take;
+		if (length > 0) {
+			compressInPlace(cv, buffer, BLOCK_LEN, counter, blocksCompressed == 0 ? CHUNK_START : 0);
+			blocksCompressed++;
+			bufferLen = 0;
+			memset(buffer, 0, BLOCK_LEN);
+		}
+	}
+
+	while (length > BLOCK_LEN) {
+		compressInPlace(cv, data, BLOCK_LEN, counter, blocksCompressed == 0 ? CHUNK_START : 0);
+		blocksCompressed++;
+		data += BLOCK_LEN;
+		length -= BLOCK_LEN;
+	}
+
+	memcpy(buffer + bufferLen, data, length);
+	bufferLen += static_cast<uint8_t>(length);
+}
+
+BLAKE3::Output BLAKE3::ChunkState::output() const {
+	Output output;
+	std::copy(cv, cv + 8, output.cv);
+	memcpy(output.block, buffer, BLOCK_LEN);
+	output.blockLen = bufferLen;
+	output.counter = counter;
+	output.flags = static_cast<uint8_t>((blocksCompressed == 0 ? CHUNK_START : 0) | CHUNK_END);
+	return output;
+}
+
+BLAKE3::Output BLAKE3::parentOutput(const uint8_t block[BLOCK_LEN]) {
+	Output output;
+	std::copy(IV, IV + 8, output.cv);
+	memcpy(output.block, block, BLOCK_LEN);
+	output.blockLen = BLOCK_LEN;
+	output.counter = 0;
+	output.flags = PARENT;
+	return output;
+}
+
+void BLAKE3::hashOne(const uint8_t* input, size_t blocks, uint64_t counter, uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t out[32]) {
+	uint32_t cv[8];
+	std::copy(IV, IV + 8, cv);
+	for (size_t b = 0; b < blocks; b++, input += BLOCK_LEN) {
+		const uint8_t blockFlags = static_cast<uint8_t>(flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0));
+		compressInPlace(cv, input, BLOCK_LEN, counter, blockFlags);
+	}
+	for (size_t i = 0; i < 8; i++) {
+		store32(out + 4 * i, cv[i]);
+	}
+}
+
+#ifdef BLAKE3_X86
+
+// SSE2 has no vector rotate; 16 is a word swap, the others are two shifts
+#define BLAKE3_ROTR4(x, n) _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
+#define BLAKE3_ROTR4_16(x) _mm_shufflehi_epi16(_mm_shufflelo_epi16((x), 0xB1), 0xB1)
+
+#define BLAKE3_G4(a, b, c, d, x, y) \
+	a = _mm_add_epi32(_mm_add_epi32(a, b), x); \
+	d = BLAKE3_ROTR4_16(_mm_xor_si128(d, a)); \
+	c = _mm_add_epi32(c, d); \
+	b = BLAKE3_ROTR4(_mm_xor_si128(b, c), 12); \
+	a = _mm_add_epi32(_mm_add_epi32(a, b), y); \
+	d = BLAKE3_ROTR4(_mm_xor_si128(d, a), 8); \
+	c = _mm_add_epi32(c, d); \
+	b = BLAKE3_ROTR4(_mm_xor_si128(b, c), 7);
+
+void BLAKE3::hash4(const uint8_t* const* inputs, size_t blocks, uint64_t counter, bool incrementCounter,
+	uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+	__m128i h[8];
+	for (size_t i = 0; i < 8; i++) {
+		h[i] = _mm_set1_epi32(static_cast<int>(IV[i]));
+	}
+	const uint64_t step = incrementCounter ? 1 : 0;
+	const __m128i counterLow = _mm_set_epi32(static_cast<int>(counter + 3 * step), static_cast<int>(counter + 2 * step),
+		static_cast<int>(counter + step), static_cast<int>(counter));
+	const __m128i counterHigh = _mm_set_epi32(static_cast<int>((counter + 3 * step) >> 32), static_cast<int>((counter + 2 * step) >> 32),
+		static_cast<int>((counter + step) >> 32), static_cast<int>(counter >> 32));
+
+	for (size_t b = 0; b < blocks; b++) {
+		// Word i of the block of every lane
+		__m128i m[16];
+		for (size_t i = 0; i < 16; i++) {
+			const size_t offset = b * BLOCK_LEN + 4 * i;
+			m[i] = _mm_set_epi32(static_cast<int>(load32(inputs[3] + offset)), static_cast<int>(load32(inputs[2] + offset)),
+				static_cast<int>(load32(inputs[1] + offset)), static_cast<int>(load32(inputs[0] + offset)));
+		}
+		const uint8_t blockFlags = static_cast<uint8_t>(flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0));
+
+		__m128i v[16] = { h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+			_mm_set1_epi32(static_cast<int>(IV[0])), _mm_set1_epi32(static_cast<int>(IV[1])),
+			_mm_set1_epi32(static_cast<int>(IV[2])), _mm_set1_epi32(static_cast<int>(IV[3])),
+			counterLow, counterHigh, _mm_set1_epi32(static_cast<int>(BLOCK_LEN)), _mm_set1_epi32(blockFlags) };
+
+		for (size_t r = 0; r < 7; r++) {
+			const uint8_t* s = MSG_SCHEDULE[r];
+			BLAKE3_G4(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+			BLAKE3_G4(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+			BLAKE3_G4(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+			BLAKE3_G4(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+			BLAKE3_G4(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+			BLAKE3_G4(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+			BLAKE3_G4(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+			BLAKE3_G4(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+		}
+
+		for (size_t i = 0; i < 8; i++) {
+			h[i] = _mm_xor_si128(v[i], v[i + 8]);
+		}
+	}
+
+	alignas(16) uint32_t words[8][4];
+	for (size_t i = 0; i < 8; i++) {
+		_mm_store_si128(reinterpret_cast<__m128i*>(words[i]), h[i]);
+	}
+	for (size_t l = 0; l < 4; l++) {
+		for (size_t i = 0; i < 8; i++) {
+			store32(out + l * 32 + 4 * i, words[i][l]);
+		}
+	}
+}
+
+#define BLAKE3_ROTR8(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+#define BLAKE3_G8(a, b, c, d, x, y) \
+	a = _mm256_add_epi32(_mm256_add_epi32(a, b), x); \
+	d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16); \
+	c = _mm256_add_epi32(c, d); \
+	b = BLAKE3_ROTR8(_mm256_xor_si256(b, c), 12); \
+	a = _mm256_add_epi32(_mm256_add_epi32(a, b), y); \
+	d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8); \
+	c = _mm256_add_epi32(c, d); \
+	b = BLAKE3_ROTR8(_mm256_xor_si256(b, c), 7);
+
+BLAKE3_TARGET("avx2")
+void BLAKE3::hash8(const uint8_t* const* inputs, size_t blocks, uint64_t counter, bool incrementCounter,
+	uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+	// Byte shuffles for the rotations by 16 and 8
+	const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+		13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+	const __m256i rot8 = _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+		12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1);
+
+	__m256i h[8];
+	for (size_t i = 0; i < 8; i++) {
+		h[i] = _mm256_set1_epi32(static_cast<int>(IV[i]));
+	}
+	alignas(32) uint32_t counters[2][8];
+	for (size_t l = 0; l < 8; l++) {
+		const uint64_t laneCounter = counter + (incrementCounter ? l : 0);
+		counters[0][l] = static_cast<uint32_t>(laneCounter);
+		counters[1][l] = static_cast<uint32_t>(laneCounter >> 32);
+	}
+	const __m256i counterLow = _mm256_load_si256(reinterpret_cast<const __m256i*>(counters[0]));
+	const __m256i counterHigh = _mm256_load_si256(reinterpret_cast<const __m256i*>(counters[1]));
+
+	for (size_t b = 0; b < blocks; b++) {
+		__m256i m[16];
+		for (size_t i = 0; i < 16; i++) {
+			const size_t offset = b * BLOCK_LEN + 4 * i;
+			m[i] = _mm256_set_epi32(static_cast<int>(load32(inputs[7] + offset)), static_cast<int>(load32(inputs[6] + offset)),
+				static_cast<int>(load32(inputs[5] + offset)), static_cast<int>(load32(inputs[4] + offset)),
+				static_cast<int>(load32(inputs[3] + offset)), static_cast<int>(load32(inputs[2] + offset)),
+				static_cast<int>(load32(inputs[1] + offset)), static_cast<int>(load32(inputs[0] + offset)));
+		}
+		const uint8_t blockFlags = static_cast<uint8_t>(flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0));
+
+		__m256i v[16] = { h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+			_mm256_set1_epi32(static_cast<int>(IV[0])), _mm256_set1_epi32(static_cast<int>(IV[1])),
+			_mm256_set1_epi32(static_cast<int>(IV[2])), _mm256_set1_epi32(static_cast<int>(IV[3])),
+			counterLow, counterHigh, _mm256_set1_epi32(static_cast<int>(BLOCK_LEN)), _mm256_set1_epi32(blockFlags) };
+
+		for (size_t r = 0; r < 7; r++) {
+			const uint8_t* s = MSG_SCHEDULE[r];
+			BLAKE3_G8(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+			BLAKE3_G8(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+			BLAKE3_G8(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+			BLAKE3_G8(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+			BLAKE3_G8(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+			BLAKE3_G8(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+			BLAKE3_G8(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+			BLAKE3_G8(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+		}
+
+		for (size_t i = 0; i < 8; i++) {
+			h[i] = _mm256_xor_si256(v[i], v[i + 8]);
+		}
+	}
+
+	alignas(32) uint32_t words[8][8];
+	for (size_t i = 0; i < 8; i++) {
+		_mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), h[i]);
+	}
+	for (size_t l = 0; l < 8; l++) {
+		for (size_t i = 0; i < 8; i++) {
+			store32(out + l * 32 + 4 * i, words[i][l]);
+		}
+	}
+}
+
+size_t BLAKE3::simdDegree() {
+	static const size_t degree = []() -> size_t {
+		int info[4] = { 0, };
+#if defined(_MSC_VER)
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		bool avx2 = false;
+		if (maxLeaf >= 7) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+		const bool ymmEnabled = osxsave && avx && ((_xgetbv(0) & 6) == 6);
+#else
+		unsigned int a, b, c, d;
+		const unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+		__cpuid(1, a, b, c, d);
+		const bool osxsave = (c & (1u << 27)) != 0;
+		const bool avx = (c & (1u << 28)) != 0;
+		bool avx2 = false;
+		if (maxLeaf >= 7) {
+			__cpuid_count(7, 0, a, b, c, d);
+			avx2 = (b & (1u << 5)) != 0;
+		}
+		bool ymmEnabled = false;
+		if (osxsave && avx) {
+			unsigned int lo, hi;
+			__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			ymmEnabled = (lo & 6) == 6;
+		}
+#endif
+		(void)info;
+		return (avx2 && ymmEnabled) ? 8 : 4; // SSE2 is always there on x64
+	}();
+	return degree;
+}
+
+#else
+
+void BLAKE3::hash4(const uint8_t* const* inputs, size_t blocks, uint64_t counter, bool incrementCounter,
+	uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+	for (size_t l = 0; l < 4; l++) {
+		hashOne(inputs[l], blocks, counter + (incrementCounter ? l : 0), flags, flagsStart, flagsEnd, out + l * 32);
+	}
+}
+
+void BLAKE3::hash8(const uint8_t* const* inputs, size_t blocks, uint64_t counter, bool incrementCounter,
+	uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+	for (size_t l = 0; l < 8; l++) {
+		hashOne(inputs[l], blocks, counter + (incrementCounter ? l : 0), flags, flagsStart, flagsEnd, out + l * 32);
+	}
+}
+
+size_t BLAKE3::simdDegree() {
+	return 1;
+}
+
+#endif
+
+void BLAKE3::hashMany(const uint8_t* const* inputs, size_t count, size_t blocks, uint64_t counter, bool incrementCounter,
+	uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+	const size_t degree = simdDegree();
+	while ((degree >= 8) && (count >= 8)) {
+		hash8(inputs, blocks, counter, incrementCounter, flags, flagsStart, flagsEnd, out);
+		inputs += 8;
+		count -= 8;
+		counter += incrementCounter ? 8 : 0;
+		out += 8 * 32;
+	}
+	while ((degree >= 4) && (count >= 4)) {
+		hash4(inputs, blocks, counter, incrementCounter, flags, flagsStart, flagsEnd, out);
+		inputs += 4;
+		count -= 4;
+		counter += incrementCounter ? 4 : 0;
+		out += 4 * 32;
+	}
+	for (; count > 0; count--, inputs++, out += 32) {
+		hashOne(*inputs, blocks, counter, flags, flagsStart, flagsEnd, out);
+		counter += incrementCounter ? 1 : 0;
+	}
+}
+
+size_t BLAKE3::compressChunksParallel(const uint8_t* input, size_t length, uint64_t chunkCounter, uint8_t* out) {
+	const uint8_t* chunks[MAX_SIMD_DEGREE];
+	size_t count = 0;
+	while (length - count * CHUNK_LEN >= CHUNK_LEN) {
+		chunks[count] = input + count * CHUNK_LEN;
+		count++;
+	}
+	hashMany(chunks, count, CHUNK_LEN / BLOCK_LEN, chunkCounter, true, 0, CHUNK_START, CHUNK_END, out);
+
+	// A partial chunk at the end is hashed on its own
+	if (length > count * CHUNK_LEN) {
+		ChunkState chunk;
+		chunk.reset(chunkCounter + count);
+		chunk.update(input + count * CHUNK_LEN, length - count * CHUNK_LEN);
+		chunk.output().chainingValue(out + count * 32);
+		count++;
+	}
+	return count;
+}
+
+size_t BLAKE3::compressParentsParallel(const uint8_t* cvs, size_t count, uint8_t* out) {
+	const uint8_t* parents[MAX_SIMD_DEGREE];
+	size_t pairs = 0;
+	while (count - 2 * pairs >= 2) {
+		parents[pairs] = cvs + 2 * pairs * 32;
+		pairs++;
+	}
+	hashMany(parents, pairs, 1, 0, false, PARENT, 0, 0, out);
+
+	// An odd one out goes up a level unchanged
+	if (count > 2 * pairs) {
+		memcpy(out + pairs * 32, cvs + 2 * pairs * 32, 32);
+		return pairs + 1;
+	}
+	return pairs;
+}
+
+/**
+ * @brief Hashes a subtree of whole chunks (its length is a power of two number of chunks, except
+ *        at the end of the input) down to at most simdDegree() chaining values, or 2 if that is 1.
+ */
+size_t BLAKE3::compressSubtreeWide(const uint8_t* input, size_t length, uint64_t chunkCounter, size_t threads, uint8_t* out) {
+	if (length <= simdDegree() * CHUNK_LEN) {
+		return compressChunksParallel(input, length, chunkCounter, out);
+	}
+
+	// The left subtree is the largest power of two number of chunks that leaves something on the right
+	size_t leftLength = CHUNK_LEN;
+	while (2 * leftLength < length) {
+		leftLength *= 2;
+	}
+	const size_t rightLength = length - leftLength;
+	const uint64_t rightChunkCounter = chunkCounter + leftLength / CHUNK_LEN;
+
+	uint8_t cvs[2 * MAX_SIMD_DEGREE * 32];
+	size_t degree = simdDegree();
+	if ((leftLength > CHUNK_LEN) && (degree == 1)) {
+		degree = 2;
+	}
+	uint8_t* rightCvs = cvs + degree * 32;
+
+	size_t leftCount = 0, rightCount = 0;
+	bool joined = false;
+	if ((threads > 1) && (rightLength >= PARALLEL_MIN_SUBTREE)) {
+		try {
+			// Left half on a new thread, right half on this one
+			std::thread left([&]() { leftCount = compressSubtreeWide(input, leftLength, chunkCounter, threads / 2, cvs); });
+			rightCount = compressSubtreeWide(input + leftLength, rightLength, rightChunkCounter, threads - threads / 2, rightCvs);
+			left.join();
+			joined = true;
+		}
+		catch (const std::system_error&) {
+			// No thread available; hash both halves here
+		}
+	}
+	if (!joined) {
+		leftCount = compressSubtreeWide(input, leftLength, chunkCounter, 1, cvs);
+		rightCount = compressSubtreeWide(input + leftLength, rightLength, rightChunkCounter, 1, rightCvs);
+	}
+
+	if (leftCount == 1) {
+		memcpy(out, cvs, 2 * 32);
+		return 2;
+	}
+	return compressParentsParallel(cvs, leftCount + rightCount, out);
+}
+
+void BLAKE3::compressSubtreeToParentNode(const uint8_t* input, size_t length, uint64_t chunkCounter, size_t threads, uint8_t out[64]) {
+	uint8_t cvs[MAX_SIMD_DEGREE * 32];
+	size_t count = compressSubtreeWide(input, length, chunkCounter, threads, cvs);
+
+	// Condense the chaining values down to a left and a right child
+	uint8_t parents[MAX_SIMD_DEGREE * 32 / 2];
+	while (count > 2) {
+		count = compressParentsParallel(cvs, count, parents);
+		memcpy(cvs, parents, count * 32);
+	}
+	memcpy(out, cvs, 2 * 32);
+}
+
+BLAKE3::BLAKE3(size_t threads) : m_threads(threads) {
+	if (m_threads == 0) {
+		m_threads = static_cast<size_t>((std::max)(std::thread::hardware_concurrency(), 1U));
+	}
+	m_chunk.reset(0);
+}
+
+void BLAKE3::mergeCvStack(uint64_t totalChunks) {
+	// Subtrees are merged lazily: one stack entry per 1 bit of the number of chunks
+	size_t postMergeLen = 0;
+	for (uint64_t bits = totalChunks; bits != 0; bits &= bits - 1) {
+		postMergeLen++;
+	}
+	while (m_cvStackLen > postMergeLen) {
+		uint8_t* parent = m_cvStack + (m_cvStackLen - 2) * 32;
+		parentOutput(parent).chainingValue(parent);
+		m_cvStackLen--;
+	}
+}
+
+void BLAKE3::pushCv(const uint8_t cv[32], uint64_t chunkCounter) {
+	mergeCvStack(chunkCounter);
+	memcpy(m_cvStack + m_cvStackLen * 32, cv, 32);
+	m_cvStackLen++;
+}
+
+void BLAKE3::update(const uint8_t* data, size_t length) {
+	// Finish the current chunk first
+	if (m_chunk.length() > 0) {
+		const size_t take = (std::min)(length, CHUNK_LEN - m_chunk.length());
+		m_chunk.update(data, take);
+		data += take;
+		length -= take;
+		if (length == 0) {
+			return;
+		}
+		uint8_t cv[32];
+		m_chunk.output().chainingValue(cv);
+		pushCv(cv, m_chunk.counter);
+		m_chunk.reset(m_chunk.counter + 1);
+	}
+
+	// Hash the largest subtrees the input and the position in the tree allow; the last chunk is kept
+	// back, since it might be the root
+	while (length > CHUNK_LEN) {
+		size_t subtreeLength = CHUNK_LEN;
+		while (2 * subtreeLength <= length) {
+			subtreeLength *= 2;
+		}
+		const uint64_t position = m_chunk.counter * CHUNK_LEN;
+		while (((subtreeLength - 1) & position) != 0) {
+			subtreeLength /= 2;
+		}
+		const uint64_t subtreeChunks = subtreeLength / CHUNK_LEN;
+		if (subtreeLength <= CHUNK_LEN) {
+			ChunkState chunk;
+			chunk.reset(m_chunk.counter);
+			chunk.update(data, subtreeLength);
+			uint8_t cv[32];
+			chunk.output().chainingValue(cv);
+			pushCv(cv, chunk.counter);
+		}
+		else {
+			uint8_t cvPair[64];
+			compressSubtreeToParentNode(data, subtreeLength, m_chunk.counter, m_threads, cvPair);
+			pushCv(cvPair, m_chunk.counter);
+			pushCv(cvPair + 32, m_chunk.counter + subtreeChunks / 2);
+		}
+		m_chunk.counter += subtreeChunks;
+		data += subtreeLength;
+		length -= subtreeLength;
+	}
+
+	if (length > 0) {
+		m_chunk.update(data, length);
+		mergeCvStack(m_chunk.counter);
+	}
+}
+
+void BLAKE3::update(const std::string& data) {
+	update(reinterpret_cast<const uint8_t*>(data.c_str()), data.size());
+}
+
+std::array<uint8_t, 32> BLAKE3::digest() {
+	std::array<uint8_t, 32> hash;
+	if (m_cvStackLen == 0) {
+		m_chunk.output().rootBytes(hash.data());
+		return hash;
+	}
+
+	// Fold the stack from the top into the current chunk (or the top two entries if it is empty)
+	Output output;
+	size_t remaining;
+	if (m_chunk.length() > 0) {
+		remaining = m_cvStackLen;
+		output = m_chunk.output();
+	}
+	else {
+		remaining = m_cvStackLen - 2;
+		output = parentOutput(m_cvStack + remaining * 32);
+	}
+	while (remaining > 0) {
+		remaining--;
+		uint8_t block[BLOCK_LEN];
+		memcpy(block, m_cvStack + remaining * 32, 32);
+		output.chainingValue(block + 32);
+		output = parentOutput(block);
+	}
+	output.rootBytes(hash.data());
+	return hash;
+}
+
+std::string BLAKE3::toString(const std::array<uint8_t, 32>& digest) {
+	return DigestValue(digest).toString();
+}
@@ -0,0 +1,118 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#ifndef BLAKE3_H
+#define BLAKE3_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <array>
+
+/**
+ * @brief BLAKE3 hash (32-byte output, default mode). Whole chunks are compressed several at a time
+ *        in SIMD lanes (8 with AVX2, 4 with SSE2), and large inputs passed to a single update are
+ *        split into subtrees that are hashed on several threads.
+ */
+class BLAKE3 {
+
+public:
+	/**
+	 * @brief Constructor.
+	 * @param threads Maximum number of threads used by update, 0 for one per hardware thread.
+	 */
+	explicit BLAKE3(size_t threads = 0);
+	void update(const uint8_t* data, size_t length);
+	void update(const std::string& data);
+	std::array<uint8_t, 32> digest();
+
+	static std::string toString(const std::array<uint8_t, 32>& digest);
+
+	/**
+	 * @brief Number of chunks compressed in parallel on this CPU (1 means one after another).
+	 */
+	static size_t simdDegree();
+
+private:
+	static constexpr size_t BLOCK_LEN = 64;
+	static constexpr size_t CHUNK_LEN = 1024;
+	static constexpr size_t MAX_SIMD_DEGREE = 8;
+	static constexpr size_t MAX_DEPTH = 54; // 2^54 chunks of 1 KiB is more than 2^64 bytes
+
+	/**
+	 * @brief What is left to compress at the end of a chunk or parent node; its chaining value,
+	 *        or the root hash if it is the last node of the tree.
+	 */
+	struct Output {
+		uint32_t cv[8];
+		uint8_t block[BLOCK_LEN];
+		uint8_t blockLen;
+		uint64_t counter;
+		uint8_t flags;
+
+		void chainingValue(uint8_t out[32]) const;
+		void rootBytes(uint8_t out[32]) const;
+	};
+
+	/**
+	 * @brief The chunk currently being hashed.
+	 */
+	struct ChunkState {
+		uint32_t cv[8];
+		uint64_t counter = 0;
+		uint8_t buffer[BLOCK_LEN] = { 0, };
+		uint8_t bufferLen = 0;
+		uint8_t blocksCompressed = 0;
+
+		void reset(uint64_t chunkCounter);
+		size_t length() const;
+		void update(const uint8_t* data, size_t length);
+		Output output() const;
+	};
+
+	ChunkState m_chunk;
+	uint8_t m_cvStack[(MAX_DEPTH + 1) * 32];
+	size_t m_cvStackLen = 0;
+	size_t m_threads;
+
+	void pushCv(const uint8_t cv[32], uint64_t chunkCounter);
+	void mergeCvStack(uint64_t totalChunks);
+
+	static Output parentOutput(const uint8_t block[BLOCK_LEN]);
+	static void compressInPlace(uint32_t cv[8], const uint8_t block[BLOCK_LEN], uint8_t blockLen, uint64_t counter, uint8_t flags);
+	static void compressXof(const uint32_t cv[8], const uint8_t block[BLOCK_LEN], uint8_t blockLen, uint64_t counter, uint8_t flags, uint8_t out[64]);
+	static void hashMany(const uint8_t* const* inputs, size_t count, size_t blocks, uint64_t counter, bool incrementCounter,
+		uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out);
+	static void hashOne(const uint8_t* input, size_t blocks, uint64_t counter, uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t out[32]);
+	static void hash4(const uint8_t* const* inputs, size_t blocks, uint64_t counter, bool incrementCounter,
+		uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out);
+	static void hash8(const uint8_t* const* inputs, size_t blocks, uint64_t counter, bool incrementCounter,
+		uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out);
+	static size_t compressChunksParallel(const uint8_t* input, size_t length, uint64_t chunkCounter, uint8_t* out);
+	static size_t compressParentsParallel(const uint8_t* cvs, size_t count, uint8_t* out);
+	static size_t compressSubtreeWide(const uint8_t* input, size_t length, uint64_t chunkCounter, size_t threads, uint8_t* out);
+	static void compressSubtreeToParentNode(const uint8_t* input, size_t length, uint64_t chunkCounter, size_t threads, uint8_t out[64]);
+};
+
+#endif
@@ -0,0 +1,1627 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+// genUp4win_bench: measures the throughput of SHA256, SHA-512, SHA-512/256, of the file checksum path, of the
+// HTTP/1.1 download path over loopback and of the manifest reader, and prints the results as JSON. The NIST test vectors and the HTTP client
+// are checked first; if any of them fails, nothing is measured and the exit code is 1.
+//
+// Usage: genUp4win_bench [--output file.json] [--max-size bytes] [--file-size bytes] [--min-time seconds]
+
+#include "SHA256.h"
+#include "SHA2.h"
+#include "BLAKE3.h"
+#include "DigestValue.h"
+#include "SHA256MultiBuffer.h"
+#include "FileReader.h"
+#include "ChecksumCache.h"
+#include "HttpTransport.h"
+#include "DownloadRecord.h"
+#include "HashCheckpoint.h"
+#include "SegmentedDownloader.h"
+#include "ManifestReader.h"
+#include "XMLDocument.h"
+#include "BinaryManifest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief One measurement: how many bytes were hashed in how much time.
+ */
+struct CResult
+{
+	std::string strBenchmark;  ///< What was measured (update, multi_buffer, file_cold, file_warm, http_loopback, http_segmented, http_request, manifest_reader, xml_document, xml_index, binary_manifest)
+	std::string strAlgorithm;  ///< Hash algorithm (sha256, sha512, sha512_256, blake3), or none
+	std::string strBackend;    ///< SHA256 backend used, the number of BLAKE3 threads, how the HTTP body is framed or the connection is made, or the encoding, the lookup or the mapping of a catalog
+	unsigned long long nSize = 0;     ///< Size of each input in bytes
+	unsigned long long nBytes = 0;    ///< Total number of bytes hashed
+	unsigned long long nIterations = 0; ///< Number of inputs hashed
+	double fSeconds = 0;       ///< Total time
+};
+
+/**
+ * @brief Benchmark settings, from the command line.
+ */
+struct CSettings
+{
+	std::string strOutputPath;                   ///< Empty to print to the standard output
+	unsigned long long nMaxSize = 1ULL << 30;    ///< Largest buffer for SHA256::update (1 GiB)
+	std::vector<unsigned long long> arrFileSizes{ 1ULL << 20, 16ULL << 20, 128ULL << 20 };
+	double fMinTime = 0.25;                      ///< Minimum time spent on each measurement
+};
+
+static volatile uint8_t g_nSink = 0; ///< Keeps the compiler from dropping unused digests
+
+static const char* BackendName(SHA256::Backend nBackend)
+{
+	switch (nBackend)
+	{
+		case SHA256::Backend::SSSE3: return "ssse3";
+		case SHA256::Backend::SHANI: return "shani";
+		default: return "portable";
+	}
+}
+
+static std::vector<SHA256::Backend> SupportedBackends()
+{
+	std::vector<SHA256::Backend> arrBackends;
+	for (const SHA256::Backend nBackend : { SHA256::Backend::Portable, SHA256::Backend::SSSE3, SHA256::Backend::SHANI })
+	{
+		if (SHA256::isSupported(nBackend))
+			arrBackends.push_back(nBackend);
+	}
+	return arrBackends;
+}
+
+/**
+ * @brief Checks the NIST FIPS 180-2 test vectors with the current backend, through SHA256 (also across
+ *        saveState and loadState) and SHA256MultiBuffer.
+ */
+static bool CheckTestVectors()
+{
+	const std::string strMillionA(1000000, 'a');
+	const std::vector<std::pair<std::string, std::string>> arrVectors{
+		{ "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+		{ "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+		{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+		{ "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+		{ strMillionA, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" }
+	};
+
+	std::vector<std::pair<const uint8_t*, size_t>> arrBuffers;
+	for (const auto& pVector : arrVectors)
+	{
+		// In one call, and byte by byte through the buffering in update
+		SHA256 sha256;
+		sha256.update(pVector.first);
+		if (SHA256::toString(sha256.digest()) != pVector.second)
+			return false;
+		SHA256 sha256Bytes;
+		for (const char nByte : pVector.first)
+			sha256Bytes.update(reinterpret_cast<const uint8_t*>(&nByte), 1);
+		if (SHA256::toString(sha256Bytes.digest()) != pVector.second)
+			return false;
+
+		// Interrupted halfway, continued from the saved state in another object
+		const size_t nHalf = pVector.first.size() / 2;
+		SHA256 sha256First, sha256Second;
+		sha256First.update(reinterpret_cast<const uint8_t*>(pVector.first.data()), nHalf);
+		const auto state = sha256First.saveState();
+		if (!sha256Second.loadState(state.data(), state.size()) || (sha256Second.length() != nHalf))
+			return false;
+		sha256Second.update(reinterpret_cast<const uint8_t*>(pVector.first.data()) + nHalf, pVector.first.size() - nHalf);
+		if (SHA256::toString(sha256Second.digest()) != pVector.second)
+			return false;
+		arrBuffers.emplace_back(reinterpret_cast<const uint8_t*>(pVector.first.data()), pVector.first.size());
+	}
+
+	// Several copies of the vectors, so that every lane gets some
+	const size_t nVectorCount = arrBuffers.size();
+	while (arrBuffers.size() < 4 * SHA256MultiBuffer::lanes() + 1)
+		arrBuffers.push_back(arrBuffers[arrBuffers.size() % nVectorCount]);
+	const std::vector<SHA256MultiBuffer::Digest> arrDigests = SHA256MultiBuffer::hashBuffers(arrBuffers);
+	for (size_t nIndex = 0; nIndex < arrDigests.size(); nIndex++)
+	{
+		if (SHA256::toString(arrDigests[nIndex]) != arrVectors[nIndex % nVectorCount].second)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Checks a hash of the SHA2 template against the vectors of the NIST examples ("", "abc" and the two-block message).
+ */
+template <typename Hash>
+static bool CheckTestVectors(const std::vector<std::string>& arrExpected)
+{
+	const std::vector<std::string> arrMessages{ "", "abc",
+		"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu" };
+	for (size_t nIndex = 0; nIndex < arrMessages.size(); nIndex++)
+	{
+		Hash pHash;
+		pHash.update(arrMessages[nIndex]);
+		if (Hash::toString(pHash.digest()) != arrExpected[nIndex])
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Checks the SHA-2 template instantiations; SHA2<SHA256Traits> uses the current SHA256 backend.
+ */
+static bool CheckSHA2TestVectors()
+{
+	return CheckTestVectors<SHA2<SHA256Traits>>({
+			"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+			"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+			"cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" }) &&
+		CheckTestVectors<SHA512>({
+			"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e",
+			"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+			"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909" }) &&
+		CheckTestVectors<SHA512_256>({
+			"c672b8d1ef56ed28ab87c3622c5114069bdd3ad7b8f9737498d0c01ecef0967a",
+			"53048e2681941ef99b2e29b76b4c7dabe4c2d0c634fc6d46e0e2f13107e7af23",
+			"3928e184fb8690f840da3988121d31be65cb9d3ef83ee6146feac861e19b563a" });
+}
+
+/**
+ * @brief Checks BLAKE3 against the official test vectors (input byte i is i % 251), and checks that
+ *        hashing on several threads gives the same result as on one.
+ */
+static bool CheckBLAKE3TestVectors()
+{
+	const std::vector<std::pair<size_t, std::string>> arrVectors{
+		{ 0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+		{ 1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+		{ 1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11" },
+		{ 1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+		{ 1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+		{ 2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a" },
+		{ 3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2" },
+		{ 8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b" },
+		{ 102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" } };
+
+	std::vector<uint8_t> arrInput((3 << 20) + 5);
+	for (size_t nIndex = 0; nIndex < arrInput.size(); nIndex++)
+		arrInput[nIndex] = static_cast<uint8_t>(nIndex % 251);
+
+	for (const auto& [nLength, strExpected] : arrVectors)
+	{
+		BLAKE3 pHash(1);
+		pHash.update(arrInput.data(), nLength);
+		if (BLAKE3::toString(pHash.digest()) != strExpected)
+			return false;
+	}
+
+	BLAKE3 pSerial(1), pParallel(4);
+	pSerial.update(arrInput.data(), arrInput.size());
+	pParallel.update(arrInput.data(), arrInput.size());
+	return pSerial.digest() == pParallel.digest();
+}
+
+/**
+ * @brief Checks the parsing of DigestValue: hexadecimal text in either case and with whitespace around it,
+ *        digests of up to 64 bytes and longer hash states, the rejection of malformed text, and that digests of other lengths differ
+ *        even when the shorter one is a prefix of the longer one padded with zeros.
+ */
+static bool CheckDigestValue()
+{
+	const std::string strHex = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	const std::string strUpper = "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD";
+	DigestValue pLower, pUpper, pWide;
+	bool bPassed = pLower.parse(strHex) && (pLower.size() == 32) && (pLower.toString() == strHex) && (pLower == DigestValue(SHA256::hash("abc"))) &&
+		pUpper.parse(" \t" + strUpper + "\r\n") && (pUpper == pLower) && (pUpper.toString() == strHex) &&
+		pWide.parse(L" " + std::wstring(strUpper.begin(), strUpper.end())) && (pWide == pLower) && (pWide.toWString() == std::wstring(strHex.begin(), strHex.end()));
+
+	// Up to 64 bytes, as for SHA-512
+	const std::string strLong = strHex + strHex;
+	DigestValue pLong;
+	bPassed = bPassed && pLong.parse(strLong) && (pLong.size() == DigestValue::MaxSize) && (pLong.toString() == strLong) && !pLong.parse(strLong + "00") && pLong.empty();
+
+	for (const char* lpszMalformed : { "", " \t ", "a", "abc", "0g", "ab cd", "ab-cd", "0x00" })
+	{
+		DigestValue pDigest;
+		bPassed = bPassed && !pDigest.parse(std::string(lpszMalformed)) && pDigest.empty();
+	}
+	DigestValue pParsed;
+	bPassed = bPassed && pParsed.parse(strHex) && !pParsed.parse(strHex.substr(1)) && pParsed.empty() && (pParsed == DigestValue());
+
+	// Hash states are longer than any digest
+	std::vector<uint8_t> arrState(100), arrParsed(100);
+	for (size_t nIndex = 0; nIndex < arrState.size(); nIndex++)
+		arrState[nIndex] = static_cast<uint8_t>(nIndex * 7);
+	std::string strState(2 * arrState.size(), '0');
+	DigestValue::formatHex(arrState.data(), arrState.size(), strState.data());
+	bPassed = bPassed && DigestValue::parseHex(std::string_view(strState), arrParsed.data()) && (arrParsed == arrState) &&
+		!DigestValue::parseHex(std::string_view(strState).substr(1), arrParsed.data()) && !DigestValue::parseHex(std::string_view(" " + strState.substr(1)), arrParsed.data());
+
+	// Lengths are part of the value, so the zero bytes left after a shorter digest don't make it equal to a longer one
+	DigestValue pShort, pPadded, pOther;
+	return bPassed && pShort.parse(std::string("00")) && pPadded.parse(std::string("0000")) && (pShort != pPadded) && (pShort != DigestValue()) &&
+		pOther.parse(std::string("01")) && (pShort != pOther) && (pLower != pLong) && (pLower == DigestValue(pLower.data(), pLower.size()));
+}
+
+/**
+ * @brief Repeats pRun until at least fMinTime seconds have passed.
+ * @return The number of runs and the time they took.
+ */
+template <typename Function>
+static std::pair<unsigned long long, double> Measure(double fMinTime, Function pRun)
+{
+	const auto tStart = std::chrono::steady_clock::now();
+	unsigned long long nRuns = 0;
+	double fSeconds = 0;
+	do
+	{
+		pRun();
+		nRuns++;
+		fSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+	} while (fSeconds < fMinTime);
+	return { nRuns, fSeconds };
+}
+
+/**
+ * @brief SHA256::update and SHA256::digest on one buffer at a time, from 64 bytes to nMaxSize.
+ */
+static void BenchUpdate(const CSettings& pSettings, const std::vector<uint8_t>& arrData, std::vector<CResult>& arrResults)
+{
+	for (const SHA256::Backend nBackend : SupportedBackends())
+	{
+		SHA256::setBackend(nBackend);
+		for (unsigned long long nSize = 64; nSize <= pSettings.nMaxSize; nSize *= 4)
+		{
+			const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+			{
+				SHA256 sha256;
+				sha256.update(arrData.data(), static_cast<size_t>(nSize));
+				g_nSink = g_nSink ^ sha256.digest()[0];
+			});
+			arrResults.push_back({ "update", "sha256", BackendName(nBackend), nSize, nRuns * nSize, nRuns, fSeconds });
+		}
+	}
+}
+
+/**
+ * @brief The other SHA-2 algorithms, which have no hardware backend, from 64 bytes to nMaxSize.
+ */
+template <typename Hash>
+static void BenchUpdate(const char* lpszAlgorithm, const CSettings& pSettings, const std::vector<uint8_t>& arrData, std::vector<CResult>& arrResults)
+{
+	for (unsigned long long nSize = 64; nSize <= pSettings.nMaxSize; nSize *= 4)
+	{
+		const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+		{
+			Hash pHash;
+			pHash.update(arrData.data(), static_cast<size_t>(nSize));
+			g_nSink = g_nSink ^ pHash.digest()[0];
+		});
+		arrResults.push_back({ "update", lpszAlgorithm, "portable", nSize, nRuns * nSize, nRuns, fSeconds });
+	}
+}
+
+/**
+ * @brief BLAKE3 on one thread and on all hardware threads, from 64 bytes to nMaxSize.
+ */
+static void BenchBLAKE3(const CSettings& pSettings, const std::vector<uint8_t>& arrData, std::vector<CResult>& arrResults)
+{
+	const size_t nThreads = (std::max)(std::thread::hardware_concurrency(), 1U);
+	for (const size_t nThreadCount : { static_cast<size_t>(1), nThreads })
+	{
+		for (unsigned long long nSize = 64; nSize <= pSettings.nMaxSize; nSize *= 4)
+		{
+			const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+			{
+				BLAKE3 pHash(nThreadCount);
+				pHash.update(arrData.data(), static_cast<size_t>(nSize));
+				g_nSink = g_nSink ^ pHash.digest()[0];
+			});
+			arrResults.push_back({ "update", "blake3", "threads_" + std::to_string(nThreadCount), nSize, nRuns * nSize, nRuns, fSeconds });
+		}
+		if (nThreads == 1)
+			break;
+	}
+}
+
+/**
+ * @brief SHA256MultiBuffer::hashBuffers on four inputs per lane, from 64 bytes to 1 MiB each.
+ */
+static void BenchMultiBuffer(const CSettings& pSettings, const std::vector<uint8_t>& arrData, std::vector<CResult>& arrResults)
+{
+	const size_t nInputCount = 4 * SHA256MultiBuffer::lanes();
+	for (unsigned long long nSize = 64; (nSize <= (1ULL << 20)) && (nSize * nInputCount <= arrData.size()); nSize *= 4)
+	{
+		std::vector<std::pair<const uint8_t*, size_t>> arrBuffers;
+		for (size_t nIndex = 0; nIndex < nInputCount; nIndex++)
+			arrBuffers.emplace_back(arrData.data() + nIndex * nSize, static_cast<size_t>(nSize));
+		const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+		{
+			g_nSink = g_nSink ^ SHA256MultiBuffer::hashBuffers(arrBuffers)[0][0];
+		});
+		arrResults.push_back({ "multi_buffer", "sha256", BackendName(SHA256::backend()), nSize, nRuns * nInputCount * nSize, nRuns * nInputCount, fSeconds });
+	}
+}
+
+/**
+ * @brief Drops a file from the page cache, so that the next read comes from the disk.
+ * @return false if this is not supported on this system.
+ */
+static bool DropFromPageCache(const std::filesystem::path& strFilePath)
+{
+#ifdef _WIN32
+	// There is no way to evict the cached pages of a single file without administrator rights
+	(void)strFilePath;
+	return false;
+#else
+	const int nFile = open(strFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (nFile < 0)
+		return false;
+	const bool retVal = (fdatasync(nFile) == 0) && (posix_fadvise(nFile, 0, 0, POSIX_FADV_DONTNEED) == 0);
+	close(nFile);
+	return retVal;
+#endif
+}
+
+/**
+ * @brief Checks ReadFileBlocks against hashing the same data in memory, on both sides of the mapping threshold
+ *        and of the mapped windows, so that both the pipelined and the mapped reads hand over every byte in order,
+ *        and checks that a mapped read of a file truncated meanwhile fails instead of crashing.
+ */
+static bool CheckFileReader()
+{
+	const unsigned long long nOddSize = 2 * MAPPING_WINDOW_SIZE + 12345;
+	std::vector<uint8_t> arrData(static_cast<size_t>(nOddSize));
+	uint32_t nState = 0x12345678;
+	for (uint8_t& nByte : arrData)
+	{
+		nState = nState * 1664525 + 1013904223;
+		nByte = static_cast<uint8_t>(nState >> 24);
+	}
+
+	bool bPassed = true;
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_reader.bin";
+	for (const unsigned long long nFileSize : { 0ULL, 1ULL, MAPPING_THRESHOLD - 1, MAPPING_THRESHOLD, MAPPING_WINDOW_SIZE + 1ULL, nOddSize })
+	{
+		{
+			std::ofstream pFile(strFilePath, std::ios::binary | std::ios::trunc);
+			pFile.write(reinterpret_cast<const char*>(arrData.data()), static_cast<std::streamsize>(nFileSize));
+			if (!pFile)
+			{
+				bPassed = false;
+				break;
+			}
+		}
+		SHA256 pExpected, pRead;
+		pExpected.update(arrData.data(), static_cast<size_t>(nFileSize));
+		unsigned long long nBytesRead = 0;
+		if (!ReadFileBlocks(strFilePath, [&](const uint8_t* pData, size_t nLength) { pRead.update(pData, nLength); nBytesRead += nLength; }) ||
+			(nBytesRead != nFileSize) || (pRead.digest() != pExpected.digest()))
+		{
+			std::cerr << "ReadFileBlocks failed on " << nFileSize << " bytes" << std::endl;
+			bPassed = false;
+			break;
+		}
+	}
+
+	// The windows after the first one are gone once the file is truncated
+	CMappedFileReader pReader(0x10000);
+	size_t nWindows = 0;
+	bPassed = bPassed && CMappedFileReader::IsOnFixedVolume(strFilePath) && !pReader.Read(strFilePath, [&](const uint8_t*, size_t)
+	{
+		if (nWindows++ == 0)
+			std::filesystem::resize_file(strFilePath, 0);
+	}) && (nWindows == 1);
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	return bPassed;
+}
+
+/**
+ * @brief The file checksum path of GetChecksumFromFile (ReadFileBlocks + SHA256), on files that are
+ *        dropped from the page cache before every run (cold) and on files that are already cached (warm).
+ */
+static bool BenchFiles(const CSettings& pSettings, const std::vector<uint8_t>& arrData, std::vector<CResult>& arrResults)
+{
+	bool retVal = true;
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_bench.bin";
+	for (const unsigned long long nFileSize : pSettings.arrFileSizes)
+	{
+		{
+			std::ofstream pFile(strFilePath, std::ios::binary | std::ios::trunc);
+			for (unsigned long long nWritten = 0; pFile && (nWritten < nFileSize);)
+			{
+				const size_t nLength = static_cast<size_t>(std::min<unsigned long long>(arrData.size(), nFileSize - nWritten));
+				pFile.write(reinterpret_cast<const char*>(arrData.data()), nLength);
+				nWritten += nLength;
+			}
+			if (!pFile)
+			{
+				std::cerr << "Cannot write " << strFilePath.string() << std::endl;
+				retVal = false;
+				break;
+			}
+		}
+
+		const auto HashFile = [&]()
+		{
+			SHA256 sha256;
+			if (!ReadFileBlocks(strFilePath, [&sha256](const uint8_t* pData, size_t nLength) { sha256.update(pData, nLength); }))
+				throw std::runtime_error("Cannot read " + strFilePath.string());
+			g_nSink = g_nSink ^ sha256.digest()[0];
+		};
+
+		// Cold: only the hashing is timed, not dropping the cache
+		if (DropFromPageCache(strFilePath))
+		{
+			CResult pResult{ "file_cold", "sha256", BackendName(SHA256::backend()), nFileSize, 0, 0, 0 };
+			do
+			{
+				DropFromPageCache(strFilePath);
+				const auto [nRuns, fSeconds] = Measure(0, HashFile);
+				pResult.nIterations += nRuns;
+				pResult.fSeconds += fSeconds;
+			} while (pResult.fSeconds < pSettings.fMinTime);
+			pResult.nBytes = pResult.nIterations * nFileSize;
+			arrResults.push_back(pResult);
+		}
+
+		HashFile();
+		const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, HashFile);
+		arrResults.push_back({ "file_warm", "sha256", BackendName(SHA256::backend()), nFileSize, nRuns * nFileSize, nRuns, fSeconds });
+	}
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	return retVal;
+}
+
+/**
+ * @brief A loopback HTTP/1.1 server for CHttpTransport, serving one payload with persistent connections,
+ *        one thread per connection: /fixed with a Content-Length, /chunked in chunks, /close up to the end
+ *        of the connection, /once with a Content-Length but closing the connection without saying so,
+ *        /redirect as a redirect to /fixed, and 404 Not Found for anything else.
+ */
+class CLoopbackServer
+{
+public:
+	explicit CLoopbackServer(const std::vector<uint8_t>& arrPayload)
+		: m_arrPayload(arrPayload), m_bStopping(false)
+	{
+	}
+
+	~CLoopbackServer()
+	{
+		Stop();
+	}
+
+	bool Start()
+	{
+		std::string strError;
+		if (!m_pListener.Listen("127.0.0.1", 0, strError))
+		{
+			std::cerr << strError << std::endl;
+			return false;
+		}
+		m_bStopping = false;
+		m_pThread = std::thread([this]() { Run(); });
+		return true;
+	}
+
+	/**
+	 * @brief Stops accepting connections, and waits for the clients to close the open ones.
+	 */
+	void Stop()
+	{
+		if (m_pThread.joinable())
+		{
+			// Wake up the pending accept with one last connection
+			m_bStopping = true;
+			CTcpSocket pSocket;
+			std::string strError;
+			pSocket.Connect("127.0.0.1", m_pListener.GetLocalPort(), TCP_SOCKET_TIMEOUT, strError);
+			m_pThread.join();
+		}
+		std::unique_lock<std::mutex> pLock(m_pLock);
+		m_pNoConnections.wait(pLock, [this]() { return m_nConnections == 0; });
+		m_pListener.Close();
+	}
+
+	std::string GetURL(const std::string& strPath) const
+	{
+		return "http://127.0.0.1:" + std::to_string(m_pListener.GetLocalPort()) + strPath;
+	}
+
+private:
+	void Run()
+	{
+		while (!m_bStopping)
+		{
+			CTcpSocket pSocket = m_pListener.Accept();
+			if (!m_bStopping && pSocket.IsOpen())
+			{
+				std::lock_guard<std::mutex> pLock(m_pLock);
+				m_nConnections++;
+				std::thread([this](CTcpSocket pConnection)
+				{
+					Serve(pConnection);
+					pConnection.Close();
+					std::lock_guard<std::mutex> pConnectionLock(m_pLock);
+					if (--m_nConnections == 0)
+						m_pNoConnections.notify_all();
+				}, std::move(pSocket)).detach();
+			}
+		}
+	}
+
+	/**
+	 * @brief Answers the requests of one connection until the client closes it.
+	 */
+	void Serve(CTcpSocket& pSocket)
+	{
+		std::string strReceived;
+		char pBuffer[4096];
+		while (true)
+		{
+			// Only the target of the request line and the Range header are used
+			size_t nHeadEnd;
+			while ((nHeadEnd = strReceived.find("\r\n\r\n")) == std::string::npos)
+			{
+				const long long nReceived = pSocket.Receive(pBuffer, sizeof(pBuffer));
+				if (nReceived <= 0)
+					return;
+				strReceived.append(pBuffer, static_cast<size_t>(nReceived));
+			}
+			const size_t nTargetStart = strReceived.find(' ') + 1;
+			const std::string strTarget = strReceived.substr(nTargetStart, strReceived.find(' ', nTargetStart) - nTargetStart);
+			const std::string strHead = strReceived.substr(0, nHeadEnd + 2);
+			strReceived.erase(0, nHeadEnd + 4);
+			if (!Answer(pSocket, strTarget, strHead))
+				return;
+		}
+	}
+
+	/**
+	 * @brief Sends the response to one request.
+	 * @return false if the connection is closed after it.
+	 */
+	bool Answer(CTcpSocket& pSocket, const std::string& strTarget, const std::string& strHead)
+	{
+		std::string strResponse;
+		if ((strTarget == "/ranges") || (strTarget == "/slow-ranges"))
+		{
+			return AnswerRange(pSocket, strHead, strTarget == "/slow-ranges");
+		}
+		if ((strTarget == "/fixed") || (strTarget == "/once"))
+		{
+			strResponse = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(m_arrPayload.size()) + "\r\n\r\n";
+			return pSocket.Send(strResponse.data(), strResponse.size()) && pSocket.Send(m_arrPayload.data(), m_arrPayload.size()) && (strTarget == "/fixed");
+		}
+		if (strTarget == "/chunked")
+		{
+			strResponse = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+			bool bSent = pSocket.Send(strResponse.data(), strResponse.size());
+			for (size_t nOffset = 0; bSent && (nOffset < m_arrPayload.size()); nOffset += 65000)
+			{
+				const size_t nLength = std::min<size_t>(65000, m_arrPayload.size() - nOffset);
+				std::ostringstream strChunkSize;
+				strChunkSize << std::hex << nLength << ";ext=1\r\n";
+				bSent = pSocket.Send(strChunkSize.str().data(), strChunkSize.str().size()) && pSocket.Send(m_arrPayload.data() + nOffset, nLength) && pSocket.Send("\r\n", 2);
+			}
+			const std::string strLastChunk = "0\r\nX-Trailer: 1\r\n\r\n";
+			return bSent && pSocket.Send(strLastChunk.data(), strLastChunk.size());
+		}
+		if (strTarget == "/close")
+		{
+			strResponse = "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n";
+			if (pSocket.Send(strResponse.data(), strResponse.size()))
+				pSocket.Send(m_arrPayload.data(), m_arrPayload.size());
+			return false;
+		}
+		if (strTarget == "/redirect")
+			strResponse = "HTTP/1.1 302 Found\r\nLocation: fixed\r\nContent-Length: 0\r\n\r\n";
+		else
+			strResponse = "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nNot Found";
+		return pSocket.Send(strResponse.data(), strResponse.size());
+	}
+
+	/**
+	 * @brief Answers a request that may have a single "Range: bytes=first-[last]" header.
+	 *        If bSlow is set, the first range that reaches the end of the payload from further than
+	 *        its start is sent slowly, so the other connections have to take it over.
+	 */
+	bool AnswerRange(CTcpSocket& pSocket, const std::string& strHead, bool bSlow)
+	{
+		const unsigned long long nSize = m_arrPayload.size();
+		unsigned long long nFirst = 0, nLast = nSize - 1;
+		const size_t nRange = strHead.find("\r\nRange: bytes=");
+		std::string strResponse;
+		if (nRange == std::string::npos)
+		{
+			strResponse = "HTTP/1.1 200 OK\r\nAccept-Ranges: bytes\r\nETag: \"payload\"\r\nContent-Length: " + std::to_string(nSize) + "\r\n\r\n";
+		}
+		else
+		{
+			const std::string strRange = strHead.substr(nRange + 15, strHead.find("\r\n", nRange + 2) - nRange - 15);
+			const size_t nDash = strRange.find('-');
+			nFirst = std::stoull(strRange.substr(0, nDash));
+			if (nDash + 1 < strRange.size())
+				nLast = std::min(nLast, std::stoull(strRange.substr(nDash + 1)));
+			if ((nFirst >= nSize) || (nFirst > nLast))
+			{
+				strResponse = "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" + std::to_string(nSize) + "\r\nContent-Length: 0\r\n\r\n";
+				return pSocket.Send(strResponse.data(), strResponse.size());
+			}
+			strResponse = "HTTP/1.1 206 Partial Content\r\nAccept-Ranges: bytes\r\nETag: \"payload\"\r\nContent-Range: bytes " + std::to_string(nFirst) + "-" +
+				std::to_string(nLast) + "/" + std::to_string(nSize) + "\r\nContent-Length: " + std::to_string(nLast - nFirst + 1) + "\r\n\r\n";
+		}
+		if (!pSocket.Send(strResponse.data(), strResponse.size()))
+			return false;
+		const bool bThrottle = bSlow && (nFirst > 0) && (nLast + 1 == nSize) && !m_bThrottled.exchange(true);
+		const size_t nPiece = bThrottle ? 0x10000 : static_cast<size_t>(nSize);
+		for (unsigned long long nOffset = nFirst; (nOffset < nSize) && (nOffset <= nLast); nOffset += nPiece)
+		{
+			if (!pSocket.Send(m_arrPayload.data() + nOffset, static_cast<size_t>(std::min<unsigned long long>(nPiece, nLast + 1 - nOffset))))
+				return false;
+			if (bThrottle)
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		return true;
+	}
+
+	const std::vector<uint8_t>& m_arrPayload; ///< Body of every successful response
+	CTcpSocket m_pListener;                   ///< Listening socket on a free loopback port
+	std::thread m_pThread;                    ///< Accepts the connections
+	std::mutex m_pLock;                       ///< Guards m_nConnections
+	std::condition_variable m_pNoConnections; ///< Signaled when the last connection is closed
+	size_t m_nConnections = 0;                ///< Connections being served, each on its own thread
+	std::atomic<bool> m_bStopping;            ///< Set by Stop
+	std::atomic<bool> m_bThrottled{ false };  ///< Set once /slow-ranges has slowed a range down
+};
+
+/**
+ * @brief Downloads the payload of a loopback server with CHttpTransport, hashing it on the way like DownloadFileWithChecksum.
+ * @return false if the download failed or the payload was not received completely.
+ */
+static bool DownloadFromLoopback(CHttpTransport& pTransport, const std::string& strURL, unsigned long long nExpectedLength, std::array<uint8_t, 32>& pDigest)
+{
+	SHA256 sha256;
+	unsigned long long nProgress = 0;
+	TRANSPORT_RESPONSE pResponse;
+	const bool bDownloaded = pTransport.Get({ strURL, {} },
+		[&sha256](const uint8_t* pData, size_t nLength) { sha256.update(pData, nLength); return true; },
+		[&nProgress](unsigned long long nReceived, unsigned long long) { nProgress = nReceived; },
+		pResponse);
+	if (!bDownloaded)
+		std::cerr << strURL << ": " << pResponse.strError << std::endl;
+	pDigest = sha256.digest();
+	return bDownloaded && (pResponse.nStatusCode == 200) && (nProgress == nExpectedLength);
+}
+
+/**
+ * @brief Checks CHttpTransport against a loopback server, for every way of framing the body,
+ *        a redirect, an error status and a cancelled download, and checks which requests
+ *        reused a pooled connection.
+ */
+static bool CheckHttpTransport()
+{
+	HTTP_URL pURL;
+	if (!ParseHttpURL("HTTP://user@[::1]:8080?q#f", pURL) || (pURL.strHost != "::1") || (pURL.nPort != 8080) || (pURL.strTarget != "/?q") ||
+		ParseHttpURL("https://example.com/", pURL) || ParseHttpURL("http://host:99999/", pURL) ||
+		(ResolveHttpURL("http://host/a/b?c", "d") != "http://host/a/d") || (ResolveHttpURL("http://host/a/b", "/e") != "http://host/e") ||
+		(ResolveHttpURL("http://host", "//other/f") != "http://other/f") || (ResolveHttpURL("http://host/a", "http://other/g") != "http://other/g"))
+		return false;
+
+	std::vector<uint8_t> arrPayload((1 << 20) + 12345);
+	for (size_t nIndex = 0; nIndex < arrPayload.size(); nIndex++)
+		arrPayload[nIndex] = static_cast<uint8_t>(nIndex % 251);
+	SHA256 sha256;
+	sha256.update(arrPayload.data(), arrPayload.size());
+	const std::array<uint8_t, 32> pExpected = sha256.digest();
+
+	// The pool closes its connections before the server waits for them
+	CLoopbackServer pServer(arrPayload);
+	if (!pServer.Start())
+		return false;
+	CHttpConnectionPool pPool;
+	CHttpTransport pTransport(pPool);
+	for (const char* lpszPath : { "/fixed", "/chunked", "/close", "/redirect" })
+	{
+		std::array<uint8_t, 32> pDigest;
+		if (!DownloadFromLoopback(pTransport, pServer.GetURL(lpszPath), arrPayload.size(), pDigest) || (pDigest != pExpected))
+			return false;
+	}
+
+	// An error status fails without passing its body on; so does a download the callback cancels
+	TRANSPORT_RESPONSE pResponse;
+	bool bBodyReceived = false;
+	if (pTransport.Get({ pServer.GetURL("/missing"), {} }, [&bBodyReceived](const uint8_t*, size_t) { bBodyReceived = true; return true; }, nullptr, pResponse) ||
+		(pResponse.nStatusCode != 404) || bBodyReceived)
+		return false;
+	if (pTransport.Get({ pServer.GetURL("/fixed"), {} }, [](const uint8_t*, size_t) { return false; }, nullptr, pResponse) || (pResponse.nStatusCode != 200))
+		return false;
+
+	// A pooled connection the server has closed is replaced by a new one
+	for (const char* lpszPath : { "/once", "/fixed" })
+	{
+		std::array<uint8_t, 32> pDigest;
+		if (!DownloadFromLoopback(pTransport, pServer.GetURL(lpszPath), arrPayload.size(), pDigest) || (pDigest != pExpected))
+			return false;
+	}
+
+	// Hits: /chunked, /close, /fixed after the redirect, /missing, the cancelled /fixed and the last /fixed
+	const HTTP_POOL_STATISTICS pStatistics = pPool.GetStatistics();
+	return (pStatistics.nHits == 6) && (pStatistics.nMisses == 3) && (pStatistics.nStale == 1);
+}
+
+/**
+ * @brief Downloads the payload of a loopback server with CSegmentedDownloader into a temporary file.
+ * @param pDigest Output: receives the SHA256 of the bytes passed on in order.
+ * @param pFileDigest Output: receives the SHA256 of the file.
+ */
+static bool DownloadSegments(CSegmentedDownloader& pDownloader, const std::string& strURL, std::array<uint8_t, 32>& pDigest, std::array<uint8_t, 32>& pFileDigest)
+{
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_segments.bin";
+	SHA256 sha256;
+	TRANSPORT_RESPONSE pResponse;
+	const bool bDownloaded = pDownloader.Download(strURL, strFilePath,
+		[&sha256](const uint8_t* pData, size_t nLength) { sha256.update(pData, nLength); return true; }, nullptr, pResponse);
+	if (!bDownloaded)
+		std::cerr << strURL << ": " << pResponse.strError << std::endl;
+	pDigest = sha256.digest();
+
+	std::ifstream pFile(strFilePath, std::ios::binary);
+	const std::vector<char> arrContent((std::istreambuf_iterator<char>(pFile)), std::istreambuf_iterator<char>());
+	pFile.close();
+	SHA256 pFileHash;
+	pFileHash.update(reinterpret_cast<const uint8_t*>(arrContent.data()), arrContent.size());
+	pFileDigest = pFileHash.digest();
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	return bDownloaded;
+}
+
+/**
+ * @brief Checks CSegmentedDownloader against a loopback server: ranges over several connections,
+ *        a slow range taken over by the others, a server without ranges and an empty file.
+ */
+static bool CheckSegmentedDownload()
+{
+	unsigned long long nFirst = 0, nLast = 0, nTotal = 0;
+	if (!ParseContentRange("bytes 0-499/1234", nFirst, nLast, nTotal) || (nFirst != 0) || (nLast != 499) || (nTotal != 1234) ||
+		!ParseContentRange(" bytes 5-9/* ", nFirst, nLast, nTotal) || (nTotal != TRANSPORT_UNKNOWN_LENGTH) ||
+		ParseContentRange("bytes */1234", nFirst, nLast, nTotal) || ParseContentRange("bytes 5-4/10", nFirst, nLast, nTotal) ||
+		ParseContentRange("bytes 0-10/10", nFirst, nLast, nTotal) || ParseContentRange("items 0-1/2", nFirst, nLast, nTotal))
+		return false;
+
+	std::vector<uint8_t> arrPayload((1 << 20) + 12345);
+	for (size_t nIndex = 0; nIndex < arrPayload.size(); nIndex++)
+		arrPayload[nIndex] = static_cast<uint8_t>(nIndex % 251);
+	SHA256 sha256;
+	sha256.update(arrPayload.data(), arrPayload.size());
+	const std::array<uint8_t, 32> pExpected = sha256.digest();
+
+	CLoopbackServer pServer(arrPayload);
+	if (!pServer.Start())
+		return false;
+	CHttpConnectionPool pPool;
+	CHttpTransport pTransport(pPool);
+	CSegmentedDownloader pDownloader(pTransport, 4, 0x10000);
+	for (const char* lpszPath : { "/ranges", "/slow-ranges", "/fixed" })
+	{
+		std::array<uint8_t, 32> pDigest, pFileDigest;
+		if (!DownloadSegments(pDownloader, pServer.GetURL(lpszPath), pDigest, pFileDigest) || (pDigest != pExpected) || (pFileDigest != pExpected))
+			return false;
+		const SEGMENTED_DOWNLOAD_STATISTICS& pStatistics = pDownloader.GetStatistics();
+		if ((strcmp(lpszPath, "/ranges") == 0) && (pStatistics.nConnections < 2))
+			return false;
+		if ((strcmp(lpszPath, "/slow-ranges") == 0) && (pStatistics.nSplits == 0))
+			return false;
+		if ((strcmp(lpszPath, "/fixed") == 0) && ((pStatistics.nConnections != 1) || (pStatistics.nRequests != 1)))
+			return false;
+	}
+	TRANSPORT_RESPONSE pResponse;
+	if (pDownloader.Download(pServer.GetURL("/missing"), std::filesystem::temp_directory_path() / "genUp4win_segments.bin", nullptr, nullptr, pResponse) ||
+		(pResponse.nStatusCode != 404))
+		return false;
+	std::error_code ec;
+	std::filesystem::remove(std::filesystem::temp_directory_path() / "genUp4win_segments.bin", ec);
+
+	// An empty file has no range to send, so it is requested again without one
+	const std::vector<uint8_t> arrEmpty;
+	CLoopbackServer pEmptyServer(arrEmpty);
+	if (!pEmptyServer.Start())
+		return false;
+	CHttpConnectionPool pEmptyPool;
+	CHttpTransport pEmptyTransport(pEmptyPool);
+	CSegmentedDownloader pEmptyDownloader(pEmptyTransport, 4, 0x10000);
+	SHA256 pEmptyHash;
+	const std::array<uint8_t, 32> pEmptyDigest = pEmptyHash.digest();
+	std::array<uint8_t, 32> pDigest, pFileDigest;
+	return DownloadSegments(pEmptyDownloader, pEmptyServer.GetURL("/ranges"), pDigest, pFileDigest) && (pDigest == pEmptyDigest) &&
+		(pFileDigest == pEmptyDigest) && (pEmptyDownloader.GetStatistics().nRequests == 2);
+}
+
+/**
+ * @brief Checks the checksum cache: its entries survive a reload from the cache file, the least recently used one
+ *        is evicted at the cap, an entry is dropped when the size or the modification time of its file changes,
+ *        and a file changed while it was hashed is not stored.
+ */
+static bool CheckChecksumCache()
+{
+	const std::filesystem::path strDirectory = std::filesystem::temp_directory_path();
+	const std::filesystem::path strCacheFilePath = strDirectory / "genUp4win_checksums.txt";
+	std::vector<std::filesystem::path> arrFilePaths;
+	for (const char* lpszName : { "genUp4win_cached1.bin", "genUp4win_cached2.bin", "genUp4win_cached3.bin" })
+	{
+		arrFilePaths.push_back(strDirectory / lpszName);
+		std::ofstream pFile(arrFilePaths.back(), std::ios::binary | std::ios::trunc);
+		pFile << lpszName;
+	}
+	std::error_code ec;
+	std::filesystem::remove(strCacheFilePath, ec);
+
+	// Stored with the identities taken before "hashing"; the first file is used last but one, so the second is evicted
+	bool bPassed = true;
+	std::string strChecksum;
+	{
+		CChecksumCache pCache(strCacheFilePath, 2);
+		std::vector<CChecksumCache::CFileIdentity> arrIdentities(arrFilePaths.size());
+		for (size_t nIndex = 0; nIndex < arrFilePaths.size(); nIndex++)
+			bPassed = bPassed && CChecksumCache::GetIdentity(arrFilePaths[nIndex], arrIdentities[nIndex]);
+		bPassed = bPassed && pCache.Store(arrFilePaths[0], "sha256", "01", arrIdentities[0]) && pCache.Store(arrFilePaths[1], "sha256", "02", arrIdentities[1]) &&
+			pCache.Lookup(arrFilePaths[0], "sha256", strChecksum) && (strChecksum == "01") && pCache.Store(arrFilePaths[2], "sha256", "03", arrIdentities[2]) &&
+			!pCache.Lookup(arrFilePaths[1], "sha256", strChecksum) && !pCache.Lookup(arrFilePaths[0], "blake3", strChecksum);
+	}
+	CChecksumCache pReloaded(strCacheFilePath, 2);
+	bPassed = bPassed && pReloaded.Lookup(arrFilePaths[0], "sha256", strChecksum) && (strChecksum == "01") &&
+		pReloaded.Lookup(arrFilePaths[2], "sha256", strChecksum) && (strChecksum == "03") && !pReloaded.Lookup(arrFilePaths[1], "sha256", strChecksum);
+
+	// A longer file, then a file of the same size with another modification time
+	{
+		std::ofstream pFile(arrFilePaths[0], std::ios::binary | std::ios::app);
+		pFile << 'x';
+	}
+	std::filesystem::last_write_time(arrFilePaths[2], std::filesystem::last_write_time(arrFilePaths[2]) - std::chrono::hours(1), ec);
+	bPassed = bPassed && !ec && !pReloaded.Lookup(arrFilePaths[0], "sha256", strChecksum) && !pReloaded.Lookup(arrFilePaths[2], "sha256", strChecksum);
+
+	// The identity from before the change no longer matches the file
+	CChecksumCache::CFileIdentity pIdentity;
+	bPassed = bPassed && CChecksumCache::GetIdentity(arrFilePaths[1], pIdentity);
+	{
+		std::ofstream pFile(arrFilePaths[1], std::ios::binary | std::ios::app);
+		pFile << 'x';
+	}
+	bPassed = bPassed && !pReloaded.Store(arrFilePaths[1], "sha256", "02", pIdentity) && !pReloaded.Lookup(arrFilePaths[1], "sha256", strChecksum);
+
+	pReloaded.Save();
+	for (const std::filesystem::path& strFilePath : arrFilePaths)
+		std::filesystem::remove(strFilePath, ec);
+	std::filesystem::remove(strCacheFilePath, ec);
+	return bPassed;
+}
+
+/**
+ * @brief Checks the checkpoint of a partial download: it survives a round trip through its file, once the partial
+ *        file is on the disk, and is rejected for another algorithm, when the partial file is shorter than the
+ *        checkpoint, and once it is removed.
+ */
+static bool CheckHashCheckpoint()
+{
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_checkpoint.bin";
+	{
+		std::ofstream pFile(strFilePath, std::ios::binary | std::ios::trunc);
+		pFile << std::string(1000, 'x');
+	}
+	std::vector<uint8_t> arrState(256);
+	for (size_t nIndex = 0; nIndex < arrState.size(); nIndex++)
+		arrState[nIndex] = static_cast<uint8_t>(nIndex);
+	unsigned long long nBytesDone = 0;
+	std::vector<uint8_t> arrLoaded;
+	std::filesystem::path strTempFilePath{ GetHashCheckpointFilePath(strFilePath) };
+	strTempFilePath += ".tmp";
+	bool bPassed = FlushFileToDisk(strFilePath) && SaveHashCheckpoint(strFilePath, "sha256", 1000, arrState) && !std::filesystem::exists(strTempFilePath) &&
+		LoadHashCheckpoint(strFilePath, "sha256", nBytesDone, arrLoaded) && (nBytesDone == 1000) && (arrLoaded == arrState) &&
+		!LoadHashCheckpoint(strFilePath, "blake3", nBytesDone, arrLoaded);
+	bPassed = bPassed && SaveHashCheckpoint(strFilePath, "sha256", 1001, arrState) && !LoadHashCheckpoint(strFilePath, "sha256", nBytesDone, arrLoaded);
+	RemoveHashCheckpoint(strFilePath);
+	bPassed = bPassed && !std::filesystem::exists(GetHashCheckpointFilePath(strFilePath)) && !LoadHashCheckpoint(strFilePath, "sha256", nBytesDone, arrLoaded);
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	return bPassed && !FlushFileToDisk(strFilePath);
+}
+
+/**
+ * @brief Checks the record of a partial download: it survives a round trip through its file, is dropped
+ *        when the partial file is shorter than recorded, and takes its validator and size from a response,
+ *        here to a request for the rest of a file from the loopback server.
+ */
+static bool CheckDownloadRecord()
+{
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_record.bin";
+	{
+		std::ofstream pFile(strFilePath, std::ios::binary | std::ios::trunc);
+		pFile << std::string(1000, 'x');
+	}
+	DOWNLOAD_RECORD pRecord;
+	pRecord.strURL = "http://127.0.0.1/setup.msi";
+	pRecord.strETag = "W/\"weak\"";
+	pRecord.strLastModified = "Wed, 21 Oct 2015 07:28:00 GMT";
+	pRecord.nExpectedSize = 5000;
+	pRecord.nBytesDone = 1000;
+	DOWNLOAD_RECORD pLoaded;
+	bool bPassed = SaveDownloadRecord(strFilePath, pRecord) && LoadDownloadRecord(strFilePath, pLoaded) && (pLoaded.strURL == pRecord.strURL) &&
+		(pLoaded.strETag == pRecord.strETag) && (pLoaded.nExpectedSize == 5000) && (pLoaded.nBytesDone == 1000) &&
+		(GetDownloadRecordValidator(pLoaded) == pRecord.strLastModified);
+	pRecord.nBytesDone = 1001;
+	pRecord.nExpectedSize = TRANSPORT_UNKNOWN_LENGTH;
+	bPassed = bPassed && SaveDownloadRecord(strFilePath, pRecord) && !LoadDownloadRecord(strFilePath, pLoaded);
+	pRecord.strURL += "\r\n";
+	bPassed = bPassed && !SaveDownloadRecord(strFilePath, pRecord);
+	RemoveDownloadRecord(strFilePath);
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	if (!bPassed || std::filesystem::exists(GetDownloadRecordFilePath(strFilePath)))
+		return false;
+
+	std::vector<uint8_t> arrPayload(100000);
+	CLoopbackServer pServer(arrPayload);
+	if (!pServer.Start())
+		return false;
+	CHttpConnectionPool pPool;
+	CHttpTransport pTransport(pPool);
+	TRANSPORT_RESPONSE pResponse;
+	unsigned long long nReceived = 0;
+	if (!pTransport.Get({ pServer.GetURL("/ranges"), { { "Range", "bytes=40000-" }, { "If-Range", "\"payload\"" } } },
+		[&nReceived](const uint8_t*, size_t nLength) { nReceived += nLength; return true; }, nullptr, pResponse) || (nReceived != 60000))
+		return false;
+	SetDownloadRecordResponse(pRecord, pResponse, 40000);
+	return (pRecord.nExpectedSize == 100000) && (GetDownloadRecordValidator(pRecord) == "\"payload\"");
+}
+
+/**
+ * @brief The section of the product the checks look for in a catalog, with spaces around a value, entities,
+ *        CDATA sections, an attribute and an empty entry.
+ */
+const char TEST_PRODUCT[] = "\t<genUp4win>\r\n\t\t<Version> 2.0.0.1 </Version>\r\n\t\t<Download>http://127.0.0.1/setup.msi?a=1&amp;b=&#x32;</Download>\r\n"
+	"\t\t<Checksum alg='BLAKE3'><![CDATA[ab]]]]><![CDATA[>cd]]></Checksum>\r\n\t\t<TreeChecksum/>\r\n\t</genUp4win>\r\n";
+
+/**
+ * @brief A catalog of nProductCount products, in UTF-16LE with a byte order mark, as MSXML saves a configuration file;
+ *        the section of the product strProduct, anywhere in the catalog, is added verbatim.
+ */
+static std::vector<uint8_t> BuildCatalog(size_t nProductCount, size_t nProductIndex, const std::string& strProduct)
+{
+	std::string strCatalog = "<?xml version=\"1.0\" encoding=\"UTF-16\" standalone=\"no\"?>\r\n<!-- catalog -->\r\n<xml>\r\n";
+	for (size_t nIndex = 0; nIndex < nProductCount; nIndex++)
+	{
+		if (nIndex == nProductIndex)
+			strCatalog += strProduct;
+		const std::string strName = "Product" + std::to_string(nIndex);
+		strCatalog += "\t<" + strName + ">\r\n\t\t<Version>1.0." + std::to_string(nIndex) + "</Version>\r\n\t\t<Download>http://127.0.0.1/" +
+			strName + ".msi</Download>\r\n\t\t<Checksum>" + std::string(64, 'a') + "</Checksum>\r\n\t</" + strName + ">\r\n";
+	}
+	strCatalog += "</xml>\r\n";
+	std::vector<uint8_t> arrCatalog{ 0xFF, 0xFE };
+	for (const char nChar : strCatalog)
+	{
+		arrCatalog.push_back(static_cast<uint8_t>(nChar));
+		arrCatalog.push_back(0);
+	}
+	return arrCatalog;
+}
+
+/**
+ * @brief Feeds a manifest to a reader in blocks of nBlockSize bytes, until the reader stops.
+ * @return The result of CManifestReader::Finish.
+ */
+static bool ReadManifest(CManifestReader& pReader, const std::vector<uint8_t>& arrManifest, size_t nBlockSize)
+{
+	for (size_t nOffset = 0; nOffset < arrManifest.size(); nOffset += nBlockSize)
+	{
+		if (!pReader.Feed(arrManifest.data() + nOffset, std::min(nBlockSize, arrManifest.size() - nOffset)))
+			break;
+	}
+	return pReader.Finish();
+}
+
+/**
+ * @brief Checks the streaming manifest reader: it finds a product in the middle of a UTF-16 catalog fed in odd-sized blocks,
+ *        with its entities, CDATA section and attributes, and stops at the end of its section; it reads a whole catalog
+ *        without the product, and rejects a truncated and a malformed one.
+ */
+static bool CheckManifestReader()
+{
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(2000, 1000, TEST_PRODUCT);
+	CManifestReader pReader("genUp4win");
+	if (!ReadManifest(pReader, arrCatalog, 7) || !pReader.HasSection() || (pReader.GetBytesRead() >= arrCatalog.size() / 2 + 1000))
+		return false;
+	const MANIFEST_ENTRY* pVersion = pReader.GetEntry("Version");
+	const MANIFEST_ENTRY* pDownload = pReader.GetEntry("Download");
+	const MANIFEST_ENTRY* pChecksum = pReader.GetEntry("Checksum");
+	const MANIFEST_ENTRY* pTreeChecksum = pReader.GetEntry("TreeChecksum");
+	if ((pVersion == nullptr) || (pVersion->strValue != "2.0.0.1") || (pDownload == nullptr) || (pDownload->strValue != "http://127.0.0.1/setup.msi?a=1&b=2") ||
+		(pChecksum == nullptr) || (pChecksum->strValue != "ab]]>cd") || (pReader.GetEntryAttribute("Checksum", "alg") != "BLAKE3") ||
+		(pTreeChecksum == nullptr) || !pTreeChecksum->strValue.empty() || (pReader.GetEntry("TreeChunkSize") != nullptr))
+		return false;
+
+	CManifestReader pMissing("Product2000");
+	if (!ReadManifest(pMissing, arrCatalog, 4096) || pMissing.HasSection() || (pMissing.GetBytesRead() != arrCatalog.size() - 4))
+		return false;
+	CManifestReader pTruncated("Product2000");
+	if (ReadManifest(pTruncated, std::vector<uint8_t>(arrCatalog.begin(), arrCatalog.begin() + arrCatalog.size() / 2), 4096) || pTruncated.GetError().empty())
+		return false;
+	const std::string strMalformed = "<xml><genUp4win><Version>1.0</Download></genUp4win></xml>";
+	CManifestReader pMalformed("genUp4win");
+	return !ReadManifest(pMalformed, std::vector<uint8_t>(strMalformed.begin(), strMalformed.end()), 4096) && !pMalformed.HasSection();
+}
+
+/**
+ * @brief Checks the XML document behind CNativeXMLAppSettings: it loads a UTF-16 catalog with entities, a CDATA section,
+ *        attributes and empty entries; a changed document survives a save and a reload in UTF-8 and in UTF-16;
+ *        it rejects malformed documents, and the nodes of the catalog take a few arena blocks.
+ */
+static bool CheckXMLDocument()
+{
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(2000, 1000, TEST_PRODUCT);
+	CXMLDocument pDocument;
+	if (!pDocument.Load(std::string(arrCatalog.begin(), arrCatalog.end())) || (pDocument.GetBlockCount() > arrCatalog.size() / XML_ARENA_BLOCK_SIZE))
+		return false;
+	XML_ELEMENT* pSection = CXMLDocument::FindChild(pDocument.GetRoot(), "genUp4win");
+	if ((pSection == nullptr) || (CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "Version")) != "2.0.0.1") ||
+		(CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "Download")) != "http://127.0.0.1/setup.msi?a=1&b=2") ||
+		(CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "Checksum")) != "ab]]>cd") ||
+		(CXMLDocument::GetAttribute(CXMLDocument::FindChild(pSection, "Checksum"), "alg") != "BLAKE3") ||
+		(CXMLDocument::FindChild(pSection, "TreeChecksum") == nullptr) || !CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "TreeChecksum")).empty())
+		return false;
+
+	// Changes which need escaping, then a round trip through both encodings
+	pDocument.SetText(CXMLDocument::FindChild(pSection, "Version"), "3.0 <beta> & \"more\"");
+	if (!pDocument.SetAttribute(CXMLDocument::FindChild(pSection, "Checksum"), "alg", "SHA-512/256 \"&\"") ||
+		(pDocument.AppendChild(pSection, "Not a name") != nullptr))
+		return false;
+	pDocument.SetText(pDocument.AppendChild(pSection, "TreeChunkSize"), "16777216");
+	pDocument.RemoveChild(pDocument.GetRoot(), CXMLDocument::FindChild(pDocument.GetRoot(), "Product0"));
+	const std::string strSaved = pDocument.Save(true);
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_settings.xml";
+	CXMLDocument pUTF8, pUTF16;
+	const bool bSaved = pDocument.SaveFile(strFilePath, true) && pUTF16.LoadFile(strFilePath) && pUTF8.Load(strSaved);
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	if (!bSaved || (pUTF16.Save(true) != strSaved) || (pUTF8.Save(true) != strSaved))
+		return false;
+	pSection = CXMLDocument::FindChild(pUTF16.GetRoot(), "genUp4win");
+	if ((CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "Version")) != "3.0 <beta> & \"more\"") ||
+		(CXMLDocument::GetAttribute(CXMLDocument::FindChild(pSection, "Checksum"), "alg") != "SHA-512/256 \"&\"") ||
+		(CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "Checksum")) != "ab]]>cd") ||
+		(CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "TreeChunkSize")) != "16777216") ||
+		(CXMLDocument::FindChild(pUTF16.GetRoot(), "Product0") != nullptr) || (CXMLDocument::FindChild(pUTF16.GetRoot(), "Product1") == nullptr))
+		return false;
+
+	for (const char* lpszMalformed : { "", "<xml>", "<xml><genUp4win></xml>", "<xml/><xml/>", "<xml a=1/>", "<xml><!-- </xml>", "text<xml/>" })
+	{
+		CXMLDocument pMalformed;
+		if (pMalformed.Load(lpszMalformed) || pMalformed.GetError().empty() || (pMalformed.GetRoot() != nullptr))
+			return false;
+	}
+	CXMLDocument pTruncated;
+	return !pTruncated.Load(std::string(arrCatalog.begin(), arrCatalog.begin() + arrCatalog.size() / 2));
+}
+
+/**
+ * @brief Checks the hashed indexes of the XML document: in a UTF-16 catalog with a product listed twice, they find the
+ *        same sections and entries as a scan, the first of two namesakes, and follow AppendChild, RemoveChild, SetText
+ *        and Load.
+ */
+static bool CheckXMLIndex()
+{
+	const std::string strProduct = "\t<genUp4win>\r\n\t\t<Version>2.0.0.1</Version>\r\n\t</genUp4win>\r\n"
+		"\t<Product1500>\r\n\t\t<Version>0.0.0.0</Version>\r\n\t</Product1500>\r\n";
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(2000, 1000, strProduct);
+	CXMLDocument pDocument;
+	if (!pDocument.Load(std::string(arrCatalog.begin(), arrCatalog.end())))
+		return false;
+	XML_ELEMENT* pRoot = pDocument.GetRoot();
+	for (size_t nIndex = 0; nIndex <= 2000; nIndex++)
+	{
+		const std::string strName = (nIndex < 2000) ? "Product" + std::to_string(nIndex) : "genUp4win";
+		XML_ELEMENT* pSection = pDocument.FindIndexedChild(pRoot, strName);
+		if ((pSection == nullptr) || (pSection != CXMLDocument::FindChild(pRoot, strName)))
+			return false;
+		for (const char* lpszEntry : { "Version", "Download", "Checksum", "TreeChecksum" })
+		{
+			if (pDocument.FindIndexedChild(pSection, lpszEntry) != CXMLDocument::FindChild(pSection, lpszEntry))
+				return false;
+		}
+	}
+	if ((pDocument.GetIndexCount() != 2002) || (pDocument.FindIndexedChild(pRoot, "Product2000") != nullptr) ||
+		(CXMLDocument::GetText(pDocument.FindIndexedChild(pDocument.FindIndexedChild(pRoot, "Product1500"), "Version")) != "0.0.0.0"))
+		return false;
+
+	// A new namesake stays hidden behind the first section, and takes its place once it is removed
+	XML_ELEMENT* pFirst = pDocument.FindIndexedChild(pRoot, "Product0");
+	XML_ELEMENT* pSecond = pDocument.AppendChild(pRoot, "Product0");
+	XML_ELEMENT* pNew = pDocument.AppendChild(pRoot, "Product2000");
+	if ((pDocument.FindIndexedChild(pRoot, "Product0") != pFirst) || (pNew == nullptr) || (pDocument.FindIndexedChild(pRoot, "Product2000") != pNew))
+		return false;
+	pDocument.RemoveChild(pRoot, pFirst);
+	if (pDocument.FindIndexedChild(pRoot, "Product0") != pSecond)
+		return false;
+	pDocument.RemoveChild(pRoot, pSecond);
+	XML_ELEMENT* pSection = pDocument.FindIndexedChild(pRoot, "genUp4win");
+	pDocument.RemoveChild(pSection, pDocument.FindIndexedChild(pSection, "Version"));
+	if ((pDocument.FindIndexedChild(pRoot, "Product0") != nullptr) || (pDocument.FindIndexedChild(pSection, "Version") != nullptr) ||
+		(pDocument.GetIndexCount() != 2001))
+		return false;
+
+	// The children of a section replaced by a text, and the descendants of a removed section, are no longer found
+	pSection = pDocument.FindIndexedChild(pRoot, "Product1");
+	pDocument.FindIndexedChild(pDocument.FindIndexedChild(pSection, "Version"), "Build");
+	pDocument.SetText(pSection, "none");
+	if ((pDocument.FindIndexedChild(pSection, "Version") != nullptr) || (pDocument.GetIndexCount() != 2001))
+		return false;
+	pSection = pDocument.FindIndexedChild(pRoot, "Product2");
+	pDocument.FindIndexedChild(pDocument.FindIndexedChild(pSection, "Version"), "Build");
+	pDocument.RemoveChild(pRoot, pSection);
+	if ((pDocument.FindIndexedChild(pRoot, "Product2") != nullptr) || (pDocument.GetIndexCount() != 2000))
+		return false;
+	return pDocument.Load(std::string(arrCatalog.begin(), arrCatalog.end())) && (pDocument.GetIndexCount() == 0) &&
+		(pDocument.FindIndexedChild(pDocument.GetRoot(), "Product0") == CXMLDocument::FindChild(pDocument.GetRoot(), "Product0"));
+}
+
+/**
+ * @brief Reads the entries of a product from a settings file with the streaming reader.
+ */
+static bool ReadManifestFile(const std::filesystem::path& strFilePath, const std::string& strSection, std::vector<MANIFEST_ENTRY>& arrEntries)
+{
+	std::ifstream pFile(strFilePath, std::ios::binary);
+	const std::vector<uint8_t> arrManifest{ std::istreambuf_iterator<char>(pFile), std::istreambuf_iterator<char>() };
+	CManifestReader pReader(strSection);
+	if (!ReadManifest(pReader, arrManifest, 4096) || !pReader.HasSection())
+		return false;
+	arrEntries = pReader.GetEntries();
+	return true;
+}
+
+/**
+ * @brief Checks how WriteConfigFile rewrites the section of a product: a settings file published with a BLAKE3
+ *        Checksum and a tree checksum, rewritten with a SHA-256 Checksum only, loses its alg attribute and its
+ *        TreeChecksum and TreeChunkSize entries, and the other products are left as they were.
+ */
+static bool CheckConfigRewrite()
+{
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_rewrite.xml";
+	CXMLDocument pDocument;
+	const std::vector<MANIFEST_ENTRY> arrOther{ { "Version", "1.0", {} }, { "Checksum", "ff", { { "alg", "SHA-512" } } } };
+	const std::vector<MANIFEST_ENTRY> arrBLAKE3{ { "Version", "1.0", {} }, { "Download", "http://127.0.0.1/setup.msi", {} },
+		{ "Checksum", "aa", { { "alg", "BLAKE3" } } }, { "TreeChecksum", "cc", {} }, { "TreeChunkSize", "16777216", {} } };
+	std::vector<MANIFEST_ENTRY> arrEntries;
+	bool bPassed = WriteManifestEntries(pDocument, "Other", arrOther, {}) && WriteManifestEntries(pDocument, "genUp4win", arrBLAKE3, {}) &&
+		pDocument.SaveFile(strFilePath, true) && ReadManifestFile(strFilePath, "genUp4win", arrEntries) &&
+		(GetManifestEntryAttribute(FindManifestEntry(arrEntries, "Checksum"), "alg") == "BLAKE3") && (FindManifestEntry(arrEntries, "TreeChecksum") != nullptr);
+
+	// The next release goes back to SHA-256
+	CXMLDocument pRewritten;
+	const std::vector<MANIFEST_ENTRY> arrSHA256{ { "Version", "2.0", {} }, { "Download", "http://127.0.0.1/setup.msi", {} }, { "Checksum", "bb", {} } };
+	bPassed = bPassed && pRewritten.LoadFile(strFilePath) && WriteManifestEntries(pRewritten, "genUp4win", arrSHA256, { "TreeChecksum", "TreeChunkSize" }) &&
+		pRewritten.SaveFile(strFilePath, true) && ReadManifestFile(strFilePath, "genUp4win", arrEntries) && (arrEntries.size() == 3) &&
+		(FindManifestEntry(arrEntries, "Checksum")->strValue == "bb") && FindManifestEntry(arrEntries, "Checksum")->arrAttributes.empty() &&
+		(FindManifestEntry(arrEntries, "Version")->strValue == "2.0") && ReadManifestFile(strFilePath, "Other", arrEntries) &&
+		(GetManifestEntryAttribute(FindManifestEntry(arrEntries, "Checksum"), "alg") == "SHA-512");
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	return bPassed && !WriteManifestEntries(pRewritten, "genUp4win", { { "Not a name", "", {} } }, {});
+}
+
+/**
+ * @brief Checks the binary manifest: built from a UTF-16 catalog, it finds the same entries and attributes as the
+ *        streaming reader, the first and the last product, and not a missing one, from memory and from a mapped file;
+ *        it rejects a truncated manifest, another format and another version; and a URL without a binary manifest
+ *        is remembered as such until its retry time.
+ */
+static bool CheckBinaryManifest()
+{
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(2000, 1000, TEST_PRODUCT);
+	CXMLDocument pDocument;
+	std::vector<uint8_t> arrManifest;
+	CManifestReader pReader("genUp4win");
+	if (!pDocument.Load(std::string(arrCatalog.begin(), arrCatalog.end())) || !BuildBinaryManifest(pDocument.GetRoot(), arrManifest) ||
+		(arrManifest.size() >= arrCatalog.size()) || !ReadManifest(pReader, arrCatalog, 4096))
+		return false;
+
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_catalog.manifest";
+	CBinaryManifest pMemory, pMapped;
+	const bool bLoaded = pMemory.Load(arrManifest) && SaveBinaryManifest(pDocument.GetRoot(), strFilePath) && pMapped.LoadFile(strFilePath);
+	bool bPassed = bLoaded && (pMemory.GetProductCount() == 2001) && (pMapped.GetProductCount() == 2001);
+	for (const CBinaryManifest* pManifest : { &pMemory, &pMapped })
+	{
+		std::vector<MANIFEST_ENTRY> arrEntries, arrFirst, arrLast;
+		bPassed = bPassed && pManifest->FindProduct("genUp4win", arrEntries) && (arrEntries.size() == pReader.GetEntries().size()) &&
+			pManifest->FindProduct("Product0", arrFirst) && (GetManifestEntryAttribute(FindManifestEntry(arrFirst, "Version"), "alg").empty()) &&
+			pManifest->FindProduct("Product1999", arrLast) && (FindManifestEntry(arrLast, "Version") != nullptr) && (FindManifestEntry(arrLast, "Version")->strValue == "1.0.1999") &&
+			!pManifest->FindProduct("Product2000", arrEntries) && !pManifest->FindProduct("", arrEntries);
+		pManifest->FindProduct("genUp4win", arrEntries);
+		for (size_t nIndex = 0; bPassed && (nIndex < arrEntries.size()); nIndex++)
+		{
+			const MANIFEST_ENTRY& pEntry = pReader.GetEntries()[nIndex];
+			bPassed = (arrEntries[nIndex].strName == pEntry.strName) && (arrEntries[nIndex].strValue == pEntry.strValue) && (arrEntries[nIndex].arrAttributes == pEntry.arrAttributes);
+		}
+	}
+	pMapped.Clear();
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	if (!bPassed)
+		return false;
+
+	CBinaryManifest pTruncated, pOther, pNewer;
+	std::vector<uint8_t> arrNewer = arrManifest;
+	arrNewer[4] = BINARY_MANIFEST_VERSION + 1;
+	if (pTruncated.Load(std::vector<uint8_t>(arrManifest.begin(), arrManifest.end() - 1)) || pOther.Load(arrCatalog) || pNewer.Load(arrNewer) ||
+		pNewer.GetError().empty())
+		return false;
+
+	const std::filesystem::path strCacheFilePath = std::filesystem::temp_directory_path() / "genUp4win_missing.manifest";
+	const std::string strURL = "http://127.0.0.1/genUp4win.manifest";
+	const bool bMissing = SaveMissingBinaryManifest(strCacheFilePath, strURL, 1000) && IsBinaryManifestMissing(strCacheFilePath, strURL, 999) &&
+		!IsBinaryManifestMissing(strCacheFilePath, strURL, 1000) && !IsBinaryManifestMissing(strCacheFilePath, strURL + "?v=2", 999);
+	RemoveMissingBinaryManifest(strCacheFilePath);
+	return bMissing && !IsBinaryManifestMissing(strCacheFilePath, strURL, 999) && !SaveMissingBinaryManifest(strCacheFilePath, strURL + "\r\n", 1000);
+}
+
+/**
+ * @brief The download path over loopback: CHttpTransport receiving a file, with a Content-Length and in chunks,
+ *        and hashing it with SHA256 as it arrives; and the time of a small request (1 KiB, like a configuration file)
+ *        on a pooled connection and on a new connection.
+ */
+static bool BenchHttpTransport(const CSettings& pSettings, const std::vector<uint8_t>& arrData, std::vector<CResult>& arrResults)
+{
+	for (const unsigned long long nFileSize : pSettings.arrFileSizes)
+	{
+		std::vector<uint8_t> arrPayload(static_cast<size_t>(nFileSize));
+		for (size_t nOffset = 0; nOffset < arrPayload.size(); nOffset += arrData.size())
+			std::copy_n(arrData.begin(), std::min(arrData.size(), arrPayload.size() - nOffset), arrPayload.begin() + nOffset);
+
+		CLoopbackServer pServer(arrPayload);
+		if (!pServer.Start())
+			return false;
+		CHttpConnectionPool pPool;
+		CHttpTransport pTransport(pPool);
+		for (const char* lpszPath : { "/fixed", "/chunked" })
+		{
+			const std::string strURL = pServer.GetURL(lpszPath);
+			const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+			{
+				std::array<uint8_t, 32> pDigest;
+				if (!DownloadFromLoopback(pTransport, strURL, nFileSize, pDigest))
+					throw std::runtime_error("Cannot download " + strURL);
+				g_nSink = g_nSink ^ pDigest[0];
+			});
+			arrResults.push_back({ "http_loopback", "sha256", lpszPath + 1, nFileSize, nRuns * nFileSize, nRuns, fSeconds });
+		}
+
+		// The same file over ranges of a quarter of it, on one connection and on four
+		for (const unsigned int nSegmentCount : { 1U, 4U })
+		{
+			CSegmentedDownloader pDownloader(pTransport, nSegmentCount, std::max<unsigned long long>(nFileSize / 4, 1));
+			const std::string strURL = pServer.GetURL("/ranges");
+			const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_segments.bin";
+			const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+			{
+				SHA256 sha256;
+				TRANSPORT_RESPONSE pResponse;
+				if (!pDownloader.Download(strURL, strFilePath, [&sha256](const uint8_t* pData, size_t nLength) { sha256.update(pData, nLength); return true; }, nullptr, pResponse))
+					throw std::runtime_error("Cannot download " + strURL + ": " + pResponse.strError);
+				g_nSink = g_nSink ^ sha256.digest()[0];
+			});
+			std::error_code ec;
+			std::filesystem::remove(strFilePath, ec);
+			arrResults.push_back({ "http_segmented", "sha256", (nSegmentCount > 1) ? "4_connections" : "1_connection", nFileSize, nRuns * nFileSize, nRuns, fSeconds });
+		}
+	}
+
+	const std::vector<uint8_t> arrSmallPayload(arrData.begin(), arrData.begin() + 1024);
+	CLoopbackServer pServer(arrSmallPayload);
+	if (!pServer.Start())
+		return false;
+	const std::string strURL = pServer.GetURL("/fixed");
+	for (const unsigned int nIdleTimeout : { HTTP_POOL_IDLE_TIMEOUT, 0U })
+	{
+		CHttpConnectionPool pPool(nIdleTimeout);
+		CHttpTransport pTransport(pPool);
+		const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+		{
+			std::array<uint8_t, 32> pDigest;
+			if (!DownloadFromLoopback(pTransport, strURL, arrSmallPayload.size(), pDigest))
+				throw std::runtime_error("Cannot download " + strURL);
+			g_nSink = g_nSink ^ pDigest[0];
+		});
+		arrResults.push_back({ "http_request", "sha256", (nIdleTimeout > 0) ? "keep_alive" : "new_connection", arrSmallPayload.size(), nRuns * arrSmallPayload.size(), nRuns, fSeconds });
+	}
+	return true;
+}
+
+/**
+ * @brief The streaming manifest reader on a catalog of 10000 products, looking for the last one.
+ */
+static void BenchManifestReader(const CSettings& pSettings, std::vector<CResult>& arrResults)
+{
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(10000, 9999, "\t<genUp4win>\r\n\t\t<Version>2.0.0.1</Version>\r\n\t</genUp4win>\r\n");
+	const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+	{
+		CManifestReader pReader("genUp4win");
+		if (!ReadManifest(pReader, arrCatalog, 0x10000) || !pReader.HasSection())
+			throw std::runtime_error("Cannot read the catalog: " + pReader.GetError());
+		g_nSink = g_nSink ^ static_cast<uint8_t>(pReader.GetBytesRead());
+	});
+	arrResults.push_back({ "manifest_reader", "none", "utf16", arrCatalog.size(), nRuns * arrCatalog.size(), nRuns, fSeconds });
+}
+
+/**
+ * @brief The XML document on a catalog of 10000 products, in UTF-16 as MSXML saves it and in UTF-8:
+ *        loading the whole catalog and reading the entries of the last product.
+ */
+static void BenchXMLDocument(const CSettings& pSettings, std::vector<CResult>& arrResults)
+{
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(10000, 9999, "\t<genUp4win>\r\n\t\t<Version>2.0.0.1</Version>\r\n\t</genUp4win>\r\n");
+	std::string strUTF8;
+	for (size_t nIndex = 2; nIndex < arrCatalog.size(); nIndex += 2)
+		strUTF8 += static_cast<char>(arrCatalog[nIndex]);
+	for (const auto& [lpszEncoding, strCatalog] : { std::pair<const char*, std::string>{ "utf16", std::string(arrCatalog.begin(), arrCatalog.end()) }, { "utf8", strUTF8 } })
+	{
+		const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+		{
+			CXMLDocument pDocument;
+			const XML_ELEMENT* pSection = pDocument.Load(strCatalog) ? CXMLDocument::FindChild(pDocument.GetRoot(), "genUp4win") : nullptr;
+			if (pSection == nullptr)
+				throw std::runtime_error("Cannot load the catalog: " + pDocument.GetError());
+			g_nSink = g_nSink ^ static_cast<uint8_t>(CXMLDocument::GetText(CXMLDocument::FindChild(pSection, "Version")).size());
+		});
+		arrResults.push_back({ "xml_document", "none", lpszEncoding, strCatalog.size(), nRuns * strCatalog.size(), nRuns, fSeconds });
+	}
+}
+
+/**
+ * @brief The lookups of a multi-product check in the XML document of a catalog of 10000 products, loaded once:
+ *        finding the Version, Download and Checksum entries of every tenth product, with the hashed indexes and with a scan.
+ */
+static void BenchXMLIndex(const CSettings& pSettings, std::vector<CResult>& arrResults)
+{
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(10000, 9999, "\t<genUp4win>\r\n\t\t<Version>2.0.0.1</Version>\r\n\t</genUp4win>\r\n");
+	CXMLDocument pDocument;
+	if (!pDocument.Load(std::string(arrCatalog.begin(), arrCatalog.end())))
+		throw std::runtime_error("Cannot load the catalog: " + pDocument.GetError());
+	std::vector<std::string> arrProducts;
+	for (size_t nIndex = 0; nIndex < 10000; nIndex += 10)
+		arrProducts.push_back("Product" + std::to_string(nIndex));
+	for (const bool bIndexed : { true, false })
+	{
+		const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+		{
+			for (const std::string& strProduct : arrProducts)
+			{
+				const XML_ELEMENT* pSection = bIndexed ? pDocument.FindIndexedChild(pDocument.GetRoot(), strProduct) : CXMLDocument::FindChild(pDocument.GetRoot(), strProduct);
+				if (pSection == nullptr)
+					throw std::runtime_error("Cannot find " + strProduct);
+				for (const char* lpszEntry : { "Version", "Download", "Checksum" })
+				{
+					const XML_ELEMENT* pEntry = bIndexed ? pDocument.FindIndexedChild(pSection, lpszEntry) : CXMLDocument::FindChild(pSection, lpszEntry);
+					g_nSink = g_nSink ^ static_cast<uint8_t>(pEntry->strContent.size());
+				}
+			}
+		});
+		arrResults.push_back({ "xml_index", "none", bIndexed ? "indexed" : "scan", arrCatalog.size(), nRuns * arrCatalog.size(), nRuns, fSeconds });
+	}
+}
+
+/**
+ * @brief The binary manifest of a catalog of 10000 products: mapping the file and finding the last product.
+ */
+static bool BenchBinaryManifest(const CSettings& pSettings, std::vector<CResult>& arrResults)
+{
+	const std::vector<uint8_t> arrCatalog = BuildCatalog(10000, 9999, "\t<genUp4win>\r\n\t\t<Version>2.0.0.1</Version>\r\n\t</genUp4win>\r\n");
+	const std::filesystem::path strFilePath = std::filesystem::temp_directory_path() / "genUp4win_catalog.manifest";
+	CXMLDocument pDocument;
+	if (!pDocument.Load(std::string(arrCatalog.begin(), arrCatalog.end())) || !SaveBinaryManifest(pDocument.GetRoot(), strFilePath))
+		return false;
+	const unsigned long long nFileSize = std::filesystem::file_size(strFilePath);
+	const auto [nRuns, fSeconds] = Measure(pSettings.fMinTime, [&]()
+	{
+		CBinaryManifest pManifest;
+		std::vector<MANIFEST_ENTRY> arrEntries;
+		if (!pManifest.LoadFile(strFilePath) || !pManifest.FindProduct("genUp4win", arrEntries))
+			throw std::runtime_error("Cannot read the binary manifest: " + pManifest.GetError());
+		g_nSink = g_nSink ^ static_cast<uint8_t>(arrEntries.size());
+	});
+	std::error_code ec;
+	std::filesystem::remove(strFilePath, ec);
+	arrResults.push_back({ "binary_manifest", "none", "mmap", nFileSize, nRuns * nFileSize, nRuns, fSeconds });
+	return true;
+}
+
+static bool ParseCommandLine(int argc, char* argv[], CSettings& pSettings)
+{
+	try
+	{
+		for (int nIndex = 1; nIndex < argc; nIndex++)
+		{
+			const std::string strOption = argv[nIndex];
+			if (nIndex + 1 >= argc)
+				return false;
+			const std::string strValue = argv[++nIndex];
+			if (strOption == "--output")
+				pSettings.strOutputPath = strValue;
+			else if (strOption == "--max-size")
+				pSettings.nMaxSize = std::stoull(strValue);
+			else if (strOption == "--file-size")
+				pSettings.arrFileSizes = { std::stoull(strValue) };
+			else if (strOption == "--min-time")
+				pSettings.fMinTime = std::stod(strValue);
+			else
+				return false;
+		}
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+	return pSettings.nMaxSize >= 64;
+}
+
+static void WriteJSON(std::ostream& pOutput, const std::vector<std::pair<std::string, bool>>& arrVectorChecks, const std::vector<CResult>& arrResults)
+{
+	pOutput << "{\n  \"default_backend\": \"" << BackendName(SHA256::backend()) << "\",\n";
+	pOutput << "  \"multi_buffer_lanes\": " << SHA256MultiBuffer::lanes() << ",\n";
+	pOutput << "  \"test_vectors\": [";
+	for (size_t nIndex = 0; nIndex < arrVectorChecks.size(); nIndex++)
+	{
+		pOutput << (nIndex ? ",\n" : "\n") << "    { \"backend\": \"" << arrVectorChecks[nIndex].first << "\", \"passed\": "
+			<< (arrVectorChecks[nIndex].second ? "true" : "false") << " }";
+	}
+	pOutput << "\n  ],\n  \"results\": [";
+	for (size_t nIndex = 0; nIndex < arrResults.size(); nIndex++)
+	{
+		const CResult& pResult = arrResults[nIndex];
+		std::ostringstream strThroughput;
+		strThroughput << std::fixed << std::setprecision(2) << (pResult.fSeconds > 0 ? pResult.nBytes / pResult.fSeconds / 1e6 : 0.0);
+		pOutput << (nIndex ? ",\n" : "\n") << "    { \"benchmark\": \"" << pResult.strBenchmark << "\", \"algorithm\": \"" << pResult.strAlgorithm << "\", \"backend\": \"" << pResult.strBackend
+			<< "\", \"size\": " << pResult.nSize << ", \"iterations\": " << pResult.nIterations << ", \"bytes\": " << pResult.nBytes
+			<< ", \"seconds\": " << pResult.fSeconds << ", \"mb_per_s\": " << strThroughput.str() << " }";
+	}
+	pOutput << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+	CSettings pSettings;
+	if (!ParseCommandLine(argc, argv, pSettings))
+	{
+		std::cerr << "Usage: genUp4win_bench [--output file.json] [--max-size bytes] [--file-size bytes] [--min-time seconds]" << std::endl;
+		return 2;
+	}
+
+	// Correctness first: a fast wrong answer is not worth measuring
+	const SHA256::Backend nDefaultBackend = SHA256::backend();
+	std::vector<std::pair<std::string, bool>> arrVectorChecks;
+	bool bPassed = true;
+	for (const SHA256::Backend nBackend : SupportedBackends())
+	{
+		SHA256::setBackend(nBackend);
+		arrVectorChecks.emplace_back(BackendName(nBackend), CheckTestVectors() && CheckSHA2TestVectors());
+		bPassed = bPassed && arrVectorChecks.back().second;
+	}
+	SHA256::setBackend(nDefaultBackend);
+	arrVectorChecks.emplace_back("blake3", CheckBLAKE3TestVectors());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("digest_value", CheckDigestValue());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("file_reader", CheckFileReader());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("http_loopback", CheckHttpTransport());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("segmented_download", CheckSegmentedDownload());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("download_record", CheckDownloadRecord());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("checksum_cache", CheckChecksumCache());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("hash_checkpoint", CheckHashCheckpoint());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("manifest_reader", CheckManifestReader());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("xml_document", CheckXMLDocument());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("binary_manifest", CheckBinaryManifest());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("xml_index", CheckXMLIndex());
+	bPassed = bPassed && arrVectorChecks.back().second;
+	arrVectorChecks.emplace_back("config_rewrite", CheckConfigRewrite());
+	bPassed = bPassed && arrVectorChecks.back().second;
+
+	std::vector<CResult> arrResults;
+	int retVal = 0;
+	if (bPassed)
+	{
+		try
+		{
+			std::vector<uint8_t> arrData(static_cast<size_t>(std::max<unsigned long long>(pSettings.nMaxSize, 1ULL << 20)));
+			std::mt19937 pGenerator(42);
+			for (uint8_t& nByte : arrData)
+				nByte = static_cast<uint8_t>(pGenerator());
+
+			BenchUpdate(pSettings, arrData, arrResults);
+			SHA256::setBackend(nDefaultBackend);
+			BenchUpdate<SHA512>("sha512", pSettings, arrData, arrResults);
+			BenchUpdate<SHA512_256>("sha512_256", pSettings, arrData, arrResults);
+			BenchBLAKE3(pSettings, arrData, arrResults);
+			BenchMultiBuffer(pSettings, arrData, arrResults);
+			BenchManifestReader(pSettings, arrResults);
+			BenchXMLDocument(pSettings, arrResults);
+			BenchXMLIndex(pSettings, arrResults);
+			if (!BenchBinaryManifest(pSettings, arrResults) || !BenchFiles(pSettings, arrData, arrResults) || !BenchHttpTransport(pSettings, arrData, arrResults))
+				retVal = 1;
+		}
+		catch (const std::exception& pException)
+		{
+			std::cerr << pException.what() << std::endl;
+			retVal = 1;
+		}
+	}
+	else
+	{
+		std::cerr << "Test vectors failed" << std::endl;
+		retVal = 1;
+	}
+
+	if (pSettings.strOutputPath.empty())
+	{
+		WriteJSON(std::cout, arrVectorChecks, arrResults);
+	}
+	else
+	{
+		std::ofstream pOutput(pSettings.strOutputPath, std::ios::trunc);
+		WriteJSON(pOutput, arrVectorChecks, arrResults);
+		if (!pOutput)
+		{
+			std::cerr << "Cannot write " << pSettings.strOutputPath << std::endl;
+			retVal = 1;
+		}
+	}
+	return retVal;
+}
@@ -0,0 +1,427 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+
+
+#include "BinaryManifest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief Reads a little-endian number, at any alignment.
+ */
+static uint32_t ReadUInt32(const uint8_t* pData)
+{
+	return static_cast<uint32_t>(pData[0]) | (static_cast<uint32_t>(pData[1]) << 8) | (static_cast<uint32_t>(pData[2]) << 16) | (static_cast<uint32_t>(pData[3]) << 24);
+}
+
+static uint64_t ReadUInt64(const uint8_t* pData)
+{
+	return static_cast<uint64_t>(ReadUInt32(pData)) | (static_cast<uint64_t>(ReadUInt32(pData + 4)) << 32);
+}
+
+/**
+ * @brief Appends a little-endian number.
+ */
+static void WriteUInt32(std::vector<uint8_t>& arrData, uint32_t nValue)
+{
+	for (int nShift = 0; nShift < 32; nShift += 8)
+		arrData.push_back(static_cast<uint8_t>(nValue >> nShift));
+}
+
+static void WriteUInt64(std::vector<uint8_t>& arrData, uint64_t nValue)
+{
+	WriteUInt32(arrData, static_cast<uint32_t>(nValue));
+	WriteUInt32(arrData, static_cast<uint32_t>(nValue >> 32));
+}
+
+uint64_t GetBinaryManifestKey(std::string_view strName)
+{
+	uint64_t nHash = 0xCBF29CE484222325ULL;
+	for (const char nChar : strName)
+	{
+		nHash ^= static_cast<uint8_t>(nChar);
+		nHash *= 0x100000001B3ULL;
+	}
+	return nHash;
+}
+
+/**
+ * @brief Builds the string pool, with each name stored once.
+ */
+class CStringPool
+{
+public:
+	uint32_t Add(std::string_view strName)
+	{
+		const auto pResult = m_mapOffsets.emplace(std::string(strName), static_cast<uint32_t>(m_strPool.size()));
+		if (pResult.second)
+			m_strPool += strName;
+		return pResult.first->second;
+	}
+
+	const std::string& GetPool() const { return m_strPool; }
+
+private:
+	std::unordered_map<std::string, uint32_t> m_mapOffsets;
+	std::string m_strPool;
+};
+
+bool BuildBinaryManifest(const XML_ELEMENT* pRoot, std::vector<uint8_t>& arrManifest)
+{
+	if (pRoot == nullptr)
+		return false;
+
+	// The products sorted by key, then by name; a product which appears again keeps its first section
+	std::vector<std::pair<uint64_t, const XML_ELEMENT*>> arrProducts;
+	for (const XML_ELEMENT* pSection = pRoot->pFirstChild; pSection != nullptr; pSection = pSection->pNextSibling)
+		arrProducts.emplace_back(GetBinaryManifestKey(pSection->strName), pSection);
+	std::stable_sort(arrProducts.begin(), arrProducts.end(), [](const auto& pLeft, const auto& pRight)
+	{
+		return (pLeft.first != pRight.first) ? (pLeft.first < pRight.first) : (pLeft.second->strName < pRight.second->strName);
+	});
+	arrProducts.erase(std::unique(arrProducts.begin(), arrProducts.end(), [](const auto& pLeft, const auto& pRight)
+	{
+		return pLeft.second->strName == pRight.second->strName;
+	}), arrProducts.end());
+
+	CStringPool pStrings;
+	std::string strBlobs;
+	std::vector<uint8_t> arrProductTable, arrEntryTable, arrAttributeTable;
+	uint32_t nEntryCount = 0, nAttributeCount = 0;
+	for (const auto& pProduct : arrProducts)
+	{
+		const uint32_t nFirstEntry = nEntryCount;
+		for (const XML_ELEMENT* pEntry = pProduct.second->pFirstChild; pEntry != nullptr; pEntry = pEntry->pNextSibling)
+		{
+			const uint32_t nFirstAttribute = nAttributeCount;
+			for (const XML_ATTRIBUTE* pAttribute = pEntry->pFirstAttribute; pAttribute != nullptr; pAttribute = pAttribute->pNext)
+			{
+				const std::string strValue = CXMLDocument::GetAttribute(pEntry, pAttribute->strName);
+				WriteUInt32(arrAttributeTable, pStrings.Add(pAttribute->strName));
+				WriteUInt32(arrAttributeTable, static_cast<uint32_t>(pAttribute->strName.size()));
+				WriteUInt32(arrAttributeTable, static_cast<uint32_t>(strBlobs.size()));
+				WriteUInt32(arrAttributeTable, static_cast<uint32_t>(strValue.size()));
+				strBlobs += strValue;
+				nAttributeCount++;
+			}
+			const std::string strValue = CXMLDocument::GetText(pEntry);
+			WriteUInt32(arrEntryTable, pStrings.Add(pEntry->strName));
+			WriteUInt32(arrEntryTable, static_cast<uint32_t>(pEntry->strName.size()));
+			WriteUInt32(arrEntryTable, static_cast<uint32_t>(strBlobs.size()));
+			WriteUInt32(arrEntryTable, static_cast<uint32_t>(strValue.size()));
+			WriteUInt32(arrEntryTable, nFirstAttribute);
+			WriteUInt32(arrEntryTable, nAttributeCount - nFirstAttribute);
+			strBlobs += strValue;
+			nEntryCount++;
+		}
+		WriteUInt64(arrProductTable, pProduct.first);
+		WriteUInt32(arrProductTable, pStrings.Add(pProduct.second->strName));
+		WriteUInt32(arrProductTable, static_cast<uint32_t>(pProduct.second->strName.size()));
+		WriteUInt32(arrProductTable, nFirstEntry);
+		WriteUInt32(arrProductTable, nEntryCount - nFirstEntry);
+
+		// The offsets of the pools are 32 bits; a manifest that large is well beyond any Web Server's catalog anyway
+		if ((pStrings.GetPool().size() > UINT32_MAX) || (strBlobs.size() > UINT32_MAX))
+			return false;
+	}
+
+	arrManifest.clear();
+	arrManifest.reserve(BINARY_MANIFEST_HEADER_SIZE + arrProductTable.size() + arrEntryTable.size() + arrAttributeTable.size() + pStrings.GetPool().size() + strBlobs.size());
+	WriteUInt32(arrManifest, BINARY_MANIFEST_MAGIC);
+	WriteUInt32(arrManifest, BINARY_MANIFEST_VERSION | (static_cast<uint32_t>(BINARY_MANIFEST_HEADER_SIZE) << 16));
+	WriteUInt32(arrManifest, static_cast<uint32_t>(arrProducts.size()));
+	WriteUInt32(arrManifest, nEntryCount);
+	WriteUInt32(arrManifest, nAttributeCount);
+	WriteUInt32(arrManifest, static_cast<uint32_t>(pStrings.GetPool().size()));
+	WriteUInt32(arrManifest, static_cast<uint32_t>(strBlobs.size()));
+	arrManifest.resize(BINARY_MANIFEST_HEADER_SIZE);
+	arrManifest.insert(arrManifest.end(), arrProductTable.begin(), arrProductTable.end());
+	arrManifest.insert(arrManifest.end(), arrEntryTable.begin(), arrEntryTable.end());
+	arrManifest.insert(arrManifest.end(), arrAttributeTable.begin(), arrAttributeTable.end());
+	arrManifest.insert(arrManifest.end(), pStrings.GetPool().begin(), pStrings.GetPool().end());
+	arrManifest.insert(arrManifest.end(), strBlobs.begin(), strBlobs.end());
+	return true;
+}
+
+bool SaveBinaryManifest(const XML_ELEMENT* pRoot, const std::filesystem::path& strFilePath)
+{
+	std::vector<uint8_t> arrManifest;
+	if (!BuildBinaryManifest(pRoot, arrManifest))
+		return false;
+	std::ofstream file(strFilePath, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(arrManifest.data()), arrManifest.size());
+	file.close();
+	return static_cast<bool>(file);
+}
+
+const char MISSING_BINARY_MANIFEST_SIGNATURE[] = "genUp4win missing manifest 1"; ///< First line of the record; anything else is ignored.
+
+std::filesystem::path GetMissingBinaryManifestFilePath(const std::filesystem::path& strCacheFilePath)
+{
+	std::filesystem::path strRecordFilePath{ strCacheFilePath };
+	strRecordFilePath += ".missing";
+	return strRecordFilePath;
+}
+
+bool SaveMissingBinaryManifest(const std::filesystem::path& strCacheFilePath, const std::string& strURL, unsigned long long nRetryTime)
+{
+	// A torn record is ignored, which only costs one more request
+	if (strURL.find_first_of("\r\n") != std::string::npos)
+		return false;
+	std::ofstream pRecordFile(GetMissingBinaryManifestFilePath(strCacheFilePath), std::ios::out | std::ios::trunc);
+	pRecordFile << MISSING_BINARY_MANIFEST_SIGNATURE << '\n' << nRetryTime << '\t' << strURL << '\n';
+	pRecordFile.close();
+	return static_cast<bool>(pRecordFile);
+}
+
+bool IsBinaryManifestMissing(const std::filesystem::path& strCacheFilePath, const std::string& strURL, unsigned long long nNow)
+{
+	std::ifstream pRecordFile(GetMissingBinaryManifestFilePath(strCacheFilePath), std::ios::in);
+	std::string strLine;
+	if (!pRecordFile.is_open() || !std::getline(pRecordFile, strLine) || (strLine != MISSING_BINARY_MANIFEST_SIGNATURE) ||
+		!std::getline(pRecordFile, strLine))
+		return false;
+
+	// The line is: retry time, URL; separated by a tab
+	std::istringstream pFields(strLine);
+	std::string strRetryTime, strRecordURL;
+	if (!std::getline(pFields, strRetryTime, '\t') || !std::getline(pFields, strRecordURL) || (strRecordURL != strURL))
+		return false;
+	try
+	{
+		return nNow < std::stoull(strRetryTime);
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
+
+void RemoveMissingBinaryManifest(const std::filesystem::path& strCacheFilePath)
+{
+	std::error_code ec;
+	std::filesystem::remove(GetMissingBinaryManifestFilePath(strCacheFilePath), ec);
+}
+
+bool CBinaryManifest::Load(std::vector<uint8_t> arrManifest)
+{
+	Clear();
+	m_arrBuffer = std::move(arrManifest);
+	return Open(m_arrBuffer.data(), m_arrBuffer.size());
+}
+
+bool CBinaryManifest::LoadFile(const std::filesystem::path& strFilePath)
+{
+	Clear();
+	const void* pView = nullptr;
+	size_t nSize = 0;
+#ifdef _WIN32
+	// The view keeps the mapping open on its own, so the handles are closed right away
+	const HANDLE hFile = CreateFileW(strFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER nFileSize{};
+		if (GetFileSizeEx(hFile, &nFileSize) && (nFileSize.QuadPart > 0) && (static_cast<unsigned long long>(nFileSize.QuadPart) <= SIZE_MAX))
+		{
+			const HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (hMapping != nullptr)
+			{
+				pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+				nSize = static_cast<size_t>(nFileSize.QuadPart);
+				CloseHandle(hMapping);
+			}
+		}
+		CloseHandle(hFile);
+	}
+#else
+	const int nFile = open(strFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (nFile >= 0)
+	{
+		struct stat pStat {};
+		if ((fstat(nFile, &pStat) == 0) && (pStat.st_size > 0))
+		{
+			nSize = static_cast<size_t>(pStat.st_size);
+			pView = mmap(nullptr, nSize, PROT_READ, MAP_PRIVATE, nFile, 0);
+			if (pView == MAP_FAILED)
+				pView = nullptr;
+		}
+		close(nFile);
+	}
+#endif
+	if (pView == nullptr)
+		return Fail("Cannot map the binary manifest");
+	m_bMapped = true;
+	return Open(static_cast<const uint8_t*>(pView), nSize);
+}
+
+void CBinaryManifest::Clear()
+{
+	if (m_bMapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+#else
+		munmap(const_cast<uint8_t*>(m_pData), m_nSize);
+#endif
+		m_bMapped = false;
+	}
+	std::vector<uint8_t>().swap(m_arrBuffer);
+	m_pData = nullptr;
+	m_nSize = 0;
+	m_nProductCount = m_nEntryCount = m_nAttributeCount = 0;
+	m_nStringPoolSize = m_nBlobPoolSize = 0;
+}
+
+bool CBinaryManifest::FindProduct(std::string_view strName, std::vector<MANIFEST_ENTRY>& arrEntries) const
+{
+	// Binary search for the first record with the key, then the name among the records with the same key
+	const uint64_t nKey = GetBinaryManifestKey(strName);
+	size_t nFirst = 0, nCount = m_nProductCount;
+	while (nCount > 0)
+	{
+		const size_t nStep = nCount / 2;
+		const uint8_t* pProduct = m_pData + m_nProducts + (nFirst + nStep) * BINARY_MANIFEST_PRODUCT_SIZE;
+		const uint64_t nProductKey = ReadUInt64(pProduct);
+		bool bBefore = (nProductKey < nKey);
+		if (nProductKey == nKey)
+		{
+			const uint32_t nNameOffset = ReadUInt32(pProduct + 8), nNameLength = ReadUInt32(pProduct + 12);
+			if ((nNameOffset > m_nStringPoolSize) || (nNameLength > m_nStringPoolSize - nNameOffset))
+				return false;
+			bBefore = (std::string_view(reinterpret_cast<const char*>(m_pData + m_nStrings + nNameOffset), nNameLength) < strName);
+		}
+		if (bBefore)
+		{
+			nFirst += nStep + 1;
+			nCount -= nStep + 1;
+		}
+		else
+			nCount = nStep;
+	}
+	if (nFirst == m_nProductCount)
+		return false;
+
+	const uint8_t* pProduct = m_pData + m_nProducts + nFirst * BINARY_MANIFEST_PRODUCT_SIZE;
+	std::string strProductName;
+	if ((ReadUInt64(pProduct) != nKey) || !GetString(ReadUInt32(pProduct + 8), ReadUInt32(pProduct + 12), strProductName) || (strProductName != strName))
+		return false;
+	const uint32_t nFirstEntry = ReadUInt32(pProduct + 16), nEntryCount = ReadUInt32(pProduct + 20);
+	if ((nFirstEntry > m_nEntryCount) || (nEntryCount > m_nEntryCount - nFirstEntry))
+		return false;
+
+	arrEntries.clear();
+	arrEntries.resize(nEntryCount);
+	for (uint32_t nIndex = 0; nIndex < nEntryCount; nIndex++)
+	{
+		const uint8_t* pEntry = m_pData + m_nEntries + static_cast<size_t>(nFirstEntry + nIndex) * BINARY_MANIFEST_ENTRY_SIZE;
+		MANIFEST_ENTRY& pManifestEntry = arrEntries[nIndex];
+		if (!GetString(ReadUInt32(pEntry), ReadUInt32(pEntry + 4), pManifestEntry.strName) || !GetBlob(ReadUInt32(pEntry + 8), ReadUInt32(pEntry + 12), pManifestEntry.strValue))
+			return false;
+		const uint32_t nFirstAttribute = ReadUInt32(pEntry + 16), nAttributeCount = ReadUInt32(pEntry + 20);
+		if ((nFirstAttribute > m_nAttributeCount) || (nAttributeCount > m_nAttributeCount - nFirstAttribute))
+			return false;
+		pManifestEntry.arrAttributes.resize(nAttributeCount);
+		for (uint32_t nAttribute = 0; nAttribute < nAttributeCount; nAttribute++)
+		{
+			const uint8_t* pAttribute = m_pData + m_nAttributes + static_cast<size_t>(nFirstAttribute + nAttribute) * BINARY_MANIFEST_ATTRIBUTE_SIZE;
+			auto& pManifestAttribute = pManifestEntry.arrAttributes[nAttribute];
+			if (!GetString(ReadUInt32(pAttribute), ReadUInt32(pAttribute + 4), pManifestAttribute.first) || !GetBlob(ReadUInt32(pAttribute + 8), ReadUInt32(pAttribute + 12), pManifestAttribute.second))
+				return false;
+		}
+	}
+	return true;
+}
+
+bool CBinaryManifest::Open(const uint8_t* pData, size_t nSize)
+{
+	m_pData = pData;
+	m_nSize = nSize;
+	if ((nSize < BINARY_MANIFEST_HEADER_SIZE) || (ReadUInt32(pData) != BINARY_MANIFEST_MAGIC))
+		return Fail("The file is not a binary manifest");
+	const uint32_t nVersion = ReadUInt32(pData + 4);
+	const size_t nHeaderSize = nVersion >> 16;
+	if (((nVersion & 0xFFFF) != BINARY_MANIFEST_VERSION) || (nHeaderSize < BINARY_MANIFEST_HEADER_SIZE) || (nHeaderSize > nSize))
+		return Fail("The binary manifest has an unsupported version");
+	m_nProductCount = ReadUInt32(pData + 8);
+	m_nEntryCount = ReadUInt32(pData + 12);
+	m_nAttributeCount = ReadUInt32(pData + 16);
+	m_nStringPoolSize = ReadUInt32(pData + 20);
+	m_nBlobPoolSize = ReadUInt32(pData + 24);
+
+	// The tables and the pools follow each other up to the end of the file, so their sizes add up to the file size
+	const unsigned long long nEntries = nHeaderSize + static_cast<unsigned long long>(m_nProductCount) * BINARY_MANIFEST_PRODUCT_SIZE;
+	const unsigned long long nAttributes = nEntries + static_cast<unsigned long long>(m_nEntryCount) * BINARY_MANIFEST_ENTRY_SIZE;
+	const unsigned long long nStrings = nAttributes + static_cast<unsigned long long>(m_nAttributeCount) * BINARY_MANIFEST_ATTRIBUTE_SIZE;
+	const unsigned long long nBlobs = nStrings + m_nStringPoolSize;
+	if (nBlobs + m_nBlobPoolSize != nSize)
+		return Fail("The binary manifest is truncated");
+	m_nProducts = nHeaderSize;
+	m_nEntries = static_cast<size_t>(nEntries);
+	m_nAttributes = static_cast<size_t>(nAttributes);
+	m_nStrings = static_cast<size_t>(nStrings);
+	m_nBlobs = static_cast<size_t>(nBlobs);
+	m_strError.clear();
+	return true;
+}
+
+bool CBinaryManifest::Fail(const std::string& strError)
+{
+	Clear();
+	m_strError = strError;
+	return false;
+}
+
+bool CBinaryManifest::GetString(uint32_t nOffset, uint32_t nLength, std::string& strValue) const
+{
+	if ((nOffset > m_nStringPoolSize) || (nLength > m_nStringPoolSize - nOffset))
+		return false;
+	strValue.assign(reinterpret_cast<const char*>(m_pData + m_nStrings + nOffset), nLength);
+	return true;
+}
+
+bool CBinaryManifest::GetBlob(uint32_t nOffset, uint32_t nLength, std::string& strValue) const
+{
+	if ((nOffset > m_nBlobPoolSize) || (nLength > m_nBlobPoolSize - nOffset))
+		return false;
+	strValue.assign(reinterpret_cast<const char*>(m_pData + m_nBlobs + nOffset), nLength);
+	return true;
+}
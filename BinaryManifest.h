@@ -0,0 +1,172 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include "ManifestReader.h"
+#include "XMLDocument.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+const uint32_t BINARY_MANIFEST_MAGIC = 0x4D345547;       ///< "GU4M", the first bytes of a binary manifest.
+const uint16_t BINARY_MANIFEST_VERSION = 1;              ///< Version of the layout below; readers reject other versions.
+const size_t BINARY_MANIFEST_HEADER_SIZE = 32;           ///< Size of the header of version 1.
+const size_t BINARY_MANIFEST_PRODUCT_SIZE = 24;          ///< Size of a record of the product table.
+const size_t BINARY_MANIFEST_ENTRY_SIZE = 24;            ///< Size of a record of the entry table.
+const size_t BINARY_MANIFEST_ATTRIBUTE_SIZE = 16;        ///< Size of a record of the attribute table.
+const size_t BINARY_MANIFEST_MAX_SIZE = 0x10000000;      ///< Largest binary manifest accepted from a Web Server (256 MiB).
+const unsigned long long BINARY_MANIFEST_RETRY_INTERVAL = 86400; ///< Seconds before a Web Server without a binary manifest is asked again (1 day).
+
+/**
+ * @brief Returns the key of a product name in the product table: the 64-bit FNV-1a hash of its UTF-8 bytes.
+ */
+uint64_t GetBinaryManifestKey(std::string_view strName);
+
+/**
+ * @brief Builds the binary manifest of a settings document: each section of the root element is a product,
+ *        each of its child elements an entry, with its text and its attributes. A product which appears more
+ *        than once keeps its first section, as CXMLAppSettings finds it.
+ * @return false if the document is empty or too large for the 32-bit offsets of the format.
+ */
+bool BuildBinaryManifest(const XML_ELEMENT* pRoot, std::vector<uint8_t>& arrManifest);
+
+/**
+ * @brief Builds the binary manifest of a settings document and writes it to a file.
+ * @return false if the manifest cannot be built or the file cannot be written.
+ */
+bool SaveBinaryManifest(const XML_ELEMENT* pRoot, const std::filesystem::path& strFilePath);
+
+/**
+ * @brief Returns the path of the record of a binary manifest which the Web Server doesn't have: the path of its
+ *        cached copy with ".missing" appended.
+ */
+std::filesystem::path GetMissingBinaryManifestFilePath(const std::filesystem::path& strCacheFilePath);
+
+/**
+ * @brief Records that the Web Server has no binary manifest at a URL, so it isn't asked again before a retry time.
+ * @param strCacheFilePath Path of the cached copy of the binary manifest.
+ * @param strURL URL of the binary manifest.
+ * @param nRetryTime When to ask again, in seconds since 1970.
+ * @return true if the record was written, false otherwise.
+ */
+bool SaveMissingBinaryManifest(const std::filesystem::path& strCacheFilePath, const std::string& strURL, unsigned long long nRetryTime);
+
+/**
+ * @brief Reports whether the Web Server is known to have no binary manifest at a URL: it is recorded as missing
+ *        for the same URL, and the retry time has not come yet.
+ * @param nNow The current time, in seconds since 1970.
+ */
+bool IsBinaryManifestMissing(const std::filesystem::path& strCacheFilePath, const std::string& strURL, unsigned long long nNow);
+
+/**
+ * @brief Removes the record of a missing binary manifest, once the Web Server has one.
+ */
+void RemoveMissingBinaryManifest(const std::filesystem::path& strCacheFilePath);
+
+/**
+ * @brief A binary manifest: the products of a configuration file laid out for lookup without parsing.
+ *
+ * All the numbers are little-endian, and all the offsets are relative to the start of their pool:
+ * - a header: magic, version (16 bits), header size (16 bits), then the number of products, entries
+ *   and attributes, and the sizes of the string and blob pools (32 bits each), padded to 32 bytes;
+ * - the product table, sorted by key (see GetBinaryManifestKey) then by name: key (64 bits), name offset
+ *   and length in the string pool, index of the first entry and number of entries (32 bits each);
+ * - the entry table: name offset and length in the string pool, value offset and length in the blob pool,
+ *   index of the first attribute and number of attributes;
+ * - the attribute table: name offset and length in the string pool, value offset and length in the blob pool;
+ * - the string pool, with the names of the products, entries and attributes, each stored once;
+ * - the blob pool, with the values of the entries and attributes.
+ *
+ * Loading only checks the header and the size of the tables; a lookup is a binary search of the product
+ * table, which checks the records it reads, so a large catalog costs O(log n) per product and nothing else.
+ */
+class CBinaryManifest
+{
+public:
+	CBinaryManifest() : m_pData(nullptr), m_nSize(0), m_bMapped(false), m_nProductCount(0), m_nEntryCount(0), m_nAttributeCount(0),
+		m_nStringPoolSize(0), m_nBlobPoolSize(0), m_nProducts(0), m_nEntries(0), m_nAttributes(0), m_nStrings(0), m_nBlobs(0) {}
+	~CBinaryManifest() { Clear(); }
+	CBinaryManifest(const CBinaryManifest&) = delete;
+	CBinaryManifest& operator=(const CBinaryManifest&) = delete;
+
+	/**
+	 * @brief Loads a binary manifest from memory, replacing the current one.
+	 * @return false if it is not a binary manifest of this version, or it is truncated.
+	 */
+	bool Load(std::vector<uint8_t> arrManifest);
+
+	/**
+	 * @brief Maps a binary manifest file into memory, replacing the current one; it stays mapped until Clear.
+	 * @return false if the file cannot be mapped, or it is not a binary manifest of this version.
+	 */
+	bool LoadFile(const std::filesystem::path& strFilePath);
+
+	/**
+	 * @brief Releases the manifest.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns why the last Load or LoadFile failed.
+	 */
+	const std::string& GetError() const { return m_strError; }
+
+	/**
+	 * @brief Returns the number of products of the manifest.
+	 */
+	size_t GetProductCount() const { return m_nProductCount; }
+
+	/**
+	 * @brief Finds a product and returns its entries, in the order of its section.
+	 * @return false if the manifest has no such product, or its records are out of bounds.
+	 */
+	bool FindProduct(std::string_view strName, std::vector<MANIFEST_ENTRY>& arrEntries) const;
+
+private:
+	bool Open(const uint8_t* pData, size_t nSize);
+	bool Fail(const std::string& strError);
+	bool GetString(uint32_t nOffset, uint32_t nLength, std::string& strValue) const;
+	bool GetBlob(uint32_t nOffset, uint32_t nLength, std::string& strValue) const;
+
+	std::vector<uint8_t> m_arrBuffer; ///< The manifest, when it was loaded from memory
+	const uint8_t* m_pData;           ///< The manifest, in m_arrBuffer or mapped
+	size_t m_nSize;
+	bool m_bMapped;
+	uint32_t m_nProductCount;
+	uint32_t m_nEntryCount;
+	uint32_t m_nAttributeCount;
+	uint32_t m_nStringPoolSize;
+	uint32_t m_nBlobPoolSize;
+	size_t m_nProducts;   ///< Offset of the product table
+	size_t m_nEntries;    ///< Offset of the entry table
+	size_t m_nAttributes; ///< Offset of the attribute table
+	size_t m_nStrings;    ///< Offset of the string pool
+	size_t m_nBlobs;      ///< Offset of the blob pool
+	std::string m_strError;
+};
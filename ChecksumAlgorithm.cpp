@@ -0,0 +1,134 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#include "ChecksumAlgorithm.h"
+#include "SHA256.h"
+#include "SHA2.h"
+#include "BLAKE3.h"
+
+namespace
+{
+	/**
+	 * @brief Adapts a hash class with the interface of SHA256 (update and digest).
+	 */
+	template <typename Hash>
+	class CHashAlgorithm : public IChecksumAlgorithm
+	{
+	public:
+		explicit CHashAlgorithm(const char* lpszName) : m_lpszName(lpszName) {}
+
+		const char* GetName() const override { return m_lpszName; }
+		void Update(const uint8_t* pData, size_t nLength) override { m_pHash.update(pData, nLength); }
+		DigestValue Finish() override { return m_pHash.digest(); }
+
+		// Only hashes with saveState and loadState (SHA256) can be checkpointed
+		bool SaveState(std::vector<uint8_t>& arrState) const override
+		{
+			if constexpr (requires { m_pHash.saveState(); })
+			{
+				const auto state = m_pHash.saveState();
+				arrState.assign(state.begin(), state.end());
+				return true;
+			}
+			else
+			{
+				return IChecksumAlgorithm::SaveState(arrState);
+			}
+		}
+
+		bool LoadState(const std::vector<uint8_t>& arrState) override
+		{
+			if constexpr (requires { m_pHash.loadState(arrState.data(), arrState.size()); })
+			{
+				return m_pHash.loadState(arrState.data(), arrState.size());
+			}
+			else
+			{
+				return IChecksumAlgorithm::LoadState(arrState);
+			}
+		}
+
+	private:
+		const char* m_lpszName;
+		Hash m_pHash;
+	};
+
+	/**
+	 * @brief Compares two ASCII strings, ignoring case.
+	 */
+	bool EqualsNoCase(const std::string& strLeft, const char* lpszRight)
+	{
+		size_t nIndex = 0;
+		for (; (nIndex < strLeft.size()) && (lpszRight[nIndex] != '\0'); nIndex++)
+		{
+			const char chLeft = ((strLeft[nIndex] >= 'a') && (strLeft[nIndex] <= 'z')) ? strLeft[nIndex] - 'a' + 'A' : strLeft[nIndex];
+			const char chRight = ((lpszRight[nIndex] >= 'a') && (lpszRight[nIndex] <= 'z')) ? lpszRight[nIndex] - 'a' + 'A' : lpszRight[nIndex];
+			if (chLeft != chRight)
+			{
+				return false;
+			}
+		}
+		return (nIndex == strLeft.size()) && (lpszRight[nIndex] == '\0');
+	}
+}
+
+const char* GetChecksumAlgorithmName(const std::string& strName)
+{
+	if (strName.empty())
+	{
+		return CHECKSUM_ALGORITHM_NAME_SHA256;
+	}
+	for (const char* lpszName : { CHECKSUM_ALGORITHM_NAME_SHA256, CHECKSUM_ALGORITHM_NAME_SHA512, CHECKSUM_ALGORITHM_NAME_SHA512_256, CHECKSUM_ALGORITHM_NAME_BLAKE3 })
+	{
+		if (EqualsNoCase(strName, lpszName))
+		{
+			return lpszName;
+		}
+	}
+	return nullptr;
+}
+
+std::unique_ptr<IChecksumAlgorithm> CreateChecksumAlgorithm(const std::string& strName)
+{
+	const char* lpszName = GetChecksumAlgorithmName(strName);
+	if (lpszName == nullptr)
+	{
+		return nullptr;
+	}
+
+	const std::string strCanonical(lpszName);
+	if (strCanonical == CHECKSUM_ALGORITHM_NAME_SHA256)
+	{
+		return std::make_unique<CHashAlgorithm<SHA256>>(lpszName); // Hardware accelerated where the CPU allows it
+	}
+	if (strCanonical == CHECKSUM_ALGORITHM_NAME_SHA512)
+	{
+		return std::make_unique<CHashAlgorithm<SHA512>>(lpszName);
+	}
+	if (strCanonical == CHECKSUM_ALGORITHM_NAME_SHA512_256)
+	{
+		return std::make_unique<CHashAlgorithm<SHA512_256>>(lpszName);
+	}
+	return std::make_unique<CHashAlgorithm<BLAKE3>>(lpszName); // SIMD lanes and all cores
+}
@@ -0,0 +1,104 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <vector>
+#include "DigestValue.h"
+
+/**
+ * @brief Names of the supported checksum algorithms, as written in the alg attribute of the Checksum entry.
+ */
+#define CHECKSUM_ALGORITHM_NAME_SHA256 "SHA-256"
+#define CHECKSUM_ALGORITHM_NAME_SHA512 "SHA-512"
+#define CHECKSUM_ALGORITHM_NAME_SHA512_256 "SHA-512/256"
+#define CHECKSUM_ALGORITHM_NAME_BLAKE3 "BLAKE3"
+
+/**
+ * @brief A checksum algorithm; data is fed in blocks, then the checksum is taken once.
+ */
+class IChecksumAlgorithm
+{
+public:
+	virtual ~IChecksumAlgorithm() = default;
+
+	/**
+	 * @brief Returns the canonical name of the algorithm (e.g. CHECKSUM_ALGORITHM_NAME_SHA256).
+	 */
+	virtual const char* GetName() const = 0;
+
+	/**
+	 * @brief Hashes the next block of data.
+	 * @param pData Pointer to the data.
+	 * @param nLength Length of the data in bytes.
+	 */
+	virtual void Update(const uint8_t* pData, size_t nLength) = 0;
+
+	/**
+	 * @brief Finishes the calculation; the object can't be updated afterwards.
+	 * @return The checksum.
+	 */
+	virtual DigestValue Finish() = 0;
+
+	/**
+	 * @brief Exports the state of the calculation, so that it can be continued later by LoadState.
+	 * @param arrState Output: receives the state.
+	 * @return false if the algorithm can't export its state.
+	 */
+	virtual bool SaveState(std::vector<uint8_t>& arrState) const
+	{
+		arrState.clear();
+		return false;
+	}
+
+	/**
+	 * @brief Continues a calculation from a state exported by SaveState.
+	 * @param arrState The state.
+	 * @return false if the state is not valid for this algorithm; the calculation is then unchanged.
+	 */
+	virtual bool LoadState(const std::vector<uint8_t>& arrState)
+	{
+		(void)arrState;
+		return false;
+	}
+};
+
+/**
+ * @brief Returns the canonical name of a checksum algorithm, ignoring case.
+ *        An empty name means SHA-256, the algorithm of configuration files that don't name one.
+ * @param strName The algorithm name (e.g. "blake3").
+ * @return The canonical name, or nullptr if the algorithm is not supported.
+ */
+const char* GetChecksumAlgorithmName(const std::string& strName);
+
+/**
+ * @brief Creates a checksum algorithm by name (see GetChecksumAlgorithmName).
+ * @param strName The algorithm name.
+ * @return The new algorithm, or nullptr if the algorithm is not supported.
+ */
+std::unique_ptr<IChecksumAlgorithm> CreateChecksumAlgorithm(const std::string& strName);
@@ -0,0 +1,291 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#include "ChecksumCache.h"
+
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+const char CHECKSUM_CACHE_SIGNATURE[] = "genUp4win checksum cache 1"; ///< First line of the cache file; anything else is ignored.
+
+/**
+ * @brief Converts a path to UTF-8, the encoding used in the cache file.
+ */
+static std::string PathToUTF8(const std::filesystem::path& strFilePath)
+{
+	const auto strUTF8 = strFilePath.u8string();
+	return std::string(strUTF8.begin(), strUTF8.end());
+}
+
+CChecksumCache::CChecksumCache(std::filesystem::path strCacheFilePath, size_t nMaxEntries)
+	: m_strCacheFilePath(std::move(strCacheFilePath)), m_nMaxEntries(nMaxEntries)
+{
+}
+
+CChecksumCache::~CChecksumCache()
+{
+	try
+	{
+		Save();
+	}
+	catch (...)
+	{
+		// The cache is only an optimization; losing an update is harmless
+	}
+}
+
+bool CChecksumCache::GetIdentity(const std::filesystem::path& strFilePath, CFileIdentity& pIdentity)
+{
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(strFilePath.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	BY_HANDLE_FILE_INFORMATION pFileInfo{};
+	const bool retVal = (GetFileInformationByHandle(hFile, &pFileInfo) != FALSE);
+	CloseHandle(hFile);
+	if (!retVal)
+	{
+		return false;
+	}
+	pIdentity.nSize = (static_cast<unsigned long long>(pFileInfo.nFileSizeHigh) << 32) | pFileInfo.nFileSizeLow;
+	pIdentity.nModified = (static_cast<unsigned long long>(pFileInfo.ftLastWriteTime.dwHighDateTime) << 32) | pFileInfo.ftLastWriteTime.dwLowDateTime;
+	pIdentity.strFileId = std::to_string(pFileInfo.dwVolumeSerialNumber) + ":" +
+		std::to_string((static_cast<unsigned long long>(pFileInfo.nFileIndexHigh) << 32) | pFileInfo.nFileIndexLow);
+#else
+	struct stat pStat {};
+	if ((stat(strFilePath.c_str(), &pStat) != 0) || !S_ISREG(pStat.st_mode))
+	{
+		return false;
+	}
+	pIdentity.nSize = static_cast<unsigned long long>(pStat.st_size);
+	pIdentity.nModified = static_cast<unsigned long long>(pStat.st_mtim.tv_sec) * 1000000000ULL + static_cast<unsigned long long>(pStat.st_mtim.tv_nsec);
+	pIdentity.strFileId = std::to_string(static_cast<unsigned long long>(pStat.st_dev)) + ":" +
+		std::to_string(static_cast<unsigned long long>(pStat.st_ino));
+#endif
+	return true;
+}
+
+std::string CChecksumCache::GetKey(const std::filesystem::path& strFilePath, const std::string& strKind)
+{
+	std::error_code ec;
+	std::filesystem::path strCanonicalPath = std::filesystem::weakly_canonical(strFilePath, ec);
+	if (ec)
+	{
+		strCanonicalPath = std::filesystem::absolute(strFilePath, ec);
+	}
+	return strKind + '\t' + PathToUTF8(strCanonicalPath);
+}
+
+void CChecksumCache::Load()
+{
+	if (m_bLoaded)
+	{
+		return;
+	}
+	m_bLoaded = true;
+
+	std::ifstream pCacheFile(m_strCacheFilePath, std::ios::in);
+	std::string strLine;
+	if (!pCacheFile.is_open() || !std::getline(pCacheFile, strLine) || (strLine != CHECKSUM_CACHE_SIGNATURE))
+	{
+		return;
+	}
+
+	// Each line is: size, modification time, file id, checksum, kind, path; separated by tabs
+	while (std::getline(pCacheFile, strLine))
+	{
+		std::istringstream pFields(strLine);
+		CEntry pEntry;
+		std::string strSize, strModified;
+		if (!std::getline(pFields, strSize, '\t') || !std::getline(pFields, strModified, '\t') ||
+			!std::getline(pFields, pEntry.pIdentity.strFileId, '\t') || !std::getline(pFields, pEntry.strChecksum, '\t') ||
+			!std::getline(pFields, pEntry.strKey) || (pEntry.strKey.find('\t') == std::string::npos))
+		{
+			continue;
+		}
+		try
+		{
+			pEntry.pIdentity.nSize = std::stoull(strSize);
+			pEntry.pIdentity.nModified = std::stoull(strModified);
+		}
+		catch (const std::exception&)
+		{
+			continue;
+		}
+
+		const auto it = m_mapEntries.find(pEntry.strKey);
+		if (it != m_mapEntries.end())
+		{
+			m_arrEntries.erase(it->second);
+		}
+		m_arrEntries.push_back(std::move(pEntry));
+		m_mapEntries[m_arrEntries.back().strKey] = std::prev(m_arrEntries.end());
+	}
+
+	while (m_arrEntries.size() > m_nMaxEntries)
+	{
+		m_mapEntries.erase(m_arrEntries.front().strKey);
+		m_arrEntries.pop_front();
+		m_bDirty = true;
+	}
+}
+
+void CChecksumCache::Save()
+{
+	if (!m_bDirty)
+	{
+		return;
+	}
+
+	// Write a new file and swap it in, so a crash or a concurrent reader never sees half of it
+	std::filesystem::path strTempFilePath{ m_strCacheFilePath };
+	strTempFilePath += ".tmp";
+	{
+		std::ofstream pCacheFile(strTempFilePath, std::ios::out | std::ios::trunc);
+		if (!pCacheFile.is_open())
+		{
+			return;
+		}
+		pCacheFile << CHECKSUM_CACHE_SIGNATURE << '\n';
+		for (const CEntry& pEntry : m_arrEntries)
+		{
+			pCacheFile << pEntry.pIdentity.nSize << '\t' << pEntry.pIdentity.nModified << '\t'
+				<< pEntry.pIdentity.strFileId << '\t' << pEntry.strChecksum << '\t' << pEntry.strKey << '\n';
+		}
+		if (!pCacheFile.flush())
+		{
+			pCacheFile.close();
+			std::error_code ec;
+			std::filesystem::remove(strTempFilePath, ec);
+			return;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename(strTempFilePath, m_strCacheFilePath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(strTempFilePath, ec);
+	}
+	else
+	{
+		m_bDirty = false;
+	}
+}
+
+bool CChecksumCache::Lookup(const std::filesystem::path& strFilePath, const std::string& strKind, std::string& strChecksum)
+{
+	Load();
+	const auto it = m_mapEntries.find(GetKey(strFilePath, strKind));
+	if (it == m_mapEntries.end())
+	{
+		return false;
+	}
+
+	CFileIdentity pIdentity;
+	if (!GetIdentity(strFilePath, pIdentity) || !(pIdentity == it->second->pIdentity))
+	{
+		// The file was changed, replaced or removed since it was hashed
+		m_arrEntries.erase(it->second);
+		m_mapEntries.erase(it);
+		m_bDirty = true;
+		return false;
+	}
+
+	if (std::next(it->second) != m_arrEntries.end())
+	{
+		m_arrEntries.splice(m_arrEntries.end(), m_arrEntries, it->second);
+		m_bDirty = true;
+	}
+	strChecksum = it->second->strChecksum;
+	return true;
+}
+
+bool CChecksumCache::Store(const std::filesystem::path& strFilePath, const std::string& strKind, const std::string& strChecksum, const CFileIdentity& pHashedIdentity)
+{
+	Load();
+	CEntry pEntry;
+	pEntry.strKey = GetKey(strFilePath, strKind);
+	pEntry.strChecksum = strChecksum;
+	// Tabs and line breaks would corrupt the cache file, so such files are simply not cached
+	if ((m_nMaxEntries == 0) || (pEntry.strKey.find_first_of("\r\n") != std::string::npos) ||
+		(strKind.find_first_of("\t\r\n") != std::string::npos) || (strChecksum.find_first_of("\t\r\n") != std::string::npos) ||
+		!GetIdentity(strFilePath, pEntry.pIdentity))
+	{
+		return false;
+	}
+	// A file rewritten while it was hashed would be cached with a checksum of its old content
+	if (!(pEntry.pIdentity == pHashedIdentity))
+	{
+		return false;
+	}
+
+	const auto it = m_mapEntries.find(pEntry.strKey);
+	if (it != m_mapEntries.end())
+	{
+		m_arrEntries.erase(it->second);
+		m_mapEntries.erase(it);
+	}
+	m_arrEntries.push_back(std::move(pEntry));
+	m_mapEntries[m_arrEntries.back().strKey] = std::prev(m_arrEntries.end());
+	while (m_arrEntries.size() > m_nMaxEntries)
+	{
+		m_mapEntries.erase(m_arrEntries.front().strKey);
+		m_arrEntries.pop_front();
+	}
+	m_bDirty = true;
+	Save();
+	return true;
+}
+
+void CChecksumCache::Invalidate(const std::filesystem::path& strFilePath)
+{
+	Load();
+	// The key is the kind, a tab, then the path; drop the file's entries of every kind
+	const std::string strPath = GetKey(strFilePath, std::string());
+	for (auto it = m_arrEntries.begin(); it != m_arrEntries.end();)
+	{
+		const size_t nSeparator = it->strKey.find('\t');
+		if (it->strKey.compare(nSeparator, std::string::npos, strPath) == 0)
+		{
+			m_mapEntries.erase(it->strKey);
+			it = m_arrEntries.erase(it);
+			m_bDirty = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
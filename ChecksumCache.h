@@ -0,0 +1,119 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#pragma once
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <filesystem>
+
+const size_t CHECKSUM_CACHE_MAX_ENTRIES = 256; ///< Default number of checksums kept in the cache file.
+
+/**
+ * @brief Persistent cache of file checksums, keyed by canonical path and checksum kind.
+ *
+ * Each entry also records the size, modification time and file id (volume serial + file index on
+ * Windows, device + inode elsewhere) of the file when it was hashed; if any of them changed, the
+ * entry is dropped on lookup. The least recently used entries are evicted beyond the size cap.
+ * The cache file is a small text file, rewritten atomically when the cache changes.
+ */
+class CChecksumCache
+{
+public:
+	/**
+	 * @brief What identifies a version of a file on disk.
+	 */
+	struct CFileIdentity
+	{
+		unsigned long long nSize = 0;
+		unsigned long long nModified = 0;
+		std::string strFileId;
+
+		bool operator==(const CFileIdentity& other) const
+		{
+			return (nSize == other.nSize) && (nModified == other.nModified) && (strFileId == other.strFileId);
+		}
+	};
+
+	/**
+	 * @brief Constructor. The cache file is loaded on first use.
+	 * @param strCacheFilePath Path to the cache file.
+	 * @param nMaxEntries Maximum number of entries kept.
+	 */
+	CChecksumCache(std::filesystem::path strCacheFilePath, size_t nMaxEntries = CHECKSUM_CACHE_MAX_ENTRIES);
+	~CChecksumCache();
+
+	CChecksumCache(const CChecksumCache&) = delete;
+	CChecksumCache& operator=(const CChecksumCache&) = delete;
+
+	/**
+	 * @brief Looks up the checksum of a file.
+	 * @param strFilePath The file whose checksum is wanted.
+	 * @param strKind Which checksum (e.g. "sha256"), so different algorithms don't collide.
+	 * @param strChecksum Output: receives the cached checksum.
+	 * @return true if a still valid entry was found, false otherwise.
+	 */
+	bool Lookup(const std::filesystem::path& strFilePath, const std::string& strKind, std::string& strChecksum);
+
+	/**
+	 * @brief Records the checksum of a file and saves the cache file.
+	 * @param pHashedIdentity The identity of the file taken before it was hashed (see GetIdentity).
+	 * @return false if the file is no longer the one which was hashed (or cannot be cached); nothing is stored then.
+	 */
+	bool Store(const std::filesystem::path& strFilePath, const std::string& strKind, const std::string& strChecksum, const CFileIdentity& pHashedIdentity);
+
+	/**
+	 * @brief Removes all entries of a file.
+	 */
+	void Invalidate(const std::filesystem::path& strFilePath);
+
+	/**
+	 * @brief Writes the cache file if it has changed since it was loaded.
+	 */
+	void Save();
+
+	/**
+	 * @brief Reads the size, modification time and file id of a file.
+	 * @return false if the file cannot be found or is not a regular file.
+	 */
+	static bool GetIdentity(const std::filesystem::path& strFilePath, CFileIdentity& pIdentity);
+
+private:
+	struct CEntry
+	{
+		std::string strKey; ///< Kind and canonical path
+		CFileIdentity pIdentity;
+		std::string strChecksum;
+	};
+
+	static std::string GetKey(const std::filesystem::path& strFilePath, const std::string& strKind);
+	void Load();
+
+	std::filesystem::path m_strCacheFilePath;
+	size_t m_nMaxEntries;
+	bool m_bLoaded = false;
+	bool m_bDirty = false;
+	std::list<CEntry> m_arrEntries; ///< Least recently used first
+	std::unordered_map<std::string, std::list<CEntry>::iterator> m_mapEntries;
+};
@@ -0,0 +1,203 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+
+#ifndef DIGEST_VALUE_H
+#define DIGEST_VALUE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <array>
+#include <type_traits>
+
+/**
+ * @brief A hash digest of up to 64 bytes, held by value. Hexadecimal text is parsed and formatted
+ *        through lookup tables, and digests are compared as raw bytes in constant time, so
+ *        "ABCD..." from a hand-edited configuration file matches "abcd...".
+ */
+class DigestValue {
+
+public:
+	static constexpr size_t MaxSize = 64; // SHA-512
+
+	DigestValue() = default;
+
+	DigestValue(const uint8_t* data, size_t size) {
+		assign(data, size);
+	}
+
+	template <size_t N>
+	DigestValue(const std::array<uint8_t, N>& digest) {
+		static_assert(N <= MaxSize, "digest too large");
+		assign(digest.data(), N);
+	}
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	const uint8_t* data() const { return m_bytes.data(); }
+
+	void clear() {
+		m_bytes.fill(0);
+		m_size = 0;
+	}
+
+	/**
+	 * @brief Parses hexadecimal text in either case; whitespace around it is ignored.
+	 * @return false if the text is empty, has an odd length, a non-hexadecimal character or
+	 *         more than MaxSize bytes; the digest is then cleared.
+	 */
+	template <typename Char>
+	bool parse(std::basic_string_view<Char> hex) {
+		clear();
+		while (!hex.empty() && isSpace(hex.front())) {
+			hex.remove_prefix(1);
+		}
+		while (!hex.empty() && isSpace(hex.back())) {
+			hex.remove_suffix(1);
+		}
+		if (hex.empty() || (hex.size() % 2 != 0) || (hex.size() > 2 * MaxSize)) {
+			return false;
+		}
+
+		if (!parseHex(hex, m_bytes.data())) {
+			clear();
+			return false;
+		}
+		m_size = hex.size() / 2;
+		return true;
+	}
+
+	bool parse(const std::string& hex) { return parse(std::string_view(hex)); }
+	bool parse(const std::wstring& hex) { return parse(std::wstring_view(hex)); }
+
+	/**
+	 * @brief Writes the digest as lowercase hexadecimal text; out must have room for 2 * size() characters.
+	 */
+	template <typename Char>
+	void format(Char* out) const {
+		formatHex(m_bytes.data(), m_size, out);
+	}
+
+	std::string toString() const {
+		std::string s(2 * m_size, '0');
+		format(s.data());
+		return s;
+	}
+
+	std::wstring toWString() const {
+		std::wstring s(2 * m_size, L'0');
+		format(s.data());
+		return s;
+	}
+
+	/**
+	 * @brief Compares all MaxSize bytes whatever the contents, so the time taken doesn't tell
+	 *        how many leading bytes matched.
+	 */
+	friend bool operator==(const DigestValue& left, const DigestValue& right) {
+		uint8_t difference = (left.m_size != right.m_size) ? 1 : 0;
+		for (size_t i = 0; i < MaxSize; i++) {
+			difference |= left.m_bytes[i] ^ right.m_bytes[i];
+		}
+		return difference == 0;
+	}
+
+	friend bool operator!=(const DigestValue& left, const DigestValue& right) {
+		return !(left == right);
+	}
+
+	/**
+	 * @brief Parses hexadecimal text in either case, without any whitespace, into hex.size() / 2 bytes at out;
+	 *        unlike parse, there is no limit on the length, e.g. for saved hash states.
+	 * @return false if the length is odd or a character is not hexadecimal; out may then be partly written.
+	 */
+	template <typename Char>
+	static bool parseHex(std::basic_string_view<Char> hex, uint8_t* out) {
+		if (hex.size() % 2 != 0) {
+			return false;
+		}
+		uint8_t invalid = 0;
+		for (size_t i = 0; i < hex.size() / 2; i++) {
+			const uint8_t high = nibble(hex[2 * i]);
+			const uint8_t low = nibble(hex[2 * i + 1]);
+			invalid |= (high | low) & 0x10;
+			out[i] = static_cast<uint8_t>((high << 4) | (low & 0x0f));
+		}
+		return invalid == 0;
+	}
+
+	/**
+	 * @brief Writes size bytes as lowercase hexadecimal text; out must have room for 2 * size characters.
+	 */
+	template <typename Char>
+	static void formatHex(const uint8_t* data, size_t size, Char* out) {
+		static constexpr char hex[] = "0123456789abcdef";
+		for (size_t i = 0; i < size; i++) {
+			out[2 * i] = static_cast<Char>(hex[data[i] >> 4]);
+			out[2 * i + 1] = static_cast<Char>(hex[data[i] & 15]);
+		}
+	}
+
+private:
+	std::array<uint8_t, MaxSize> m_bytes = { 0, }; // Unused bytes stay zero, the comparison relies on it
+	size_t m_size = 0;
+
+	void assign(const uint8_t* data, size_t size) {
+		m_bytes.fill(0);
+		m_size = (size < MaxSize) ? size : MaxSize;
+		memcpy(m_bytes.data(), data, m_size);
+	}
+
+	// Value of each character, with 0x10 set for anything that is not a hexadecimal digit
+	static constexpr std::array<uint8_t, 256> HexTable = []() {
+		std::array<uint8_t, 256> table{};
+		for (size_t c = 0; c < 256; c++) {
+			table[c] = 0x10;
+		}
+		for (uint8_t c = 0; c < 10; c++) {
+			table['0' + c] = c;
+		}
+		for (uint8_t c = 0; c < 6; c++) {
+			table['a' + c] = static_cast<uint8_t>(10 + c);
+			table['A' + c] = static_cast<uint8_t>(10 + c);
+		}
+		return table;
+	}();
+
+	template <typename Char>
+	static uint8_t nibble(Char c) {
+		const auto code = static_cast<std::make_unsigned_t<Char>>(c);
+		return (code < 256) ? HexTable[code] : 0x10;
+	}
+
+	template <typename Char>
+	static bool isSpace(Char c) {
+		return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+	}
+};
+
+#endif
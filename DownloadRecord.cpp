@@ -0,0 +1,140 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+
+#include "DownloadRecord.h"
+#include "SegmentedDownloader.h"
+
+#include <fstream>
+#include <system_error>
+
+const char DOWNLOAD_RECORD_SIGNATURE[] = "genUp4win download record 1"; ///< First line of the record file; anything else is ignored.
+
+std::filesystem::path GetDownloadRecordFilePath(const std::filesystem::path& strPartialFilePath)
+{
+	std::filesystem::path strRecordFilePath{ strPartialFilePath };
+	strRecordFilePath += ".download";
+	return strRecordFilePath;
+}
+
+void SetDownloadRecordResponse(DOWNLOAD_RECORD& pRecord, const TRANSPORT_RESPONSE& pResponse, unsigned long long nOffset)
+{
+	const std::string* pETag = FindTransportHeader(pResponse.arrHeaders, "ETag");
+	const std::string* pLastModified = FindTransportHeader(pResponse.arrHeaders, "Last-Modified");
+	pRecord.strETag = (pETag != nullptr) ? *pETag : std::string();
+	pRecord.strLastModified = (pLastModified != nullptr) ? *pLastModified : std::string();
+
+	// The size of the whole file is in the Content-Range of a partial response
+	const std::string* pContentRange = FindTransportHeader(pResponse.arrHeaders, "Content-Range");
+	unsigned long long nFirst = 0, nLast = 0, nTotal = 0;
+	if ((pResponse.nStatusCode == 206) && (pContentRange != nullptr) && ParseContentRange(*pContentRange, nFirst, nLast, nTotal))
+		pRecord.nExpectedSize = nTotal;
+	else if (pResponse.nContentLength != TRANSPORT_UNKNOWN_LENGTH)
+		pRecord.nExpectedSize = pResponse.nContentLength + nOffset;
+	else
+		pRecord.nExpectedSize = TRANSPORT_UNKNOWN_LENGTH;
+}
+
+std::string GetDownloadRecordValidator(const DOWNLOAD_RECORD& pRecord)
+{
+	// A weak ETag cannot validate a range
+	if (!pRecord.strETag.empty() && (pRecord.strETag.compare(0, 2, "W/") != 0))
+		return pRecord.strETag;
+	return pRecord.strLastModified;
+}
+
+bool SaveDownloadRecord(const std::filesystem::path& strPartialFilePath, const DOWNLOAD_RECORD& pRecord)
+{
+	// A line break would split a field into two lines
+	for (const std::string* pField : { &pRecord.strURL, &pRecord.strETag, &pRecord.strLastModified })
+	{
+		if (pField->find_first_of("\r\n") != std::string::npos)
+			return false;
+	}
+
+	// Write a new file and swap it in, so a crash never leaves half a record behind
+	const std::filesystem::path strRecordFilePath{ GetDownloadRecordFilePath(strPartialFilePath) };
+	std::filesystem::path strTempFilePath{ strRecordFilePath };
+	strTempFilePath += ".tmp";
+	{
+		std::ofstream pRecordFile(strTempFilePath, std::ios::out | std::ios::trunc);
+		if (!pRecordFile.is_open())
+			return false;
+		pRecordFile << DOWNLOAD_RECORD_SIGNATURE << '\n' << pRecord.strURL << '\n' << pRecord.strETag << '\n' << pRecord.strLastModified << '\n';
+		if (pRecord.nExpectedSize != TRANSPORT_UNKNOWN_LENGTH)
+			pRecordFile << pRecord.nExpectedSize;
+		pRecordFile << '\n' << pRecord.nBytesDone << '\n';
+		if (!pRecordFile.flush())
+		{
+			pRecordFile.close();
+			std::error_code ec;
+			std::filesystem::remove(strTempFilePath, ec);
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename(strTempFilePath, strRecordFilePath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(strTempFilePath, ec);
+		return false;
+	}
+	return true;
+}
+
+bool LoadDownloadRecord(const std::filesystem::path& strPartialFilePath, DOWNLOAD_RECORD& pRecord)
+{
+	// The lines are: signature, URL, ETag, Last-Modified, expected size (empty if unknown), bytes done
+	std::ifstream pRecordFile(GetDownloadRecordFilePath(strPartialFilePath), std::ios::in);
+	std::string strLine, strExpectedSize, strBytesDone;
+	DOWNLOAD_RECORD pLoaded;
+	if (!pRecordFile.is_open() || !std::getline(pRecordFile, strLine) || (strLine != DOWNLOAD_RECORD_SIGNATURE) ||
+		!std::getline(pRecordFile, pLoaded.strURL) || !std::getline(pRecordFile, pLoaded.strETag) ||
+		!std::getline(pRecordFile, pLoaded.strLastModified) || !std::getline(pRecordFile, strExpectedSize) ||
+		!std::getline(pRecordFile, strBytesDone))
+		return false;
+
+	try
+	{
+		pLoaded.nExpectedSize = strExpectedSize.empty() ? TRANSPORT_UNKNOWN_LENGTH : std::stoull(strExpectedSize);
+		pLoaded.nBytesDone = std::stoull(strBytesDone);
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+
+	std::error_code ec;
+	const unsigned long long nFileSize = std::filesystem::file_size(strPartialFilePath, ec);
+	if (ec || (nFileSize < pLoaded.nBytesDone) || (pLoaded.nBytesDone > pLoaded.nExpectedSize))
+		return false;
+	pRecord = pLoaded;
+	return true;
+}
+
+void RemoveDownloadRecord(const std::filesystem::path& strPartialFilePath)
+{
+	std::error_code ec;
+	std::filesystem::remove(GetDownloadRecordFilePath(strPartialFilePath), ec);
+}
@@ -0,0 +1,80 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <string>
+#include <filesystem>
+#include "Transport.h"
+
+/**
+ * @brief What is known about a partially downloaded file, so the download can be continued with a
+ *        Range request after the process restarts, if the file on the server is still the same.
+ */
+struct DOWNLOAD_RECORD
+{
+	std::string strURL;          ///< URL the file is downloaded from
+	std::string strETag;         ///< ETag of the file on the server, if it sent one
+	std::string strLastModified; ///< Last-Modified of the file on the server, if it sent one
+	unsigned long long nExpectedSize = TRANSPORT_UNKNOWN_LENGTH; ///< Size of the whole file, if known; a partial file of this size is complete
+	unsigned long long nBytesDone = 0; ///< Bytes written to the file (and hashed) when the record was saved
+};
+
+/**
+ * @brief Returns the path of the record of a partially downloaded file: the same path with
+ *        ".download" appended.
+ */
+std::filesystem::path GetDownloadRecordFilePath(const std::filesystem::path& strPartialFilePath);
+
+/**
+ * @brief Fills a record from the response that brings the file: its validators and its size.
+ * @param pResponse A 200 response, or a 206 response with a Content-Range.
+ * @param nOffset Position in the file of the first byte of the response body.
+ */
+void SetDownloadRecordResponse(DOWNLOAD_RECORD& pRecord, const TRANSPORT_RESPONSE& pResponse, unsigned long long nOffset);
+
+/**
+ * @brief Returns the validator to send in If-Range: the ETag if it is a strong one, otherwise the
+ *        Last-Modified date, or an empty string if the record has neither.
+ */
+std::string GetDownloadRecordValidator(const DOWNLOAD_RECORD& pRecord);
+
+/**
+ * @brief Writes the record of a partially downloaded file. The record file is rewritten
+ *        atomically, so it is either the old or the new record after a crash.
+ * @return true if the record was written, false otherwise.
+ */
+bool SaveDownloadRecord(const std::filesystem::path& strPartialFilePath, const DOWNLOAD_RECORD& pRecord);
+
+/**
+ * @brief Reads the record of a partially downloaded file. The record is only valid if the file
+ *        has at least nBytesDone bytes.
+ * @return true if a valid record was found, false otherwise.
+ */
+bool LoadDownloadRecord(const std::filesystem::path& strPartialFilePath, DOWNLOAD_RECORD& pRecord);
+
+/**
+ * @brief Removes the record of a file, once it is complete or has been discarded.
+ */
+void RemoveDownloadRecord(const std::filesystem::path& strPartialFilePath);
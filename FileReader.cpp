@@ -0,0 +1,43 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#include "FileReader.h"
+
+#include <system_error>
+
+bool ReadFileBlocks(const std::filesystem::path& strFilePath, const std::function<void(const uint8_t*, size_t)>& pConsumer,
+	size_t nBufferCount, size_t nBufferSize)
+{
+	// Mapping only pays off, and only keeps the page cache clean, for large files on a local disk
+	std::error_code errorCode;
+	const unsigned long long nFileSize = std::filesystem::file_size(strFilePath, errorCode);
+	if (!errorCode && (nFileSize >= MAPPING_THRESHOLD) && CMappedFileReader::IsOnFixedVolume(strFilePath))
+	{
+		CMappedFileReader pReader;
+		return pReader.Read(strFilePath, pConsumer);
+	}
+
+	// Hand each buffer over as soon as the reader has filled it
+	CPipelinedReader pReader(nBufferCount, nBufferSize);
+	return pReader.Read(strFilePath, pConsumer);
+}
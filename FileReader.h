@@ -0,0 +1,40 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#pragma once
+
+#include "PipelinedReader.h"
+#include "MappedFileReader.h"
+
+/**
+ * @brief Reads a whole file, calling pConsumer for each block in file order. Large files are read
+ *        from a memory mapping (see CMappedFileReader); smaller ones through a ring of buffers
+ *        filled on a background thread (see CPipelinedReader).
+ * @param strFilePath Path to the file to read.
+ * @param pConsumer Receives a pointer to the data and its length; the data is valid only during the call.
+ * @param nBufferCount Number of read buffers in the ring.
+ * @param nBufferSize Size of each read buffer in bytes.
+ * @return true if the whole file was read, false if it couldn't be opened or read.
+ */
+bool ReadFileBlocks(const std::filesystem::path& strFilePath, const std::function<void(const uint8_t*, size_t)>& pConsumer,
+	size_t nBufferCount = PIPELINE_BUFFER_COUNT, size_t nBufferSize = PIPELINE_BUFFER_SIZE);
@@ -0,0 +1,170 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#include "HashCheckpoint.h"
+#include "DigestValue.h"
+
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const char HASH_CHECKPOINT_SIGNATURE[] = "genUp4win hash checkpoint 1"; ///< First line of the checkpoint file; anything else is ignored.
+
+std::filesystem::path GetHashCheckpointFilePath(const std::filesystem::path& strPartialFilePath)
+{
+	std::filesystem::path strCheckpointFilePath{ strPartialFilePath };
+	strCheckpointFilePath += ".checkpoint";
+	return strCheckpointFilePath;
+}
+
+bool FlushFileToDisk(const std::filesystem::path& strFilePath)
+{
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(strFilePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	const bool retVal = (FlushFileBuffers(hFile) != FALSE);
+	CloseHandle(hFile);
+	return retVal;
+#else
+	const int nFile = open(strFilePath.c_str(), O_RDONLY);
+	if (nFile < 0)
+	{
+		return false;
+	}
+	const bool retVal = (fsync(nFile) == 0);
+	close(nFile);
+	return retVal;
+#endif
+}
+
+/**
+ * @brief Writes the entry of a renamed file in its directory to the disk. NTFS journals renames, so only POSIX needs it.
+ */
+static void FlushDirectoryToDisk(const std::filesystem::path& strFilePath)
+{
+#ifndef _WIN32
+	const int nDirectory = open(strFilePath.parent_path().empty() ? "." : strFilePath.parent_path().c_str(), O_RDONLY);
+	if (nDirectory >= 0)
+	{
+		fsync(nDirectory);
+		close(nDirectory);
+	}
+#else
+	(void)strFilePath;
+#endif
+}
+
+bool SaveHashCheckpoint(const std::filesystem::path& strPartialFilePath, const std::string& strAlgorithm, unsigned long long nBytesDone, const std::vector<uint8_t>& arrState)
+{
+	std::string strState(2 * arrState.size(), '0');
+	DigestValue::formatHex(arrState.data(), arrState.size(), strState.data());
+
+	// Write a new file to the disk and swap it in, so neither a crash nor a power loss leaves half a checkpoint behind
+	const std::filesystem::path strCheckpointFilePath{ GetHashCheckpointFilePath(strPartialFilePath) };
+	std::filesystem::path strTempFilePath{ strCheckpointFilePath };
+	strTempFilePath += ".tmp";
+	{
+		std::ofstream pCheckpointFile(strTempFilePath, std::ios::out | std::ios::trunc);
+		if (!pCheckpointFile.is_open())
+		{
+			return false;
+		}
+		pCheckpointFile << HASH_CHECKPOINT_SIGNATURE << '\n' << strAlgorithm << '\t' << nBytesDone << '\t' << strState << '\n';
+		pCheckpointFile.close();
+		if (!pCheckpointFile || !FlushFileToDisk(strTempFilePath))
+		{
+			std::error_code ec;
+			std::filesystem::remove(strTempFilePath, ec);
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename(strTempFilePath, strCheckpointFilePath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(strTempFilePath, ec);
+		return false;
+	}
+	FlushDirectoryToDisk(strCheckpointFilePath);
+	return true;
+}
+
+bool LoadHashCheckpoint(const std::filesystem::path& strPartialFilePath, const std::string& strAlgorithm, unsigned long long& nBytesDone, std::vector<uint8_t>& arrState)
+{
+	std::ifstream pCheckpointFile(GetHashCheckpointFilePath(strPartialFilePath), std::ios::in);
+	std::string strLine;
+	if (!pCheckpointFile.is_open() || !std::getline(pCheckpointFile, strLine) || (strLine != HASH_CHECKPOINT_SIGNATURE) ||
+		!std::getline(pCheckpointFile, strLine))
+	{
+		return false;
+	}
+
+	// The line is: algorithm, bytes done, hexadecimal state; separated by tabs
+	std::istringstream pFields(strLine);
+	std::string strCheckpointAlgorithm, strBytesDone, strState;
+	if (!std::getline(pFields, strCheckpointAlgorithm, '\t') || !std::getline(pFields, strBytesDone, '\t') ||
+		!std::getline(pFields, strState) || (strCheckpointAlgorithm != strAlgorithm) || (strState.size() % 2 != 0))
+	{
+		return false;
+	}
+
+	try
+	{
+		nBytesDone = std::stoull(strBytesDone);
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+
+	// The file may have lost its tail (e.g. it was not flushed before a crash), but not the hashed bytes
+	std::error_code ec;
+	const unsigned long long nFileSize = std::filesystem::file_size(strPartialFilePath, ec);
+	if (ec || (nFileSize < nBytesDone))
+	{
+		return false;
+	}
+
+	arrState.resize(strState.size() / 2);
+	return DigestValue::parseHex(std::string_view(strState), arrState.data());
+}
+
+void RemoveHashCheckpoint(const std::filesystem::path& strPartialFilePath)
+{
+	std::error_code ec;
+	std::filesystem::remove(GetHashCheckpointFilePath(strPartialFilePath), ec);
+}
@@ -0,0 +1,75 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+const unsigned long long HASH_CHECKPOINT_INTERVAL = 0x1000000; ///< Bytes downloaded between two checkpoints (16 MiB).
+
+/**
+ * @brief Returns the path of the checkpoint file of a partially downloaded file: the same path
+ *        with ".checkpoint" appended.
+ */
+std::filesystem::path GetHashCheckpointFilePath(const std::filesystem::path& strPartialFilePath);
+
+/**
+ * @brief Writes the data of a file still held in the cache of the system to the disk. Other handles
+ *        of the file may be writing it; what they have written so far is flushed too.
+ * @return true if the data written to the file so far is on the disk, false otherwise.
+ */
+bool FlushFileToDisk(const std::filesystem::path& strFilePath);
+
+/**
+ * @brief Records how many bytes of a partially downloaded file have been hashed, and the state of
+ *        the hash at that point (see IChecksumAlgorithm::SaveState). The checkpoint file is written
+ *        to the disk and then swapped in, so it is either the old or the new checkpoint after a crash
+ *        or a power loss. The first nBytesDone bytes of the file must be on the disk first (see
+ *        FlushFileToDisk), or the checkpoint could claim bytes which a power loss took away.
+ * @param strPartialFilePath Path to the partially downloaded file.
+ * @param strAlgorithm Name of the checksum algorithm whose state is saved.
+ * @param nBytesDone Number of bytes written to the file and hashed.
+ * @param arrState The saved state of the hash.
+ * @return true if the checkpoint was written, false otherwise.
+ */
+bool SaveHashCheckpoint(const std::filesystem::path& strPartialFilePath, const std::string& strAlgorithm, unsigned long long nBytesDone, const std::vector<uint8_t>& arrState);
+
+/**
+ * @brief Reads the checkpoint of a partially downloaded file. The checkpoint is only valid if it
+ *        is for the same algorithm and the file has at least nBytesDone bytes.
+ * @param strPartialFilePath Path to the partially downloaded file.
+ * @param strAlgorithm Name of the checksum algorithm that will continue the calculation.
+ * @param nBytesDone Output: receives the number of bytes already hashed.
+ * @param arrState Output: receives the saved state of the hash.
+ * @return true if a valid checkpoint was found, false otherwise.
+ */
+bool LoadHashCheckpoint(const std::filesystem::path& strPartialFilePath, const std::string& strAlgorithm, unsigned long long& nBytesDone, std::vector<uint8_t>& arrState);
+
+/**
+ * @brief Removes the checkpoint of a file, once it is complete or has been discarded.
+ */
+void RemoveHashCheckpoint(const std::filesystem::path& strPartialFilePath);
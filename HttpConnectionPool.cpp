@@ -0,0 +1,127 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#include "HttpConnectionPool.h"
+
+#include <algorithm>
+#include <cctype>
+
+CHttpConnectionPool::CHttpConnectionPool(unsigned int nIdleTimeout, size_t nMaxIdlePerHost)
+	: m_nIdleTimeout(nIdleTimeout), m_nMaxIdlePerHost(nMaxIdlePerHost)
+{
+}
+
+std::string CHttpConnectionPool::GetKey(const std::string& strScheme, const std::string& strHost, uint16_t nPort)
+{
+	// Scheme and host names are not case sensitive
+	std::string strKey = strScheme + "://" + strHost + ":" + std::to_string(nPort);
+	std::transform(strKey.begin(), strKey.end(), strKey.begin(), [](unsigned char chValue) { return static_cast<char>(std::tolower(chValue)); });
+	return strKey;
+}
+
+void CHttpConnectionPool::RemoveExpired(std::chrono::steady_clock::time_point tNow)
+{
+	for (auto pIterator = m_mapIdle.begin(); pIterator != m_mapIdle.end();)
+	{
+		std::vector<CIdleConnection>& arrConnections = pIterator->second;
+		const size_t nCount = arrConnections.size();
+		arrConnections.erase(std::remove_if(arrConnections.begin(), arrConnections.end(),
+			[tNow](const CIdleConnection& pConnection) { return pConnection.tExpires <= tNow; }), arrConnections.end());
+		m_pStatistics.nExpired += nCount - arrConnections.size();
+		pIterator = arrConnections.empty() ? m_mapIdle.erase(pIterator) : std::next(pIterator);
+	}
+}
+
+CTcpSocket CHttpConnectionPool::Acquire(const std::string& strScheme, const std::string& strHost, uint16_t nPort)
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	RemoveExpired(std::chrono::steady_clock::now());
+	const auto pIterator = m_mapIdle.find(GetKey(strScheme, strHost, nPort));
+	if (pIterator == m_mapIdle.end())
+	{
+		m_pStatistics.nMisses++;
+		return CTcpSocket();
+	}
+
+	// The most recently used connection is the least likely to have been closed by the server
+	CTcpSocket pSocket = std::move(pIterator->second.back().pSocket);
+	pIterator->second.pop_back();
+	if (pIterator->second.empty())
+	{
+		m_mapIdle.erase(pIterator);
+	}
+	m_pStatistics.nHits++;
+	return pSocket;
+}
+
+void CHttpConnectionPool::Release(const std::string& strScheme, const std::string& strHost, uint16_t nPort, CTcpSocket&& pSocket, unsigned int nIdleTimeout)
+{
+	CTcpSocket pClosed; // Closed after the lock is released
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	const unsigned int nTimeout = (nIdleTimeout > 0) ? (std::min)(nIdleTimeout, m_nIdleTimeout) : m_nIdleTimeout;
+	if (!pSocket.IsOpen() || (nTimeout == 0) || (m_nMaxIdlePerHost == 0))
+	{
+		pClosed = std::move(pSocket);
+		return;
+	}
+	std::vector<CIdleConnection>& arrConnections = m_mapIdle[GetKey(strScheme, strHost, nPort)];
+	if (arrConnections.size() >= m_nMaxIdlePerHost)
+	{
+		// Drop the oldest connection
+		pClosed = std::move(arrConnections.front().pSocket);
+		arrConnections.erase(arrConnections.begin());
+	}
+	arrConnections.push_back({ std::move(pSocket), std::chrono::steady_clock::now() + std::chrono::milliseconds(nTimeout) });
+}
+
+void CHttpConnectionPool::CountStale()
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	m_pStatistics.nStale++;
+}
+
+void CHttpConnectionPool::Clear()
+{
+	std::map<std::string, std::vector<CIdleConnection>> mapClosed;
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	mapClosed.swap(m_mapIdle);
+}
+
+void CHttpConnectionPool::SetIdleTimeout(unsigned int nIdleTimeout)
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	m_nIdleTimeout = nIdleTimeout;
+}
+
+HTTP_POOL_STATISTICS CHttpConnectionPool::GetStatistics() const
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	return m_pStatistics;
+}
+
+CHttpConnectionPool& GetHttpConnectionPool()
+{
+	static CHttpConnectionPool pPool;
+	return pPool;
+}
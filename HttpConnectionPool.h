@@ -0,0 +1,123 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "TcpSocket.h"
+
+const unsigned int HTTP_POOL_IDLE_TIMEOUT = 30000; ///< Default time an idle connection is kept, in milliseconds.
+const size_t HTTP_POOL_MAX_IDLE_PER_HOST = 4;      ///< Most idle connections kept to the same scheme, host and port.
+
+/**
+ * @brief Counters of a connection pool, for tuning the idle timeout.
+ */
+struct HTTP_POOL_STATISTICS
+{
+	unsigned long long nHits = 0;    ///< Requests sent on an idle connection from the pool.
+	unsigned long long nMisses = 0;  ///< Requests that had to open a new connection.
+	unsigned long long nExpired = 0; ///< Idle connections closed because they were not used in time.
+	unsigned long long nStale = 0;   ///< Idle connections the server had closed, found when they were used.
+};
+
+/**
+ * @brief Keeps the connections of completed HTTP/1.1 requests open, so that the next request to
+ *        the same scheme, host and port skips the DNS lookup and the TCP handshake.
+ *
+ * A connection is taken out of the pool while a request uses it, and put back when its response
+ * has been read completely. Connections that stay idle longer than the idle timeout (or the
+ * timeout the server announced in its Keep-Alive header, if shorter) are closed. The pool is
+ * thread safe.
+ */
+class CHttpConnectionPool
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * @param nIdleTimeout Time an idle connection is kept, in milliseconds (0 disables the pool).
+	 * @param nMaxIdlePerHost Most idle connections kept to the same scheme, host and port.
+	 */
+	explicit CHttpConnectionPool(unsigned int nIdleTimeout = HTTP_POOL_IDLE_TIMEOUT, size_t nMaxIdlePerHost = HTTP_POOL_MAX_IDLE_PER_HOST);
+
+	/**
+	 * @brief Takes the most recently used idle connection to a server, counting a hit; if there is none,
+	 *        counts a miss and returns a socket that is not open, for the caller to connect.
+	 */
+	CTcpSocket Acquire(const std::string& strScheme, const std::string& strHost, uint16_t nPort);
+
+	/**
+	 * @brief Puts a connection back after its response has been read completely.
+	 * @param nIdleTimeout Idle timeout the server announced, in milliseconds, or 0 to use the timeout of the pool.
+	 */
+	void Release(const std::string& strScheme, const std::string& strHost, uint16_t nPort, CTcpSocket&& pSocket, unsigned int nIdleTimeout = 0);
+
+	/**
+	 * @brief Counts an idle connection that turned out to be closed by the server.
+	 */
+	void CountStale();
+
+	/**
+	 * @brief Closes all idle connections.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Changes the idle timeout; connections already idle keep the timeout they got.
+	 */
+	void SetIdleTimeout(unsigned int nIdleTimeout);
+
+	/**
+	 * @brief Returns the counters since the pool was created.
+	 */
+	HTTP_POOL_STATISTICS GetStatistics() const;
+
+private:
+	/**
+	 * @brief An idle connection and the time it expires.
+	 */
+	struct CIdleConnection
+	{
+		CTcpSocket pSocket;
+		std::chrono::steady_clock::time_point tExpires;
+	};
+
+	static std::string GetKey(const std::string& strScheme, const std::string& strHost, uint16_t nPort);
+	void RemoveExpired(std::chrono::steady_clock::time_point tNow);
+
+	mutable std::mutex m_pLock;       ///< Guards the members below
+	unsigned int m_nIdleTimeout;      ///< Time an idle connection is kept, in milliseconds
+	size_t m_nMaxIdlePerHost;         ///< Most idle connections per key
+	std::map<std::string, std::vector<CIdleConnection>> m_mapIdle; ///< Idle connections by scheme://host:port, oldest first
+	HTTP_POOL_STATISTICS m_pStatistics; ///< Counters
+};
+
+/**
+ * @brief Returns the connection pool of the process, shared by all the HTTP transports that don't get their own.
+ */
+CHttpConnectionPool& GetHttpConnectionPool();
@@ -0,0 +1,629 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#include "HttpTransport.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+const size_t HTTP_RECEIVE_BUFFER_SIZE = 0x10000; ///< Size of the receive buffer (64 KiB), the largest block passed to the body callback.
+const size_t HTTP_MAX_LINE_LENGTH = 0x2000;      ///< Longest status line, header line or chunk size line.
+const size_t HTTP_MAX_HEADER_COUNT = 100;        ///< Most header lines accepted in a response.
+const unsigned long long HTTP_MAX_DRAIN_LENGTH = 0x10000; ///< Longest unused body (e.g. of a redirect) read to keep the connection open.
+
+/**
+ * @brief Buffered reader for one HTTP connection; the body is passed on straight from its buffer.
+ */
+class CHttpReader
+{
+public:
+	explicit CHttpReader(CTcpSocket& pSocket)
+		: m_pSocket(pSocket), m_arrBuffer(HTTP_RECEIVE_BUFFER_SIZE), m_nStart(0), m_nEnd(0), m_nReceived(0)
+	{
+	}
+
+	/**
+	 * @brief Reads a line, without its CR LF.
+	 * @return false if the connection failed or closed, or the line is too long.
+	 */
+	bool ReadLine(std::string& strLine, std::string& strError)
+	{
+		size_t nSearchFrom = m_nStart;
+		while (true)
+		{
+			const uint8_t* pBegin = m_arrBuffer.data() + m_nStart;
+			const uint8_t* pNewLine = static_cast<const uint8_t*>(memchr(m_arrBuffer.data() + nSearchFrom, '\n', m_nEnd - nSearchFrom));
+			if (pNewLine != nullptr)
+			{
+				const size_t nLength = static_cast<size_t>(pNewLine - pBegin);
+				strLine.assign(reinterpret_cast<const char*>(pBegin), ((nLength > 0) && (pBegin[nLength - 1] == '\r')) ? nLength - 1 : nLength);
+				m_nStart += nLength + 1;
+				return true;
+			}
+			if (m_nEnd - m_nStart >= HTTP_MAX_LINE_LENGTH)
+			{
+				strError = "The server sent a line that is too long";
+				return false;
+			}
+			const size_t nSearched = m_nEnd - m_nStart;
+			const long long nReceived = Fill();
+			if (nReceived <= 0)
+			{
+				strError = (nReceived == 0) ? "The server closed the connection" : "Cannot receive the response: " + m_pSocket.GetLastError();
+				return false;
+			}
+			nSearchFrom = m_nStart + nSearched;
+		}
+	}
+
+	/**
+	 * @brief Receives more data after the data already buffered.
+	 * @return The number of bytes received, 0 if the connection was closed, -1 on error.
+	 */
+	long long Fill()
+	{
+		if (m_nStart == m_nEnd)
+		{
+			m_nStart = m_nEnd = 0;
+		}
+		else if (m_nEnd == m_arrBuffer.size())
+		{
+			std::memmove(m_arrBuffer.data(), m_arrBuffer.data() + m_nStart, m_nEnd - m_nStart);
+			m_nEnd -= m_nStart;
+			m_nStart = 0;
+		}
+		const long long nReceived = m_pSocket.Receive(m_arrBuffer.data() + m_nEnd, m_arrBuffer.size() - m_nEnd);
+		if (nReceived > 0)
+		{
+			m_nEnd += static_cast<size_t>(nReceived);
+			m_nReceived += static_cast<unsigned long long>(nReceived);
+		}
+		return nReceived;
+	}
+
+	const uint8_t* GetData() const { return m_arrBuffer.data() + m_nStart; }
+	size_t GetAvailable() const { return m_nEnd - m_nStart; }
+	void Consume(size_t nLength) { m_nStart += nLength; }
+	unsigned long long GetReceived() const { return m_nReceived; }
+	const std::string& GetLastError() const { return m_pSocket.GetLastError(); }
+
+private:
+	CTcpSocket& m_pSocket;           ///< The connection
+	std::vector<uint8_t> m_arrBuffer; ///< Receive buffer
+	size_t m_nStart;                 ///< First byte not consumed yet
+	size_t m_nEnd;                   ///< End of the received data
+	unsigned long long m_nReceived;  ///< Number of bytes received on the connection so far
+};
+
+/**
+ * @brief Compares two ASCII strings, ignoring case.
+ */
+static bool EqualsNoCase(const std::string& strLeft, const char* lpszRight)
+{
+	const size_t nLength = std::strlen(lpszRight);
+	if (strLeft.size() != nLength)
+	{
+		return false;
+	}
+	for (size_t nIndex = 0; nIndex < nLength; nIndex++)
+	{
+		if (std::tolower(static_cast<unsigned char>(strLeft[nIndex])) != std::tolower(static_cast<unsigned char>(lpszRight[nIndex])))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Removes the spaces and tabs around a header value.
+ */
+static std::string TrimHeaderValue(const std::string& strValue)
+{
+	const size_t nFirst = strValue.find_first_not_of(" \t");
+	if (nFirst == std::string::npos)
+	{
+		return std::string();
+	}
+	return strValue.substr(nFirst, strValue.find_last_not_of(" \t") - nFirst + 1);
+}
+
+/**
+ * @brief Checks whether a comma separated header value (e.g. of Connection) has a token, ignoring case.
+ */
+static bool HasHeaderToken(const std::string& strValue, const char* lpszToken)
+{
+	size_t nStart = 0;
+	while (nStart <= strValue.size())
+	{
+		const size_t nComma = std::min(strValue.find(',', nStart), strValue.size());
+		if (EqualsNoCase(TrimHeaderValue(strValue.substr(nStart, nComma - nStart)), lpszToken))
+		{
+			return true;
+		}
+		nStart = nComma + 1;
+	}
+	return false;
+}
+
+/**
+ * @brief How the body of a response is framed, and whether the connection stays open after it.
+ */
+struct HTTP_FRAMING
+{
+	bool bChunked = false;         ///< The body uses the chunked transfer coding.
+	bool bKeepAlive = false;       ///< The server keeps the connection open after the response.
+	unsigned int nIdleTimeout = 0; ///< Idle timeout from the Keep-Alive header in milliseconds, 0 if none.
+	std::string strReason;         ///< Reason phrase of the status line.
+};
+
+/**
+ * @brief Reads a status line and the header lines after it, skipping interim (1xx) responses.
+ * @param pReader The connection.
+ * @param pResponse Output: receives the status, the headers and the length of the body.
+ * @param pFraming Output: receives how the body is framed.
+ * @return false if the response is not valid HTTP/1.x or couldn't be received.
+ */
+static bool ReadResponseHead(CHttpReader& pReader, TRANSPORT_RESPONSE& pResponse, HTTP_FRAMING& pFraming)
+{
+	std::string strLine;
+	bool bHTTP11 = false;
+	do
+	{
+		// Status line: HTTP/1.1 200 OK
+		if (!pReader.ReadLine(strLine, pResponse.strError))
+		{
+			return false;
+		}
+		if ((strLine.size() < 12) || (strLine.compare(0, 7, "HTTP/1.") != 0) || (strLine[8] != ' ') ||
+			!std::isdigit(static_cast<unsigned char>(strLine[9])) || !std::isdigit(static_cast<unsigned char>(strLine[10])) || !std::isdigit(static_cast<unsigned char>(strLine[11])))
+		{
+			pResponse.strError = "The server didn't send a valid HTTP response";
+			return false;
+		}
+		pResponse.nStatusCode = (strLine[9] - '0') * 100 + (strLine[10] - '0') * 10 + (strLine[11] - '0');
+		pFraming.strReason = TrimHeaderValue(strLine.substr(12));
+		bHTTP11 = strLine[7] != '0';
+
+		pResponse.arrHeaders.clear();
+		while (true)
+		{
+			if (!pReader.ReadLine(strLine, pResponse.strError))
+			{
+				return false;
+			}
+			if (strLine.empty())
+			{
+				break;
+			}
+			const size_t nColon = strLine.find(':');
+			if ((nColon == std::string::npos) || (nColon == 0) || (pResponse.arrHeaders.size() >= HTTP_MAX_HEADER_COUNT))
+			{
+				pResponse.strError = "The server sent an invalid header";
+				return false;
+			}
+			pResponse.arrHeaders.emplace_back(strLine.substr(0, nColon), TrimHeaderValue(strLine.substr(nColon + 1)));
+		}
+	} while ((pResponse.nStatusCode >= 100) && (pResponse.nStatusCode < 200));
+
+	// The last transfer coding is the one that frames the body
+	pFraming.bChunked = false;
+	if (const std::string* pTransferEncoding = FindTransportHeader(pResponse.arrHeaders, "Transfer-Encoding"))
+	{
+		const size_t nLast = pTransferEncoding->find_last_of(',');
+		pFraming.bChunked = EqualsNoCase(TrimHeaderValue((nLast == std::string::npos) ? *pTransferEncoding : pTransferEncoding->substr(nLast + 1)), "chunked");
+	}
+
+	// HTTP/1.1 connections are persistent unless the server says otherwise, HTTP/1.0 ones only if it asks for it
+	const std::string* pConnection = FindTransportHeader(pResponse.arrHeaders, "Connection");
+	pFraming.bKeepAlive = bHTTP11 ? ((pConnection == nullptr) || !HasHeaderToken(*pConnection, "close")) : ((pConnection != nullptr) && HasHeaderToken(*pConnection, "keep-alive"));
+	pFraming.nIdleTimeout = 0;
+	if (const std::string* pKeepAlive = FindTransportHeader(pResponse.arrHeaders, "Keep-Alive"))
+	{
+		// Keep-Alive: timeout=5, max=100
+		const size_t nTimeout = pKeepAlive->find("timeout=");
+		unsigned long long nSeconds = 0;
+		if ((nTimeout != std::string::npos) &&
+			ParseTransportNumber(TrimHeaderValue(pKeepAlive->substr(nTimeout + 8, pKeepAlive->find(',', nTimeout) - nTimeout - 8)), 10, nSeconds) && (nSeconds > 0))
+		{
+			pFraming.nIdleTimeout = static_cast<unsigned int>(std::min<unsigned long long>(nSeconds, 86400) * 1000);
+		}
+	}
+
+	pResponse.nContentLength = TRANSPORT_UNKNOWN_LENGTH;
+	if ((pResponse.nStatusCode == 204) || (pResponse.nStatusCode == 304))
+	{
+		pResponse.nContentLength = 0;
+	}
+	else if (const std::string* pContentLength = FindTransportHeader(pResponse.arrHeaders, "Content-Length"); (pContentLength != nullptr) && !pFraming.bChunked)
+	{
+		if (!ParseTransportNumber(*pContentLength, 10, pResponse.nContentLength))
+		{
+			pResponse.strError = "The server sent an invalid Content-Length";
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Passes the next nLength bytes of the body to the callback.
+ */
+static bool ReadBodyBytes(CHttpReader& pReader, unsigned long long nLength, const fnTransportBody& pBody, const fnTransportProgress& pProgress,
+	unsigned long long& nReceived, TRANSPORT_RESPONSE& pResponse)
+{
+	while (nLength > 0)
+	{
+		if (pReader.GetAvailable() == 0)
+		{
+			const long long nResult = pReader.Fill();
+			if (nResult <= 0)
+			{
+				pResponse.strError = (nResult == 0) ? "The server closed the connection before the end of the body" : "Cannot receive the body: " + pReader.GetLastError();
+				return false;
+			}
+		}
+		const size_t nBlock = static_cast<size_t>(std::min<unsigned long long>(pReader.GetAvailable(), nLength));
+		if (!pBody(pReader.GetData(), nBlock))
+		{
+			pResponse.strError = "The download was cancelled";
+			return false;
+		}
+		pReader.Consume(nBlock);
+		nLength -= nBlock;
+		nReceived += nBlock;
+		if (pProgress)
+		{
+			pProgress(nReceived, pResponse.nContentLength);
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Reads a body in the chunked transfer coding, up to and including its trailer.
+ */
+static bool ReadChunkedBody(CHttpReader& pReader, const fnTransportBody& pBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse)
+{
+	unsigned long long nReceived = 0;
+	std::string strLine;
+	while (true)
+	{
+		// Chunk size in hexadecimal, maybe followed by extensions
+		if (!pReader.ReadLine(strLine, pResponse.strError))
+		{
+			return false;
+		}
+		unsigned long long nChunkSize = 0;
+		if (!ParseTransportNumber(TrimHeaderValue(strLine.substr(0, strLine.find(';'))), 16, nChunkSize))
+		{
+			pResponse.strError = "The server sent an invalid chunk";
+			return false;
+		}
+		if (nChunkSize == 0)
+		{
+			break;
+		}
+		if (!ReadBodyBytes(pReader, nChunkSize, pBody, pProgress, nReceived, pResponse) || !pReader.ReadLine(strLine, pResponse.strError))
+		{
+			return false;
+		}
+		if (!strLine.empty())
+		{
+			pResponse.strError = "The server sent an invalid chunk";
+			return false;
+		}
+	}
+
+	// Trailer fields are not used
+	do
+	{
+		if (!pReader.ReadLine(strLine, pResponse.strError))
+		{
+			return false;
+		}
+	} while (!strLine.empty());
+	return true;
+}
+
+/**
+ * @brief Reads a body that ends when the server closes the connection.
+ */
+static bool ReadBodyToEnd(CHttpReader& pReader, const fnTransportBody& pBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse)
+{
+	unsigned long long nReceived = 0;
+	while (true)
+	{
+		if ((pReader.GetAvailable() > 0) && !ReadBodyBytes(pReader, pReader.GetAvailable(), pBody, pProgress, nReceived, pResponse))
+		{
+			return false;
+		}
+		const long long nResult = pReader.Fill();
+		if (nResult == 0)
+		{
+			return true;
+		}
+		if (nResult < 0)
+		{
+			pResponse.strError = "Cannot receive the body: " + pReader.GetLastError();
+			return false;
+		}
+	}
+}
+
+/**
+ * @brief Formats a GET request.
+ * @return false if one of the additional headers can't be sent (e.g. it has a line break).
+ */
+static bool FormatRequest(const HTTP_URL& pURL, const TRANSPORT_HEADERS& arrHeaders, std::string& strRequest)
+{
+	const bool bIPv6 = pURL.strHost.find(':') != std::string::npos;
+	strRequest = "GET " + pURL.strTarget + " HTTP/1.1\r\nHost: ";
+	strRequest += bIPv6 ? "[" + pURL.strHost + "]" : pURL.strHost;
+	if (pURL.nPort != 80)
+	{
+		strRequest += ":" + std::to_string(pURL.nPort);
+	}
+	strRequest += "\r\nUser-Agent: genUp4win\r\nAccept-Encoding: identity\r\n";
+	for (const auto& pHeader : arrHeaders)
+	{
+		if (pHeader.first.empty() || (pHeader.first.find_first_of(":\r\n") != std::string::npos) || (pHeader.second.find_first_of("\r\n") != std::string::npos))
+		{
+			return false;
+		}
+		strRequest += pHeader.first + ": " + pHeader.second + "\r\n";
+	}
+	strRequest += "\r\n";
+	return true;
+}
+
+bool ParseHttpURL(const std::string& strURL, HTTP_URL& pURL)
+{
+	if ((strURL.size() < 7) || !EqualsNoCase(strURL.substr(0, 7), "http://"))
+	{
+		return false;
+	}
+
+	// Authority: [userinfo@]host[:port]
+	const size_t nAuthorityEnd = strURL.find_first_of("/?#", 7);
+	std::string strAuthority = strURL.substr(7, (nAuthorityEnd == std::string::npos) ? std::string::npos : nAuthorityEnd - 7);
+	const size_t nUserInfo = strAuthority.rfind('@');
+	if (nUserInfo != std::string::npos)
+	{
+		strAuthority.erase(0, nUserInfo + 1);
+	}
+	std::string strPort;
+	if (!strAuthority.empty() && (strAuthority[0] == '['))
+	{
+		const size_t nBracket = strAuthority.find(']');
+		if ((nBracket == std::string::npos) || ((nBracket + 1 < strAuthority.size()) && (strAuthority[nBracket + 1] != ':')))
+		{
+			return false;
+		}
+		pURL.strHost = strAuthority.substr(1, nBracket - 1);
+		if (nBracket + 1 < strAuthority.size())
+		{
+			strPort = strAuthority.substr(nBracket + 2);
+		}
+	}
+	else
+	{
+		const size_t nColon = strAuthority.find(':');
+		pURL.strHost = strAuthority.substr(0, nColon);
+		if (nColon != std::string::npos)
+		{
+			strPort = strAuthority.substr(nColon + 1);
+		}
+	}
+	if (pURL.strHost.empty())
+	{
+		return false;
+	}
+	pURL.nPort = 80;
+	if (!strPort.empty())
+	{
+		unsigned long long nPort = 0;
+		if (!ParseTransportNumber(strPort, 10, nPort) || (nPort == 0) || (nPort > 65535))
+		{
+			return false;
+		}
+		pURL.nPort = static_cast<uint16_t>(nPort);
+	}
+
+	// Request target: path and query, without the fragment
+	pURL.strTarget.clear();
+	if (nAuthorityEnd != std::string::npos)
+	{
+		pURL.strTarget = strURL.substr(nAuthorityEnd, strURL.find('#', nAuthorityEnd) - nAuthorityEnd);
+	}
+	if (pURL.strTarget.empty() || (pURL.strTarget[0] != '/'))
+	{
+		pURL.strTarget.insert(0, "/");
+	}
+	return pURL.strTarget.find_first_of(" \r\n") == std::string::npos;
+}
+
+std::string ResolveHttpURL(const std::string& strBaseURL, const std::string& strLocation)
+{
+	// Absolute URL (the scheme is letters, digits, +, - and . followed by a colon)
+	const size_t nColon = strLocation.find(':');
+	if ((nColon != std::string::npos) && (nColon > 0) && std::isalpha(static_cast<unsigned char>(strLocation[0])) &&
+		(strLocation.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+-.") == nColon))
+	{
+		return strLocation;
+	}
+
+	const size_t nScheme = strBaseURL.find("://");
+	const size_t nAuthorityStart = (nScheme == std::string::npos) ? 0 : nScheme + 3;
+	if (strLocation.compare(0, 2, "//") == 0)
+	{
+		return strBaseURL.substr(0, nAuthorityStart - 2) + strLocation;
+	}
+	const size_t nPathStart = std::min(strBaseURL.find_first_of("/?#", nAuthorityStart), strBaseURL.size());
+	if (!strLocation.empty() && (strLocation[0] == '/'))
+	{
+		return strBaseURL.substr(0, nPathStart) + strLocation;
+	}
+
+	// Relative to the directory of the base path
+	const size_t nPathEnd = std::min(strBaseURL.find_first_of("?#", nPathStart), strBaseURL.size());
+	const size_t nLastSlash = strBaseURL.rfind('/', nPathEnd);
+	if ((nLastSlash == std::string::npos) || (nLastSlash < nPathStart))
+	{
+		return strBaseURL.substr(0, nPathStart) + "/" + strLocation;
+	}
+	return strBaseURL.substr(0, nLastSlash + 1) + strLocation;
+}
+
+CHttpTransport::CHttpTransport(CHttpConnectionPool& pPool, unsigned int nTimeout)
+	: m_pPool(pPool), m_nTimeout(nTimeout)
+{
+}
+
+void CHttpTransport::ReleaseConnection(const HTTP_URL& pURL, CTcpSocket& pSocket, CHttpReader& pReader, const TRANSPORT_RESPONSE& pResponse, const HTTP_FRAMING& pFraming, bool bBodyRead)
+{
+	if (!pFraming.bKeepAlive)
+	{
+		return;
+	}
+	if (!bBodyRead)
+	{
+		// Read a short unused body to reach the next response; a long one costs more than a new connection
+		if (pFraming.bChunked || (pResponse.nContentLength > HTTP_MAX_DRAIN_LENGTH))
+		{
+			return;
+		}
+		TRANSPORT_RESPONSE pDrained{ pResponse };
+		unsigned long long nReceived = 0;
+		if (!ReadBodyBytes(pReader, pResponse.nContentLength, [](const uint8_t*, size_t) { return true; }, nullptr, nReceived, pDrained))
+		{
+			return;
+		}
+	}
+	// Anything received after the response means the connection is out of step
+	if (pReader.GetAvailable() == 0)
+	{
+		m_pPool.Release("http", pURL.strHost, pURL.nPort, std::move(pSocket), pFraming.nIdleTimeout);
+	}
+}
+
+bool CHttpTransport::Get(const TRANSPORT_REQUEST& pRequest, const fnTransportBody& pBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse)
+{
+	std::string strURL = pRequest.strURL;
+	for (unsigned int nRedirect = 0; ; nRedirect++)
+	{
+		pResponse = TRANSPORT_RESPONSE();
+		HTTP_URL pURL;
+		if (!ParseHttpURL(strURL, pURL))
+		{
+			pResponse.strError = "Unsupported URL: " + strURL;
+			return false;
+		}
+		std::string strRequest;
+		if (!FormatRequest(pURL, pRequest.arrHeaders, strRequest))
+		{
+			pResponse.strError = "Invalid request header";
+			return false;
+		}
+
+		// Send the request on an idle connection to the same server if there is one
+		CTcpSocket pSocket = m_pPool.Acquire("http", pURL.strHost, pURL.nPort);
+		bool bReused = pSocket.IsOpen();
+		CHttpReader pReader(pSocket);
+		HTTP_FRAMING pFraming;
+		while (true)
+		{
+			if (!pSocket.IsOpen() && !pSocket.Connect(pURL.strHost, pURL.nPort, m_nTimeout, pResponse.strError))
+			{
+				return false;
+			}
+			const bool bSent = pSocket.Send(strRequest.data(), strRequest.size());
+			if (bSent && ReadResponseHead(pReader, pResponse, pFraming))
+			{
+				break;
+			}
+
+			// The server may have closed the idle connection meanwhile; a GET can safely be sent again
+			if (bReused && (pReader.GetReceived() == 0))
+			{
+				m_pPool.CountStale();
+				pSocket.Close();
+				bReused = false;
+				pResponse = TRANSPORT_RESPONSE();
+				continue;
+			}
+			if (!bSent)
+			{
+				pResponse.strError = "Cannot send the request: " + pSocket.GetLastError();
+			}
+			return false;
+		}
+
+		// Follow redirects
+		const int nStatusCode = pResponse.nStatusCode;
+		if ((nStatusCode == 301) || (nStatusCode == 302) || (nStatusCode == 303) || (nStatusCode == 307) || (nStatusCode == 308))
+		{
+			const std::string* pLocation = FindTransportHeader(pResponse.arrHeaders, "Location");
+			if ((pLocation != nullptr) && !pLocation->empty() && (nRedirect < HTTP_MAX_REDIRECTS))
+			{
+				strURL = ResolveHttpURL(strURL, *pLocation);
+				ReleaseConnection(pURL, pSocket, pReader, pResponse, pFraming, false);
+				continue;
+			}
+		}
+		if ((nStatusCode < 200) || (nStatusCode >= 300))
+		{
+			pResponse.strError = "HTTP " + std::to_string(nStatusCode) + (pFraming.strReason.empty() ? "" : " " + pFraming.strReason);
+			ReleaseConnection(pURL, pSocket, pReader, pResponse, pFraming, false);
+			return false;
+		}
+
+		if (pFraming.bChunked)
+		{
+			const bool bRead = ReadChunkedBody(pReader, pBody, pProgress, pResponse);
+			if (bRead)
+			{
+				ReleaseConnection(pURL, pSocket, pReader, pResponse, pFraming, true);
+			}
+			return bRead;
+		}
+		if (pResponse.nContentLength == TRANSPORT_UNKNOWN_LENGTH)
+		{
+			return ReadBodyToEnd(pReader, pBody, pProgress, pResponse);
+		}
+		unsigned long long nReceived = 0;
+		if (pProgress)
+		{
+			pProgress(0, pResponse.nContentLength);
+		}
+		const bool bRead = ReadBodyBytes(pReader, pResponse.nContentLength, pBody, pProgress, nReceived, pResponse);
+		if (bRead)
+		{
+			ReleaseConnection(pURL, pSocket, pReader, pResponse, pFraming, true);
+		}
+		return bRead;
+	}
+}
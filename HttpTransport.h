@@ -0,0 +1,93 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "Transport.h"
+#include "TcpSocket.h"
+#include "HttpConnectionPool.h"
+
+const unsigned int HTTP_MAX_REDIRECTS = 5; ///< Redirects followed before a request fails.
+
+/**
+ * @brief The parts of an http:// URL that are needed to send a request.
+ */
+struct HTTP_URL
+{
+	std::string strHost;   ///< Host name or address, without the brackets of an IPv6 address.
+	uint16_t nPort = 80;   ///< TCP port.
+	std::string strTarget; ///< Path and query, starting with "/".
+};
+
+/**
+ * @brief Splits an http:// URL into host, port and request target; the fragment is dropped.
+ * @param strURL The URL; the scheme is not case sensitive.
+ * @param pURL Output: receives the parts of the URL.
+ * @return false if the URL is not a valid http:// URL (https:// is not supported).
+ */
+bool ParseHttpURL(const std::string& strURL, HTTP_URL& pURL);
+
+/**
+ * @brief Resolves the Location of a redirect against the URL that was requested.
+ * @return The absolute URL to request next.
+ */
+std::string ResolveHttpURL(const std::string& strBaseURL, const std::string& strLocation);
+
+class CHttpReader;
+struct HTTP_FRAMING;
+
+/**
+ * @brief A portable HTTP/1.1 client over plain TCP, for http:// URLs.
+ *
+ * Bodies are read with Content-Length, chunked transfer coding, or up to the end of the
+ * connection, and are passed to the caller straight from the receive buffer. Persistent
+ * connections go back to a connection pool once their response has been read, so the
+ * configuration file and the installer can share one connection. The client
+ * builds on Windows and POSIX systems, so the download path can be tested and measured
+ * against a loopback server. It doesn't speak TLS; https:// URLs need the urlmon transport.
+ */
+class CHttpTransport : public ITransport
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * @param pPool Pool of idle connections (by default the pool of the process); it must outlive the transport.
+	 * @param nTimeout Send and receive timeout of the connections, in milliseconds.
+	 */
+	explicit CHttpTransport(CHttpConnectionPool& pPool = GetHttpConnectionPool(), unsigned int nTimeout = TCP_SOCKET_TIMEOUT);
+
+	bool Get(const TRANSPORT_REQUEST& pRequest, const fnTransportBody& pBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse) override;
+
+private:
+	/**
+	 * @brief Puts a connection back into the pool if the server keeps it open and the response has been read completely.
+	 * @param bBodyRead false if the body has not been read; a short one is read and dropped.
+	 */
+	void ReleaseConnection(const HTTP_URL& pURL, CTcpSocket& pSocket, CHttpReader& pReader, const TRANSPORT_RESPONSE& pResponse, const HTTP_FRAMING& pFraming, bool bBodyRead);
+
+	CHttpConnectionPool& m_pPool; ///< Idle connections
+	unsigned int m_nTimeout; ///< Send and receive timeout, in milliseconds
+};
@@ -0,0 +1,475 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+
+
+#include "ManifestReader.h"
+#include "XMLDocument.h"
+
+#include <cstring>
+
+/**
+ * @brief Parses the attributes of a tag: name="value" or name='value', separated by white space.
+ * @return false if the attributes are malformed or have an unknown entity.
+ */
+static bool ParseAttributes(const std::string& strAttributes, std::vector<std::pair<std::string, std::string>>& arrAttributes)
+{
+	size_t nIndex = 0;
+	while (true)
+	{
+		while ((nIndex < strAttributes.size()) && IsXMLSpace(strAttributes[nIndex]))
+			nIndex++;
+		if (nIndex == strAttributes.size())
+			return true;
+		const size_t nNameStart = nIndex;
+		while ((nIndex < strAttributes.size()) && !IsXMLSpace(strAttributes[nIndex]) && (strAttributes[nIndex] != '='))
+			nIndex++;
+		const std::string strName = strAttributes.substr(nNameStart, nIndex - nNameStart);
+		while ((nIndex < strAttributes.size()) && IsXMLSpace(strAttributes[nIndex]))
+			nIndex++;
+		if (strName.empty() || (nIndex == strAttributes.size()) || (strAttributes[nIndex] != '='))
+			return false;
+		nIndex++;
+		while ((nIndex < strAttributes.size()) && IsXMLSpace(strAttributes[nIndex]))
+			nIndex++;
+		if ((nIndex == strAttributes.size()) || ((strAttributes[nIndex] != '"') && (strAttributes[nIndex] != '\'')))
+			return false;
+		const size_t nValueEnd = strAttributes.find(strAttributes[nIndex], nIndex + 1);
+		if (nValueEnd == std::string::npos)
+			return false;
+		std::string strValue;
+		if (!DecodeXMLEntities(strAttributes.substr(nIndex + 1, nValueEnd - nIndex - 1), strValue))
+			return false;
+		arrAttributes.emplace_back(strName, strValue);
+		nIndex = nValueEnd + 1;
+		if ((nIndex < strAttributes.size()) && !IsXMLSpace(strAttributes[nIndex]))
+			return false;
+	}
+}
+
+CManifestReader::CManifestReader(std::string strSection)
+	: m_strSection(std::move(strSection)), m_nEncoding(ENCODING::Unknown), m_nState(STATE::Text), m_nOddByte(0), m_bOddByte(false),
+	m_nHighSurrogate(0), m_nQuote(0), m_nMatched(0), m_bRootClosed(false), m_bInSection(false), m_bSectionFound(false),
+	m_nSectionLength(0), m_bDone(false), m_nBytesRead(0)
+{
+}
+
+bool CManifestReader::Feed(const uint8_t* pData, size_t nLength)
+{
+	if (m_bDone)
+		return false;
+	size_t nIndex = 0;
+	if (m_nEncoding == ENCODING::Unknown)
+	{
+		// The byte order mark, or the first character, takes up to 3 bytes
+		while ((nIndex < nLength) && (m_strPending.size() < 3))
+			m_strPending.push_back(static_cast<char>(pData[nIndex++]));
+		if ((m_strPending.size() < 3) || !DetectEncoding())
+			return !m_bDone;
+	}
+	for (; (nIndex < nLength) && !m_bDone; nIndex++)
+	{
+		m_nBytesRead++;
+		if (m_nEncoding == ENCODING::UTF8)
+		{
+			Parse(static_cast<char>(pData[nIndex]));
+		}
+		else if (!m_bOddByte)
+		{
+			m_nOddByte = pData[nIndex];
+			m_bOddByte = true;
+		}
+		else
+		{
+			m_bOddByte = false;
+			ParseUTF16((m_nEncoding == ENCODING::UTF16LE) ? static_cast<uint16_t>(m_nOddByte | (pData[nIndex] << 8)) : static_cast<uint16_t>((m_nOddByte << 8) | pData[nIndex]));
+		}
+	}
+	return !m_bDone;
+}
+
+bool CManifestReader::Finish()
+{
+	if ((m_nEncoding == ENCODING::Unknown) && !m_bDone)
+		DetectEncoding();
+	if (!m_bDone)
+		Fail(((m_nBytesRead == 0) && m_arrElements.empty()) ? "The configuration file is empty" : "The configuration file is truncated");
+	return m_strError.empty();
+}
+
+const MANIFEST_ENTRY* FindManifestEntry(const std::vector<MANIFEST_ENTRY>& arrEntries, const std::string& strName)
+{
+	for (const MANIFEST_ENTRY& pEntry : arrEntries)
+	{
+		if (pEntry.strName == strName)
+			return &pEntry;
+	}
+	return nullptr;
+}
+
+std::string GetManifestEntryAttribute(const MANIFEST_ENTRY* pEntry, const std::string& strAttribute)
+{
+	if (pEntry != nullptr)
+	{
+		for (const auto& pAttribute : pEntry->arrAttributes)
+		{
+			if (pAttribute.first == strAttribute)
+				return pAttribute.second;
+		}
+	}
+	return std::string();
+}
+
+bool WriteManifestEntries(CXMLDocument& pDocument, const std::string& strSection, const std::vector<MANIFEST_ENTRY>& arrEntries, const std::vector<std::string>& arrRemovedNames)
+{
+	XML_ELEMENT* pRoot = (pDocument.GetRoot() != nullptr) ? pDocument.GetRoot() : pDocument.CreateRoot("xml");
+	XML_ELEMENT* pSection = pDocument.FindIndexedChild(pRoot, strSection);
+	if ((pSection == nullptr) && ((pSection = pDocument.AppendChild(pRoot, strSection)) == nullptr))
+		return false;
+	for (const MANIFEST_ENTRY& pEntry : arrEntries)
+	{
+		XML_ELEMENT* pElement = pDocument.FindIndexedChild(pSection, pEntry.strName);
+		if ((pElement == nullptr) && ((pElement = pDocument.AppendChild(pSection, pEntry.strName)) == nullptr))
+			return false;
+		pElement->pFirstAttribute = nullptr;
+		pDocument.SetText(pElement, pEntry.strValue);
+		for (const auto& pAttribute : pEntry.arrAttributes)
+		{
+			if (!pDocument.SetAttribute(pElement, pAttribute.first, pAttribute.second))
+				return false;
+		}
+	}
+	for (const std::string& strName : arrRemovedNames)
+	{
+		while (XML_ELEMENT* pElement = pDocument.FindIndexedChild(pSection, strName))
+			pDocument.RemoveChild(pSection, pElement);
+	}
+	return true;
+}
+
+const MANIFEST_ENTRY* CManifestReader::GetEntry(const std::string& strName) const
+{
+	return FindManifestEntry(m_arrEntries, strName);
+}
+
+std::string CManifestReader::GetEntryAttribute(const std::string& strName, const std::string& strAttribute) const
+{
+	return GetManifestEntryAttribute(GetEntry(strName), strAttribute);
+}
+
+bool CManifestReader::DetectEncoding()
+{
+	const std::string strPending = std::move(m_strPending);
+	m_strPending.clear();
+	size_t nSkip = 0;
+	if ((strPending.size() >= 3) && (strPending.compare(0, 3, "\xEF\xBB\xBF") == 0))
+	{
+		m_nEncoding = ENCODING::UTF8;
+		nSkip = 3;
+	}
+	else if ((strPending.size() >= 2) && (static_cast<uint8_t>(strPending[0]) == 0xFF) && (static_cast<uint8_t>(strPending[1]) == 0xFE))
+	{
+		m_nEncoding = ENCODING::UTF16LE;
+		nSkip = 2;
+	}
+	else if ((strPending.size() >= 2) && (static_cast<uint8_t>(strPending[0]) == 0xFE) && (static_cast<uint8_t>(strPending[1]) == 0xFF))
+	{
+		m_nEncoding = ENCODING::UTF16BE;
+		nSkip = 2;
+	}
+	else if ((strPending.size() >= 2) && (strPending[0] == '<') && (strPending[1] == '\0'))
+		m_nEncoding = ENCODING::UTF16LE; // UTF-16 without a byte order mark starts with "<?xml" or the root element
+	else if ((strPending.size() >= 2) && (strPending[0] == '\0') && (strPending[1] == '<'))
+		m_nEncoding = ENCODING::UTF16BE;
+	else
+		m_nEncoding = ENCODING::UTF8;
+
+	m_nBytesRead += nSkip;
+	return Feed(reinterpret_cast<const uint8_t*>(strPending.data()) + nSkip, strPending.size() - nSkip);
+}
+
+bool CManifestReader::ParseUTF16(uint16_t nUnit)
+{
+	uint32_t nCodePoint = nUnit;
+	if (m_nHighSurrogate != 0)
+	{
+		if ((nUnit < 0xDC00) || (nUnit > 0xDFFF))
+			return Fail("The configuration file has an invalid UTF-16 character");
+		nCodePoint = 0x10000 + ((static_cast<uint32_t>(m_nHighSurrogate - 0xD800) << 10) | (nUnit - 0xDC00));
+		m_nHighSurrogate = 0;
+	}
+	else if ((nUnit >= 0xD800) && (nUnit <= 0xDBFF))
+	{
+		m_nHighSurrogate = nUnit;
+		return true;
+	}
+	else if ((nUnit >= 0xDC00) && (nUnit <= 0xDFFF))
+		return Fail("The configuration file has an invalid UTF-16 character");
+
+	if (nCodePoint < 0x80)
+		return Parse(static_cast<char>(nCodePoint));
+	std::string strUTF8;
+	AppendUTF8(strUTF8, nCodePoint);
+	for (const char nChar : strUTF8)
+	{
+		if (!Parse(nChar))
+			return false;
+	}
+	return true;
+}
+
+bool CManifestReader::Parse(char nChar)
+{
+	switch (m_nState)
+	{
+	case STATE::Text:
+		if (nChar == '<')
+		{
+			if (!FlushText())
+				return false;
+			m_nState = STATE::Markup;
+			m_strToken.clear();
+		}
+		else if (m_bInSection && (m_arrElements.size() >= 3))
+		{
+			if (m_nSectionLength + m_strText.size() >= MANIFEST_READER_MAX_SECTION_LENGTH)
+				return Fail("The product's section of the configuration file is too long");
+			m_strText.push_back(nChar);
+		}
+		else if (m_arrElements.empty() && !IsXMLSpace(nChar))
+			return Fail("The configuration file has text outside of the root element");
+		return true;
+
+	case STATE::Markup:
+		// Tell a tag from a comment, a processing instruction, a CDATA section or a DTD by their first characters
+		m_strToken.push_back(nChar);
+		m_nMatched = 0;
+		if (m_strToken == "?")
+			m_nState = STATE::ProcessingInstruction;
+		else if (m_strToken == "!--")
+			m_nState = STATE::Comment;
+		else if (m_strToken == "![CDATA[")
+		{
+			if (m_arrElements.empty())
+				return Fail("The configuration file has a CDATA section outside of the root element");
+			m_nState = STATE::CData;
+		}
+		else if (m_strToken[0] == '!')
+		{
+			if ((strncmp(m_strToken.c_str(), "!--", m_strToken.size()) != 0) && (strncmp(m_strToken.c_str(), "![CDATA[", m_strToken.size()) != 0))
+			{
+				m_nState = STATE::Declaration;
+				m_nQuote = 0;
+				return Parse(nChar);
+			}
+		}
+		else
+		{
+			m_nState = STATE::Tag;
+			m_nQuote = 0;
+			m_strToken.clear();
+			return Parse(nChar);
+		}
+		return true;
+
+	case STATE::Tag:
+		if (m_nQuote != 0)
+		{
+			if (nChar == m_nQuote)
+				m_nQuote = 0;
+		}
+		else if ((nChar == '"') || (nChar == '\''))
+			m_nQuote = nChar;
+		else if (nChar == '>')
+		{
+			m_nState = STATE::Text;
+			return ParseTag();
+		}
+		else if (nChar == '<')
+			return Fail("The configuration file has an invalid tag");
+		if (m_strToken.size() >= MANIFEST_READER_MAX_TOKEN_LENGTH)
+			return Fail("The configuration file has a tag that is too long");
+		m_strToken.push_back(nChar);
+		return true;
+
+	case STATE::Comment:
+		if (nChar == '-')
+			m_nMatched = (m_nMatched < 2) ? m_nMatched + 1 : 2;
+		else if ((nChar == '>') && (m_nMatched == 2))
+			m_nState = STATE::Text;
+		else
+			m_nMatched = 0;
+		return true;
+
+	case STATE::ProcessingInstruction:
+		if (nChar == '?')
+			m_nMatched = 1;
+		else if ((nChar == '>') && (m_nMatched == 1))
+			m_nState = STATE::Text;
+		else
+			m_nMatched = 0;
+		return true;
+
+	case STATE::CData:
+		// The content is literal text, so it goes straight to the value; a ] is only content once it can't be part of ]]>
+		if (nChar == ']')
+		{
+			if (++m_nMatched <= 2)
+				return true;
+			m_nMatched = 2;
+		}
+		else if ((nChar == '>') && (m_nMatched >= 2))
+		{
+			m_nState = STATE::Text;
+			return true;
+		}
+		if (m_bInSection && (m_arrElements.size() >= 3))
+		{
+			const std::string strContent = std::string((nChar == ']') ? 1 : m_nMatched, ']') + ((nChar == ']') ? std::string() : std::string(1, nChar));
+			if (!Append(m_arrEntries.back().strValue, strContent))
+				return false;
+		}
+		if (nChar != ']')
+			m_nMatched = 0;
+		return true;
+
+	case STATE::Declaration:
+		// A DTD is skipped up to the > that closes it, past its internal subset in brackets
+		if (m_nQuote != 0)
+		{
+			if (nChar == m_nQuote)
+				m_nQuote = 0;
+		}
+		else if ((nChar == '"') || (nChar == '\''))
+			m_nQuote = nChar;
+		else if (nChar == '[')
+			m_nMatched++;
+		else if ((nChar == ']') && (m_nMatched > 0))
+			m_nMatched--;
+		else if ((nChar == '>') && (m_nMatched == 0))
+			m_nState = STATE::Text;
+		return true;
+	}
+	return true;
+}
+
+bool CManifestReader::ParseTag()
+{
+	if (!m_strToken.empty() && (m_strToken[0] == '/'))
+	{
+		size_t nEnd = m_strToken.size();
+		while ((nEnd > 1) && IsXMLSpace(m_strToken[nEnd - 1]))
+			nEnd--;
+		return EndElement(m_strToken.substr(1, nEnd - 1));
+	}
+
+	const bool bEmpty = !m_strToken.empty() && (m_strToken.back() == '/');
+	if (bEmpty)
+		m_strToken.pop_back();
+	size_t nNameEnd = 0;
+	while ((nNameEnd < m_strToken.size()) && !IsXMLSpace(m_strToken[nNameEnd]))
+		nNameEnd++;
+	if (nNameEnd == 0)
+		return Fail("The configuration file has an invalid tag");
+	const std::string strName = m_strToken.substr(0, nNameEnd);
+	if (m_bRootClosed || (m_arrElements.size() >= MANIFEST_READER_MAX_DEPTH))
+		return Fail("The configuration file has an unexpected element");
+	m_arrElements.push_back(strName);
+
+	if (m_arrElements.size() == 2)
+	{
+		m_bInSection = (strName == m_strSection);
+	}
+	else if ((m_arrElements.size() == 3) && m_bInSection)
+	{
+		// Only the attributes of the product's entries are kept, the others are skipped
+		MANIFEST_ENTRY pEntry;
+		if (!Append(pEntry.strName, strName) || !ParseAttributes(m_strToken.substr(nNameEnd), pEntry.arrAttributes))
+			return m_bDone ? false : Fail("The configuration file has an invalid attribute");
+		for (const auto& pAttribute : pEntry.arrAttributes)
+		{
+			m_nSectionLength += pAttribute.first.size() + pAttribute.second.size();
+		}
+		if (m_nSectionLength >= MANIFEST_READER_MAX_SECTION_LENGTH)
+			return Fail("The product's section of the configuration file is too long");
+		m_arrEntries.push_back(std::move(pEntry));
+	}
+	return bEmpty ? EndElement(strName) : true;
+}
+
+bool CManifestReader::EndElement(const std::string& strName)
+{
+	if (m_arrElements.empty() || (m_arrElements.back() != strName))
+		return Fail("The configuration file has a mismatched end tag");
+	if (m_bInSection)
+	{
+		if (m_arrElements.size() == 3)
+		{
+			std::string& strValue = m_arrEntries.back().strValue;
+			strValue = std::string(TrimXMLSpace(strValue));
+		}
+		else if (m_arrElements.size() == 2)
+		{
+			// Found: the rest of the manifest doesn't matter
+			m_bInSection = false;
+			m_bSectionFound = true;
+			m_bDone = true;
+		}
+	}
+	m_arrElements.pop_back();
+	if (m_arrElements.empty())
+	{
+		m_bRootClosed = true;
+		m_bDone = true;
+	}
+	return !m_bDone;
+}
+
+bool CManifestReader::FlushText()
+{
+	if (m_strText.empty())
+		return true;
+	std::string strValue;
+	if (!DecodeXMLEntities(m_strText, strValue))
+		return Fail("The configuration file has an unknown entity");
+	m_strText.clear();
+	return Append(m_arrEntries.back().strValue, strValue);
+}
+
+bool CManifestReader::Append(std::string& strTarget, const std::string& strSource)
+{
+	m_nSectionLength += strSource.size();
+	if (m_nSectionLength >= MANIFEST_READER_MAX_SECTION_LENGTH)
+		return Fail("The product's section of the configuration file is too long");
+	strTarget += strSource;
+	return true;
+}
+
+bool CManifestReader::Fail(const std::string& strError)
+{
+	if (m_strError.empty())
+		m_strError = strError;
+	m_bDone = true;
+	return false;
+}
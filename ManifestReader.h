@@ -0,0 +1,171 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+const size_t MANIFEST_READER_MAX_TOKEN_LENGTH = 0x10000;   ///< Longest tag (name and attributes) accepted in a manifest.
+const size_t MANIFEST_READER_MAX_SECTION_LENGTH = 0x10000; ///< Most bytes of values kept from the product's section.
+const size_t MANIFEST_READER_MAX_DEPTH = 64;               ///< Deepest nesting of elements accepted in a manifest.
+
+class CXMLDocument;
+
+/**
+ * @brief One entry of the product's section, e.g. <Checksum alg="BLAKE3">...</Checksum>.
+ */
+struct MANIFEST_ENTRY
+{
+	std::string strName;  ///< Element name
+	std::string strValue; ///< Text of the element, with entities decoded and surrounding white space removed
+	std::vector<std::pair<std::string, std::string>> arrAttributes; ///< Attributes of the element, with entities decoded
+};
+
+/**
+ * @brief Returns an entry of a product's section, or nullptr if there is no such entry.
+ *        The first one is returned if the entry appears more than once.
+ */
+const MANIFEST_ENTRY* FindManifestEntry(const std::vector<MANIFEST_ENTRY>& arrEntries, const std::string& strName);
+
+/**
+ * @brief Returns the value of an attribute of an entry, or an empty string if there is no such entry (nullptr) or attribute.
+ */
+std::string GetManifestEntryAttribute(const MANIFEST_ENTRY* pEntry, const std::string& strAttribute);
+
+/**
+ * @brief Writes entries into a product's section of a settings document, creating the root element and the section
+ *        if necessary. Each entry gets its value and exactly its attributes: the attributes it had before are dropped.
+ *        The entries named in arrRemovedNames are removed from the section, if it has them.
+ * @return false if a name is not a valid element or attribute name.
+ */
+bool WriteManifestEntries(CXMLDocument& pDocument, const std::string& strSection, const std::vector<MANIFEST_ENTRY>& arrEntries, const std::vector<std::string>& arrRemovedNames);
+
+/**
+ * @brief Forward-only reader of a configuration file (manifest), which extracts the entries of one product
+ *        without building a DOM.
+ *
+ * The manifest is laid out as CXMLAppSettings writes it: a root element, a section element per product
+ * and an entry element per setting. The manifest is fed in blocks as it arrives, in UTF-8 or in UTF-16
+ * (as MSXML saves it), and the reader stops as soon as the product's section is closed, so the rest of a
+ * large catalog is neither downloaded nor parsed. Only the product's section is kept; memory use doesn't
+ * depend on the size of the manifest.
+ *
+ * DTDs are skipped, not interpreted: only the predefined and the character entities are decoded.
+ */
+class CManifestReader
+{
+public:
+	/**
+	 * @param strSection Name of the product's section, in UTF-8.
+	 */
+	explicit CManifestReader(std::string strSection);
+
+	/**
+	 * @brief Parses the next block of the manifest.
+	 * @return true if more of the manifest is needed, false once the product's section (or the root element)
+	 *         was read, or the manifest is not well-formed.
+	 */
+	bool Feed(const uint8_t* pData, size_t nLength);
+
+	/**
+	 * @brief Ends the manifest, when there are no more blocks.
+	 * @return true if the manifest was read up to the end of the product's section or of the root element,
+	 *         false if it was truncated or is not well-formed.
+	 */
+	bool Finish();
+
+	/**
+	 * @brief Reports whether the reader stopped: the product's section or the root element was read, or it failed.
+	 */
+	bool IsDone() const { return m_bDone; }
+
+	/**
+	 * @brief Returns why the manifest was rejected, or an empty string.
+	 */
+	const std::string& GetError() const { return m_strError; }
+
+	/**
+	 * @brief Reports whether the product's section was found.
+	 */
+	bool HasSection() const { return m_bSectionFound; }
+
+	/**
+	 * @brief Returns the entries of the product's section, in the order of the section.
+	 */
+	const std::vector<MANIFEST_ENTRY>& GetEntries() const { return m_arrEntries; }
+
+	/**
+	 * @brief Returns an entry of the product's section, or nullptr if there is no such entry.
+	 *        The first one is returned if the entry appears more than once.
+	 */
+	const MANIFEST_ENTRY* GetEntry(const std::string& strName) const;
+
+	/**
+	 * @brief Returns the value of an attribute of an entry, or an empty string if there is no such entry or attribute.
+	 */
+	std::string GetEntryAttribute(const std::string& strName, const std::string& strAttribute) const;
+
+	/**
+	 * @brief Returns how many bytes of the manifest were parsed before the reader stopped.
+	 */
+	unsigned long long GetBytesRead() const { return m_nBytesRead; }
+
+private:
+	enum class ENCODING { Unknown, UTF8, UTF16LE, UTF16BE };
+	enum class STATE { Text, Markup, Tag, Comment, ProcessingInstruction, CData, Declaration };
+
+	bool DetectEncoding();
+	bool Parse(char nChar);
+	bool ParseUTF16(uint16_t nUnit);
+	bool ParseTag();
+	bool EndElement(const std::string& strName);
+	bool FlushText();
+	bool Append(std::string& strTarget, const std::string& strSource);
+	bool Fail(const std::string& strError);
+
+	std::string m_strSection;
+	ENCODING m_nEncoding;
+	STATE m_nState;
+	std::string m_strPending;          ///< Bytes received before the encoding is known
+	uint8_t m_nOddByte;                ///< First byte of a UTF-16 code unit split between two blocks
+	bool m_bOddByte;
+	uint16_t m_nHighSurrogate;         ///< First half of a UTF-16 surrogate pair, or 0
+	std::string m_strToken;            ///< Current tag, without < and >
+	std::string m_strText;             ///< Raw text of the current entry, before entities are decoded
+	char m_nQuote;                     ///< Quote of the attribute value being read in a tag, or 0
+	size_t m_nMatched;                 ///< Characters of the end of a comment, PI, CDATA section or DTD matched so far
+	std::vector<std::string> m_arrElements; ///< Names of the open elements
+	bool m_bRootClosed;
+	bool m_bInSection;
+	bool m_bSectionFound;
+	size_t m_nSectionLength;
+	std::vector<MANIFEST_ENTRY> m_arrEntries;
+	bool m_bDone;
+	std::string m_strError;
+	unsigned long long m_nBytesRead;
+};
@@ -0,0 +1,383 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#include "MappedFileReader.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <atomic>
+#include <csetjmp>
+#include <csignal>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/vfs.h>
+#endif
+#endif
+
+const size_t MAPPING_GRANULARITY = 0x10000; ///< Window offsets must be multiples of the allocation granularity on Windows.
+const size_t MAPPING_PAGE_SIZE = 0x1000;    ///< Smallest page size; touching one byte every this many bytes reads in every page.
+
+/**
+ * @brief Reads one byte of every page of a window, so the pages are read in from the disk.
+ */
+static void ReadInPages(const volatile uint8_t* pView, size_t nLength)
+{
+	volatile uint8_t nSink = 0;
+	for (size_t nOffset = 0; nOffset < nLength; nOffset += MAPPING_PAGE_SIZE)
+	{
+		nSink = nSink ^ pView[nOffset];
+	}
+	nSink = nSink ^ pView[nLength - 1];
+}
+
+#if !defined(_WIN32)
+static thread_local sigjmp_buf* t_pReadInJump = nullptr; ///< Set while this thread reads in a window
+static struct sigaction g_pPreviousBusAction {};          ///< Handler of SIGBUS before ours, for the faults that are not ours
+
+/**
+ * @brief Jumps out of ReadInWindow when a page of the window cannot be read, and hands any other SIGBUS
+ *        over to the handler that was there before.
+ */
+static void OnBusError(int nSignal, siginfo_t* pInfo, void* pContext)
+{
+	if (t_pReadInJump != nullptr)
+	{
+		siglongjmp(*t_pReadInJump, 1);
+	}
+	if ((g_pPreviousBusAction.sa_flags & SA_SIGINFO) != 0)
+	{
+		g_pPreviousBusAction.sa_sigaction(nSignal, pInfo, pContext);
+	}
+	else if ((g_pPreviousBusAction.sa_handler != SIG_DFL) && (g_pPreviousBusAction.sa_handler != SIG_IGN))
+	{
+		g_pPreviousBusAction.sa_handler(nSignal);
+	}
+	else
+	{
+		signal(nSignal, SIG_DFL);
+		raise(nSignal);
+	}
+}
+#endif
+
+/**
+ * @brief Reads in every page of a mapped window before it is handed over. A page that cannot be read, because
+ *        of an I/O error or because the file was truncated meanwhile, faults: EXCEPTION_IN_PAGE_ERROR on Windows,
+ *        SIGBUS on POSIX; it is caught here rather than in the consumer, which may read the window on other threads.
+ * @return false if a page could not be read.
+ */
+static bool ReadInWindow(const uint8_t* pView, size_t nLength)
+{
+#if defined(_MSC_VER)
+	__try
+	{
+		ReadInPages(pView, nLength);
+	}
+	__except ((GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR) ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		return false;
+	}
+	return true;
+#elif defined(_WIN32)
+	ReadInPages(pView, nLength); // Structured exception handling needs MSVC
+	return true;
+#else
+	static std::once_flag pInstalled;
+	std::call_once(pInstalled, []()
+	{
+		struct sigaction pAction {};
+		pAction.sa_sigaction = OnBusError;
+		pAction.sa_flags = SA_SIGINFO | SA_NODEFER;
+		sigemptyset(&pAction.sa_mask);
+		sigaction(SIGBUS, &pAction, &g_pPreviousBusAction);
+	});
+	sigjmp_buf pJump;
+	if (sigsetjmp(pJump, 1) != 0)
+	{
+		t_pReadInJump = nullptr;
+		return false;
+	}
+	// The fences keep the compiler from moving the reads out from between the stores
+	t_pReadInJump = &pJump;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+	ReadInPages(pView, nLength);
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+	t_pReadInJump = nullptr;
+	return true;
+#endif
+}
+
+/**
+ * @brief Thin wrapper around a read-only file mapping, one window at a time.
+ */
+class CFileMapping
+{
+public:
+	explicit CFileMapping(const std::filesystem::path& strFilePath)
+	{
+#ifdef _WIN32
+		m_hFile = CreateFileW(strFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		LARGE_INTEGER nFileSize{};
+		if ((m_hFile != INVALID_HANDLE_VALUE) && GetFileSizeEx(m_hFile, &nFileSize))
+		{
+			m_nFileSize = static_cast<unsigned long long>(nFileSize.QuadPart);
+			m_bOpen = true;
+			// An empty file cannot be mapped, but there is nothing to read either
+			if (m_nFileSize > 0)
+			{
+				m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				m_bOpen = (m_hMapping != nullptr);
+			}
+		}
+#else
+		m_nFile = open(strFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat pStat {};
+		if ((m_nFile >= 0) && (fstat(m_nFile, &pStat) == 0))
+		{
+			m_nFileSize = static_cast<unsigned long long>(pStat.st_size);
+			m_bOpen = true;
+		}
+#endif
+	}
+
+	~CFileMapping()
+	{
+#ifdef _WIN32
+		if (m_hMapping != nullptr)
+		{
+			CloseHandle(m_hMapping);
+		}
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+		}
+#else
+		if (m_nFile >= 0)
+		{
+			close(m_nFile);
+		}
+#endif
+	}
+
+	CFileMapping(const CFileMapping&) = delete;
+	CFileMapping& operator=(const CFileMapping&) = delete;
+
+	bool IsOpen() const { return m_bOpen; }
+	unsigned long long GetSize() const { return m_nFileSize; }
+
+	/**
+	 * @brief Maps a window of the file and starts reading it ahead asynchronously.
+	 * @return The mapped address, or nullptr on failure.
+	 */
+	const uint8_t* Map(unsigned long long nOffset, size_t nLength)
+	{
+#ifdef _WIN32
+		void* pView = MapViewOfFile(m_hMapping, FILE_MAP_READ, static_cast<DWORD>(nOffset >> 32), static_cast<DWORD>(nOffset), nLength);
+#if (_WIN32_WINNT >= 0x0602)
+		if (pView != nullptr)
+		{
+			WIN32_MEMORY_RANGE_ENTRY pRange{ pView, nLength };
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &pRange, 0);
+		}
+#endif
+		return static_cast<const uint8_t*>(pView);
+#else
+		void* pView = mmap(nullptr, nLength, PROT_READ, MAP_SHARED, m_nFile, static_cast<off_t>(nOffset));
+		if (pView == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		madvise(pView, nLength, MADV_SEQUENTIAL);
+		madvise(pView, nLength, MADV_WILLNEED);
+		return static_cast<const uint8_t*>(pView);
+#endif
+	}
+
+	/**
+	 * @brief Checks whether a mapped window is entirely in the page cache already.
+	 */
+	bool IsResident(const uint8_t* pView, size_t nLength) const
+	{
+#ifdef _WIN32
+		// Windows keeps unmapped file pages on the standby list, which yields to the working set of
+		// running processes by itself, so there is nothing to clean up afterwards
+		(void)pView;
+		(void)nLength;
+		return true;
+#else
+		const size_t nPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		std::vector<unsigned char> arrResident((nLength + nPageSize - 1) / nPageSize);
+		if (mincore(const_cast<uint8_t*>(pView), nLength, arrResident.data()) != 0)
+		{
+			return true; // Unknown, leave the cache alone
+		}
+		return std::all_of(arrResident.begin(), arrResident.end(), [](unsigned char nPage) { return (nPage & 1) != 0; });
+#endif
+	}
+
+	/**
+	 * @brief Unmaps a window, optionally dropping its pages from the page cache.
+	 */
+	void Unmap(const uint8_t* pView, unsigned long long nOffset, size_t nLength, bool bDropFromCache)
+	{
+#ifdef _WIN32
+		(void)nOffset;
+		(void)nLength;
+		(void)bDropFromCache;
+		UnmapViewOfFile(pView);
+#else
+		munmap(const_cast<uint8_t*>(pView), nLength);
+#if defined(POSIX_FADV_DONTNEED)
+		if (bDropFromCache)
+		{
+			posix_fadvise(m_nFile, static_cast<off_t>(nOffset), static_cast<off_t>(nLength), POSIX_FADV_DONTNEED);
+		}
+#else
+		(void)nOffset;
+		(void)bDropFromCache;
+#endif
+#endif
+	}
+
+private:
+	bool m_bOpen = false;
+	unsigned long long m_nFileSize = 0;
+#ifdef _WIN32
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;
+	HANDLE m_hMapping = nullptr;
+#else
+	int m_nFile = -1;
+#endif
+};
+
+CMappedFileReader::CMappedFileReader(size_t nWindowSize)
+	: m_nWindowSize(((std::max)(nWindowSize, static_cast<size_t>(1)) + MAPPING_GRANULARITY - 1) & ~(MAPPING_GRANULARITY - 1))
+{
+}
+
+bool CMappedFileReader::Read(const std::filesystem::path& strFilePath, const std::function<void(const uint8_t*, size_t)>& pConsumer)
+{
+	CFileMapping pMapping(strFilePath);
+	if (!pMapping.IsOpen())
+	{
+		return false;
+	}
+
+	const unsigned long long nFileSize = pMapping.GetSize();
+	const auto WindowLength = [&](unsigned long long nOffset)
+	{
+		return static_cast<size_t>((std::min)(static_cast<unsigned long long>(m_nWindowSize), nFileSize - nOffset));
+	};
+
+	unsigned long long nOffset = 0;
+	size_t nLength = (nFileSize > 0) ? WindowLength(0) : 0;
+	const uint8_t* pView = (nLength > 0) ? pMapping.Map(0, nLength) : nullptr;
+	bool bResident = (pView != nullptr) && pMapping.IsResident(pView, nLength);
+	while (nLength > 0)
+	{
+		if (pView == nullptr)
+		{
+			return false;
+		}
+
+		// Map the next window first, so the OS reads it while the current one is consumed
+		const unsigned long long nNextOffset = nOffset + nLength;
+		const size_t nNextLength = (nNextOffset < nFileSize) ? WindowLength(nNextOffset) : 0;
+		const uint8_t* pNextView = (nNextLength > 0) ? pMapping.Map(nNextOffset, nNextLength) : nullptr;
+		const bool bNextResident = (pNextView != nullptr) && pMapping.IsResident(pNextView, nNextLength);
+
+		if (!ReadInWindow(pView, nLength))
+		{
+			pMapping.Unmap(pView, nOffset, nLength, !bResident);
+			if (pNextView != nullptr)
+			{
+				pMapping.Unmap(pNextView, nNextOffset, nNextLength, !bNextResident);
+			}
+			return false;
+		}
+		try
+		{
+			pConsumer(pView, nLength);
+		}
+		catch (...)
+		{
+			pMapping.Unmap(pView, nOffset, nLength, !bResident);
+			if (pNextView != nullptr)
+			{
+				pMapping.Unmap(pNextView, nNextOffset, nNextLength, !bNextResident);
+			}
+			throw;
+		}
+
+		// Drop behind: give back the pages we brought into the cache ourselves
+		pMapping.Unmap(pView, nOffset, nLength, !bResident);
+
+		nOffset = nNextOffset;
+		nLength = nNextLength;
+		pView = pNextView;
+		bResident = bNextResident;
+	}
+	return true;
+}
+
+bool CMappedFileReader::IsOnFixedVolume(const std::filesystem::path& strFilePath)
+{
+#ifdef _WIN32
+	// The volume of a UNC path or of a mapped network drive is DRIVE_REMOTE, that of a USB stick DRIVE_REMOVABLE
+	wchar_t lpszVolume[MAX_PATH + 1] = { 0, };
+	return GetVolumePathNameW(strFilePath.c_str(), lpszVolume, MAX_PATH + 1) && (GetDriveTypeW(lpszVolume) == DRIVE_FIXED);
+#elif defined(__linux__)
+	// Network and FUSE file systems, by their magic numbers in statfs
+	struct statfs pStat {};
+	if (statfs(strFilePath.c_str(), &pStat) != 0)
+	{
+		return false;
+	}
+	switch (static_cast<unsigned long>(pStat.f_type))
+	{
+	case 0x6969UL:     // NFS
+	case 0x517BUL:     // SMB
+	case 0xFF534D42UL: // CIFS
+	case 0xFE534D42UL: // SMB2
+	case 0x01021997UL: // 9P
+	case 0x65735546UL: // FUSE
+		return false;
+	default:
+		return true;
+	}
+#else
+	(void)strFilePath;
+	return true;
+#endif
+}
@@ -0,0 +1,72 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+
+const size_t MAPPING_WINDOW_SIZE = 0x4000000;        ///< Default size of each mapped window (64 MiB).
+const unsigned long long MAPPING_THRESHOLD = 0x2000000; ///< Files from this size up (32 MiB) are worth mapping.
+
+/**
+ * @brief Reads a file through a sliding memory-mapped window, handing the mapped bytes
+ *        straight to a consumer, with no copy into an intermediate buffer.
+ *
+ * The next window is mapped and prefetched while the consumer processes the current one.
+ * Each window is read in before it is handed over, so a read error fails Read instead of
+ * faulting in the consumer. On POSIX, windows that were not already in the page cache are
+ * dropped from it once consumed, so reading a large file does not push the rest of the system
+ * out of memory; Windows has no such call, but moves unmapped pages to its standby list, which
+ * yields to running processes by itself. Only files on local fixed disks are worth mapping
+ * (see IsOnFixedVolume); a file truncated by another process while the consumer reads a window
+ * still raises SIGBUS on POSIX, whereas Windows doesn't let a mapped file be truncated.
+ */
+class CMappedFileReader
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * @param nWindowSize Size of each mapped window, rounded up to a multiple of 64 KiB.
+	 */
+	CMappedFileReader(size_t nWindowSize = MAPPING_WINDOW_SIZE);
+
+	/**
+	 * @brief Reads the whole file, calling pConsumer for each window in file order.
+	 * @param strFilePath Path to the file to read (should be on a local disk).
+	 * @param pConsumer Receives a pointer to the mapped data and its length; the data is valid only during the call.
+	 * @return true if the whole file was read, false if it couldn't be opened or mapped.
+	 */
+	bool Read(const std::filesystem::path& strFilePath, const std::function<void(const uint8_t*, size_t)>& pConsumer);
+
+	/**
+	 * @brief Checks whether a file is on a local fixed disk. Network shares and removable media can fail
+	 *        a read at any time, which a memory mapping only reports as a fault, so they are read with buffers.
+	 */
+	static bool IsOnFixedVolume(const std::filesystem::path& strFilePath);
+
+private:
+	size_t m_nWindowSize; ///< Size of each mapped window
+};
@@ -0,0 +1,397 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include "AppSettings.h"
+#include "XMLDocument.h"
+
+/**
+ * @brief The app settings class which reads / writes application settings to an XML file without MSXML.
+ *        It has the same file format and the same behavior as CXMLAppSettings, but the document is held
+ *        by the portable CXMLDocument, so it needs neither COM nor CoInitialize. Sections and entries are
+ *        found through the hashed indexes of the document, not with an XPath query each.
+ */
+class CNativeXMLAppSettings : public IAppSettings
+{
+public:
+	CNativeXMLAppSettings(String sXMLFile, bool bWriteFlush = false, bool bPrettyPrint = false) noexcept : m_sXMLFile(std::move(sXMLFile)),
+		m_bLoaded(false),
+		m_bDirty(false),
+		m_bWriteFlush(bWriteFlush),
+		m_bPrettyPrint(bPrettyPrint)
+	{
+	}
+
+	CNativeXMLAppSettings(const CNativeXMLAppSettings&) = delete;
+	CNativeXMLAppSettings(CNativeXMLAppSettings&&) = delete;
+
+	~CNativeXMLAppSettings() noexcept
+	{
+		// Exceptions are not thrown from the destructor
+		try
+		{
+			Flush();
+		}
+		catch (CAppSettingsException& /*e*/)
+		{
+		}
+	}
+
+	CNativeXMLAppSettings& operator=(const CNativeXMLAppSettings&) = delete;
+	CNativeXMLAppSettings& operator=(CNativeXMLAppSettings&&) = delete;
+
+	void SetXMLFile(const String& sXMLFile)
+	{
+		// Flush the document, so nothing of it is left when the new file is loaded
+		Flush();
+		m_pDocument.Clear();
+		m_bLoaded = false;
+
+		m_sXMLFile = sXMLFile;
+	}
+
+	[[nodiscard]] String GetXMLFile() const
+	{
+		return m_sXMLFile;
+	}
+
+	void SetWriteFlush(bool bWriteFlush) noexcept
+	{
+		m_bWriteFlush = bWriteFlush;
+	}
+
+	[[nodiscard]] bool GetWriteFlush() const noexcept
+	{
+		return m_bWriteFlush;
+	}
+
+	/**
+	 * @brief Returns the document of the file, with the changes made since it was loaded.
+	 */
+	const CXMLDocument& GetDocument() const
+	{
+		return m_pDocument;
+	}
+
+	/**
+	 * @brief Returns the document to change it directly, loading the file if necessary; it is saved by the next Flush.
+	 */
+	CXMLDocument& EditDocument()
+	{
+		LoadIfNecessary(false);
+		m_bDirty = true;
+		return m_pDocument;
+	}
+
+	/**
+	 * @brief Returns an attribute of an entry, or an empty string if the entry has no such attribute.
+	 */
+	String GetEntryAttribute(LPCTSTR lpszSection, LPCTSTR lpszEntry, LPCTSTR lpszAttribute)
+	{
+		const XML_ELEMENT* pEntry = GetEntryElement(lpszSection, lpszEntry, true);
+		return FromUTF8(CXMLDocument::GetAttribute(pEntry, ToUTF8(lpszAttribute)));
+	}
+
+	/**
+	 * @brief Sets an attribute of an entry, creating the entry if necessary, or removes it if there is no value.
+	 */
+	void WriteEntryAttribute(LPCTSTR lpszSection, LPCTSTR lpszEntry, LPCTSTR lpszAttribute, LPCTSTR lpszValue)
+	{
+		XML_ELEMENT* pEntry = GetEntryElement(lpszSection, lpszEntry, false);
+		if (lpszValue == nullptr)
+			CXMLDocument::RemoveAttribute(pEntry, ToUTF8(lpszAttribute));
+		else if (!m_pDocument.SetAttribute(pEntry, ToUTF8(lpszAttribute), ToUTF8(lpszValue)))
+			ThrowWin32AppSettingsException(ERROR_INVALID_NAME);
+
+		m_bDirty = true;
+		if (m_bWriteFlush)
+			Flush();
+	}
+
+	// IAppSettings
+	int GetInt(LPCTSTR lpszSection, LPCTSTR lpszEntry) override
+	{
+		const String sValue{ GetString(lpszSection, lpszEntry) };
+		return _ttoi(sValue.c_str());
+	}
+
+	String GetString(LPCTSTR lpszSection, LPCTSTR lpszEntry) override
+	{
+		return FromUTF8(CXMLDocument::GetText(GetEntryElement(lpszSection, lpszEntry, true)));
+	}
+
+	std::vector<BYTE> GetBinary(LPCTSTR lpszSection, LPCTSTR lpszEntry) override
+	{
+		// Same encoding as CXMLAppSettings: each byte is two letters, the low nibble first
+		const String sBinary{ GetString(lpszSection, lpszEntry) };
+		const size_t nLength = sBinary.length();
+		if (nLength % 2)
+			ThrowWin32AppSettingsException(ERROR_INVALID_DATA);
+		std::vector<BYTE> data(nLength / 2);
+		for (size_t nIndex = 0; nIndex < nLength; nIndex += 2)
+		{
+			data[nIndex / 2] = static_cast<BYTE>(((sBinary[nIndex + 1] - 'A') << 4) + (sBinary[nIndex] - 'A'));
+		}
+		return data;
+	}
+
+	std::vector<String> GetStringArray(LPCTSTR lpszSection, LPCTSTR lpszEntry) override
+	{
+		// The strings are stored as a double null terminated list, written with WriteBinary
+		std::vector<BYTE> data{ GetBinary(lpszSection, lpszEntry) };
+		std::vector<String> arr;
+		if (data.size() < sizeof(TCHAR))
+			return arr;
+		data.resize(data.size() + sizeof(TCHAR) * 2); // guards against a list which is not terminated
+		for (LPCTSTR lpszString = reinterpret_cast<LPCTSTR>(data.data()); lpszString[0] != _T('\0'); lpszString += _tcslen(lpszString) + 1)
+		{
+			arr.emplace_back(lpszString);
+		}
+		return arr;
+	}
+
+	std::vector<String> GetSections() override
+	{
+		std::vector<String> sections;
+		for (const XML_ELEMENT* pSection = GetDocumentElement(true)->pFirstChild; pSection != nullptr; pSection = pSection->pNextSibling)
+		{
+			sections.push_back(FromUTF8(std::string(pSection->strName)));
+		}
+		return sections;
+	}
+
+	std::vector<String> GetSection(LPCTSTR lpszSection, bool bWithValues) override
+	{
+		std::vector<String> sectionEntries;
+		for (const XML_ELEMENT* pEntry = GetSectionElement(lpszSection, true)->pFirstChild; pEntry != nullptr; pEntry = pEntry->pNextSibling)
+		{
+			String sEntry{ FromUTF8(std::string(pEntry->strName)) };
+			if (bWithValues)
+			{
+				sEntry += _T('=');
+				sEntry += FromUTF8(CXMLDocument::GetText(pEntry));
+			}
+			sectionEntries.push_back(sEntry);
+		}
+		return sectionEntries;
+	}
+
+	void WriteInt(LPCTSTR lpszSection, LPCTSTR lpszEntry, int nValue) override
+	{
+		WriteInt(lpszSection, lpszEntry, nValue, m_bWriteFlush);
+	}
+
+	void WriteString(LPCTSTR lpszSection, LPCTSTR lpszEntry, LPCTSTR lpszValue) override
+	{
+		WriteString(lpszSection, lpszEntry, lpszValue, m_bWriteFlush);
+	}
+
+	void WriteBinary(LPCTSTR lpszSection, LPCTSTR lpszEntry, const BYTE* pData, DWORD dwBytes) override
+	{
+		WriteBinary(lpszSection, lpszEntry, pData, dwBytes, m_bWriteFlush);
+	}
+
+	void WriteStringArray(LPCTSTR lpszSection, LPCTSTR lpszEntry, const std::vector<String>& arr) override
+	{
+		WriteStringArray(lpszSection, lpszEntry, arr, m_bWriteFlush);
+	}
+
+	void WriteSection(LPCTSTR lpszSection, const std::vector<String>& sectionEntries) override
+	{
+		WriteSection(lpszSection, sectionEntries, m_bWriteFlush);
+	}
+
+	// Versions of the Write* methods which take the flush setting as a parameter
+	void WriteInt(LPCTSTR lpszSection, LPCTSTR lpszEntry, int nValue, bool bWriteFlush)
+	{
+		ATL::CAtlString sValue;
+		sValue.Format(_T("%d"), nValue);
+		WriteString(lpszSection, lpszEntry, sValue, bWriteFlush);
+	}
+
+	void WriteString(LPCTSTR lpszSection, LPCTSTR lpszEntry, LPCTSTR lpszValue, bool bWriteFlush)
+	{
+		if (lpszEntry == nullptr) // delete the section
+		{
+			m_pDocument.RemoveChild(GetDocumentElement(true), GetSectionElement(lpszSection, true));
+		}
+		else if (lpszValue == nullptr) // delete the entry
+		{
+			m_pDocument.RemoveChild(GetSectionElement(lpszSection, true), GetEntryElement(lpszSection, lpszEntry, true));
+		}
+		else
+		{
+			m_pDocument.SetText(GetEntryElement(lpszSection, lpszEntry, false), ToUTF8(lpszValue));
+		}
+		m_bDirty = true;
+
+		if (bWriteFlush)
+			Flush();
+	}
+
+	void WriteBinary(LPCTSTR lpszSection, LPCTSTR lpszEntry, const BYTE* pData, DWORD dwBytes, bool bWriteFlush)
+	{
+		String sBinary;
+		sBinary.reserve(static_cast<size_t>(dwBytes) * 2);
+		for (DWORD nIndex = 0; nIndex < dwBytes; nIndex++)
+		{
+			sBinary += static_cast<TCHAR>((pData[nIndex] & 0x0F) + 'A'); // low nibble
+			sBinary += static_cast<TCHAR>(((pData[nIndex] >> 4) & 0x0F) + 'A'); // high nibble
+		}
+		WriteString(lpszSection, lpszEntry, sBinary.c_str(), bWriteFlush);
+	}
+
+	void WriteStringArray(LPCTSTR lpszSection, LPCTSTR lpszEntry, const std::vector<String>& arr, bool bWriteFlush)
+	{
+		// A double null terminated list, as CXMLAppSettings writes it
+		String sStrings;
+		for (const auto& sText : arr)
+		{
+			sStrings += sText;
+			sStrings += _T('\0');
+		}
+		sStrings += _T('\0');
+		WriteBinary(lpszSection, lpszEntry, reinterpret_cast<const BYTE*>(sStrings.data()), static_cast<DWORD>(sStrings.length() * sizeof(TCHAR)), bWriteFlush);
+	}
+
+	void WriteSection(LPCTSTR lpszSection, const std::vector<String>& sectionEntries, bool bWriteFlush)
+	{
+		ATLASSERT(lpszSection != nullptr);
+
+		// Replace the whole section with the new entries
+		GetSectionElement(lpszSection, false);
+		WriteString(lpszSection, nullptr, nullptr, false);
+		for (const auto& sEntry : sectionEntries)
+		{
+			const size_t nSeparator = sEntry.find(_T('='));
+			const String sName{ sEntry.substr(0, nSeparator) };
+			const String sValue{ (nSeparator != String::npos) ? sEntry.substr(nSeparator + 1) : String{} };
+			WriteString(lpszSection, sName.c_str(), sValue.c_str(), false);
+		}
+
+		if (bWriteFlush)
+			Flush();
+	}
+
+	void Flush()
+	{
+		// Save to disk if there are changes
+		if (m_bDirty && m_bLoaded)
+		{
+			if (!m_pDocument.SaveFile(m_sXMLFile, m_bPrettyPrint))
+				ThrowWin32AppSettingsException(ERROR_WRITE_FAULT);
+			m_bDirty = false;
+		}
+	}
+
+protected:
+	static std::string ToUTF8(LPCTSTR lpszText)
+	{
+		return std::string{ ATL::CW2A(ATL::CT2W(lpszText), CP_UTF8) };
+	}
+
+	static String FromUTF8(const std::string& strText)
+	{
+		return String{ ATL::CW2T(ATL::CA2W(strText.c_str(), CP_UTF8)) };
+	}
+
+	/**
+	 * @brief Loads the file the first time it is needed. A missing or malformed file is an error when reading;
+	 *        when writing, it is replaced by a new document, like MSXML does.
+	 */
+	void LoadIfNecessary(bool bFailIfNotPresent)
+	{
+		if (!m_bLoaded)
+		{
+			ATLASSERT(m_sXMLFile.length());
+
+			if (!m_pDocument.LoadFile(m_sXMLFile) && bFailIfNotPresent)
+			{
+				std::error_code ec;
+				ThrowWin32AppSettingsException(std::filesystem::exists(m_sXMLFile, ec) ? ERROR_INVALID_DATA : ERROR_FILE_NOT_FOUND);
+			}
+			m_bLoaded = true;
+			m_bDirty = false;
+		}
+	}
+
+	XML_ELEMENT* GetDocumentElement(bool bReadOnly)
+	{
+		LoadIfNecessary(bReadOnly);
+
+		XML_ELEMENT* pRoot = m_pDocument.GetRoot();
+		if (pRoot == nullptr)
+		{
+			if (bReadOnly)
+				ThrowWin32AppSettingsException(ERROR_NOT_FOUND);
+			pRoot = m_pDocument.CreateRoot("xml");
+			m_bDirty = true;
+		}
+		return pRoot;
+	}
+
+	XML_ELEMENT* GetSectionElement(LPCTSTR lpszSection, bool bReadOnly)
+	{
+		// For compatibility with CXMLAppSettings, an empty section name is allowed
+		const std::string strSection{ ((lpszSection == nullptr) || (lpszSection[0] == _T('\0'))) ? std::string{ "IAPPSettings_Empty" } : ToUTF8(lpszSection) };
+
+		XML_ELEMENT* pRoot = GetDocumentElement(bReadOnly);
+		XML_ELEMENT* pSection = m_pDocument.FindIndexedChild(pRoot, strSection);
+		if (pSection == nullptr)
+		{
+			if (bReadOnly)
+				ThrowWin32AppSettingsException(ERROR_NOT_FOUND);
+			if ((pSection = m_pDocument.AppendChild(pRoot, strSection)) == nullptr)
+				ThrowWin32AppSettingsException(ERROR_INVALID_NAME);
+			m_bDirty = true;
+		}
+		return pSection;
+	}
+
+	XML_ELEMENT* GetEntryElement(LPCTSTR lpszSection, LPCTSTR lpszEntry, bool bReadOnly)
+	{
+		ATLASSERT(lpszEntry != nullptr);
+
+		const std::string strEntry{ ToUTF8(lpszEntry) };
+		XML_ELEMENT* pSection = GetSectionElement(lpszSection, bReadOnly);
+		XML_ELEMENT* pEntry = m_pDocument.FindIndexedChild(pSection, strEntry);
+		if (pEntry == nullptr)
+		{
+			if (bReadOnly)
+				ThrowWin32AppSettingsException(ERROR_NOT_FOUND);
+			if ((pEntry = m_pDocument.AppendChild(pSection, strEntry)) == nullptr)
+				ThrowWin32AppSettingsException(ERROR_INVALID_NAME);
+			m_bDirty = true;
+		}
+		return pEntry;
+	}
+
+	String m_sXMLFile; ///< The XML file
+	CXMLDocument m_pDocument; ///< The document of the file, once it is loaded
+	bool m_bLoaded; ///< The file was loaded (or found missing) into m_pDocument
+	bool m_bDirty; ///< A save is pending
+	bool m_bWriteFlush; ///< Save after every change
+	bool m_bPrettyPrint; ///< Indent the saved file
+};
@@ -0,0 +1,236 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#include "PipelinedReader.h"
+
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const size_t PIPELINE_ALIGNMENT = 0x1000; ///< Buffers are page aligned and whole pages long; the reads go through the page cache, so this is not required, only tidier for the copies.
+
+/**
+ * @brief Thin wrapper around the native file handle, for sequential reads.
+ */
+class CSequentialFile
+{
+public:
+	explicit CSequentialFile(const std::filesystem::path& strFilePath)
+	{
+#ifdef _WIN32
+		m_hFile = CreateFileW(strFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#else
+		m_nFile = open(strFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+#if defined(POSIX_FADV_SEQUENTIAL)
+		if (m_nFile >= 0)
+		{
+			posix_fadvise(m_nFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+		}
+#endif
+#endif
+	}
+
+	~CSequentialFile()
+	{
+#ifdef _WIN32
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+		}
+#else
+		if (m_nFile >= 0)
+		{
+			close(m_nFile);
+		}
+#endif
+	}
+
+	CSequentialFile(const CSequentialFile&) = delete;
+	CSequentialFile& operator=(const CSequentialFile&) = delete;
+
+	bool IsOpen() const
+	{
+#ifdef _WIN32
+		return m_hFile != INVALID_HANDLE_VALUE;
+#else
+		return m_nFile >= 0;
+#endif
+	}
+
+	/**
+	 * @brief Fills the buffer, stopping early only at the end of the file.
+	 * @return The number of bytes read (less than nLength at the end of the file), or -1 on error.
+	 */
+	long long Read(uint8_t* pBuffer, size_t nLength)
+	{
+		size_t nTotal = 0;
+		while (nTotal < nLength)
+		{
+#ifdef _WIN32
+			DWORD nRead = 0;
+			const DWORD nRequest = static_cast<DWORD>((std::min)(nLength - nTotal, static_cast<size_t>(0x40000000)));
+			if (!::ReadFile(m_hFile, pBuffer + nTotal, nRequest, &nRead, nullptr))
+			{
+				return -1;
+			}
+#else
+			const ssize_t nRead = pread(m_nFile, pBuffer + nTotal, nLength - nTotal, static_cast<off_t>(m_nOffset));
+			if (nRead < 0)
+			{
+				return -1;
+			}
+			m_nOffset += static_cast<unsigned long long>(nRead);
+#endif
+			if (nRead == 0)
+			{
+				break; // End of the file
+			}
+			nTotal += static_cast<size_t>(nRead);
+		}
+		return static_cast<long long>(nTotal);
+	}
+
+private:
+#ifdef _WIN32
+	HANDLE m_hFile;
+#else
+	int m_nFile;
+	unsigned long long m_nOffset = 0;
+#endif
+};
+
+CPipelinedReader::CPipelinedReader(size_t nBufferCount, size_t nBufferSize)
+	: m_nBufferCount((std::max)(nBufferCount, static_cast<size_t>(2))),
+	m_nBufferSize(((std::max)(nBufferSize, static_cast<size_t>(1)) + PIPELINE_ALIGNMENT - 1) & ~(PIPELINE_ALIGNMENT - 1))
+{
+}
+
+bool CPipelinedReader::Read(const std::filesystem::path& strFilePath, const std::function<void(const uint8_t*, size_t)>& pConsumer)
+{
+	CSequentialFile pFile(strFilePath);
+	if (!pFile.IsOpen())
+	{
+		return false;
+	}
+
+	// One allocation for the whole ring, aligned by hand
+	std::vector<uint8_t> arrStorage(m_nBufferCount * m_nBufferSize + PIPELINE_ALIGNMENT);
+	uint8_t* pRing = arrStorage.data() + ((PIPELINE_ALIGNMENT - (reinterpret_cast<uintptr_t>(arrStorage.data()) % PIPELINE_ALIGNMENT)) % PIPELINE_ALIGNMENT);
+	std::vector<size_t> arrLength(m_nBufferCount, 0);
+
+	// Ring state, shared by the reader thread and the consumer
+	std::mutex pMutex;
+	std::condition_variable pCondition;
+	size_t nFilled = 0;  // Buffers ready for the consumer
+	bool bEndOfFile = false;
+	bool bFailed = false;
+	bool bCancelled = false;
+
+	std::thread pReader([&]()
+	{
+		for (size_t nTail = 0; ; nTail = (nTail + 1) % m_nBufferCount)
+		{
+			{
+				// Wait for a free buffer
+				std::unique_lock<std::mutex> pLock(pMutex);
+				pCondition.wait(pLock, [&]() { return (nFilled < m_nBufferCount) || bCancelled; });
+				if (bCancelled)
+				{
+					return;
+				}
+			}
+
+			const long long nRead = pFile.Read(pRing + nTail * m_nBufferSize, m_nBufferSize);
+
+			std::lock_guard<std::mutex> pLock(pMutex);
+			if (nRead < 0)
+			{
+				bFailed = true;
+				bEndOfFile = true;
+			}
+			else
+			{
+				if (nRead > 0)
+				{
+					arrLength[nTail] = static_cast<size_t>(nRead);
+					nFilled++;
+				}
+				bEndOfFile = static_cast<size_t>(nRead) < m_nBufferSize;
+			}
+			pCondition.notify_all();
+			if (bEndOfFile)
+			{
+				return;
+			}
+		}
+	});
+
+	try
+	{
+		for (size_t nHead = 0; ; nHead = (nHead + 1) % m_nBufferCount)
+		{
+			{
+				// Wait for a filled buffer
+				std::unique_lock<std::mutex> pLock(pMutex);
+				pCondition.wait(pLock, [&]() { return (nFilled > 0) || bEndOfFile; });
+				if (nFilled == 0)
+				{
+					break;
+				}
+			}
+
+			pConsumer(pRing + nHead * m_nBufferSize, arrLength[nHead]);
+
+			// Give the buffer back to the reader
+			std::lock_guard<std::mutex> pLock(pMutex);
+			nFilled--;
+			pCondition.notify_all();
+		}
+	}
+	catch (...)
+	{
+		// Stop the reader before unwinding, it still uses the ring
+		{
+			std::lock_guard<std::mutex> pLock(pMutex);
+			bCancelled = true;
+			pCondition.notify_all();
+		}
+		pReader.join();
+		throw;
+	}
+
+	pReader.join();
+	return !bFailed;
+}
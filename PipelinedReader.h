@@ -0,0 +1,62 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+
+const size_t PIPELINE_BUFFER_COUNT = 4;        ///< Default number of buffers in the read ring.
+const size_t PIPELINE_BUFFER_SIZE = 0x100000;  ///< Default size of each buffer (1 MiB).
+
+/**
+ * @brief Reads a file sequentially on a background thread into a ring of aligned buffers,
+ *        handing each filled buffer to a consumer on the calling thread, so that reading
+ *        the next buffers overlaps with processing (e.g. hashing) the current one.
+ *
+ * The reader uses ReadFile on Windows and pread on POSIX systems.
+ */
+class CPipelinedReader
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * @param nBufferCount Number of buffers in the ring (at least 2).
+	 * @param nBufferSize Size of each buffer in bytes, rounded up to a multiple of 4 KiB.
+	 */
+	CPipelinedReader(size_t nBufferCount = PIPELINE_BUFFER_COUNT, size_t nBufferSize = PIPELINE_BUFFER_SIZE);
+
+	/**
+	 * @brief Reads the whole file, calling pConsumer for each chunk in file order.
+	 * @param strFilePath Path to the file to read.
+	 * @param pConsumer Receives a pointer to the data and its length; the data is valid only during the call.
+	 * @return true if the whole file was read, false if it couldn't be opened or read.
+	 */
+	bool Read(const std::filesystem::path& strFilePath, const std::function<void(const uint8_t*, size_t)>& pConsumer);
+
+private:
+	size_t m_nBufferCount; ///< Number of buffers in the ring
+	size_t m_nBufferSize;  ///< Size of each buffer
+};
@@ -0,0 +1,257 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#ifndef SHA2_H
+#define SHA2_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <array>
+#include <algorithm>
+#include "SHA256.h"
+#include "DigestValue.h"
+
+/**
+ * @brief Parameters of SHA-256: 32-bit words, 64 rounds, 64-byte blocks.
+ *        Blocks are compressed by the hardware accelerated transform of SHA256.
+ */
+struct SHA256Traits {
+	using Word = uint32_t;
+	static constexpr size_t Rounds = 64;
+	static constexpr size_t DigestSize = 32;
+	static constexpr const std::array<uint32_t, 64>& K = SHA256::K;
+	static constexpr std::array<uint32_t, 8> H0 = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	static constexpr std::array<unsigned, 3> Sigma0 = { 2, 13, 22 };  // Rotations of a
+	static constexpr std::array<unsigned, 3> Sigma1 = { 6, 11, 25 };  // Rotations of e
+	static constexpr std::array<unsigned, 3> sigma0 = { 7, 18, 3 };   // Message schedule, last one is a shift
+	static constexpr std::array<unsigned, 3> sigma1 = { 17, 19, 10 };
+
+	static void transform(uint32_t* state, const uint8_t* blocks, size_t count); // Defined in SHA256.cpp
+};
+
+/**
+ * @brief Parameters of SHA-512: 64-bit words, 80 rounds, 128-byte blocks.
+ *        On 64-bit CPUs without SHA extensions it hashes about 1.5 times as many bytes per round as SHA-256.
+ */
+struct SHA512Traits {
+	using Word = uint64_t;
+	static constexpr size_t Rounds = 80;
+	static constexpr size_t DigestSize = 64;
+	static constexpr std::array<uint64_t, 80> K = {
+		0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc,
+		0x3956c25bf348b538, 0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118,
+		0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+		0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694,
+		0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+		0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+		0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4,
+		0xc6e00bf33da88fc2, 0xd5a79147930aa725, 0x06ca6351e003826f, 0x142929670a0e6e70,
+		0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+		0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+		0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30,
+		0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+		0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8,
+		0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3,
+		0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+		0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b,
+		0xca273eceea26619c, 0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178,
+		0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+		0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c,
+		0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
+	};
+	static constexpr std::array<uint64_t, 8> H0 = {
+		0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+		0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179
+	};
+	static constexpr std::array<unsigned, 3> Sigma0 = { 28, 34, 39 };
+	static constexpr std::array<unsigned, 3> Sigma1 = { 14, 18, 41 };
+	static constexpr std::array<unsigned, 3> sigma0 = { 1, 8, 7 };
+	static constexpr std::array<unsigned, 3> sigma1 = { 19, 61, 6 };
+};
+
+/**
+ * @brief Parameters of SHA-512/256: SHA-512 with its own initial state, truncated to 32 bytes.
+ */
+struct SHA512_256Traits : SHA512Traits {
+	static constexpr size_t DigestSize = 32;
+	static constexpr std::array<uint64_t, 8> H0 = {
+		0x22312194fc2bf72c, 0x9f555fa3c84c64c2, 0x2393b86b6f53b151, 0x963877195940eabd,
+		0x96283ee2a88effe3, 0xbe5e1e2553863992, 0x2b0199fc2c85b8aa, 0x0eb72ddc81c52ca2
+	};
+};
+
+/**
+ * @brief The SHA-2 family (FIPS 180-4), parameterized on the word type, the round constants and,
+ *        through the word size, the block size. Same interface as SHA256.
+ *        A Traits type with a transform function supplies its own (e.g. accelerated) compression.
+ */
+template <typename Traits>
+class SHA2 {
+
+public:
+	using Word = typename Traits::Word;
+	static constexpr size_t BlockSize = 16 * sizeof(Word);
+	static constexpr size_t DigestSize = Traits::DigestSize;
+	using Digest = std::array<uint8_t, DigestSize>;
+
+	SHA2() {
+		std::copy(Traits::H0.begin(), Traits::H0.end(), m_state);
+	}
+
+	void update(const uint8_t* data, size_t length) {
+		// Top up a partially filled block first
+		if (m_blocklen > 0) {
+			const size_t head = (std::min)(length, BlockSize - m_blocklen);
+			memcpy(m_data + m_blocklen, data, head);
+			m_blocklen += head;
+			data += head;
+			length -= head;
+
+			if (m_blocklen < BlockSize) {
+				return;
+			}
+			compress(m_state, m_data, 1);
+			m_bitlen += BlockSize * 8;
+			m_blocklen = 0;
+		}
+
+		// Hash whole blocks straight from the caller's buffer
+		const size_t blocks = length / BlockSize;
+		if (blocks > 0) {
+			compress(m_state, data, blocks);
+			m_bitlen += static_cast<uint64_t>(blocks) * BlockSize * 8;
+			data += blocks * BlockSize;
+			length -= blocks * BlockSize;
+		}
+
+		// Keep the tail for the next update or for digest()
+		memcpy(m_data, data, length);
+		m_blocklen = length;
+	}
+
+	void update(const std::string& data) {
+		update(reinterpret_cast<const uint8_t*>(data.c_str()), data.size());
+	}
+
+	Digest digest() {
+		// Append the 1 bit, then zeros up to the length field, which takes the last two words of a block
+		const uint64_t bitlen = m_bitlen + static_cast<uint64_t>(m_blocklen) * 8;
+		m_data[m_blocklen++] = 0x80;
+		if (m_blocklen > BlockSize - 2 * sizeof(Word)) {
+			memset(m_data + m_blocklen, 0, BlockSize - m_blocklen);
+			compress(m_state, m_data, 1);
+			m_blocklen = 0;
+		}
+		memset(m_data + m_blocklen, 0, BlockSize - m_blocklen);
+		for (size_t i = 0; i < 8; i++) { // Big endian; the length is never above 2^64 bits
+			m_data[BlockSize - 1 - i] = static_cast<uint8_t>(bitlen >> (i * 8));
+		}
+		compress(m_state, m_data, 1);
+
+		// Big endian words, truncated to the digest size
+		Digest hash;
+		for (size_t i = 0; i < DigestSize; i++) {
+			hash[i] = static_cast<uint8_t>(m_state[i / sizeof(Word)] >> ((sizeof(Word) - 1 - i % sizeof(Word)) * 8));
+		}
+		return hash;
+	}
+
+	static std::string toString(const Digest& digest) {
+		return DigestValue(digest).toString();
+	}
+
+private:
+	uint8_t m_data[BlockSize] = { 0, };
+	size_t m_blocklen = 0;
+	uint64_t m_bitlen = 0;
+	Word m_state[8]; // A, B, C, D, E, F, G, H
+
+	static Word rotr(Word x, unsigned n) {
+		return (x >> n) | (x << (8 * sizeof(Word) - n));
+	}
+
+	static Word bigSigma(Word x, const std::array<unsigned, 3>& r) {
+		return rotr(x, r[0]) ^ rotr(x, r[1]) ^ rotr(x, r[2]);
+	}
+
+	static Word smallSigma(Word x, const std::array<unsigned, 3>& r) {
+		return rotr(x, r[0]) ^ rotr(x, r[1]) ^ (x >> r[2]);
+	}
+
+	static void compress(Word* state, const uint8_t* blocks, size_t count) {
+		if constexpr (requires { Traits::transform(state, blocks, count); }) {
+			Traits::transform(state, blocks, count);
+		}
+		else {
+			transformPortable(state, blocks, count);
+		}
+	}
+
+	static void transformPortable(Word* hash, const uint8_t* blocks, size_t count) {
+		Word m[16], s[8];
+
+		for (; count > 0; count--, blocks += BlockSize) {
+			for (size_t i = 0; i < 16; i++) { // Split data in big endian words for the 16 first words
+				m[i] = 0;
+				for (size_t j = 0; j < sizeof(Word); j++) {
+					m[i] = (m[i] << 8) | blocks[i * sizeof(Word) + j];
+				}
+			}
+
+			std::copy(hash, hash + 8, s);
+
+			for (size_t i = 0; i < Traits::Rounds; i++) {
+				if (i >= 16) { // Remaining words, computed in place over the oldest one
+					m[i & 15] += smallSigma(m[(i - 2) & 15], Traits::sigma1) + m[(i - 7) & 15] + smallSigma(m[(i - 15) & 15], Traits::sigma0);
+				}
+
+				const Word sum = m[i & 15] + Traits::K[i] + s[7] + ((s[4] & s[5]) ^ (~s[4] & s[6])) + bigSigma(s[4], Traits::Sigma1);
+				const Word newA = bigSigma(s[0], Traits::Sigma0) + ((s[0] & (s[1] | s[2])) | (s[1] & s[2])) + sum;
+				const Word newE = s[3] + sum;
+
+				s[7] = s[6];
+				s[6] = s[5];
+				s[5] = s[4];
+				s[4] = newE;
+				s[3] = s[2];
+				s[2] = s[1];
+				s[1] = s[0];
+				s[0] = newA;
+			}
+
+			for (size_t i = 0; i < 8; i++) {
+				hash[i] += s[i];
+			}
+		}
+	}
+};
+
+using SHA512 = SHA2<SHA512Traits>;
+using SHA512_256 = SHA2<SHA512_256Traits>;
+
+#endif
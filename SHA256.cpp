@@ -20,157 +20,305 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
-#include "pch.h"
 #include "SHA256.h"
+#include "SHA2.h"
+#include "DigestValue.h"
 #include <cstring>
-#include <sstream>
-#include <iomanip>
-
-SHA256::SHA256() : m_blocklen(0), m_bitlen(0) {
-	m_state[0] = 0x6a09e667;
-	m_state[1] = 0xbb67ae85;
-	m_state[2] = 0x3c6ef372;
-	m_state[3] = 0xa54ff53a;
-	m_state[4] = 0x510e527f;
-	m_state[5] = 0x9b05688c;
-	m_state[6] = 0x1f83d9ab;
-	m_state[7] = 0x5be0cd19;
-}
-
-void SHA256::update(const uint8_t* data, size_t length) {
-	for (size_t i = 0; i < length; i++) {
-		m_data[m_blocklen++] = data[i];
-		if (m_blocklen == 64) {
-			transform();
-
-			// End of the block
-			m_bitlen += 512;
-			m_blocklen = 0;
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SHA256_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSSE3/SHA instructions inside functions that opt in; MSVC always does
+#if defined(__GNUC__) || defined(__clang__)
+#define SHA256_TARGET(x) __attribute__((target(x)))
+#else
+#define SHA256_TARGET(x)
+#endif
+
+// The compile-time path must agree with the NIST FIPS 180-2 examples
+static constexpr bool matchesHex(const std::array<uint8_t, 32>& digest, std::string_view hex) {
+	constexpr std::string_view digits = "0123456789abcdef";
+	for (size_t i = 0; i < digest.size(); i++) {
+		if ((digits[digest[i] >> 4] != hex[2 * i]) || (digits[digest[i] & 15] != hex[2 * i + 1])) {
+			return false;
 		}
 	}
+	return hex.size() == 2 * digest.size();
 }
 
-void SHA256::update(const std::string& data) {
-	update(reinterpret_cast<const uint8_t*> (data.c_str()), data.size());
+static_assert(matchesHex(SHA256::hash(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+static_assert(matchesHex(SHA256::hash("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+static_assert(matchesHex(SHA256::hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+	"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+static_assert(matchesHex(SHA256::hash("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"),
+	"cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"));
+static_assert(SHA256::hash(std::array<uint8_t, 3>{ 'a', 'b', 'c' }) == SHA256::hash("abc"));
+
+// State layout: format version, block length, two zero bytes, then big endian A-H and bit length,
+// then the pending bytes of the current block, zero padded
+static constexpr uint8_t STATE_FORMAT = 1;
+
+std::array<uint8_t, SHA256::StateSize> SHA256::saveState() const {
+	std::array<uint8_t, StateSize> state = { 0, };
+	state[0] = STATE_FORMAT;
+	state[1] = static_cast<uint8_t>(m_blocklen);
+	for (size_t i = 0; i < 8; i++) {
+		for (size_t j = 0; j < 4; j++) {
+			state[4 + 4 * i + j] = static_cast<uint8_t>(m_state[i] >> (24 - 8 * j));
+		}
+	}
+	for (size_t i = 0; i < 8; i++) {
+		state[36 + i] = static_cast<uint8_t>(m_bitlen >> (56 - 8 * i));
+	}
+	memcpy(state.data() + 44, m_data, m_blocklen);
+	return state;
 }
 
-std::array<uint8_t, 32> SHA256::digest() {
-	std::array<uint8_t, 32> hash;
-
-	pad();
-	revert(hash);
-
-	return hash;
-}
+bool SHA256::loadState(const uint8_t* data, size_t length) {
+	if ((length != StateSize) || (data[0] != STATE_FORMAT) || (data[1] >= 64) || (data[2] != 0) || (data[3] != 0)) {
+		return false;
+	}
+	uint64_t bitlen = 0;
+	for (size_t i = 0; i < 8; i++) {
+		bitlen = (bitlen << 8) | data[36 + i];
+	}
+	if (bitlen % 512 != 0) { // Only whole blocks are counted before the tail is hashed
+		return false;
+	}
 
-uint32_t SHA256::rotr(uint32_t x, uint32_t n) {
-	return (x >> n) | (x << (32 - n));
+	for (size_t i = 0; i < 8; i++) {
+		m_state[i] = (static_cast<uint32_t>(data[4 + 4 * i]) << 24) | (static_cast<uint32_t>(data[5 + 4 * i]) << 16) |
+			(static_cast<uint32_t>(data[6 + 4 * i]) << 8) | static_cast<uint32_t>(data[7 + 4 * i]);
+	}
+	m_bitlen = bitlen;
+	m_blocklen = data[1];
+	memset(m_data, 0, sizeof(m_data));
+	memcpy(m_data, data + 44, m_blocklen);
+	return true;
 }
 
-uint32_t SHA256::choose(uint32_t e, uint32_t f, uint32_t g) {
-	return (e & f) ^ (~e & g);
+uint64_t SHA256::length() const {
+	return m_bitlen / 8 + m_blocklen;
 }
 
-uint32_t SHA256::majority(uint32_t a, uint32_t b, uint32_t c) {
-	return (a & (b | c)) | (b & c);
+void SHA256Traits::transform(uint32_t* state, const uint8_t* blocks, size_t count) {
+	SHA256::selectedTransform().load(std::memory_order_relaxed)(state, blocks, count);
 }
 
-uint32_t SHA256::sig0(uint32_t x) {
-	return SHA256::rotr(x, 7) ^ SHA256::rotr(x, 18) ^ (x >> 3);
-}
+#ifdef SHA256_X86
 
-uint32_t SHA256::sig1(uint32_t x) {
-	return SHA256::rotr(x, 17) ^ SHA256::rotr(x, 19) ^ (x >> 10);
-}
+// 4-lane versions of sig0/sig1 on the message schedule; SSE has no vector rotate
+#define SHA256_ROTR_EPI32(x, n) _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
+#define SHA256_SIG0_EPI32(x) _mm_xor_si128(_mm_xor_si128(SHA256_ROTR_EPI32(x, 7), SHA256_ROTR_EPI32(x, 18)), _mm_srli_epi32((x), 3))
+#define SHA256_SIG1_EPI32(x) _mm_xor_si128(_mm_xor_si128(SHA256_ROTR_EPI32(x, 17), SHA256_ROTR_EPI32(x, 19)), _mm_srli_epi32((x), 10))
 
-void SHA256::transform() {
-	uint32_t maj, xorA, ch, xorE, sum, newA, newE, m[64];
+SHA256_TARGET("ssse3")
+void SHA256::transformSSSE3(uint32_t* hash, const uint8_t* blocks, size_t count) {
+	alignas(16) uint32_t wk[64]; // Message schedule with the round constants already added
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	uint32_t maj, xorA, ch, xorE, sum, newA, newE;
 	uint32_t state[8];
 
-	for (uint8_t i = 0, j = 0; i < 16; i++, j += 4) { // Split data in 32 bit blocks for the 16 first words
-		m[i] = (m_data[j] << 24) | (m_data[j + 1] << 16) | (m_data[j + 2] << 8) | (m_data[j + 3]);
-	}
+	for (; count > 0; count--, blocks += 64) {
+		// Load the 16 first words, converting from big endian with a single shuffle per 4 words
+		__m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks)), bswap);
+		__m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16)), bswap);
+		__m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 32)), bswap);
+		__m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 48)), bswap);
+
+		for (uint8_t i = 0; i < 64; i += 4) {
+			_mm_store_si128(reinterpret_cast<__m128i*>(&wk[i]), _mm_add_epi32(x0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[i]))));
+			__m128i next = x0;
+			if (i < 48) {
+				// Next 4 words: x0 holds m[k - 16..k - 13] and x3 holds m[k - 4..k - 1]
+				next = _mm_add_epi32(_mm_add_epi32(x0, _mm_alignr_epi8(x3, x2, 4)), SHA256_SIG0_EPI32(_mm_alignr_epi8(x1, x0, 4)));
+				// m[k] and m[k + 1] only depend on words we already have...
+				next = _mm_add_epi32(next, SHA256_SIG1_EPI32(_mm_srli_si128(x3, 8)));
+				// ...while m[k + 2] and m[k + 3] depend on the two we just computed (sig1(0) is 0)
+				next = _mm_add_epi32(next, SHA256_SIG1_EPI32(_mm_slli_si128(next, 8)));
+			}
+			x0 = x1;
+			x1 = x2;
+			x2 = x3;
+			x3 = next;
+		}
 
-	for (uint8_t k = 16; k < 64; k++) { // Remaining 48 blocks
-		m[k] = SHA256::sig1(m[k - 2]) + m[k - 7] + SHA256::sig0(m[k - 15]) + m[k - 16];
-	}
+		for (uint8_t i = 0; i < 8; i++) {
+			state[i] = hash[i];
+		}
 
-	for (uint8_t i = 0; i < 8; i++) {
-		state[i] = m_state[i];
-	}
+		for (uint8_t i = 0; i < 64; i++) {
+			maj = SHA256::majority(state[0], state[1], state[2]);
+			xorA = SHA256::rotr(state[0], 2) ^ SHA256::rotr(state[0], 13) ^ SHA256::rotr(state[0], 22);
 
-	for (uint8_t i = 0; i < 64; i++) {
-		maj = SHA256::majority(state[0], state[1], state[2]);
-		xorA = SHA256::rotr(state[0], 2) ^ SHA256::rotr(state[0], 13) ^ SHA256::rotr(state[0], 22);
+			ch = choose(state[4], state[5], state[6]);
 
-		ch = choose(state[4], state[5], state[6]);
+			xorE = SHA256::rotr(state[4], 6) ^ SHA256::rotr(state[4], 11) ^ SHA256::rotr(state[4], 25);
 
-		xorE = SHA256::rotr(state[4], 6) ^ SHA256::rotr(state[4], 11) ^ SHA256::rotr(state[4], 25);
+			sum = wk[i] + state[7] + ch + xorE;
+			newA = xorA + maj + sum;
+			newE = state[3] + sum;
 
-		sum = m[i] + K[i] + state[7] + ch + xorE;
-		newA = xorA + maj + sum;
-		newE = state[3] + sum;
+			state[7] = state[6];
+			state[6] = state[5];
+			state[5] = state[4];
+			state[4] = newE;
+			state[3] = state[2];
+			state[2] = state[1];
+			state[1] = state[0];
+			state[0] = newA;
+		}
 
-		state[7] = state[6];
-		state[6] = state[5];
-		state[5] = state[4];
-		state[4] = newE;
-		state[3] = state[2];
-		state[2] = state[1];
-		state[1] = state[0];
-		state[0] = newA;
+		for (uint8_t i = 0; i < 8; i++) {
+			hash[i] += state[i];
+		}
 	}
+}
 
-	for (uint8_t i = 0; i < 8; i++) {
-		m_state[i] += state[i];
+SHA256_TARGET("sha,sse4.1,ssse3")
+void SHA256::transformSHANI(uint32_t* hash, const uint8_t* blocks, size_t count) {
+	const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	// The SHA instructions keep the state as ABEF/CDGH instead of ABCD/EFGH
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&hash[0])), 0xB1); // CDAB
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&hash[4])), 0x1B); // EFGH
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0); // CDGH
+
+	for (; count > 0; count--, blocks += 64) {
+		const __m128i abefSave = state0;
+		const __m128i cdghSave = state1;
+		__m128i msg[4];
+
+		for (uint8_t i = 0; i < 4; i++) {
+			msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * 16)), bswap);
+		}
+
+		// 16 groups of 4 rounds, each computing the message words needed 4 groups later
+		for (uint8_t i = 0; i < 16; i++) {
+			__m128i wk = _mm_add_epi32(msg[i & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[i * 4])));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+			wk = _mm_shuffle_epi32(wk, 0x0E);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+
+			if (i < 12) {
+				tmp = _mm_add_epi32(_mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]), _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4));
+				msg[i & 3] = _mm_sha256msg2_epu32(tmp, msg[(i + 3) & 3]);
+			}
+		}
+
+		state0 = _mm_add_epi32(state0, abefSave);
+		state1 = _mm_add_epi32(state1, cdghSave);
 	}
+
+	// Back to ABCD/EFGH
+	tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1); // DCHG
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(&hash[0]), _mm_blend_epi16(tmp, state1, 0xF0)); // DCBA
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(&hash[4]), _mm_alignr_epi8(state1, tmp, 8)); // HGFE
+}
+
+#else
+
+void SHA256::transformSSSE3(uint32_t* hash, const uint8_t* blocks, size_t count) {
+	transformPortable(hash, blocks, count);
 }
 
-void SHA256::pad() {
+void SHA256::transformSHANI(uint32_t* hash, const uint8_t* blocks, size_t count) {
+	transformPortable(hash, blocks, count);
+}
+
+#endif
 
-	uint64_t i = m_blocklen;
-	uint8_t end = m_blocklen < 56 ? 56 : 64;
+bool SHA256::isSupported(Backend backend) {
+	if (backend == Backend::Portable) {
+		return true;
+	}
+#ifdef SHA256_X86
+	int regs[4] = { 0, }; // EAX, EBX, ECX, EDX
+	int maxLeaf = 0;
+#if defined(_MSC_VER)
+	__cpuid(regs, 0);
+	maxLeaf = regs[0];
+#else
+	maxLeaf = static_cast<int>(__get_cpuid_max(0, nullptr));
+#endif
+	if (maxLeaf < 1) {
+		return false;
+	}
 
-	m_data[i++] = 0x80; // Append a bit 1
-	while (i < end) {
-		m_data[i++] = 0x00; // Pad with zeros
+#if defined(_MSC_VER)
+	__cpuid(regs, 1);
+#else
+	__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	const bool ssse3 = (regs[2] & (1 << 9)) != 0;
+	const bool sse41 = (regs[2] & (1 << 19)) != 0;
+	if (backend == Backend::SSSE3) {
+		return ssse3;
 	}
 
-	if (m_blocklen >= 56) {
-		transform();
-		memset(m_data, 0, 56);
+	if (maxLeaf < 7) {
+		return false;
 	}
+#if defined(_MSC_VER)
+	__cpuidex(regs, 7, 0);
+#else
+	__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	const bool sha = (regs[1] & (1 << 29)) != 0;
+	return (backend == Backend::SHANI) && sha && sse41 && ssse3;
+#else
+	return false;
+#endif
+}
 
-	// Append to the padding the total message's length in bits and transform.
-	m_bitlen += m_blocklen * 8;
-	m_data[63] = static_cast<uint8_t>(m_bitlen);
-	m_data[62] = static_cast<uint8_t>(m_bitlen >> 8);
-	m_data[61] = static_cast<uint8_t>(m_bitlen >> 16);
-	m_data[60] = static_cast<uint8_t>(m_bitlen >> 24);
-	m_data[59] = static_cast<uint8_t>(m_bitlen >> 32);
-	m_data[58] = static_cast<uint8_t>(m_bitlen >> 40);
-	m_data[57] = static_cast<uint8_t>(m_bitlen >> 48);
-	m_data[56] = static_cast<uint8_t>(m_bitlen >> 56);
-	transform();
+std::atomic<SHA256::TransformFn>& SHA256::selectedTransform() {
+	// Runs the CPUID checks only once, the first time a block is hashed
+	static std::atomic<TransformFn> transformFn = isSupported(Backend::SHANI) ? &SHA256::transformSHANI
+		: isSupported(Backend::SSSE3) ? &SHA256::transformSSSE3
+		: &SHA256::transformPortable;
+	return transformFn;
 }
 
-void SHA256::revert(std::array<uint8_t, 32>& hash) {
-	// SHA uses big endian byte ordering
-	// Revert all bytes
-	for (uint8_t i = 0; i < 4; i++) {
-		for (uint8_t j = 0; j < 8; j++) {
-			hash[i + (j * 4)] = (m_state[j] >> (24 - i * 8)) & 0x000000ff;
-		}
+SHA256::Backend SHA256::backend() {
+	const TransformFn transformFn = selectedTransform().load(std::memory_order_relaxed);
+	if (transformFn == &SHA256::transformSHANI) {
+		return Backend::SHANI;
 	}
+	if (transformFn == &SHA256::transformSSSE3) {
+		return Backend::SSSE3;
+	}
+	return Backend::Portable;
 }
 
-std::string SHA256::toString(const std::array<uint8_t, 32>& digest) {
-	std::stringstream s;
-	s << std::setfill('0') << std::hex;
+bool SHA256::setBackend(Backend backend) {
+	if (!isSupported(backend)) {
+		return false;
+	}
 
-	for (uint8_t i = 0; i < 32; i++) {
-		s << std::setw(2) << (unsigned int)digest[i];
+	switch (backend) {
+	case Backend::SHANI:
+		selectedTransform().store(&SHA256::transformSHANI, std::memory_order_relaxed);
+		break;
+	case Backend::SSSE3:
+		selectedTransform().store(&SHA256::transformSSSE3, std::memory_order_relaxed);
+		break;
+	default:
+		selectedTransform().store(&SHA256::transformPortable, std::memory_order_relaxed);
+		break;
 	}
+	return true;
+}
 
-	return s.str();
+std::string SHA256::toString(const std::array<uint8_t, 32>& digest) {
+	return DigestValue(digest).toString();
 }
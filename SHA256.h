@@ -23,20 +23,49 @@ SOFTWARE.*/
 #ifndef SHA256_H
 #define SHA256_H
 
+#include <cstdint>
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <array>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
 
 class SHA256 {
 
 public:
-	SHA256();
-	void update(const uint8_t* data, size_t length);
-	void update(const std::string& data);
-	std::array<uint8_t, 32> digest();
+	// Also usable in constant expressions, e.g. static_assert(SHA256::hash("abc") == ...);
+	// the portable transform is used at compile time, the selected backend at run time
+	constexpr SHA256();
+	constexpr void update(const uint8_t* data, size_t length);
+	constexpr void update(std::string_view data);
+	constexpr std::array<uint8_t, 32> digest();
+
+	static constexpr std::array<uint8_t, 32> hash(std::string_view data);
+	template <size_t N>
+	static constexpr std::array<uint8_t, 32> hash(const std::array<uint8_t, N>& data);
 
 	static std::string toString(const std::array<uint8_t, 32>& digest);
 
+	// Hasher state, so that an interrupted calculation can be continued later, even by another process
+	static constexpr size_t StateSize = 4 + 32 + 8 + 64; // Format and block length, A-H, bit length, pending bytes
+	std::array<uint8_t, StateSize> saveState() const;
+	bool loadState(const uint8_t* data, size_t length); // Returns false (and changes nothing) if data is not a saved state
+	uint64_t length() const; // Number of bytes hashed so far
+
+	// Block transform implementations, selected once at startup by CPUID
+	enum class Backend { Portable, SSSE3, SHANI };
+	static Backend backend();
+	static bool isSupported(Backend backend);
+	static bool setBackend(Backend backend); // Returns false if the CPU lacks the required extensions
+
 private:
+	friend class SHA256MultiBuffer; // Shares K, the initial state and the selected transform
+	friend struct SHA256Traits; // Lets SHA2<SHA256Traits> use K and the selected transform
+
+	using TransformFn = void (*)(uint32_t* state, const uint8_t* blocks, size_t count);
+
 	uint8_t  m_data[64] = { 0, };
 	uint32_t m_blocklen;
 	uint64_t m_bitlen;
@@ -61,14 +90,206 @@ private:
 		0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
 	};
 
-	static uint32_t rotr(uint32_t x, uint32_t n);
-	static uint32_t choose(uint32_t e, uint32_t f, uint32_t g);
-	static uint32_t majority(uint32_t a, uint32_t b, uint32_t c);
-	static uint32_t sig0(uint32_t x);
-	static uint32_t sig1(uint32_t x);
-	void transform();
-	void pad();
-	void revert(std::array<uint8_t, 32>& hash);
+	static constexpr uint32_t rotr(uint32_t x, uint32_t n);
+	static constexpr uint32_t choose(uint32_t e, uint32_t f, uint32_t g);
+	static constexpr uint32_t majority(uint32_t a, uint32_t b, uint32_t c);
+	static constexpr uint32_t sig0(uint32_t x);
+	static constexpr uint32_t sig1(uint32_t x);
+	static constexpr void transformPortable(uint32_t* state, const uint8_t* blocks, size_t count);
+	static void transformSSSE3(uint32_t* state, const uint8_t* blocks, size_t count);
+	static void transformSHANI(uint32_t* state, const uint8_t* blocks, size_t count);
+	static std::atomic<TransformFn>& selectedTransform(); // setBackend may change it while other threads hash
+	constexpr void transform(const uint8_t* blocks, size_t count);
+	constexpr void pad();
+	constexpr void revert(std::array<uint8_t, 32>& hash) const;
 };
 
+constexpr SHA256::SHA256() : m_blocklen(0), m_bitlen(0),
+	m_state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 } {
+}
+
+constexpr void SHA256::update(const uint8_t* data, size_t length) {
+	// Top up a partially filled block first
+	if (m_blocklen > 0) {
+		const size_t head = (std::min)(length, static_cast<size_t>(64 - m_blocklen));
+		std::copy_n(data, head, m_data + m_blocklen);
+		m_blocklen += static_cast<uint32_t>(head);
+		data += head;
+		length -= head;
+
+		if (m_blocklen < 64) {
+			return;
+		}
+		transform(m_data, 1);
+
+		// End of the block
+		m_bitlen += 512;
+		m_blocklen = 0;
+	}
+
+	// Hash whole blocks straight from the caller's buffer
+	const size_t blocks = length / 64;
+	if (blocks > 0) {
+		transform(data, blocks);
+		m_bitlen += static_cast<uint64_t>(blocks) * 512;
+		data += blocks * 64;
+		length -= blocks * 64;
+	}
+
+	// Keep the tail for the next update or for pad()
+	std::copy_n(data, length, m_data);
+	m_blocklen = static_cast<uint32_t>(length);
+}
+
+constexpr void SHA256::update(std::string_view data) {
+	if (std::is_constant_evaluated()) {
+		// reinterpret_cast is not allowed in constant expressions, so the characters are copied a block at a time
+		uint8_t bytes[64] = { 0, };
+		while (!data.empty()) {
+			const size_t length = (std::min)(data.size(), sizeof(bytes));
+			for (size_t i = 0; i < length; i++) {
+				bytes[i] = static_cast<uint8_t>(data[i]);
+			}
+			update(bytes, length);
+			data.remove_prefix(length);
+		}
+	} else {
+		update(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+	}
+}
+
+constexpr std::array<uint8_t, 32> SHA256::digest() {
+	std::array<uint8_t, 32> hash = { 0, };
+
+	pad();
+	revert(hash);
+
+	return hash;
+}
+
+constexpr std::array<uint8_t, 32> SHA256::hash(std::string_view data) {
+	SHA256 sha256;
+	sha256.update(data);
+	return sha256.digest();
+}
+
+template <size_t N>
+constexpr std::array<uint8_t, 32> SHA256::hash(const std::array<uint8_t, N>& data) {
+	SHA256 sha256;
+	sha256.update(data.data(), N);
+	return sha256.digest();
+}
+
+constexpr uint32_t SHA256::rotr(uint32_t x, uint32_t n) {
+	return (x >> n) | (x << (32 - n));
+}
+
+constexpr uint32_t SHA256::choose(uint32_t e, uint32_t f, uint32_t g) {
+	return (e & f) ^ (~e & g);
+}
+
+constexpr uint32_t SHA256::majority(uint32_t a, uint32_t b, uint32_t c) {
+	return (a & (b | c)) | (b & c);
+}
+
+constexpr uint32_t SHA256::sig0(uint32_t x) {
+	return SHA256::rotr(x, 7) ^ SHA256::rotr(x, 18) ^ (x >> 3);
+}
+
+constexpr uint32_t SHA256::sig1(uint32_t x) {
+	return SHA256::rotr(x, 17) ^ SHA256::rotr(x, 19) ^ (x >> 10);
+}
+
+constexpr void SHA256::transform(const uint8_t* blocks, size_t count) {
+	if (std::is_constant_evaluated()) {
+		transformPortable(m_state, blocks, count); // The accelerated backends use intrinsics
+	} else {
+		selectedTransform().load(std::memory_order_relaxed)(m_state, blocks, count);
+	}
+}
+
+constexpr void SHA256::transformPortable(uint32_t* hash, const uint8_t* blocks, size_t count) {
+	uint32_t maj = 0, xorA = 0, ch = 0, xorE = 0, sum = 0, newA = 0, newE = 0, m[16] = { 0, };
+	uint32_t state[8] = { 0, };
+
+	for (; count > 0; count--, blocks += 64) {
+		for (uint8_t i = 0, j = 0; i < 16; i++, j += 4) { // Split data in 32 bit blocks for the 16 first words
+			m[i] = (static_cast<uint32_t>(blocks[j]) << 24) | (static_cast<uint32_t>(blocks[j + 1]) << 16) |
+				(static_cast<uint32_t>(blocks[j + 2]) << 8) | static_cast<uint32_t>(blocks[j + 3]);
+		}
+
+		for (uint8_t i = 0; i < 8; i++) {
+			state[i] = hash[i];
+		}
+
+		for (uint8_t i = 0; i < 64; i++) {
+			if (i >= 16) { // Remaining 48 words, computed in place over the oldest one
+				m[i & 15] += SHA256::sig1(m[(i - 2) & 15]) + m[(i - 7) & 15] + SHA256::sig0(m[(i - 15) & 15]);
+			}
+
+			maj = SHA256::majority(state[0], state[1], state[2]);
+			xorA = SHA256::rotr(state[0], 2) ^ SHA256::rotr(state[0], 13) ^ SHA256::rotr(state[0], 22);
+
+			ch = choose(state[4], state[5], state[6]);
+
+			xorE = SHA256::rotr(state[4], 6) ^ SHA256::rotr(state[4], 11) ^ SHA256::rotr(state[4], 25);
+
+			sum = m[i & 15] + K[i] + state[7] + ch + xorE;
+			newA = xorA + maj + sum;
+			newE = state[3] + sum;
+
+			state[7] = state[6];
+			state[6] = state[5];
+			state[5] = state[4];
+			state[4] = newE;
+			state[3] = state[2];
+			state[2] = state[1];
+			state[1] = state[0];
+			state[0] = newA;
+		}
+
+		for (uint8_t i = 0; i < 8; i++) {
+			hash[i] += state[i];
+		}
+	}
+}
+
+constexpr void SHA256::pad() {
+
+	uint64_t i = m_blocklen;
+	uint8_t end = m_blocklen < 56 ? 56 : 64;
+
+	m_data[i++] = 0x80; // Append a bit 1
+	while (i < end) {
+		m_data[i++] = 0x00; // Pad with zeros
+	}
+
+	if (m_blocklen >= 56) {
+		transform(m_data, 1);
+		std::fill_n(m_data, 56, static_cast<uint8_t>(0));
+	}
+
+	// Append to the padding the total message's length in bits and transform.
+	m_bitlen += m_blocklen * 8;
+	m_data[63] = static_cast<uint8_t>(m_bitlen);
+	m_data[62] = static_cast<uint8_t>(m_bitlen >> 8);
+	m_data[61] = static_cast<uint8_t>(m_bitlen >> 16);
+	m_data[60] = static_cast<uint8_t>(m_bitlen >> 24);
+	m_data[59] = static_cast<uint8_t>(m_bitlen >> 32);
+	m_data[58] = static_cast<uint8_t>(m_bitlen >> 40);
+	m_data[57] = static_cast<uint8_t>(m_bitlen >> 48);
+	m_data[56] = static_cast<uint8_t>(m_bitlen >> 56);
+	transform(m_data, 1);
+}
+
+constexpr void SHA256::revert(std::array<uint8_t, 32>& hash) const {
+	// SHA uses big endian byte ordering
+	// Revert all bytes
+	for (uint8_t i = 0; i < 4; i++) {
+		for (uint8_t j = 0; j < 8; j++) {
+			hash[i + (j * 4)] = (m_state[j] >> (24 - i * 8)) & 0x000000ff;
+		}
+	}
+}
+
 #endif
@@ -0,0 +1,357 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#include "SHA256MultiBuffer.h"
+#include "SHA256.h"
+#include <cstring>
+#include <fstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__SSE2__)
+#define SHA256MB_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SHA256MB_TARGET(x) __attribute__((target(x)))
+#else
+#define SHA256MB_TARGET(x)
+#endif
+
+constexpr size_t MAX_LANES = 8;
+constexpr size_t LANE_BUFFER = 0x10000; ///< Read buffer per lane when hashing files.
+
+/**
+ * @brief One SIMD lane: feeds the 64-byte blocks of its current input, padding included.
+ *        Memory inputs are read in place; file inputs go through a per-lane buffer.
+ */
+struct SHA256MultiBuffer::Lane {
+	size_t input = SIZE_MAX;    ///< Index of the input being hashed, SIZE_MAX when idle
+	const uint8_t* data = nullptr;
+	size_t available = 0;       ///< Bytes left at data
+	uint64_t length = 0;        ///< Bytes hashed so far, for the final length field
+	std::ifstream file;
+	std::vector<uint8_t> buffer;
+	bool failed = false;
+	uint8_t tail[128] = { 0, }; ///< Last partial block plus padding
+	uint8_t tailBlocks = 0;
+	uint8_t tailNext = 0;
+	bool padded = false;
+
+	void reset(size_t index) {
+		input = index;
+		data = nullptr;
+		available = 0;
+		length = 0;
+		failed = false;
+		tailBlocks = 0;
+		tailNext = 0;
+		padded = false;
+		if (file.is_open()) {
+			file.close();
+		}
+		file.clear();
+	}
+
+	void refill() {
+		if (buffer.empty()) {
+			buffer.resize(LANE_BUFFER);
+		}
+		if (available > 0) {
+			memmove(buffer.data(), data, available);
+		}
+		data = buffer.data();
+		while (available < buffer.size()) {
+			file.read(reinterpret_cast<char*>(buffer.data() + available), static_cast<std::streamsize>(buffer.size() - available));
+			const std::streamsize count = file.gcount();
+			available += static_cast<size_t>(count);
+			if (!file) {
+				failed = file.bad();
+				file.close();
+				break;
+			}
+		}
+	}
+
+	// Returns the next block to compress, or nullptr once the padding has been consumed
+	const uint8_t* next() {
+		if ((available < 64) && file.is_open()) {
+			refill();
+		}
+		if (available >= 64) {
+			const uint8_t* block = data;
+			data += 64;
+			available -= 64;
+			length += 64;
+			return block;
+		}
+		if (!padded) {
+			memcpy(tail, data, available);
+			length += available;
+			tail[available] = 0x80; // Append a bit 1
+			tailBlocks = (available < 56) ? 1 : 2;
+			memset(tail + available + 1, 0, tailBlocks * 64 - available - 1);
+			const uint64_t bitlen = length * 8;
+			for (uint8_t i = 0; i < 8; i++) {
+				tail[tailBlocks * 64 - 1 - i] = static_cast<uint8_t>(bitlen >> (i * 8));
+			}
+			available = 0;
+			padded = true;
+		}
+		return (tailNext < tailBlocks) ? tail + 64 * tailNext++ : nullptr;
+	}
+};
+
+static inline uint32_t load32(const uint8_t* p) {
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+std::vector<SHA256MultiBuffer::Digest> SHA256MultiBuffer::hashBuffers(const std::vector<std::pair<const uint8_t*, size_t>>& buffers) {
+	std::vector<Digest> digests;
+	run(buffers.size(), [&buffers](Lane& lane, size_t input) {
+		lane.data = buffers[input].first;
+		lane.available = buffers[input].second;
+		return true;
+	}, digests);
+	return digests;
+}
+
+bool SHA256MultiBuffer::hashFiles(const std::vector<std::filesystem::path>& paths, std::vector<Digest>& digests) {
+	return run(paths.size(), [&paths](Lane& lane, size_t input) {
+		lane.file.open(paths[input], std::ios::binary);
+		return lane.file.is_open();
+	}, digests);
+}
+
+bool SHA256MultiBuffer::run(size_t count, const std::function<bool(Lane&, size_t)>& open, std::vector<Digest>& digests) {
+	const size_t width = lanes();
+	const CompressFn compress = (width == 8) ? &SHA256MultiBuffer::compress8 : (width == 4) ? &SHA256MultiBuffer::compress4 : &SHA256MultiBuffer::compress1;
+	const SHA256 initial;
+	const uint8_t idle[64] = { 0, }; // Compressed by lanes with nothing left to do
+	alignas(32) uint32_t state[8 * MAX_LANES]; // Word-major: state[word * width + lane]
+	std::vector<Lane> lane(width);
+	size_t nextInput = 0;
+	bool retVal = true;
+
+	digests.assign(count, Digest{});
+	while (true) {
+		const uint8_t* blocks[MAX_LANES];
+		size_t active = 0;
+		for (size_t l = 0; l < width; l++) {
+			const uint8_t* block = (lane[l].input != SIZE_MAX) ? lane[l].next() : nullptr;
+			if ((block == nullptr) && (lane[l].input != SIZE_MAX)) {
+				// Input finished: store its digest, big endian
+				if (lane[l].failed) {
+					retVal = false;
+				}
+				for (uint8_t j = 0; j < 8; j++) {
+					const uint32_t word = state[j * width + l];
+					for (uint8_t i = 0; i < 4; i++) {
+						digests[lane[l].input][j * 4 + i] = static_cast<uint8_t>(word >> (24 - i * 8));
+					}
+				}
+				lane[l].reset(SIZE_MAX);
+			}
+			while ((block == nullptr) && (nextInput < count)) {
+				// Pick up the next input
+				lane[l].reset(nextInput++);
+				if (!open(lane[l], lane[l].input)) {
+					retVal = false;
+					lane[l].reset(SIZE_MAX);
+					continue;
+				}
+				for (uint8_t j = 0; j < 8; j++) {
+					state[j * width + l] = initial.m_state[j];
+				}
+				block = lane[l].next();
+			}
+			if (block != nullptr) {
+				active++;
+			}
+			blocks[l] = (block != nullptr) ? block : idle;
+		}
+		if (active == 0) {
+			break;
+		}
+		compress(state, blocks);
+	}
+	return retVal;
+}
+
+size_t SHA256MultiBuffer::lanes() {
+	// A single SHA-NI stream outruns 8 software lanes, so don't interleave there
+	if (SHA256::backend() == SHA256::Backend::SHANI) {
+		return 1;
+	}
+#ifdef SHA256MB_X86
+	static const size_t width = []() -> size_t {
+		int regs[4] = { 0, }; // EAX, EBX, ECX, EDX
+#if defined(_MSC_VER)
+		__cpuid(regs, 0);
+		const int maxLeaf = regs[0];
+		__cpuid(regs, 1);
+#else
+		const int maxLeaf = static_cast<int>(__get_cpuid_max(0, nullptr));
+		__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+		// AVX2 needs the OS to save the YMM registers (OSXSAVE, then XCR0 bits 1 and 2)
+		const bool osxsave = (regs[2] & (1 << 27)) != 0;
+		if (osxsave && (maxLeaf >= 7)) {
+#if defined(_MSC_VER)
+			const bool ymm = (_xgetbv(0) & 6) == 6;
+			__cpuidex(regs, 7, 0);
+#else
+			uint32_t xcr0 = 0, edx = 0;
+			__asm__("xgetbv" : "=a"(xcr0), "=d"(edx) : "c"(0));
+			const bool ymm = (xcr0 & 6) == 6;
+			__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			if (ymm && ((regs[1] & (1 << 5)) != 0)) {
+				return 8;
+			}
+		}
+		return 4; // SSE2 is part of every x64 CPU
+	}();
+	return width;
+#else
+	return 1;
+#endif
+}
+
+void SHA256MultiBuffer::compress1(uint32_t* state, const uint8_t* const* blocks) {
+	SHA256::selectedTransform().load(std::memory_order_relaxed)(state, blocks[0], 1);
+}
+
+#ifdef SHA256MB_X86
+
+// Rotations, sigma and round functions on 4 lanes; SSE2 has no vector rotate
+#define SHA256MB_ROTR4(x, n) _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
+#define SHA256MB_ROTR8(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+void SHA256MultiBuffer::compress4(uint32_t* state, const uint8_t* const* blocks) {
+	__m128i m[16];
+	for (uint8_t i = 0; i < 16; i++) {
+		m[i] = _mm_set_epi32(static_cast<int>(load32(blocks[3] + i * 4)), static_cast<int>(load32(blocks[2] + i * 4)),
+			static_cast<int>(load32(blocks[1] + i * 4)), static_cast<int>(load32(blocks[0] + i * 4)));
+	}
+
+	__m128i s[8];
+	for (uint8_t i = 0; i < 8; i++) {
+		s[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(state + i * 4));
+	}
+	__m128i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+	for (uint8_t i = 0; i < 64; i++) {
+		if (i >= 16) {
+			const __m128i w2 = m[(i - 2) & 15];
+			const __m128i w15 = m[(i - 15) & 15];
+			const __m128i sig1 = _mm_xor_si128(_mm_xor_si128(SHA256MB_ROTR4(w2, 17), SHA256MB_ROTR4(w2, 19)), _mm_srli_epi32(w2, 10));
+			const __m128i sig0 = _mm_xor_si128(_mm_xor_si128(SHA256MB_ROTR4(w15, 7), SHA256MB_ROTR4(w15, 18)), _mm_srli_epi32(w15, 3));
+			m[i & 15] = _mm_add_epi32(_mm_add_epi32(m[i & 15], sig1), _mm_add_epi32(m[(i - 7) & 15], sig0));
+		}
+
+		const __m128i ch = _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g));
+		const __m128i maj = _mm_or_si128(_mm_and_si128(a, _mm_or_si128(b, c)), _mm_and_si128(b, c));
+		const __m128i xorA = _mm_xor_si128(_mm_xor_si128(SHA256MB_ROTR4(a, 2), SHA256MB_ROTR4(a, 13)), SHA256MB_ROTR4(a, 22));
+		const __m128i xorE = _mm_xor_si128(_mm_xor_si128(SHA256MB_ROTR4(e, 6), SHA256MB_ROTR4(e, 11)), SHA256MB_ROTR4(e, 25));
+		const __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_add_epi32(m[i & 15], _mm_set1_epi32(static_cast<int>(SHA256::K[i]))), _mm_add_epi32(h, ch)), xorE);
+
+		h = g;
+		g = f;
+		f = e;
+		e = _mm_add_epi32(d, sum);
+		d = c;
+		c = b;
+		b = a;
+		a = _mm_add_epi32(_mm_add_epi32(xorA, maj), sum);
+	}
+
+	const __m128i out[8] = { a, b, c, d, e, f, g, h };
+	for (uint8_t i = 0; i < 8; i++) {
+		_mm_store_si128(reinterpret_cast<__m128i*>(state + i * 4), _mm_add_epi32(s[i], out[i]));
+	}
+}
+
+SHA256MB_TARGET("avx2")
+void SHA256MultiBuffer::compress8(uint32_t* state, const uint8_t* const* blocks) {
+	__m256i m[16];
+	for (uint8_t i = 0; i < 16; i++) {
+		m[i] = _mm256_set_epi32(static_cast<int>(load32(blocks[7] + i * 4)), static_cast<int>(load32(blocks[6] + i * 4)),
+			static_cast<int>(load32(blocks[5] + i * 4)), static_cast<int>(load32(blocks[4] + i * 4)),
+			static_cast<int>(load32(blocks[3] + i * 4)), static_cast<int>(load32(blocks[2] + i * 4)),
+			static_cast<int>(load32(blocks[1] + i * 4)), static_cast<int>(load32(blocks[0] + i * 4)));
+	}
+
+	__m256i s[8];
+	for (uint8_t i = 0; i < 8; i++) {
+		s[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state + i * 8));
+	}
+	__m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+	for (uint8_t i = 0; i < 64; i++) {
+		if (i >= 16) {
+			const __m256i w2 = m[(i - 2) & 15];
+			const __m256i w15 = m[(i - 15) & 15];
+			const __m256i sig1 = _mm256_xor_si256(_mm256_xor_si256(SHA256MB_ROTR8(w2, 17), SHA256MB_ROTR8(w2, 19)), _mm256_srli_epi32(w2, 10));
+			const __m256i sig0 = _mm256_xor_si256(_mm256_xor_si256(SHA256MB_ROTR8(w15, 7), SHA256MB_ROTR8(w15, 18)), _mm256_srli_epi32(w15, 3));
+			m[i & 15] = _mm256_add_epi32(_mm256_add_epi32(m[i & 15], sig1), _mm256_add_epi32(m[(i - 7) & 15], sig0));
+		}
+
+		const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+		const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, _mm256_or_si256(b, c)), _mm256_and_si256(b, c));
+		const __m256i xorA = _mm256_xor_si256(_mm256_xor_si256(SHA256MB_ROTR8(a, 2), SHA256MB_ROTR8(a, 13)), SHA256MB_ROTR8(a, 22));
+		const __m256i xorE = _mm256_xor_si256(_mm256_xor_si256(SHA256MB_ROTR8(e, 6), SHA256MB_ROTR8(e, 11)), SHA256MB_ROTR8(e, 25));
+		const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(m[i & 15], _mm256_set1_epi32(static_cast<int>(SHA256::K[i]))), _mm256_add_epi32(h, ch)), xorE);
+
+		h = g;
+		g = f;
+		f = e;
+		e = _mm256_add_epi32(d, sum);
+		d = c;
+		c = b;
+		b = a;
+		a = _mm256_add_epi32(_mm256_add_epi32(xorA, maj), sum);
+	}
+
+	const __m256i out[8] = { a, b, c, d, e, f, g, h };
+	for (uint8_t i = 0; i < 8; i++) {
+		_mm256_store_si256(reinterpret_cast<__m256i*>(state + i * 8), _mm256_add_epi32(s[i], out[i]));
+	}
+}
+
+#else
+
+// lanes() never reports more than one lane without SSE2
+void SHA256MultiBuffer::compress4(uint32_t* state, const uint8_t* const* blocks) {
+	compress1(state, blocks);
+}
+
+void SHA256MultiBuffer::compress8(uint32_t* state, const uint8_t* const* blocks) {
+	compress1(state, blocks);
+}
+
+#endif
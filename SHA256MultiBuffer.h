@@ -0,0 +1,74 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+#ifndef SHA256_MULTI_BUFFER_H
+#define SHA256_MULTI_BUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <array>
+#include <vector>
+#include <filesystem>
+#include <functional>
+
+/**
+ * @brief Hashes several independent inputs at once, one input per SIMD lane
+ *        (8 lanes with AVX2, 4 with SSE2). Produces the same digests as SHA256.
+ */
+class SHA256MultiBuffer {
+
+public:
+	using Digest = std::array<uint8_t, 32>;
+
+	/**
+	 * @brief Hashes a list of memory buffers.
+	 * @param buffers Pointer and length of each input.
+	 * @return One digest per input, in the same order.
+	 */
+	static std::vector<Digest> hashBuffers(const std::vector<std::pair<const uint8_t*, size_t>>& buffers);
+
+	/**
+	 * @brief Hashes a list of files, streaming each one through a small read buffer.
+	 * @param paths Files to hash.
+	 * @param digests Output: one digest per file, in the same order.
+	 * @return true if every file was read successfully, false otherwise.
+	 */
+	static bool hashFiles(const std::vector<std::filesystem::path>& paths, std::vector<Digest>& digests);
+
+	/**
+	 * @brief Number of inputs hashed in parallel on this CPU (1 means one after another).
+	 */
+	static size_t lanes();
+
+private:
+	struct Lane;
+	using CompressFn = void (*)(uint32_t* state, const uint8_t* const* blocks);
+
+	static bool run(size_t count, const std::function<bool(Lane&, size_t)>& open, std::vector<Digest>& digests);
+	static void compress1(uint32_t* state, const uint8_t* const* blocks);
+	static void compress4(uint32_t* state, const uint8_t* const* blocks);
+	static void compress8(uint32_t* state, const uint8_t* const* blocks);
+};
+
+#endif
@@ -0,0 +1,690 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+
+#include "SegmentedDownloader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const size_t SEGMENTED_DOWNLOAD_READ_BUFFER_SIZE = 0x100000; ///< Block read back from the file for the bytes that were written ahead of the in-order stream (1 MiB).
+
+/**
+ * @brief Destination file, written at explicit offsets so several threads can write at once.
+ */
+class CSegmentFile
+{
+public:
+	CSegmentFile() = default;
+
+	~CSegmentFile()
+	{
+		Close();
+	}
+
+	CSegmentFile(const CSegmentFile&) = delete;
+	CSegmentFile& operator=(const CSegmentFile&) = delete;
+
+	/**
+	 * @brief Creates the file, or empties it if it exists.
+	 */
+	bool Create(const std::filesystem::path& strFilePath)
+	{
+#ifdef _WIN32
+		// Shared for writing, so the file can be flushed to the disk (see FlushFileToDisk) before each checkpoint
+		m_hFile = CreateFileW(strFilePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		return (m_hFile != INVALID_HANDLE_VALUE);
+#else
+		m_nFile = open(strFilePath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+		return (m_nFile >= 0);
+#endif
+	}
+
+	/**
+	 * @brief Allocates the whole file up front, so the segments don't fragment it as they grow.
+	 */
+	bool Allocate(unsigned long long nSize)
+	{
+#ifdef _WIN32
+		LARGE_INTEGER nPosition{};
+		nPosition.QuadPart = static_cast<LONGLONG>(nSize);
+		return SetFilePointerEx(m_hFile, nPosition, nullptr, FILE_BEGIN) && SetEndOfFile(m_hFile);
+#elif defined(__linux__)
+		return (posix_fallocate(m_nFile, 0, static_cast<off_t>(nSize)) == 0) || (ftruncate(m_nFile, static_cast<off_t>(nSize)) == 0);
+#else
+		return (ftruncate(m_nFile, static_cast<off_t>(nSize)) == 0);
+#endif
+	}
+
+	/**
+	 * @brief Writes a block at the given offset; the file pointer is not used.
+	 */
+	bool WriteAt(unsigned long long nOffset, const uint8_t* pData, size_t nLength)
+	{
+		while (nLength > 0)
+		{
+#ifdef _WIN32
+			OVERLAPPED pOverlapped{};
+			pOverlapped.Offset = static_cast<DWORD>(nOffset);
+			pOverlapped.OffsetHigh = static_cast<DWORD>(nOffset >> 32);
+			DWORD nWritten = 0;
+			if (!WriteFile(m_hFile, pData, static_cast<DWORD>(std::min<size_t>(nLength, 0x40000000)), &nWritten, &pOverlapped) || (nWritten == 0))
+				return false;
+#else
+			const ssize_t nWritten = pwrite(m_nFile, pData, nLength, static_cast<off_t>(nOffset));
+			if (nWritten <= 0)
+			{
+				if ((nWritten < 0) && (errno == EINTR))
+					continue;
+				return false;
+			}
+#endif
+			pData += nWritten;
+			nLength -= static_cast<size_t>(nWritten);
+			nOffset += static_cast<unsigned long long>(nWritten);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Reads a block at the given offset; the file pointer is not used.
+	 */
+	bool ReadAt(unsigned long long nOffset, uint8_t* pData, size_t nLength)
+	{
+		while (nLength > 0)
+		{
+#ifdef _WIN32
+			OVERLAPPED pOverlapped{};
+			pOverlapped.Offset = static_cast<DWORD>(nOffset);
+			pOverlapped.OffsetHigh = static_cast<DWORD>(nOffset >> 32);
+			DWORD nRead = 0;
+			if (!ReadFile(m_hFile, pData, static_cast<DWORD>(std::min<size_t>(nLength, 0x40000000)), &nRead, &pOverlapped) || (nRead == 0))
+				return false;
+#else
+			const ssize_t nRead = pread(m_nFile, pData, nLength, static_cast<off_t>(nOffset));
+			if (nRead <= 0)
+			{
+				if ((nRead < 0) && (errno == EINTR))
+					continue;
+				return false;
+			}
+#endif
+			pData += nRead;
+			nLength -= static_cast<size_t>(nRead);
+			nOffset += static_cast<unsigned long long>(nRead);
+		}
+		return true;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (m_hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_hFile);
+			m_hFile = INVALID_HANDLE_VALUE;
+		}
+#else
+		if (m_nFile >= 0)
+		{
+			close(m_nFile);
+			m_nFile = -1;
+		}
+#endif
+	}
+
+private:
+#ifdef _WIN32
+	HANDLE m_hFile = INVALID_HANDLE_VALUE; ///< File handle
+#else
+	int m_nFile = -1; ///< File descriptor
+#endif
+};
+
+/**
+ * @brief A byte range of the file, downloaded by one connection at a time.
+ */
+struct SEGMENT
+{
+	unsigned long long nNext; ///< First byte not received yet
+	unsigned long long nEnd;  ///< One past the last byte; lowered when the segment is split
+	bool bOwned;              ///< A connection is downloading the segment
+};
+
+/**
+ * @brief State of one download, shared by all its connections.
+ */
+class CSegmentedDownload
+{
+public:
+	CSegmentedDownload(ITransport& pTransport, const std::string& strURL, unsigned int nSegmentCount, unsigned long long nMinSegmentSize,
+		const fnTransportBody& pInOrderBody, const fnTransportProgress& pProgress, SEGMENTED_DOWNLOAD_STATISTICS& pStatistics)
+		: m_pTransport(pTransport), m_strURL(strURL), m_nSegmentCount(nSegmentCount), m_nMinSegmentSize(std::max<unsigned long long>(nMinSegmentSize, 1)),
+		m_pInOrderBody(pInOrderBody), m_pProgress(pProgress), m_pStatistics(pStatistics)
+	{
+	}
+
+	~CSegmentedDownload()
+	{
+		m_bAbort = true;
+		JoinWorkers();
+	}
+
+	bool Run(const std::filesystem::path& strFilePath, TRANSPORT_RESPONSE& pResponse);
+
+private:
+	bool Probe(bool bRange, TRANSPORT_RESPONSE& pResponse);
+	bool Start(const TRANSPORT_RESPONSE& pResponse);
+	void RunWorker();
+	bool ClaimSegment(size_t& nSegment);
+	bool DownloadSegment(size_t nSegment, bool& bProgress);
+	bool CheckRange(const TRANSPORT_RESPONSE& pResponse, unsigned long long nStart);
+	bool WriteSegment(size_t nSegment, const uint8_t* pData, size_t nLength);
+	bool WriteBlock(unsigned long long nOffset, const uint8_t* pData, size_t nLength);
+	bool FeedInOrder(unsigned long long nOffset, const uint8_t* pData, size_t nLength);
+	void AddWrittenRange(unsigned long long nStart, unsigned long long nEnd);
+	bool FeedFromFile(unsigned long long nStart, unsigned long long nEnd);
+	void BeginRequest();
+	void EndRequest();
+	void Fail(const std::string& strError);
+	void JoinWorkers();
+
+	ITransport& m_pTransport;               ///< Transport of every request
+	std::string m_strURL;                   ///< URL of the file
+	unsigned int m_nSegmentCount;           ///< Most concurrent connections
+	unsigned long long m_nMinSegmentSize;   ///< Smallest segment in bytes
+	fnTransportBody m_pInOrderBody;         ///< Receives the file in order
+	fnTransportProgress m_pProgress;        ///< Progress over all connections
+	SEGMENTED_DOWNLOAD_STATISTICS& m_pStatistics; ///< Counters, updated under m_pLock
+
+	CSegmentFile m_pFile;                   ///< Destination file
+	unsigned long long m_nTotal = TRANSPORT_UNKNOWN_LENGTH; ///< Size of the file, if known
+	std::string m_strValidator;             ///< ETag or Last-Modified of the file, sent in If-Range
+	bool m_bSegmented = false;              ///< The file is split into segments; set before the workers start
+	std::atomic<bool> m_bAbort{ false };    ///< Set on the first fatal error; every connection stops
+
+	std::mutex m_pLock;                     ///< Guards the segments, the counters and the error
+	std::vector<SEGMENT> m_arrSegments;     ///< Segments of the file; empty for a single stream
+	unsigned int m_nActive = 0;             ///< Requests in flight
+	std::string m_strError;                 ///< First fatal error
+	std::vector<std::thread> m_arrWorkers;  ///< Connections other than the first one
+
+	std::mutex m_pInOrderLock;              ///< Guards the in-order position and the ranges written ahead of it
+	unsigned long long m_nInOrder = 0;      ///< Bytes passed to the in-order callback
+	bool m_bFeeding = false;                ///< A connection is calling the in-order callback; only one at a time does
+	std::map<unsigned long long, unsigned long long> m_mapWritten; ///< Ranges written ahead of the in-order stream, from start to end, merged
+	std::vector<uint8_t> m_arrReadBuffer;   ///< Buffer of the connection that reads the ranges back
+
+	std::mutex m_pProgressLock;             ///< Serializes the progress callback
+	unsigned long long m_nReceived = 0;     ///< Bytes written over all connections
+};
+
+bool CSegmentedDownload::Run(const std::filesystem::path& strFilePath, TRANSPORT_RESPONSE& pResponse)
+{
+	if (!m_pFile.Create(strFilePath))
+	{
+		pResponse = TRANSPORT_RESPONSE();
+		pResponse.strError = "Cannot create the file";
+		return false;
+	}
+
+	// Ask for the whole file as a range: a 206 answer tells the size and that ranges are supported
+	bool bResult = Probe(true, pResponse);
+	if (!bResult && (pResponse.nStatusCode == 416) && (m_nReceived == 0))
+	{
+		bResult = Probe(false, pResponse); // An empty file has no byte 0 to send
+	}
+	if (!m_bSegmented)
+	{
+		if (bResult)
+		{
+			bResult = !m_bAbort;
+		}
+		if (m_bAbort)
+		{
+			pResponse.strError = m_strError;
+		}
+		return bResult;
+	}
+
+	// The first connection has finished its segment, or failed; either way it joins the others
+	{
+		std::lock_guard<std::mutex> pLock(m_pLock);
+		m_arrSegments[0].bOwned = false;
+	}
+	RunWorker();
+	JoinWorkers();
+	if (m_bAbort)
+	{
+		pResponse.strError = m_strError;
+		return false;
+	}
+	pResponse.nContentLength = m_nTotal;
+	pResponse.strError.clear();
+	return true;
+}
+
+bool CSegmentedDownload::Probe(bool bRange, TRANSPORT_RESPONSE& pResponse)
+{
+	TRANSPORT_REQUEST pRequest{ m_strURL, {} };
+	if (bRange)
+	{
+		pRequest.arrHeaders.emplace_back("Range", "bytes=0-");
+	}
+	bool bStarted = false;
+	unsigned long long nOffset = 0;
+	BeginRequest();
+	const bool bResult = m_pTransport.Get(pRequest, [&](const uint8_t* pData, size_t nLength)
+	{
+		if (!bStarted)
+		{
+			bStarted = true;
+			if (!Start(pResponse))
+				return false;
+		}
+		if (m_bSegmented)
+		{
+			return WriteSegment(0, pData, nLength);
+		}
+		if (!WriteBlock(nOffset, pData, nLength))
+			return false;
+		nOffset += nLength;
+		return true;
+	}, nullptr, pResponse);
+	EndRequest();
+	return bResult;
+}
+
+bool CSegmentedDownload::Start(const TRANSPORT_RESPONSE& pResponse)
+{
+	bool bRanges = false;
+	m_nTotal = pResponse.nContentLength;
+	if (pResponse.nStatusCode == 206)
+	{
+		const std::string* pContentRange = FindTransportHeader(pResponse.arrHeaders, "Content-Range");
+		unsigned long long nFirst = 0, nLast = 0;
+		if ((pContentRange == nullptr) || !ParseContentRange(*pContentRange, nFirst, nLast, m_nTotal) || (nFirst != 0))
+		{
+			Fail("Invalid Content-Range in the response");
+			return false;
+		}
+		bRanges = (m_nTotal != TRANSPORT_UNKNOWN_LENGTH);
+	}
+	if (m_nTotal != TRANSPORT_UNKNOWN_LENGTH)
+	{
+		m_pFile.Allocate(m_nTotal); // Only an optimization: writes past the end grow the file anyway
+	}
+
+	// A weak ETag cannot validate a range, so fall back to the modification time
+	const std::string* pETag = FindTransportHeader(pResponse.arrHeaders, "ETag");
+	const std::string* pLastModified = FindTransportHeader(pResponse.arrHeaders, "Last-Modified");
+	if ((pETag != nullptr) && !pETag->empty() && (pETag->compare(0, 2, "W/") != 0))
+	{
+		m_strValidator = *pETag;
+	}
+	else if (pLastModified != nullptr)
+	{
+		m_strValidator = *pLastModified;
+	}
+
+	const unsigned long long nCount = bRanges ? std::min<unsigned long long>(m_nSegmentCount, m_nTotal / m_nMinSegmentSize) : 1;
+	if (nCount < 2)
+	{
+		return true; // Download a single stream
+	}
+
+	// The first connection keeps the first segment; the others are taken by the workers
+	const unsigned long long nSegmentSize = m_nTotal / nCount;
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	m_bSegmented = true;
+	for (unsigned long long nIndex = 0; nIndex < nCount; nIndex++)
+	{
+		m_arrSegments.push_back({ nIndex * nSegmentSize, (nIndex + 1 == nCount) ? m_nTotal : (nIndex + 1) * nSegmentSize, nIndex == 0 });
+	}
+	for (unsigned long long nIndex = 1; nIndex < nCount; nIndex++)
+	{
+		try
+		{
+			m_arrWorkers.emplace_back(&CSegmentedDownload::RunWorker, this);
+		}
+		catch (const std::system_error&)
+		{
+			break; // The segments left are taken by the connections that finish first
+		}
+	}
+	return true;
+}
+
+void CSegmentedDownload::RunWorker()
+{
+	unsigned int nFailures = 0;
+	size_t nSegment = 0;
+	while (!m_bAbort && ClaimSegment(nSegment))
+	{
+		bool bProgress = false;
+		if (DownloadSegment(nSegment, bProgress))
+		{
+			nFailures = 0;
+			continue;
+		}
+		// Give the segment back; this worker (or an idle one) asks for the rest of it again
+		std::lock_guard<std::mutex> pLock(m_pLock);
+		m_arrSegments[nSegment].bOwned = false;
+		nFailures = bProgress ? 0 : nFailures + 1;
+		if (nFailures > SEGMENTED_DOWNLOAD_RETRIES)
+		{
+			if (!m_bAbort.exchange(true))
+			{
+				m_strError = "Cannot download the range: " + m_strError;
+			}
+			return;
+		}
+		m_pStatistics.nRetries++;
+	}
+}
+
+bool CSegmentedDownload::ClaimSegment(size_t& nSegment)
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	size_t nLargest = m_arrSegments.size();
+	for (size_t nIndex = 0; nIndex < m_arrSegments.size(); nIndex++)
+	{
+		const SEGMENT& pSegment = m_arrSegments[nIndex];
+		if (pSegment.nNext == pSegment.nEnd)
+			continue;
+		if (!pSegment.bOwned)
+		{
+			m_arrSegments[nIndex].bOwned = true;
+			nSegment = nIndex;
+			return true;
+		}
+		if ((nLargest == m_arrSegments.size()) || (pSegment.nEnd - pSegment.nNext > m_arrSegments[nLargest].nEnd - m_arrSegments[nLargest].nNext))
+		{
+			nLargest = nIndex;
+		}
+	}
+
+	// Take over the second half of the segment with the most bytes left, if both halves are worth a connection
+	if ((nLargest == m_arrSegments.size()) || (m_arrSegments[nLargest].nEnd - m_arrSegments[nLargest].nNext < 2 * m_nMinSegmentSize))
+	{
+		return false;
+	}
+	SEGMENT& pLargest = m_arrSegments[nLargest];
+	const unsigned long long nMiddle = pLargest.nNext + (pLargest.nEnd - pLargest.nNext) / 2;
+	m_arrSegments.push_back({ nMiddle, pLargest.nEnd, true });
+	m_arrSegments[nLargest].nEnd = nMiddle;
+	m_pStatistics.nSplits++;
+	nSegment = m_arrSegments.size() - 1;
+	return true;
+}
+
+bool CSegmentedDownload::DownloadSegment(size_t nSegment, bool& bProgress)
+{
+	unsigned long long nStart = 0, nEnd = 0;
+	{
+		std::lock_guard<std::mutex> pLock(m_pLock);
+		nStart = m_arrSegments[nSegment].nNext;
+		nEnd = m_arrSegments[nSegment].nEnd;
+	}
+	TRANSPORT_REQUEST pRequest{ m_strURL, { { "Range", "bytes=" + std::to_string(nStart) + "-" + std::to_string(nEnd - 1) } } };
+	if (!m_strValidator.empty())
+	{
+		pRequest.arrHeaders.emplace_back("If-Range", m_strValidator);
+	}
+	TRANSPORT_RESPONSE pResponse;
+	bool bChecked = false;
+	BeginRequest();
+	m_pTransport.Get(pRequest, [&](const uint8_t* pData, size_t nLength)
+	{
+		if (!bChecked)
+		{
+			if (!CheckRange(pResponse, nStart))
+				return false;
+			bChecked = true;
+		}
+		bProgress = true;
+		return WriteSegment(nSegment, pData, nLength);
+	}, nullptr, pResponse);
+	EndRequest();
+
+	// The segment may be complete even if the request was cut short, as it may have been split meanwhile
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	const SEGMENT& pSegment = m_arrSegments[nSegment];
+	if (pSegment.nNext == pSegment.nEnd)
+	{
+		return true;
+	}
+	if (!m_bAbort)
+	{
+		m_strError = pResponse.strError.empty() ? "The server closed the connection before the end of the range" : pResponse.strError;
+	}
+	return false;
+}
+
+bool CSegmentedDownload::CheckRange(const TRANSPORT_RESPONSE& pResponse, unsigned long long nStart)
+{
+	// A 200 answer to If-Range means the file changed since the first request
+	const std::string* pContentRange = FindTransportHeader(pResponse.arrHeaders, "Content-Range");
+	unsigned long long nFirst = 0, nLast = 0, nTotal = 0;
+	if ((pResponse.nStatusCode != 206) || (pContentRange == nullptr) || !ParseContentRange(*pContentRange, nFirst, nLast, nTotal) ||
+		(nFirst != nStart) || (nTotal != m_nTotal))
+	{
+		Fail("The file changed on the server during the download");
+		return false;
+	}
+	return true;
+}
+
+bool CSegmentedDownload::WriteSegment(size_t nSegment, const uint8_t* pData, size_t nLength)
+{
+	if (m_bAbort)
+		return false;
+
+	// Reserve the bytes first, so a split made meanwhile starts after them
+	unsigned long long nOffset = 0;
+	size_t nBlock = 0;
+	{
+		std::lock_guard<std::mutex> pLock(m_pLock);
+		SEGMENT& pSegment = m_arrSegments[nSegment];
+		nOffset = pSegment.nNext;
+		nBlock = static_cast<size_t>(std::min<unsigned long long>(nLength, pSegment.nEnd - pSegment.nNext));
+		pSegment.nNext += nBlock;
+	}
+	if ((nBlock > 0) && !WriteBlock(nOffset, pData, nBlock))
+		return false;
+	// Stop the response once it reaches the end of the segment, which a split may have moved
+	return (nBlock == nLength) && !m_bAbort;
+}
+
+bool CSegmentedDownload::WriteBlock(unsigned long long nOffset, const uint8_t* pData, size_t nLength)
+{
+	if (!m_pFile.WriteAt(nOffset, pData, nLength))
+	{
+		Fail("Cannot write the file");
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> pLock(m_pProgressLock);
+		m_nReceived += nLength;
+		if (m_pProgress)
+		{
+			m_pProgress(m_nReceived, m_nTotal);
+		}
+	}
+
+	return !m_pInOrderBody || FeedInOrder(nOffset, pData, nLength);
+}
+
+bool CSegmentedDownload::FeedInOrder(unsigned long long nOffset, const uint8_t* pData, size_t nLength)
+{
+	// A block that continues the in-order stream is passed on at once. Any other block, or one written while
+	// another connection feeds the stream, is only noted: the feeding connection reads it back from the file
+	// as soon as the bytes before it are there, so the stream keeps up with the download
+	std::unique_lock<std::mutex> pLock(m_pInOrderLock);
+	if (m_bFeeding || (nOffset != m_nInOrder))
+	{
+		AddWrittenRange(nOffset, nOffset + nLength);
+		return true;
+	}
+	m_bFeeding = true;
+	pLock.unlock();
+	bool bResult = m_pInOrderBody(pData, nLength);
+	if (!bResult)
+	{
+		Fail("The download was cancelled");
+	}
+	pLock.lock();
+	m_nInOrder += nLength;
+	while (bResult && !m_mapWritten.empty() && (m_mapWritten.begin()->first == m_nInOrder))
+	{
+		// The bytes of the range are not written again, so they can be read back without the lock
+		const unsigned long long nStart = m_nInOrder, nEnd = m_mapWritten.begin()->second;
+		m_mapWritten.erase(m_mapWritten.begin());
+		pLock.unlock();
+		bResult = FeedFromFile(nStart, nEnd);
+		pLock.lock();
+		m_nInOrder = nEnd;
+	}
+	m_bFeeding = false;
+	return bResult;
+}
+
+void CSegmentedDownload::AddWrittenRange(unsigned long long nStart, unsigned long long nEnd)
+{
+	// Merge with the ranges just before and just after it, so the feeding connection reads them back at once
+	auto it = m_mapWritten.upper_bound(nStart);
+	if ((it != m_mapWritten.begin()) && (std::prev(it)->second == nStart))
+	{
+		nStart = std::prev(it)->first;
+		m_mapWritten.erase(std::prev(it));
+	}
+	if ((it != m_mapWritten.end()) && (it->first == nEnd))
+	{
+		nEnd = it->second;
+		m_mapWritten.erase(it);
+	}
+	m_mapWritten[nStart] = nEnd;
+}
+
+bool CSegmentedDownload::FeedFromFile(unsigned long long nStart, unsigned long long nEnd)
+{
+	m_arrReadBuffer.resize(SEGMENTED_DOWNLOAD_READ_BUFFER_SIZE);
+	while (nStart < nEnd)
+	{
+		const size_t nLength = static_cast<size_t>(std::min<unsigned long long>(m_arrReadBuffer.size(), nEnd - nStart));
+		if (!m_pFile.ReadAt(nStart, m_arrReadBuffer.data(), nLength))
+		{
+			Fail("Cannot read the file back");
+			return false;
+		}
+		if (!m_pInOrderBody(m_arrReadBuffer.data(), nLength))
+		{
+			Fail("The download was cancelled");
+			return false;
+		}
+		nStart += nLength;
+	}
+	return true;
+}
+
+void CSegmentedDownload::BeginRequest()
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	m_pStatistics.nRequests++;
+	m_pStatistics.nConnections = std::max(m_pStatistics.nConnections, ++m_nActive);
+}
+
+void CSegmentedDownload::EndRequest()
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	m_nActive--;
+}
+
+void CSegmentedDownload::Fail(const std::string& strError)
+{
+	std::lock_guard<std::mutex> pLock(m_pLock);
+	if (!m_bAbort.exchange(true))
+	{
+		m_strError = strError;
+	}
+}
+
+void CSegmentedDownload::JoinWorkers()
+{
+	for (std::thread& pWorker : m_arrWorkers)
+	{
+		pWorker.join();
+	}
+	m_arrWorkers.clear();
+}
+
+CSegmentedDownloader::CSegmentedDownloader(ITransport& pTransport, unsigned int nSegmentCount, unsigned long long nMinSegmentSize)
+	: m_pTransport(pTransport), m_nSegmentCount(nSegmentCount), m_nMinSegmentSize(nMinSegmentSize)
+{
+}
+
+bool CSegmentedDownloader::Download(const std::string& strURL, const std::filesystem::path& strFilePath, const fnTransportBody& pInOrderBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse)
+{
+	m_pStatistics = SEGMENTED_DOWNLOAD_STATISTICS();
+	CSegmentedDownload pDownload(m_pTransport, strURL, m_nSegmentCount, m_nMinSegmentSize, pInOrderBody, pProgress, m_pStatistics);
+	return pDownload.Run(strFilePath, pResponse);
+}
+
+bool ParseContentRange(const std::string& strValue, unsigned long long& nFirst, unsigned long long& nLast, unsigned long long& nTotal)
+{
+	// bytes first-last/total, where total may be "*"
+	const size_t nStart = strValue.find_first_not_of(" \t");
+	if ((nStart == std::string::npos) || (strValue.compare(nStart, 6, "bytes ") != 0))
+		return false;
+	const size_t nDash = strValue.find('-', nStart + 6);
+	const size_t nSlash = strValue.find('/', nStart + 6);
+	if ((nDash == std::string::npos) || (nSlash == std::string::npos) || (nDash > nSlash))
+		return false;
+	const size_t nEnd = strValue.find_last_not_of(" \t");
+	const std::string strTotal = strValue.substr(nSlash + 1, nEnd - nSlash);
+	if (!ParseTransportNumber(strValue.substr(nStart + 6, nDash - nStart - 6), 10, nFirst) || !ParseTransportNumber(strValue.substr(nDash + 1, nSlash - nDash - 1), 10, nLast) || (nLast < nFirst))
+		return false;
+	if (strTotal == "*")
+	{
+		nTotal = TRANSPORT_UNKNOWN_LENGTH;
+		return true;
+	}
+	return ParseTransportNumber(strTotal, 10, nTotal) && (nLast < nTotal);
+}
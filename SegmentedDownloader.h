@@ -0,0 +1,103 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include "Transport.h"
+
+const unsigned int SEGMENTED_DOWNLOAD_SEGMENT_COUNT = 1;             ///< Default number of concurrent connections; segmenting is opt-in.
+const unsigned long long SEGMENTED_DOWNLOAD_MIN_SEGMENT_SIZE = 0x400000; ///< Default smallest segment (4 MiB).
+const unsigned int SEGMENTED_DOWNLOAD_RETRIES = 3;                   ///< Times a segment is requested again after its connection failed.
+
+/**
+ * @brief Counters of the last download, for tests and tuning.
+ */
+struct SEGMENTED_DOWNLOAD_STATISTICS
+{
+	unsigned int nConnections = 0; ///< Most requests in flight at once; 1 if the download fell back to a single stream.
+	unsigned int nRequests = 0;    ///< Requests sent, including retries.
+	unsigned int nSplits = 0;      ///< Segments split to help a slower connection.
+	unsigned int nRetries = 0;     ///< Requests sent again after a connection failed.
+};
+
+/**
+ * @brief Downloads a file over several connections at once, each fetching a byte range with
+ *        an HTTP Range request into a preallocated file.
+ *
+ * The first request asks for the whole file from byte 0 as a range. If the server answers with
+ * 206 Partial Content and the total size, the rest of the file is split into segments that are
+ * requested concurrently; the first connection keeps streaming its own segment. When a connection
+ * finishes its segment, it takes over the second half of the segment with the most bytes left,
+ * so a slow connection doesn't hold up the download. If the server ignores the range (200 OK)
+ * or the file is too small to split, the first response is simply downloaded as a single stream.
+ *
+ * The file is also passed to a callback in order, so it can be hashed: the blocks that continue the
+ * stream are passed on as they arrive, and the ranges that other connections wrote ahead of it are
+ * read back from the file as soon as the bytes before them are there.
+ */
+class CSegmentedDownloader
+{
+public:
+	/**
+	 * @brief Constructor.
+	 * @param pTransport The transport; its Get is called from several threads at once.
+	 * @param nSegmentCount Most concurrent connections (1 downloads a single stream).
+	 * @param nMinSegmentSize Smallest segment in bytes; segments are only split if both halves are at least this size.
+	 */
+	CSegmentedDownloader(ITransport& pTransport, unsigned int nSegmentCount = SEGMENTED_DOWNLOAD_SEGMENT_COUNT, unsigned long long nMinSegmentSize = SEGMENTED_DOWNLOAD_MIN_SEGMENT_SIZE);
+
+	/**
+	 * @brief Downloads a URL into a file.
+	 * @param strURL The URL, in UTF-8.
+	 * @param strFilePath Path of the file to write; it is replaced.
+	 * @param pInOrderBody Optional callback that receives the whole file in order (may be empty).
+	 * @param pProgress Optional progress callback, over all connections (may be empty); it is never called concurrently.
+	 * @param pResponse Output: receives the first response, before the first call to pInOrderBody, or the reason of the failure.
+	 * @return true if the whole file was downloaded, false otherwise.
+	 */
+	bool Download(const std::string& strURL, const std::filesystem::path& strFilePath, const fnTransportBody& pInOrderBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse);
+
+	/**
+	 * @brief Returns the counters of the last download.
+	 */
+	const SEGMENTED_DOWNLOAD_STATISTICS& GetStatistics() const { return m_pStatistics; }
+
+private:
+	ITransport& m_pTransport;            ///< Transport of every request
+	unsigned int m_nSegmentCount;        ///< Most concurrent connections
+	unsigned long long m_nMinSegmentSize; ///< Smallest segment in bytes
+	SEGMENTED_DOWNLOAD_STATISTICS m_pStatistics; ///< Counters of the last download
+};
+
+/**
+ * @brief Parses the value of a Content-Range header ("bytes 0-499/1234").
+ * @param nFirst Output: receives the first byte position.
+ * @param nLast Output: receives the last byte position.
+ * @param nTotal Output: receives the total size, or TRANSPORT_UNKNOWN_LENGTH if it is "*".
+ * @return false if the value is not a valid byte range.
+ */
+bool ParseContentRange(const std::string& strValue, unsigned long long& nFirst, unsigned long long& nLast, unsigned long long& nTotal);
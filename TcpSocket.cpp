@@ -0,0 +1,393 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#include "TcpSocket.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <cerrno>
+#include <system_error>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+const SOCKET_HANDLE INVALID_SOCKET_HANDLE = static_cast<SOCKET_HANDLE>(INVALID_SOCKET);
+
+/**
+ * @brief Initializes Winsock once for the whole process.
+ */
+static bool StartupSockets()
+{
+	static const bool bStarted = []()
+	{
+		WSADATA pData;
+		return WSAStartup(MAKEWORD(2, 2), &pData) == 0;
+	}();
+	return bStarted;
+}
+
+static int GetSocketError()
+{
+	return WSAGetLastError();
+}
+
+/**
+ * @brief Returns the system's description of a Winsock error, in UTF-8.
+ */
+static std::string GetSocketErrorMessage(int nError)
+{
+	LPWSTR lpszMessage = nullptr;
+	const DWORD nLength = FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+		nullptr, static_cast<DWORD>(nError), 0, reinterpret_cast<LPWSTR>(&lpszMessage), 0, nullptr);
+	std::string strMessage;
+	if (nLength > 0)
+	{
+		const int nSize = WideCharToMultiByte(CP_UTF8, 0, lpszMessage, static_cast<int>(nLength), nullptr, 0, nullptr, nullptr);
+		strMessage.resize(static_cast<size_t>(nSize));
+		WideCharToMultiByte(CP_UTF8, 0, lpszMessage, static_cast<int>(nLength), strMessage.data(), nSize, nullptr, nullptr);
+		while (!strMessage.empty() && ((strMessage.back() == '\n') || (strMessage.back() == '\r') || (strMessage.back() == ' ')))
+		{
+			strMessage.pop_back();
+		}
+	}
+	LocalFree(lpszMessage);
+	return strMessage.empty() ? "Socket error " + std::to_string(nError) : strMessage;
+}
+
+static void CloseSocketHandle(SOCKET_HANDLE hSocket)
+{
+	closesocket(static_cast<SOCKET>(hSocket));
+}
+#else
+const SOCKET_HANDLE INVALID_SOCKET_HANDLE = -1;
+
+static bool StartupSockets()
+{
+	return true;
+}
+
+static int GetSocketError()
+{
+	return errno;
+}
+
+static std::string GetSocketErrorMessage(int nError)
+{
+	return std::system_category().message(nError);
+}
+
+static void CloseSocketHandle(SOCKET_HANDLE hSocket)
+{
+	close(hSocket);
+}
+#endif
+
+/**
+ * @brief Sets the send and receive timeouts of a socket.
+ */
+static void SetSocketTimeout(SOCKET_HANDLE hSocket, unsigned int nTimeout)
+{
+#ifdef _WIN32
+	const DWORD nValue = nTimeout;
+	setsockopt(static_cast<SOCKET>(hSocket), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&nValue), sizeof(nValue));
+	setsockopt(static_cast<SOCKET>(hSocket), SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&nValue), sizeof(nValue));
+#else
+	timeval pValue{};
+	pValue.tv_sec = static_cast<time_t>(nTimeout / 1000);
+	pValue.tv_usec = static_cast<suseconds_t>((nTimeout % 1000) * 1000);
+	setsockopt(hSocket, SOL_SOCKET, SO_RCVTIMEO, &pValue, sizeof(pValue));
+	setsockopt(hSocket, SOL_SOCKET, SO_SNDTIMEO, &pValue, sizeof(pValue));
+#endif
+}
+
+/**
+ * @brief Sets the options of a connected socket.
+ */
+static void SetConnectedSocketOptions(SOCKET_HANDLE hSocket)
+{
+	// Messages are written in as few pieces as possible, so delaying small segments only adds latency
+	// (a response head sent before its body would wait for the delayed acknowledgement of the peer)
+	const int nNoDelay = 1;
+	setsockopt(hSocket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&nNoDelay), sizeof(nNoDelay));
+#ifdef SO_NOSIGPIPE
+	const int nNoSigPipe = 1;
+	setsockopt(hSocket, SOL_SOCKET, SO_NOSIGPIPE, &nNoSigPipe, sizeof(nNoSigPipe));
+#endif
+}
+
+/**
+ * @brief Resolves a host name, for a connecting (bPassive = false) or a listening socket.
+ * @return The list of addresses, to be freed with freeaddrinfo, or nullptr if the name can't be resolved.
+ */
+static addrinfo* ResolveHost(const std::string& strHost, uint16_t nPort, bool bPassive, std::string& strError)
+{
+	addrinfo pHints{};
+	pHints.ai_family = AF_UNSPEC;
+	pHints.ai_socktype = SOCK_STREAM;
+	pHints.ai_protocol = IPPROTO_TCP;
+	pHints.ai_flags = bPassive ? AI_PASSIVE : 0;
+	addrinfo* pAddresses = nullptr;
+	const int nResult = getaddrinfo(strHost.c_str(), std::to_string(nPort).c_str(), &pHints, &pAddresses);
+	if (nResult != 0)
+	{
+#ifdef _WIN32
+		strError = "Cannot resolve " + strHost + ": " + GetSocketErrorMessage(nResult);
+#else
+		strError = "Cannot resolve " + strHost + ": " + gai_strerror(nResult);
+#endif
+		return nullptr;
+	}
+	return pAddresses;
+}
+
+CTcpSocket::CTcpSocket()
+	: m_hSocket(INVALID_SOCKET_HANDLE)
+{
+}
+
+CTcpSocket::CTcpSocket(SOCKET_HANDLE hSocket)
+	: m_hSocket(hSocket)
+{
+}
+
+CTcpSocket::~CTcpSocket()
+{
+	Close();
+}
+
+CTcpSocket::CTcpSocket(CTcpSocket&& pSocket) noexcept
+	: m_hSocket(pSocket.m_hSocket), m_strError(std::move(pSocket.m_strError))
+{
+	pSocket.m_hSocket = INVALID_SOCKET_HANDLE;
+}
+
+CTcpSocket& CTcpSocket::operator=(CTcpSocket&& pSocket) noexcept
+{
+	if (this != &pSocket)
+	{
+		Close();
+		m_hSocket = pSocket.m_hSocket;
+		m_strError = std::move(pSocket.m_strError);
+		pSocket.m_hSocket = INVALID_SOCKET_HANDLE;
+	}
+	return *this;
+}
+
+bool CTcpSocket::Connect(const std::string& strHost, uint16_t nPort, unsigned int nTimeout, std::string& strError)
+{
+	Close();
+	if (!StartupSockets())
+	{
+		strError = "Cannot initialize sockets";
+		return false;
+	}
+	addrinfo* pAddresses = ResolveHost(strHost, nPort, false, strError);
+	if (pAddresses == nullptr)
+	{
+		return false;
+	}
+
+	int nError = 0;
+	for (const addrinfo* pAddress = pAddresses; pAddress != nullptr; pAddress = pAddress->ai_next)
+	{
+		const SOCKET_HANDLE hSocket = static_cast<SOCKET_HANDLE>(socket(pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol));
+		if (hSocket == INVALID_SOCKET_HANDLE)
+		{
+			nError = GetSocketError();
+			continue;
+		}
+		SetSocketTimeout(hSocket, nTimeout);
+		if (connect(hSocket, pAddress->ai_addr, static_cast<int>(pAddress->ai_addrlen)) == 0)
+		{
+			SetConnectedSocketOptions(hSocket);
+			m_hSocket = hSocket;
+			break;
+		}
+		nError = GetSocketError();
+		CloseSocketHandle(hSocket);
+	}
+	freeaddrinfo(pAddresses);
+
+	if (m_hSocket == INVALID_SOCKET_HANDLE)
+	{
+		strError = "Cannot connect to " + strHost + ":" + std::to_string(nPort) + ": " + GetSocketErrorMessage(nError);
+		return false;
+	}
+	return true;
+}
+
+bool CTcpSocket::Listen(const std::string& strHost, uint16_t nPort, std::string& strError)
+{
+	Close();
+	if (!StartupSockets())
+	{
+		strError = "Cannot initialize sockets";
+		return false;
+	}
+	addrinfo* pAddresses = ResolveHost(strHost, nPort, true, strError);
+	if (pAddresses == nullptr)
+	{
+		return false;
+	}
+
+	int nError = 0;
+	for (const addrinfo* pAddress = pAddresses; pAddress != nullptr; pAddress = pAddress->ai_next)
+	{
+		const SOCKET_HANDLE hSocket = static_cast<SOCKET_HANDLE>(socket(pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol));
+		if (hSocket == INVALID_SOCKET_HANDLE)
+		{
+			nError = GetSocketError();
+			continue;
+		}
+#ifndef _WIN32
+		// Let a restarted test server take the same port while old connections are in TIME_WAIT
+		const int nReuseAddress = 1;
+		setsockopt(hSocket, SOL_SOCKET, SO_REUSEADDR, &nReuseAddress, sizeof(nReuseAddress));
+#endif
+		if ((bind(hSocket, pAddress->ai_addr, static_cast<int>(pAddress->ai_addrlen)) == 0) && (listen(hSocket, SOMAXCONN) == 0))
+		{
+			m_hSocket = hSocket;
+			break;
+		}
+		nError = GetSocketError();
+		CloseSocketHandle(hSocket);
+	}
+	freeaddrinfo(pAddresses);
+
+	if (m_hSocket == INVALID_SOCKET_HANDLE)
+	{
+		strError = "Cannot listen on " + strHost + ":" + std::to_string(nPort) + ": " + GetSocketErrorMessage(nError);
+		return false;
+	}
+	return true;
+}
+
+CTcpSocket CTcpSocket::Accept()
+{
+	if (m_hSocket == INVALID_SOCKET_HANDLE)
+	{
+		return CTcpSocket();
+	}
+	const SOCKET_HANDLE hSocket = static_cast<SOCKET_HANDLE>(accept(m_hSocket, nullptr, nullptr));
+	if (hSocket == INVALID_SOCKET_HANDLE)
+	{
+		m_strError = GetSocketErrorMessage(GetSocketError());
+		return CTcpSocket();
+	}
+	SetConnectedSocketOptions(hSocket);
+	return CTcpSocket(hSocket);
+}
+
+uint16_t CTcpSocket::GetLocalPort() const
+{
+	sockaddr_storage pAddress{};
+	socklen_t nLength = sizeof(pAddress);
+	if ((m_hSocket == INVALID_SOCKET_HANDLE) || (getsockname(m_hSocket, reinterpret_cast<sockaddr*>(&pAddress), &nLength) != 0))
+	{
+		return 0;
+	}
+	if (pAddress.ss_family == AF_INET)
+	{
+		return ntohs(reinterpret_cast<const sockaddr_in*>(&pAddress)->sin_port);
+	}
+	if (pAddress.ss_family == AF_INET6)
+	{
+		return ntohs(reinterpret_cast<const sockaddr_in6*>(&pAddress)->sin6_port);
+	}
+	return 0;
+}
+
+bool CTcpSocket::Send(const void* pData, size_t nLength)
+{
+	const char* pNext = static_cast<const char*>(pData);
+	while (nLength > 0)
+	{
+		// Send at most 1 GiB at a time, so the length fits in an int on Windows
+		const size_t nChunk = (nLength < 0x40000000) ? nLength : 0x40000000;
+#if defined(_WIN32)
+		const int nSent = send(m_hSocket, pNext, static_cast<int>(nChunk), 0);
+#elif defined(MSG_NOSIGNAL)
+		const ssize_t nSent = send(m_hSocket, pNext, nChunk, MSG_NOSIGNAL);
+#else
+		const ssize_t nSent = send(m_hSocket, pNext, nChunk, 0);
+#endif
+		if (nSent <= 0)
+		{
+			m_strError = GetSocketErrorMessage(GetSocketError());
+			return false;
+		}
+		pNext += nSent;
+		nLength -= static_cast<size_t>(nSent);
+	}
+	return true;
+}
+
+long long CTcpSocket::Receive(void* pBuffer, size_t nLength)
+{
+	const size_t nChunk = (nLength < 0x40000000) ? nLength : 0x40000000;
+#ifdef _WIN32
+	const int nReceived = recv(m_hSocket, static_cast<char*>(pBuffer), static_cast<int>(nChunk), 0);
+#else
+	ssize_t nReceived;
+	do
+	{
+		nReceived = recv(m_hSocket, pBuffer, nChunk, 0);
+	} while ((nReceived < 0) && (errno == EINTR));
+#endif
+	if (nReceived < 0)
+	{
+		m_strError = GetSocketErrorMessage(GetSocketError());
+		return -1;
+	}
+	return nReceived;
+}
+
+void CTcpSocket::Close()
+{
+	if (m_hSocket != INVALID_SOCKET_HANDLE)
+	{
+		CloseSocketHandle(m_hSocket);
+		m_hSocket = INVALID_SOCKET_HANDLE;
+	}
+}
+
+bool CTcpSocket::IsOpen() const
+{
+	return m_hSocket != INVALID_SOCKET_HANDLE;
+}
@@ -0,0 +1,119 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+typedef uintptr_t SOCKET_HANDLE;  ///< Same as SOCKET, without including winsock2.h.
+#else
+typedef int SOCKET_HANDLE;        ///< File descriptor of the socket.
+#endif
+
+const unsigned int TCP_SOCKET_TIMEOUT = 30000; ///< Default send and receive timeout, in milliseconds.
+
+/**
+ * @brief A blocking TCP socket, for the portable HTTP/1.1 client and its loopback test server.
+ *
+ * The socket uses Winsock on Windows and BSD sockets on POSIX systems. It is closed
+ * by the destructor; it can be moved but not copied.
+ */
+class CTcpSocket
+{
+public:
+	CTcpSocket();
+	~CTcpSocket();
+	CTcpSocket(CTcpSocket&& pSocket) noexcept;
+	CTcpSocket& operator=(CTcpSocket&& pSocket) noexcept;
+	CTcpSocket(const CTcpSocket&) = delete;
+	CTcpSocket& operator=(const CTcpSocket&) = delete;
+
+	/**
+	 * @brief Connects to a host, trying each of its addresses in turn.
+	 * @param strHost Host name or address (IPv4 or IPv6).
+	 * @param nPort TCP port.
+	 * @param nTimeout Send and receive timeout in milliseconds (0 for none).
+	 * @param strError Output: receives the reason if the connection failed.
+	 * @return true if connected, false otherwise.
+	 */
+	bool Connect(const std::string& strHost, uint16_t nPort, unsigned int nTimeout, std::string& strError);
+
+	/**
+	 * @brief Starts listening for connections.
+	 * @param strHost Local address to bind to (e.g. "127.0.0.1").
+	 * @param nPort TCP port, or 0 to let the system pick a free one (see GetLocalPort).
+	 * @param strError Output: receives the reason if the socket couldn't listen.
+	 * @return true if listening, false otherwise.
+	 */
+	bool Listen(const std::string& strHost, uint16_t nPort, std::string& strError);
+
+	/**
+	 * @brief Waits for the next connection to a listening socket.
+	 * @return The connected socket, which is not open if the wait failed.
+	 */
+	CTcpSocket Accept();
+
+	/**
+	 * @brief Returns the local port the socket is bound to, or 0 if it is not bound.
+	 */
+	uint16_t GetLocalPort() const;
+
+	/**
+	 * @brief Sends all the data, blocking until it is sent.
+	 * @return true if everything was sent, false on error or timeout.
+	 */
+	bool Send(const void* pData, size_t nLength);
+
+	/**
+	 * @brief Receives the next available data, blocking until some arrives.
+	 * @param pBuffer Buffer to receive the data.
+	 * @param nLength Size of the buffer in bytes.
+	 * @return The number of bytes received, 0 if the peer closed the connection, or -1 on error or timeout.
+	 */
+	long long Receive(void* pBuffer, size_t nLength);
+
+	/**
+	 * @brief Returns the reason of the last failed Send or Receive.
+	 */
+	const std::string& GetLastError() const { return m_strError; }
+
+	/**
+	 * @brief Closes the socket; does nothing if it is not open.
+	 */
+	void Close();
+
+	/**
+	 * @brief Returns true if the socket is open.
+	 */
+	bool IsOpen() const;
+
+private:
+	explicit CTcpSocket(SOCKET_HANDLE hSocket);
+
+	SOCKET_HANDLE m_hSocket; ///< Native socket handle
+	std::string m_strError;  ///< Reason of the last failure
+};
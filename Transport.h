@@ -0,0 +1,141 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+const unsigned long long TRANSPORT_UNKNOWN_LENGTH = ~0ULL; ///< Total length reported when the server doesn't send one.
+
+/**
+ * @brief HTTP header fields, as name and value pairs in the order they were sent.
+ */
+typedef std::vector<std::pair<std::string, std::string>> TRANSPORT_HEADERS;
+
+/**
+ * @brief Receives the next block of a response body; the data is valid only during the call.
+ * @return false to abort the transfer.
+ */
+typedef std::function<bool(const uint8_t* pData, size_t nLength)> fnTransportBody;
+
+/**
+ * @brief Reports the progress of a response body: the number of bytes received so far,
+ *        and the total length, or TRANSPORT_UNKNOWN_LENGTH if the server didn't send one.
+ */
+typedef std::function<void(unsigned long long nReceived, unsigned long long nTotal)> fnTransportProgress;
+
+/**
+ * @brief A GET request.
+ */
+struct TRANSPORT_REQUEST
+{
+	std::string strURL;           ///< Absolute URL, in UTF-8.
+	TRANSPORT_HEADERS arrHeaders; ///< Additional request headers (e.g. If-None-Match).
+};
+
+/**
+ * @brief The response to a GET request, without the body, which goes to the fnTransportBody callback.
+ */
+struct TRANSPORT_RESPONSE
+{
+	int nStatusCode = 0;          ///< HTTP status code of the final response, 0 if no response was received.
+	TRANSPORT_HEADERS arrHeaders; ///< Response headers of the final response.
+	unsigned long long nContentLength = TRANSPORT_UNKNOWN_LENGTH; ///< Length of the body, if known.
+	std::string strError;         ///< Description of the failure, in UTF-8, if the request failed.
+};
+
+/**
+ * @brief Finds a header by name, ignoring case.
+ * @return The value of the first header with that name, or nullptr if there is none.
+ */
+inline const std::string* FindTransportHeader(const TRANSPORT_HEADERS& arrHeaders, const std::string& strName)
+{
+	for (const auto& pHeader : arrHeaders)
+	{
+		if ((pHeader.first.size() == strName.size()) && std::equal(pHeader.first.begin(), pHeader.first.end(), strName.begin(),
+			[](char chLeft, char chRight) { return ((chLeft >= 'A' && chLeft <= 'Z') ? chLeft + 32 : chLeft) == ((chRight >= 'A' && chRight <= 'Z') ? chRight + 32 : chRight); }))
+		{
+			return &pHeader.second;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * @brief Parses a non-negative decimal (nBase 10) or hexadecimal (nBase 16) number, such as a header value,
+ *        which must fill the whole string; longer numbers than fit in 64 bits are refused.
+ */
+inline bool ParseTransportNumber(const std::string& strValue, int nBase, unsigned long long& nValue)
+{
+	if (strValue.empty() || (strValue.size() > ((nBase == 16) ? 16U : 19U)))
+	{
+		return false;
+	}
+	nValue = 0;
+	for (const char chDigit : strValue)
+	{
+		int nDigit;
+		if (chDigit >= '0' && chDigit <= '9')
+			nDigit = chDigit - '0';
+		else if ((nBase == 16) && (chDigit >= 'a' && chDigit <= 'f'))
+			nDigit = chDigit - 'a' + 10;
+		else if ((nBase == 16) && (chDigit >= 'A' && chDigit <= 'F'))
+			nDigit = chDigit - 'A' + 10;
+		else
+			return false;
+		nValue = nValue * nBase + nDigit;
+	}
+	return true;
+}
+
+/**
+ * @brief A way to download URLs; the updater gets all of its files through one.
+ *
+ * Implementations: the URL Moniker of Windows (urlmon, the default, in genUp4win.cpp)
+ * and a portable HTTP/1.1 client (CHttpTransport).
+ */
+class ITransport
+{
+public:
+	virtual ~ITransport() = default;
+
+	/**
+	 * @brief Downloads a URL, streaming the response body to a callback as it arrives.
+	 *        Redirects are followed; the body of any other response than the final one is dropped.
+	 *        Get may be called from several threads at once.
+	 * @param pRequest The request.
+	 * @param pBody Receives the response body, in order.
+	 * @param pProgress Optional progress callback (may be empty).
+	 * @param pResponse Output: receives the status and headers of the response, before the first call to pBody,
+	 *        or the reason of the failure.
+	 * @return true if the server answered with a success (2xx) status and the whole body was received, false otherwise.
+	 */
+	virtual bool Get(const TRANSPORT_REQUEST& pRequest, const fnTransportBody& pBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse) = 0;
+};
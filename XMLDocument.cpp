@@ -0,0 +1,764 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+
+
+#include "XMLDocument.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+/**
+ * @brief Reports whether a character can be part of an element or attribute name.
+ */
+static bool IsNameChar(char nChar)
+{
+	return !IsXMLSpace(nChar) && (strchr("<>/=\"'&", nChar) == nullptr);
+}
+
+/**
+ * @brief Reports whether a string is a valid element or attribute name.
+ */
+static bool IsValidName(std::string_view strName)
+{
+	if (strName.empty() || ((strName[0] >= '0') && (strName[0] <= '9')) || (strName[0] == '-') || (strName[0] == '.'))
+		return false;
+	for (const char nChar : strName)
+	{
+		if ((nChar == '\0') || !IsNameChar(nChar))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Reports whether the text at pData starts with a prefix.
+ */
+static bool StartsWith(const char* pData, const char* pEnd, std::string_view strPrefix)
+{
+	return (static_cast<size_t>(pEnd - pData) >= strPrefix.size()) && (memcmp(pData, strPrefix.data(), strPrefix.size()) == 0);
+}
+
+/**
+ * @brief Returns the position past the first occurrence of a terminator (e.g. "-->"), or nullptr if there is none.
+ */
+static const char* SkipPast(const char* pData, const char* pEnd, std::string_view strTerminator)
+{
+	const size_t nPosition = std::string_view(pData, pEnd - pData).find(strTerminator);
+	return (nPosition == std::string_view::npos) ? nullptr : pData + nPosition + strTerminator.size();
+}
+
+/**
+ * @brief Appends a text to a document, escaping the characters that cannot appear as they are.
+ */
+static void AppendEscaped(std::string& strXML, std::string_view strText, bool bAttribute)
+{
+	for (const char nChar : strText)
+	{
+		if (nChar == '&')
+			strXML += "&amp;";
+		else if (nChar == '<')
+			strXML += "&lt;";
+		else if (nChar == '>')
+			strXML += "&gt;";
+		else if ((nChar == '"') && bAttribute)
+			strXML += "&quot;";
+		else
+			strXML += nChar;
+	}
+}
+
+bool IsXMLSpace(char nChar)
+{
+	return (nChar == ' ') || (nChar == '\t') || (nChar == '\r') || (nChar == '\n');
+}
+
+std::string_view TrimXMLSpace(std::string_view strText)
+{
+	while (!strText.empty() && IsXMLSpace(strText.front()))
+		strText.remove_prefix(1);
+	while (!strText.empty() && IsXMLSpace(strText.back()))
+		strText.remove_suffix(1);
+	return strText;
+}
+
+void AppendUTF8(std::string& strTarget, uint32_t nCodePoint)
+{
+	if (nCodePoint < 0x80)
+	{
+		strTarget.push_back(static_cast<char>(nCodePoint));
+	}
+	else if (nCodePoint < 0x800)
+	{
+		strTarget.push_back(static_cast<char>(0xC0 | (nCodePoint >> 6)));
+		strTarget.push_back(static_cast<char>(0x80 | (nCodePoint & 0x3F)));
+	}
+	else if (nCodePoint < 0x10000)
+	{
+		strTarget.push_back(static_cast<char>(0xE0 | (nCodePoint >> 12)));
+		strTarget.push_back(static_cast<char>(0x80 | ((nCodePoint >> 6) & 0x3F)));
+		strTarget.push_back(static_cast<char>(0x80 | (nCodePoint & 0x3F)));
+	}
+	else
+	{
+		strTarget.push_back(static_cast<char>(0xF0 | (nCodePoint >> 18)));
+		strTarget.push_back(static_cast<char>(0x80 | ((nCodePoint >> 12) & 0x3F)));
+		strTarget.push_back(static_cast<char>(0x80 | ((nCodePoint >> 6) & 0x3F)));
+		strTarget.push_back(static_cast<char>(0x80 | (nCodePoint & 0x3F)));
+	}
+}
+
+/**
+ * @brief Decodes one entity, without its & and ;.
+ * @return false if the entity is unknown or an invalid character reference.
+ */
+static bool DecodeEntity(std::string_view strEntity, std::string& strTarget)
+{
+	if (strEntity == "lt")
+		strTarget.push_back('<');
+	else if (strEntity == "gt")
+		strTarget.push_back('>');
+	else if (strEntity == "amp")
+		strTarget.push_back('&');
+	else if (strEntity == "apos")
+		strTarget.push_back('\'');
+	else if (strEntity == "quot")
+		strTarget.push_back('"');
+	else if ((strEntity.size() > 1) && (strEntity[0] == '#'))
+	{
+		const bool bHex = (strEntity[1] == 'x');
+		const size_t nFirst = bHex ? 2 : 1;
+		if (nFirst == strEntity.size())
+			return false;
+		uint32_t nCodePoint = 0;
+		for (size_t nIndex = nFirst; nIndex < strEntity.size(); nIndex++)
+		{
+			const char nChar = strEntity[nIndex];
+			uint32_t nDigit = 0;
+			if ((nChar >= '0') && (nChar <= '9'))
+				nDigit = nChar - '0';
+			else if (bHex && (nChar >= 'a') && (nChar <= 'f'))
+				nDigit = nChar - 'a' + 10;
+			else if (bHex && (nChar >= 'A') && (nChar <= 'F'))
+				nDigit = nChar - 'A' + 10;
+			else
+				return false;
+			nCodePoint = nCodePoint * (bHex ? 16 : 10) + nDigit;
+			if (nCodePoint > 0x10FFFF)
+				return false;
+		}
+		if ((nCodePoint == 0) || ((nCodePoint >= 0xD800) && (nCodePoint <= 0xDFFF)))
+			return false;
+		AppendUTF8(strTarget, nCodePoint);
+	}
+	else
+		return false;
+	return true;
+}
+
+bool DecodeXMLEntities(std::string_view strSource, std::string& strTarget)
+{
+	bool bValid = true;
+	while (true)
+	{
+		const size_t nAmpersand = strSource.find('&');
+		strTarget.append(strSource.substr(0, nAmpersand));
+		if (nAmpersand == std::string_view::npos)
+			return bValid;
+		const size_t nSemicolon = strSource.find(';', nAmpersand);
+		if (nSemicolon == std::string_view::npos)
+		{
+			strTarget.append(strSource.substr(nAmpersand));
+			return false;
+		}
+		if (!DecodeEntity(strSource.substr(nAmpersand + 1, nSemicolon - nAmpersand - 1), strTarget))
+		{
+			strTarget.append(strSource.substr(nAmpersand, nSemicolon - nAmpersand + 1));
+			bValid = false;
+		}
+		strSource.remove_prefix(nSemicolon + 1);
+	}
+}
+
+void* CXMLArena::Allocate(size_t nSize)
+{
+	const size_t nAlignment = alignof(std::max_align_t);
+	nSize = (nSize + nAlignment - 1) & ~(nAlignment - 1);
+
+	// Large strings get a block of their own, so they don't waste the rest of the current block
+	if (nSize > XML_ARENA_BLOCK_SIZE / 4)
+	{
+		m_arrBlocks.emplace_back(new char[nSize]);
+		return m_arrBlocks.back().get();
+	}
+	if ((m_pBlock == nullptr) || (m_nUsed + nSize > XML_ARENA_BLOCK_SIZE))
+	{
+		m_arrBlocks.emplace_back(new char[XML_ARENA_BLOCK_SIZE]);
+		m_pBlock = m_arrBlocks.back().get();
+		m_nUsed = 0;
+	}
+	void* pData = m_pBlock + m_nUsed;
+	m_nUsed += nSize;
+	return pData;
+}
+
+std::string_view CXMLArena::Copy(std::string_view strText)
+{
+	if (strText.empty())
+		return std::string_view();
+	char* pData = static_cast<char*>(Allocate(strText.size()));
+	memcpy(pData, strText.data(), strText.size());
+	return std::string_view(pData, strText.size());
+}
+
+void CXMLArena::Clear()
+{
+	m_arrBlocks.clear();
+	m_pBlock = nullptr;
+	m_nUsed = 0;
+}
+
+bool CXMLDocument::Load(std::string strXML)
+{
+	Clear();
+	m_strError.clear();
+
+	// UTF-16 is converted to UTF-8 once, a UTF-8 document is parsed where it is
+	size_t nStart = 0;
+	if ((strXML.size() >= 2) && (((static_cast<uint8_t>(strXML[0]) == 0xFF) && (static_cast<uint8_t>(strXML[1]) == 0xFE)) ||
+		((static_cast<uint8_t>(strXML[0]) == 0xFE) && (static_cast<uint8_t>(strXML[1]) == 0xFF))))
+	{
+		const bool bLittleEndian = (static_cast<uint8_t>(strXML[0]) == 0xFF);
+		if (strXML.size() % 2 != 0)
+			return Fail("The document ends in the middle of a character");
+		m_strBuffer.reserve(strXML.size() / 2);
+		uint32_t nHighSurrogate = 0;
+		for (size_t nIndex = 2; nIndex < strXML.size(); nIndex += 2)
+		{
+			const uint8_t nFirst = static_cast<uint8_t>(strXML[nIndex]);
+			const uint8_t nSecond = static_cast<uint8_t>(strXML[nIndex + 1]);
+			const uint32_t nUnit = bLittleEndian ? (nFirst | (nSecond << 8)) : ((nFirst << 8) | nSecond);
+			if (nHighSurrogate != 0)
+			{
+				if ((nUnit < 0xDC00) || (nUnit > 0xDFFF))
+					return Fail("The document has an invalid UTF-16 character");
+				AppendUTF8(m_strBuffer, 0x10000 + (((nHighSurrogate - 0xD800) << 10) | (nUnit - 0xDC00)));
+				nHighSurrogate = 0;
+			}
+			else if ((nUnit >= 0xD800) && (nUnit <= 0xDBFF))
+				nHighSurrogate = nUnit;
+			else if ((nUnit >= 0xDC00) && (nUnit <= 0xDFFF))
+				return Fail("The document has an invalid UTF-16 character");
+			else
+				AppendUTF8(m_strBuffer, nUnit);
+		}
+		if (nHighSurrogate != 0)
+			return Fail("The document ends in the middle of a character");
+	}
+	else
+	{
+		m_strBuffer = std::move(strXML);
+		if (m_strBuffer.compare(0, 3, "\xEF\xBB\xBF") == 0)
+			nStart = 3;
+	}
+	return Parse(m_strBuffer.data() + nStart, m_strBuffer.data() + m_strBuffer.size());
+}
+
+bool CXMLDocument::LoadFile(const std::filesystem::path& strFilePath)
+{
+	std::ifstream file(strFilePath, std::ios::binary);
+	if (!file)
+	{
+		Clear();
+		return Fail("Cannot open the document");
+	}
+	std::string strXML{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	if (file.bad())
+	{
+		Clear();
+		return Fail("Cannot read the document");
+	}
+	return Load(std::move(strXML));
+}
+
+std::string CXMLDocument::Save(bool bPrettyPrint) const
+{
+	std::string strXML;
+	Serialize(strXML, "UTF-8", bPrettyPrint);
+	return strXML;
+}
+
+bool CXMLDocument::SaveFile(const std::filesystem::path& strFilePath, bool bPrettyPrint) const
+{
+	std::string strXML;
+	Serialize(strXML, "UTF-16", bPrettyPrint);
+
+	// The document is valid UTF-8, built from UTF-8 input and UTF-8 strings
+	std::string strUTF16{ "\xFF\xFE" };
+	strUTF16.reserve(2 + strXML.size() * 2);
+	for (size_t nIndex = 0; nIndex < strXML.size();)
+	{
+		const uint8_t nLead = static_cast<uint8_t>(strXML[nIndex]);
+		const size_t nLength = (nLead < 0x80) ? 1 : (nLead < 0xE0) ? 2 : (nLead < 0xF0) ? 3 : 4;
+		uint32_t nCodePoint = (nLength == 1) ? nLead : (nLead & (0x7F >> nLength));
+		for (size_t nTrail = 1; (nTrail < nLength) && (nIndex + nTrail < strXML.size()); nTrail++)
+			nCodePoint = (nCodePoint << 6) | (static_cast<uint8_t>(strXML[nIndex + nTrail]) & 0x3F);
+		nIndex += nLength;
+		if (nCodePoint >= 0x10000)
+		{
+			nCodePoint -= 0x10000;
+			const uint32_t nHigh = 0xD800 | (nCodePoint >> 10);
+			strUTF16 += static_cast<char>(nHigh & 0xFF);
+			strUTF16 += static_cast<char>(nHigh >> 8);
+			nCodePoint = 0xDC00 | (nCodePoint & 0x3FF);
+		}
+		strUTF16 += static_cast<char>(nCodePoint & 0xFF);
+		strUTF16 += static_cast<char>(nCodePoint >> 8);
+	}
+
+	std::ofstream file(strFilePath, std::ios::binary | std::ios::trunc);
+	file.write(strUTF16.data(), strUTF16.size());
+	file.close();
+	return static_cast<bool>(file);
+}
+
+void CXMLDocument::Clear()
+{
+	m_pArena.Clear();
+	std::string().swap(m_strBuffer);
+	m_pRoot = nullptr;
+	m_mapChildren.clear();
+}
+
+XML_ELEMENT* CXMLDocument::CreateRoot(std::string_view strName)
+{
+	Clear();
+	return IsValidName(strName) ? NewElement(nullptr, m_pArena.Copy(strName)) : nullptr;
+}
+
+XML_ELEMENT* CXMLDocument::FindChild(const XML_ELEMENT* pParent, std::string_view strName)
+{
+	for (XML_ELEMENT* pChild = pParent->pFirstChild; pChild != nullptr; pChild = pChild->pNextSibling)
+	{
+		if (pChild->strName == strName)
+			return pChild;
+	}
+	return nullptr;
+}
+
+XML_ELEMENT* CXMLDocument::FindIndexedChild(const XML_ELEMENT* pParent, std::string_view strName)
+{
+	auto [itIndex, bInserted] = m_mapChildren.try_emplace(pParent);
+	if (bInserted)
+	{
+		// The names are views into the document, so they live as long as the index
+		for (XML_ELEMENT* pChild = pParent->pFirstChild; pChild != nullptr; pChild = pChild->pNextSibling)
+			itIndex->second.try_emplace(pChild->strName, pChild);
+	}
+	const auto itChild = itIndex->second.find(strName);
+	return (itChild != itIndex->second.end()) ? itChild->second : nullptr;
+}
+
+XML_ELEMENT* CXMLDocument::AppendChild(XML_ELEMENT* pParent, std::string_view strName)
+{
+	if (!IsValidName(strName))
+		return nullptr;
+	pParent->strContent = std::string_view();
+	pParent->bEncoded = false;
+	XML_ELEMENT* pElement = NewElement(pParent, m_pArena.Copy(strName));
+	const auto itIndex = m_mapChildren.find(pParent);
+	if (itIndex != m_mapChildren.end())
+		itIndex->second.try_emplace(pElement->strName, pElement);
+	return pElement;
+}
+
+void CXMLDocument::RemoveChild(XML_ELEMENT* pParent, XML_ELEMENT* pChild)
+{
+	XML_ELEMENT* pPrevious = nullptr;
+	for (XML_ELEMENT* pElement = pParent->pFirstChild; pElement != nullptr; pPrevious = pElement, pElement = pElement->pNextSibling)
+	{
+		if (pElement == pChild)
+		{
+			(pPrevious != nullptr ? pPrevious->pNextSibling : pParent->pFirstChild) = pChild->pNextSibling;
+			if (pParent->pLastChild == pChild)
+				pParent->pLastChild = pPrevious;
+			pChild->pParent = nullptr;
+			pChild->pNextSibling = nullptr;
+
+			// A later sibling with the same name, if any, is found in its place
+			const auto itIndex = m_mapChildren.find(pParent);
+			if (itIndex != m_mapChildren.end())
+			{
+				const auto itChild = itIndex->second.find(pChild->strName);
+				if ((itChild != itIndex->second.end()) && (itChild->second == pChild))
+				{
+					XML_ELEMENT* pNext = FindChild(pParent, pChild->strName);
+					if (pNext != nullptr)
+						itChild->second = pNext;
+					else
+						itIndex->second.erase(itChild);
+				}
+			}
+			RemoveIndexes(pChild);
+			return;
+		}
+	}
+}
+
+std::string CXMLDocument::GetText(const XML_ELEMENT* pElement)
+{
+	if (!pElement->bEncoded)
+		return std::string(pElement->strContent);
+
+	// Most values are plain text, which is copied as it is
+	const std::string_view strContent = pElement->strContent;
+	if (strContent.find_first_of("&<") == std::string_view::npos)
+		return std::string(TrimXMLSpace(strContent));
+
+	std::string strText;
+	size_t nStart = 0;
+	while (nStart < strContent.size())
+	{
+		const size_t nMarkup = strContent.find('<', nStart);
+		DecodeXMLEntities(strContent.substr(nStart, (nMarkup == std::string_view::npos) ? std::string_view::npos : nMarkup - nStart), strText);
+		if (nMarkup == std::string_view::npos)
+			break;
+
+		// The content was checked when it was parsed, so its CDATA sections, comments and processing instructions are closed
+		if (strContent.compare(nMarkup, 9, "<![CDATA[") == 0)
+		{
+			const size_t nEnd = strContent.find("]]>", nMarkup + 9);
+			strText.append(strContent.substr(nMarkup + 9, nEnd - nMarkup - 9));
+			nStart = nEnd + 3;
+		}
+		else if (strContent.compare(nMarkup, 4, "<!--") == 0)
+			nStart = strContent.find("-->", nMarkup + 4) + 3;
+		else
+			nStart = strContent.find("?>", nMarkup + 2) + 2;
+	}
+	return std::string(TrimXMLSpace(strText));
+}
+
+void CXMLDocument::SetText(XML_ELEMENT* pElement, std::string_view strText)
+{
+	RemoveIndexes(pElement);
+	pElement->pFirstChild = nullptr;
+	pElement->pLastChild = nullptr;
+	pElement->strContent = m_pArena.Copy(strText);
+	pElement->bEncoded = false;
+}
+
+const XML_ATTRIBUTE* CXMLDocument::FindAttribute(const XML_ELEMENT* pElement, std::string_view strName)
+{
+	for (const XML_ATTRIBUTE* pAttribute = pElement->pFirstAttribute; pAttribute != nullptr; pAttribute = pAttribute->pNext)
+	{
+		if (pAttribute->strName == strName)
+			return pAttribute;
+	}
+	return nullptr;
+}
+
+std::string CXMLDocument::GetAttribute(const XML_ELEMENT* pElement, std::string_view strName)
+{
+	const XML_ATTRIBUTE* pAttribute = FindAttribute(pElement, strName);
+	if (pAttribute == nullptr)
+		return std::string();
+	if (!pAttribute->bEncoded)
+		return std::string(pAttribute->strValue);
+	std::string strValue;
+	DecodeXMLEntities(pAttribute->strValue, strValue);
+	return strValue;
+}
+
+bool CXMLDocument::SetAttribute(XML_ELEMENT* pElement, std::string_view strName, std::string_view strValue)
+{
+	if (!IsValidName(strName))
+		return false;
+	XML_ATTRIBUTE* pAttribute = const_cast<XML_ATTRIBUTE*>(FindAttribute(pElement, strName));
+	if (pAttribute == nullptr)
+	{
+		pAttribute = m_pArena.New<XML_ATTRIBUTE>();
+		pAttribute->strName = m_pArena.Copy(strName);
+		XML_ATTRIBUTE** ppLast = &pElement->pFirstAttribute;
+		while (*ppLast != nullptr)
+			ppLast = &(*ppLast)->pNext;
+		*ppLast = pAttribute;
+	}
+	pAttribute->strValue = m_pArena.Copy(strValue);
+	pAttribute->bEncoded = false;
+	return true;
+}
+
+void CXMLDocument::RemoveAttribute(XML_ELEMENT* pElement, std::string_view strName)
+{
+	for (XML_ATTRIBUTE** ppAttribute = &pElement->pFirstAttribute; *ppAttribute != nullptr; ppAttribute = &(*ppAttribute)->pNext)
+	{
+		if ((*ppAttribute)->strName == strName)
+		{
+			*ppAttribute = (*ppAttribute)->pNext;
+			return;
+		}
+	}
+}
+
+bool CXMLDocument::Parse(const char* pData, const char* pEnd)
+{
+	XML_ELEMENT* pCurrent = nullptr;
+	size_t nDepth = 0;
+	while (true)
+	{
+		// The text up to the next markup is part of the content of the current element; outside of the root element, only white space is allowed
+		const char* pMarkup = static_cast<const char*>(memchr(pData, '<', pEnd - pData));
+		if (pCurrent == nullptr)
+		{
+			for (const char* pText = pData; pText < ((pMarkup != nullptr) ? pMarkup : pEnd); pText++)
+			{
+				if (!IsXMLSpace(*pText))
+					return Fail("The document has text outside of the root element");
+			}
+		}
+		if (pMarkup == nullptr)
+		{
+			if (pCurrent != nullptr)
+				return Fail("The document is truncated");
+			return (m_pRoot != nullptr) ? true : Fail("The document has no root element");
+		}
+		pData = pMarkup;
+
+		if (StartsWith(pData, pEnd, "<!--"))
+		{
+			if ((pData = SkipPast(pData + 4, pEnd, "-->")) == nullptr)
+				return Fail("The document has an unterminated comment");
+		}
+		else if (StartsWith(pData, pEnd, "<?"))
+		{
+			if ((pData = SkipPast(pData + 2, pEnd, "?>")) == nullptr)
+				return Fail("The document has an unterminated processing instruction");
+		}
+		else if (StartsWith(pData, pEnd, "<![CDATA["))
+		{
+			if (pCurrent == nullptr)
+				return Fail("The document has a CDATA section outside of the root element");
+			if ((pData = SkipPast(pData + 9, pEnd, "]]>")) == nullptr)
+				return Fail("The document has an unterminated CDATA section");
+		}
+		else if (StartsWith(pData, pEnd, "<!"))
+		{
+			// A DTD is skipped up to the > that closes it, past its internal subset in brackets
+			if ((pCurrent != nullptr) || (m_pRoot != nullptr))
+				return Fail("The document has a misplaced declaration");
+			size_t nBrackets = 0;
+			char nQuote = 0;
+			for (pData += 2; (pData < pEnd) && ((*pData != '>') || (nQuote != 0) || (nBrackets != 0)); pData++)
+			{
+				if (nQuote != 0)
+					nQuote = (*pData == nQuote) ? 0 : nQuote;
+				else if ((*pData == '"') || (*pData == '\''))
+					nQuote = *pData;
+				else if (*pData == '[')
+					nBrackets++;
+				else if ((*pData == ']') && (nBrackets > 0))
+					nBrackets--;
+			}
+			if (pData++ == pEnd)
+				return Fail("The document has an unterminated declaration");
+		}
+		else if (StartsWith(pData, pEnd, "</"))
+		{
+			const char* pClose = static_cast<const char*>(memchr(pData, '>', pEnd - pData));
+			if (pClose == nullptr)
+				return Fail("The document is truncated");
+			if ((pCurrent == nullptr) || (TrimXMLSpace(std::string_view(pData + 2, pClose - pData - 2)) != pCurrent->strName))
+				return Fail("The document has a mismatched end tag");
+
+			// The content of a leaf element (its text) spans from the end of its start tag to here
+			pCurrent->strContent = (pCurrent->pFirstChild == nullptr) ? std::string_view(pCurrent->strContent.data(), pMarkup - pCurrent->strContent.data()) : std::string_view();
+			pCurrent->bEncoded = (pCurrent->pFirstChild == nullptr);
+			pCurrent = pCurrent->pParent;
+			nDepth--;
+			pData = pClose + 1;
+		}
+		else
+		{
+			if ((pCurrent == nullptr) && (m_pRoot != nullptr))
+				return Fail("The document has more than one root element");
+			const char* pName = ++pData;
+			while ((pData < pEnd) && IsNameChar(*pData))
+				pData++;
+			if ((pData == pName) || !IsValidName(std::string_view(pName, pData - pName)))
+				return Fail("The document has an invalid tag");
+			XML_ELEMENT* pElement = NewElement(pCurrent, std::string_view(pName, pData - pName));
+
+			// Attributes, up to the end of the tag
+			XML_ATTRIBUTE** ppLast = &pElement->pFirstAttribute;
+			bool bEmpty = false;
+			while (true)
+			{
+				const char* pSpace = pData;
+				while ((pData < pEnd) && IsXMLSpace(*pData))
+					pData++;
+				if (pData == pEnd)
+					return Fail("The document is truncated");
+				if (*pData == '>')
+				{
+					pData++;
+					break;
+				}
+				if (StartsWith(pData, pEnd, "/>"))
+				{
+					pData += 2;
+					bEmpty = true;
+					break;
+				}
+				const char* pAttributeName = pData;
+				while ((pData < pEnd) && IsNameChar(*pData))
+					pData++;
+				const std::string_view strAttributeName(pAttributeName, pData - pAttributeName);
+				while ((pData < pEnd) && IsXMLSpace(*pData))
+					pData++;
+				if ((pSpace == pAttributeName) || !IsValidName(strAttributeName) || (pData == pEnd) || (*pData != '='))
+					return Fail("The document has an invalid attribute");
+				pData++;
+				while ((pData < pEnd) && IsXMLSpace(*pData))
+					pData++;
+				const char* pValueEnd = ((pData < pEnd) && ((*pData == '"') || (*pData == '\''))) ? static_cast<const char*>(memchr(pData + 1, *pData, pEnd - pData - 1)) : nullptr;
+				if (pValueEnd == nullptr)
+					return Fail("The document has an invalid attribute");
+				const std::string_view strValue(pData + 1, pValueEnd - pData - 1);
+				if (strValue.find('<') != std::string_view::npos)
+					return Fail("The document has an invalid attribute");
+				XML_ATTRIBUTE* pAttribute = m_pArena.New<XML_ATTRIBUTE>();
+				pAttribute->strName = strAttributeName;
+				pAttribute->strValue = strValue;
+				pAttribute->bEncoded = (strValue.find('&') != std::string_view::npos);
+				*ppLast = pAttribute;
+				ppLast = &pAttribute->pNext;
+				pData = pValueEnd + 1;
+			}
+			if (!bEmpty)
+			{
+				if (++nDepth > XML_DOCUMENT_MAX_DEPTH)
+					return Fail("The document is nested too deeply");
+				pElement->strContent = std::string_view(pData, 0);
+				pCurrent = pElement;
+			}
+		}
+	}
+}
+
+bool CXMLDocument::Fail(const std::string& strError)
+{
+	Clear();
+	m_strError = strError;
+	return false;
+}
+
+void CXMLDocument::RemoveIndexes(const XML_ELEMENT* pElement)
+{
+	if (m_mapChildren.empty())
+		return;
+	std::vector<const XML_ELEMENT*> arrPending{ pElement };
+	while (!arrPending.empty())
+	{
+		const XML_ELEMENT* pNext = arrPending.back();
+		arrPending.pop_back();
+		m_mapChildren.erase(pNext);
+		for (const XML_ELEMENT* pChild = pNext->pFirstChild; pChild != nullptr; pChild = pChild->pNextSibling)
+			arrPending.push_back(pChild);
+	}
+}
+
+XML_ELEMENT* CXMLDocument::NewElement(XML_ELEMENT* pParent, std::string_view strName)
+{
+	XML_ELEMENT* pElement = m_pArena.New<XML_ELEMENT>();
+	pElement->strName = strName;
+	pElement->pParent = pParent;
+	if (pParent == nullptr)
+		m_pRoot = pElement;
+	else
+	{
+		(pParent->pLastChild != nullptr ? pParent->pLastChild->pNextSibling : pParent->pFirstChild) = pElement;
+		pParent->pLastChild = pElement;
+	}
+	return pElement;
+}
+
+/**
+ * @brief Appends an element and its descendants to a document.
+ */
+static void SerializeElement(std::string& strXML, const XML_ELEMENT* pElement, size_t nDepth, bool bPrettyPrint)
+{
+	if (bPrettyPrint)
+		strXML.append(nDepth, '\t');
+	strXML += '<';
+	strXML += pElement->strName;
+	for (const XML_ATTRIBUTE* pAttribute = pElement->pFirstAttribute; pAttribute != nullptr; pAttribute = pAttribute->pNext)
+	{
+		strXML += ' ';
+		strXML += pAttribute->strName;
+		strXML += "=\"";
+		if (pAttribute->bEncoded && (pAttribute->strValue.find('"') == std::string_view::npos))
+			strXML += pAttribute->strValue;
+		else
+			AppendEscaped(strXML, pAttribute->bEncoded ? CXMLDocument::GetAttribute(pElement, pAttribute->strName) : std::string(pAttribute->strValue), true);
+		strXML += '"';
+	}
+	if (pElement->pFirstChild != nullptr)
+	{
+		strXML += bPrettyPrint ? ">\r\n" : ">";
+		for (const XML_ELEMENT* pChild = pElement->pFirstChild; pChild != nullptr; pChild = pChild->pNextSibling)
+			SerializeElement(strXML, pChild, nDepth + 1, bPrettyPrint);
+		if (bPrettyPrint)
+			strXML.append(nDepth, '\t');
+		strXML += "</";
+		strXML += pElement->strName;
+		strXML += '>';
+	}
+	else if (pElement->strContent.empty())
+		strXML += "/>";
+	else
+	{
+		// Content as it was loaded is written back as it is, CDATA sections included
+		strXML += '>';
+		if (pElement->bEncoded)
+			strXML += pElement->strContent;
+		else
+			AppendEscaped(strXML, pElement->strContent, false);
+		strXML += "</";
+		strXML += pElement->strName;
+		strXML += '>';
+	}
+	if (bPrettyPrint)
+		strXML += "\r\n";
+}
+
+void CXMLDocument::Serialize(std::string& strXML, const char* lpszEncoding, bool bPrettyPrint) const
+{
+	strXML += "<?xml version=\"1.0\" encoding=\"";
+	strXML += lpszEncoding;
+	strXML += "\" standalone=\"no\"?>\r\n";
+	if (m_pRoot != nullptr)
+		SerializeElement(strXML, m_pRoot, 0, bPrettyPrint);
+}
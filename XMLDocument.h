@@ -0,0 +1,273 @@
+/* MIT License
+
+Copyright (c) 2024-2026 Stefan-Mihai MOGA
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE. */
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+const size_t XML_ARENA_BLOCK_SIZE = 0x10000; ///< Size of the blocks the nodes of a document are allocated from (64 KiB).
+const size_t XML_DOCUMENT_MAX_DEPTH = 256;   ///< Deepest nesting of elements accepted in a document.
+
+/**
+ * @brief Reports whether a character is XML white space.
+ */
+bool IsXMLSpace(char nChar);
+
+/**
+ * @brief Removes the white space at both ends of a text, as MSXML does when it returns the text of an element.
+ */
+std::string_view TrimXMLSpace(std::string_view strText);
+
+/**
+ * @brief Appends a Unicode code point to a UTF-8 string.
+ */
+void AppendUTF8(std::string& strTarget, uint32_t nCodePoint);
+
+/**
+ * @brief Decodes the predefined entities (&lt; &gt; &amp; &apos; &quot;) and the character references of a text.
+ *        An unknown entity or an invalid character reference is copied as it is.
+ * @return false if the text has an unknown entity or an invalid character reference.
+ */
+bool DecodeXMLEntities(std::string_view strSource, std::string& strTarget);
+
+/**
+ * @brief An attribute of an element. Name and value are views into the document or into its arena.
+ */
+struct XML_ATTRIBUTE
+{
+	std::string_view strName;
+	std::string_view strValue; ///< Value as written in the document, or the plain value once it was set
+	bool bEncoded;             ///< strValue may have entities, which are decoded when it is read
+	XML_ATTRIBUTE* pNext;
+};
+
+/**
+ * @brief An element. Only the content of a leaf element is kept: the text of a setting.
+ */
+struct XML_ELEMENT
+{
+	std::string_view strName;
+	std::string_view strContent; ///< Content of a leaf element as written in the document, or its plain text once it was set
+	bool bEncoded;               ///< strContent may have entities, CDATA sections and comments, which are decoded when it is read
+	XML_ATTRIBUTE* pFirstAttribute;
+	XML_ELEMENT* pParent;
+	XML_ELEMENT* pFirstChild;
+	XML_ELEMENT* pLastChild;
+	XML_ELEMENT* pNextSibling;
+};
+
+/**
+ * @brief Allocates the nodes of a document from large blocks, which are all freed at once.
+ */
+class CXMLArena
+{
+public:
+	CXMLArena() : m_pBlock(nullptr), m_nUsed(0) {}
+	CXMLArena(const CXMLArena&) = delete;
+	CXMLArena& operator=(const CXMLArena&) = delete;
+
+	/**
+	 * @brief Allocates nSize bytes, aligned for any type.
+	 */
+	void* Allocate(size_t nSize);
+
+	/**
+	 * @brief Allocates a node; nodes are trivially destructible, so they are never destroyed one by one.
+	 */
+	template <typename Type>
+	Type* New()
+	{
+		return new (Allocate(sizeof(Type))) Type();
+	}
+
+	/**
+	 * @brief Copies a string into the arena.
+	 */
+	std::string_view Copy(std::string_view strText);
+
+	/**
+	 * @brief Frees all the blocks.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns the number of blocks allocated, i.e. of heap allocations made for the nodes.
+	 */
+	size_t GetBlockCount() const { return m_arrBlocks.size(); }
+
+private:
+	std::vector<std::unique_ptr<char[]>> m_arrBlocks;
+	char* m_pBlock; ///< The block of XML_ARENA_BLOCK_SIZE bytes being filled, or nullptr
+	size_t m_nUsed; ///< Bytes used in m_pBlock
+};
+
+/**
+ * @brief A portable XML document for settings files, as CXMLAppSettings reads and writes them: a root element,
+ *        section elements and entry elements with text and attributes.
+ *
+ * The document is parsed in place: names, values and texts are views into the loaded buffer, the nodes are
+ * allocated from an arena, and entities are only decoded when a value is read. UTF-16 files (as MSXML saves
+ * them) are converted to UTF-8 once on load; UTF-8 files are not copied. Files are saved in UTF-16, like MSXML.
+ *
+ * DTDs are skipped, not interpreted: only the predefined and the character entities are decoded.
+ *
+ * FindIndexedChild looks elements up in hashed indexes of the children of their parents, which are built on the
+ * first lookup and kept up to date by AppendChild and RemoveChild, so a catalog of many products is not scanned
+ * again for each section and each entry read from it.
+ */
+class CXMLDocument
+{
+public:
+	CXMLDocument() : m_pRoot(nullptr) {}
+	CXMLDocument(const CXMLDocument&) = delete;
+	CXMLDocument& operator=(const CXMLDocument&) = delete;
+
+	/**
+	 * @brief Parses a document, in UTF-8 or in UTF-16 with a byte order mark, replacing the current one.
+	 * @return false if the document is not well-formed; the document is then empty.
+	 */
+	bool Load(std::string strXML);
+
+	/**
+	 * @brief Reads and parses a file, replacing the current document.
+	 * @return false if the file cannot be read or is not well-formed; the document is then empty.
+	 */
+	bool LoadFile(const std::filesystem::path& strFilePath);
+
+	/**
+	 * @brief Returns the document in UTF-8, optionally indented with tabs.
+	 */
+	std::string Save(bool bPrettyPrint) const;
+
+	/**
+	 * @brief Writes the document to a file in UTF-16 with a byte order mark, optionally indented with tabs.
+	 * @return false if the file cannot be written.
+	 */
+	bool SaveFile(const std::filesystem::path& strFilePath, bool bPrettyPrint) const;
+
+	/**
+	 * @brief Empties the document.
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns why the last Load or LoadFile failed.
+	 */
+	const std::string& GetError() const { return m_strError; }
+
+	/**
+	 * @brief Returns the root element, or nullptr if the document is empty.
+	 */
+	XML_ELEMENT* GetRoot() const { return m_pRoot; }
+
+	/**
+	 * @brief Empties the document and creates its root element.
+	 * @return The root element, or nullptr if the name is not a valid element name.
+	 */
+	XML_ELEMENT* CreateRoot(std::string_view strName);
+
+	/**
+	 * @brief Returns the first child element with a name, or nullptr.
+	 */
+	static XML_ELEMENT* FindChild(const XML_ELEMENT* pParent, std::string_view strName);
+
+	/**
+	 * @brief Returns the first child element with a name, or nullptr, like FindChild, in O(1).
+	 *        The first lookup under a parent indexes all its children by name.
+	 */
+	XML_ELEMENT* FindIndexedChild(const XML_ELEMENT* pParent, std::string_view strName);
+
+	/**
+	 * @brief Appends a new child element; the text of the parent, if any, is dropped.
+	 * @return The new element, or nullptr if the name is not a valid element name.
+	 */
+	XML_ELEMENT* AppendChild(XML_ELEMENT* pParent, std::string_view strName);
+
+	/**
+	 * @brief Removes a child element, with its descendants. Their memory is only freed with the document.
+	 */
+	void RemoveChild(XML_ELEMENT* pParent, XML_ELEMENT* pChild);
+
+	/**
+	 * @brief Returns the text of a leaf element, decoded, without the white space at both ends (like MSXML).
+	 */
+	static std::string GetText(const XML_ELEMENT* pElement);
+
+	/**
+	 * @brief Replaces the content of an element with a text.
+	 */
+	void SetText(XML_ELEMENT* pElement, std::string_view strText);
+
+	/**
+	 * @brief Returns an attribute of an element, or nullptr.
+	 */
+	static const XML_ATTRIBUTE* FindAttribute(const XML_ELEMENT* pElement, std::string_view strName);
+
+	/**
+	 * @brief Returns the decoded value of an attribute, or an empty string if the element has no such attribute.
+	 */
+	static std::string GetAttribute(const XML_ELEMENT* pElement, std::string_view strName);
+
+	/**
+	 * @brief Sets an attribute of an element.
+	 * @return false if the name is not a valid attribute name.
+	 */
+	bool SetAttribute(XML_ELEMENT* pElement, std::string_view strName, std::string_view strValue);
+
+	/**
+	 * @brief Removes an attribute of an element, if it has it.
+	 */
+	static void RemoveAttribute(XML_ELEMENT* pElement, std::string_view strName);
+
+	/**
+	 * @brief Returns the number of heap blocks the nodes of the document take.
+	 */
+	size_t GetBlockCount() const { return m_pArena.GetBlockCount(); }
+
+	/**
+	 * @brief Returns the number of parents whose children are indexed.
+	 */
+	size_t GetIndexCount() const { return m_mapChildren.size(); }
+
+private:
+	bool Parse(const char* pBegin, const char* pEnd);
+	bool Fail(const std::string& strError);
+	XML_ELEMENT* NewElement(XML_ELEMENT* pParent, std::string_view strName);
+	void RemoveIndexes(const XML_ELEMENT* pElement); ///< Drops the indexes of an element and of its descendants, which are detached
+	void Serialize(std::string& strXML, const char* lpszEncoding, bool bPrettyPrint) const;
+
+	std::string m_strBuffer; ///< The loaded document, which the names and values point into
+	CXMLArena m_pArena;
+	XML_ELEMENT* m_pRoot;
+	std::string m_strError;
+	std::unordered_map<const XML_ELEMENT*, std::unordered_map<std::string_view, XML_ELEMENT*>> m_mapChildren; ///< First child by name, of the parents looked up with FindIndexedChild
+};
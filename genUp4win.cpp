@@ -24,9 +24,10 @@ SOFTWARE. */
 #include "resource.h"
 #include "genUp4win.h"
 #include "AppSettings.h"
+#include "NativeXMLAppSettings.h"
 #include "VersionInfo.h"
 
-#include "Urlmon.h" // URLDownloadToFile function
+#include "Urlmon.h" // URLOpenBlockingStream function
 #pragma comment(lib, "Urlmon.lib")
 
 #include "shellapi.h" // ShellExecuteEx function
@@ -35,35 +36,56 @@ SOFTWARE. */
 #include <comdef.h>
 #include <shlobj.h>
 #include "SHA256.h"
+#include "ChecksumAlgorithm.h"
+#include "DigestValue.h"
+#include "SHA256MultiBuffer.h"
+#include "FileReader.h"
+#include "ChecksumCache.h"
+#include "HashCheckpoint.h"
+#include "DownloadRecord.h"
+#include "Transport.h"
+#include "HttpTransport.h"
+#include "SegmentedDownloader.h"
+#include "ManifestReader.h"
+#include "BinaryManifest.h"
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <system_error>
 
 /**
- * @brief IBindStatusCallback implementation for URLDownloadToFile to report download progress.
+ * @brief IBindStatusCallback and IHttpNegotiate implementation for the urlmon transport.
  * 
- * This class implements the COM IBindStatusCallback interface to provide progress notifications
- * during file downloads using URLDownloadToFile. It tracks download progress and reports
- * percentage completion to a user-provided callback function.
+ * This class implements the COM IBindStatusCallback interface to learn the total size of a download
+ * opened with URLOpenBlockingStream, and the IHttpNegotiate interface to add request headers
+ * and to receive the status code and the headers of the HTTP response.
  * 
  * @note This class manages its own lifetime through COM reference counting.
  *       It will automatically delete itself when the reference count reaches zero.
  */
-class CDownloadCallback : public IBindStatusCallback
+class CDownloadCallback : public IBindStatusCallback, public IHttpNegotiate
 {
 private:
 	ULONG m_refCount;           ///< COM reference count for object lifetime management
-	fnCallback m_callback;      ///< User callback function for progress notifications
-	ULONGLONG m_totalBytes;     ///< Total size of the file being downloaded in bytes
-	ULONGLONG m_downloadedBytes; ///< Number of bytes downloaded so far
+	std::wstring m_strAdditionalHeaders; ///< Request headers to add, each line ending with CR LF
+	ULONGLONG m_totalBytes;     ///< Total size of the file being downloaded in bytes, 0 if unknown
+	DWORD m_responseCode;       ///< HTTP status code of the response, 0 if none was received
+	std::wstring m_strResponseHeaders; ///< Status line and headers of the HTTP response
 
 public:
 	/**
-	 * @brief Constructor that initializes the callback with a user-provided function.
-	 * @param callback The callback function to be invoked with progress updates.
+	 * @brief Constructor.
+	 * @param strAdditionalHeaders Request headers to add, each line ending with CR LF (may be empty).
 	 */
-	CDownloadCallback(fnCallback callback) 
-		: m_refCount(1), m_callback(callback), m_totalBytes(0), m_downloadedBytes(0)
+	CDownloadCallback(const std::wstring& strAdditionalHeaders)
+		: m_refCount(1), m_strAdditionalHeaders(strAdditionalHeaders), m_totalBytes(0), m_responseCode(0)
 	{
 	}
 
+	ULONGLONG GetTotalBytes() const { return m_totalBytes; }
+	DWORD GetResponseCode() const { return m_responseCode; }
+	const std::wstring& GetResponseHeaders() const { return m_strResponseHeaders; }
+
 	// ========================================================================================
 	// IUnknown methods - Required for all COM interfaces
 	// ========================================================================================
@@ -76,13 +98,19 @@ public:
 	 */
 	STDMETHOD(QueryInterface)(REFIID riid, void** ppvObject)
 	{
-		// Check if the requested interface is IUnknown or IBindStatusCallback
+		// Check if the requested interface is IUnknown, IBindStatusCallback or IHttpNegotiate
 		if (riid == IID_IUnknown || riid == IID_IBindStatusCallback)
 		{
 			*ppvObject = static_cast<IBindStatusCallback*>(this);
 			AddRef(); // Increment reference count for the returned interface
 			return S_OK;
 		}
+		if (riid == IID_IHttpNegotiate)
+		{
+			*ppvObject = static_cast<IHttpNegotiate*>(this);
+			AddRef(); // Increment reference count for the returned interface
+			return S_OK;
+		}
 		*ppvObject = nullptr;
 		return E_NOINTERFACE; // Interface not supported
 	}
@@ -151,8 +179,8 @@ public:
 	/**
 	 * @brief Called periodically to report download progress.
 	 * 
-	 * This is the main method that tracks and reports download progress. It calculates
-	 * the percentage complete and notifies the user callback function.
+	 * The bytes received are counted by the transport as it reads the stream, in 64 bits;
+	 * this method only records the total size, for servers that don't send a Content-Length.
 	 * 
 	 * @param ulProgress Number of bytes downloaded so far.
 	 * @param ulProgressMax Total size of the download in bytes.
@@ -160,34 +188,16 @@ public:
 	 * @param szStatusText Optional status text (not used in this implementation).
 	 * @return S_OK to continue the operation.
 	 */
-	STDMETHOD(OnProgress)(ULONG ulProgress, ULONG ulProgressMax, ULONG ulStatusCode, LPCWSTR)
+	STDMETHOD(OnProgress)(ULONG, ULONG ulProgressMax, ULONG ulStatusCode, LPCWSTR)
 	{
 		// Only process download progress notifications
 		// BINDSTATUS_DOWNLOADINGDATA: Called periodically during download
 		// BINDSTATUS_ENDDOWNLOADDATA: Called when download completes
 		if (ulStatusCode == BINDSTATUS_DOWNLOADINGDATA || ulStatusCode == BINDSTATUS_ENDDOWNLOADDATA)
 		{
-			// Ensure we have valid progress data to avoid division by zero
 			if (ulProgressMax > 0)
 			{
-				// Update our internal progress tracking
-				m_downloadedBytes = ulProgress;
 				m_totalBytes = ulProgressMax;
-
-				// Calculate percentage complete (0-100)
-				const int percentage = static_cast<int>((ulProgress * 100) / ulProgressMax);
-
-				// Notify the user callback if it's set
-				if (m_callback)
-				{
-					CString strStatusMessage;
-					// Load the localized "Downloading..." message from resources
-					if (strStatusMessage.LoadString(IDS_DOWNLOADING))
-					{
-						// Report progress to the parent application with current percentage
-						m_callback(GENUP4WIN_INPROGRESS, std::wstring(strStatusMessage), percentage);
-					}
-				}
 			}
 		}
 		return S_OK; // Continue the download
@@ -225,7 +235,7 @@ public:
 	 */
 	STDMETHOD(OnDataAvailable)(DWORD, DWORD, FORMATETC*, STGMEDIUM*)
 	{
-		return S_OK; // Data is being handled by URLDownloadToFile
+		return S_OK; // Data is pulled from the blocking stream by DownloadFileWithChecksum
 	}
 
 	/**
@@ -238,6 +248,53 @@ public:
 	{
 		return S_OK; // Object availability notification received
 	}
+
+	// ========================================================================================
+	// IHttpNegotiate methods - Add request headers and receive the response headers
+	// ========================================================================================
+
+	/**
+	 * @brief Called before the request is sent, to add request headers.
+	 * @param szURL The URL being requested.
+	 * @param szHeaders The headers urlmon is going to send.
+	 * @param dwReserved Reserved for future use.
+	 * @param pszAdditionalHeaders Output: receives the headers to add, allocated with CoTaskMemAlloc.
+	 * @return S_OK, or E_OUTOFMEMORY if the headers couldn't be allocated.
+	 */
+	STDMETHOD(BeginningTransaction)(LPCWSTR, LPCWSTR, DWORD, LPWSTR* pszAdditionalHeaders)
+	{
+		*pszAdditionalHeaders = nullptr;
+		if (!m_strAdditionalHeaders.empty())
+		{
+			const size_t nSize = (m_strAdditionalHeaders.size() + 1) * sizeof(WCHAR);
+			*pszAdditionalHeaders = static_cast<LPWSTR>(CoTaskMemAlloc(nSize));
+			if (*pszAdditionalHeaders == nullptr)
+			{
+				return E_OUTOFMEMORY;
+			}
+			memcpy(*pszAdditionalHeaders, m_strAdditionalHeaders.c_str(), nSize);
+		}
+		return S_OK;
+	}
+
+	/**
+	 * @brief Called when the HTTP response is received.
+	 * @param dwResponseCode The HTTP status code.
+	 * @param szResponseHeaders The status line and the headers of the response.
+	 * @param szRequestHeaders The headers that were sent (not used in this implementation).
+	 * @param pszAdditionalRequestHeaders Output: headers to send again, none in this implementation.
+	 * @return S_OK to continue the operation.
+	 */
+	STDMETHOD(OnResponse)(DWORD dwResponseCode, LPCWSTR szResponseHeaders, LPCWSTR, LPWSTR* pszAdditionalRequestHeaders)
+	{
+		m_responseCode = dwResponseCode;
+		m_strResponseHeaders = (szResponseHeaders != nullptr) ? szResponseHeaders : L"";
+		if (pszAdditionalRequestHeaders != nullptr)
+		{
+			*pszAdditionalRequestHeaders = nullptr;
+		}
+		return S_OK;
+	}
 };
 
 /**
@@ -343,361 +400,1478 @@ std::string wstring_to_utf8(const std::wstring& wide_string)
 const int MAX_BUFFER = 0x10000; ///< Maximum buffer size for file operations.
 
 /**
- * @brief Calculates the SHA256 checksum of a file.
- * @param strFilePath Path to the file to calculate checksum for.
- * @param strChecksum Output: receives the calculated checksum as a hexadecimal string.
- * @return true if the checksum was calculated successfully, false if the file couldn't be opened.
+ * @brief The urlmon transport: downloads with URLOpenBlockingStream, so it supports https and
+ *        the proxy settings of the system, like URLDownloadToFile.
  */
-bool GetChecksumFromFile(const std::wstring& strFilePath, std::wstring& strChecksum)
+class CUrlmonTransport : public ITransport
 {
-	SHA256 sha256;
+public:
+	bool Get(const TRANSPORT_REQUEST& pRequest, const fnTransportBody& pBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse) override
+	{
+		// Segmented downloads call Get from worker threads, which have not initialized COM
+		const HRESULT hInitialize = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+		const bool bResult = Download(pRequest, pBody, pProgress, pResponse);
+		if (SUCCEEDED(hInitialize))
+		{
+			CoUninitialize();
+		}
+		return bResult;
+	}
 
-	// Open the file in binary mode
-	std::ifstream file(strFilePath, std::ios::binary);
-	if (!file)
+private:
+	/**
+	 * @brief Downloads a URL through a blocking stream; see ITransport::Get.
+	 */
+	bool Download(const TRANSPORT_REQUEST& pRequest, const fnTransportBody& pBody, const fnTransportProgress& pProgress, TRANSPORT_RESPONSE& pResponse)
 	{
-		return false;
+		pResponse = TRANSPORT_RESPONSE();
+		std::wstring strAdditionalHeaders;
+		for (const auto& pHeader : pRequest.arrHeaders)
+		{
+			strAdditionalHeaders += utf8_to_wstring(pHeader.first) + L": " + utf8_to_wstring(pHeader.second) + L"\r\n";
+		}
+
+		// Open a blocking stream so the data passes through our hands instead of going straight to disk
+		CDownloadCallback pCallback(strAdditionalHeaders);
+		ATL::CComPtr<IStream> pStream;
+		HRESULT hResult = URLOpenBlockingStream(nullptr, utf8_to_wstring(pRequest.strURL).c_str(), &pStream, 0, &pCallback);
+		ReadResponseHeaders(pCallback, pResponse);
+		if (FAILED(hResult))
+		{
+			pResponse.strError = wstring_to_utf8(_com_error(hResult).ErrorMessage());
+			return false;
+		}
+		if ((pResponse.nStatusCode < 200) || (pResponse.nStatusCode >= 300))
+		{
+			pResponse.strError = "HTTP " + std::to_string(pResponse.nStatusCode);
+			return false;
+		}
+
+		// The bytes are counted here, as the progress notifications of urlmon are only 32 bits
+		ULONGLONG nReceived = 0;
+		std::vector<uint8_t> buffer(MAX_BUFFER);
+		while (true)
+		{
+			ULONG nRead = 0;
+			hResult = pStream->Read(buffer.data(), static_cast<ULONG>(buffer.size()), &nRead);
+			if (FAILED(hResult))
+			{
+				pResponse.strError = wstring_to_utf8(_com_error(hResult).ErrorMessage());
+				return false;
+			}
+			if (nRead > 0)
+			{
+				if (!pBody(buffer.data(), nRead))
+				{
+					pResponse.strError = wstring_to_utf8(_com_error(E_ABORT).ErrorMessage());
+					return false;
+				}
+				nReceived += nRead;
+				if (pProgress)
+				{
+					if ((pResponse.nContentLength == TRANSPORT_UNKNOWN_LENGTH) && (pCallback.GetTotalBytes() > 0))
+					{
+						pResponse.nContentLength = pCallback.GetTotalBytes();
+					}
+					pProgress(nReceived, pResponse.nContentLength);
+				}
+			}
+			if ((hResult == S_FALSE) || (nRead == 0))
+			{
+				break; // End of the stream
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Fills the status and the headers of the response from what urlmon received.
+	 *        URLs other than http:// and https:// (e.g. file://) have no status, and get 200.
+	 */
+	static void ReadResponseHeaders(const CDownloadCallback& pCallback, TRANSPORT_RESPONSE& pResponse)
+	{
+		pResponse.nStatusCode = (pCallback.GetResponseCode() != 0) ? static_cast<int>(pCallback.GetResponseCode()) : 200;
+		std::wistringstream pHeaders(pCallback.GetResponseHeaders());
+		std::wstring strLine;
+		std::getline(pHeaders, strLine); // Status line
+		while (std::getline(pHeaders, strLine))
+		{
+			if (!strLine.empty() && (strLine.back() == L'\r'))
+			{
+				strLine.pop_back();
+			}
+			const size_t nColon = strLine.find(L':');
+			if ((nColon != std::wstring::npos) && (nColon > 0))
+			{
+				// Trimmed on both sides, as CHttpTransport does
+				const size_t nValue = strLine.find_first_not_of(L" \t", nColon + 1);
+				pResponse.arrHeaders.emplace_back(wstring_to_utf8(strLine.substr(0, nColon)),
+					(nValue == std::wstring::npos) ? std::string() : wstring_to_utf8(strLine.substr(nValue, strLine.find_last_not_of(L" \t") - nValue + 1)));
+			}
+		}
+		// The body is already downloaded, so an invalid length is only left unknown
+		unsigned long long nContentLength = 0;
+		if (const std::string* pContentLength = FindTransportHeader(pResponse.arrHeaders, "Content-Length"); (pContentLength != nullptr) &&
+			ParseTransportNumber(*pContentLength, 10, nContentLength))
+		{
+			pResponse.nContentLength = nContentLength;
+		}
 	}
+};
 
-	// Use a dynamically allocated buffer to avoid stack overflow
-	constexpr size_t bufferSize = MAX_BUFFER;
-	std::vector<char> buffer(bufferSize);
+std::mutex g_pTransportLock;                ///< Guards g_pTransport
+std::shared_ptr<ITransport> g_pTransport;   ///< Transport set by SetTransport, or nullptr for urlmon
 
-	// Read the file in chunks and update the SHA256 hash
-	while (file.read(buffer.data(), bufferSize) || file.gcount() > 0)
+/**
+ * @brief Returns the transport that downloads the configuration files and the installers.
+ *        A download keeps its transport even if SetTransport is called meanwhile.
+ */
+std::shared_ptr<ITransport> GetTransport()
+{
+	std::lock_guard<std::mutex> pLock(g_pTransportLock);
+	if (g_pTransport == nullptr)
 	{
-		sha256.update(reinterpret_cast<const uint8_t*>(buffer.data()),
-			static_cast<size_t>(file.gcount()));
+		g_pTransport = std::make_shared<CUrlmonTransport>();
 	}
+	return g_pTransport;
+}
 
-	// Convert the digest to a hexadecimal string
-	strChecksum = utf8_to_wstring(SHA256::toString(sha256.digest()));
+/**
+ * @brief Selects the transport that downloads the configuration files and the installers.
+ * @param strName TRANSPORT_URLMON or TRANSPORT_HTTP, in any case.
+ * @return true if the transport was selected, false if the name is not known.
+ */
+bool SetTransport(const std::wstring& strName)
+{
+	std::shared_ptr<ITransport> pTransport;
+	if (_wcsicmp(strName.c_str(), TRANSPORT_URLMON) == 0)
+	{
+		pTransport = std::make_shared<CUrlmonTransport>();
+	}
+	else if (_wcsicmp(strName.c_str(), TRANSPORT_HTTP) == 0)
+	{
+		pTransport = std::make_shared<CHttpTransport>();
+	}
+	else
+	{
+		return false;
+	}
+	std::lock_guard<std::mutex> pLock(g_pTransportLock);
+	g_pTransport = pTransport;
 	return true;
 }
 
 /**
- * @brief Downloads a file from a URL and calculates its SHA256 checksum.
- * @param strURL The URL to download the file from.
- * @param strChecksum Output: receives the calculated checksum as a hexadecimal string.
- * @return true if the download and checksum calculation succeeded, false otherwise.
+ * @brief Returns the counters of the connection pool of the HTTP/1.1 transport.
+ * @param nHits Output: receives the number of requests sent on a kept-alive connection.
+ * @param nMisses Output: receives the number of requests that opened a new connection.
  */
-bool GetChecksumFromURL(const std::wstring strURL, std::wstring& strChecksum)
+void GetConnectionPoolStatistics(unsigned long long& nHits, unsigned long long& nMisses)
 {
-	HRESULT hResult = S_OK;
-	TCHAR lpszTempPath[_MAX_PATH + 1] = { 0, };
+	const HTTP_POOL_STATISTICS pStatistics = GetHttpConnectionPool().GetStatistics();
+	nHits = pStatistics.nHits;
+	nMisses = pStatistics.nMisses;
+}
 
-	// Get the system's temporary directory path
-	DWORD nLength = GetTempPath(_MAX_PATH, lpszTempPath);
-	if (nLength > 0)
+/**
+ * @brief Sets how long the HTTP/1.1 transport keeps an idle connection open.
+ * @param nIdleTimeout The idle timeout in milliseconds; 0 closes every connection after its response.
+ */
+void SetConnectionPoolIdleTimeout(unsigned int nIdleTimeout)
+{
+	GetHttpConnectionPool().SetIdleTimeout(nIdleTimeout);
+	if (nIdleTimeout == 0)
 	{
-		TCHAR lpszFilePath[_MAX_PATH + 1] = { 0, };
-
-		// Generate a unique temporary file name
-		nLength = GetTempFileName(lpszTempPath, L"GUP", 0, lpszFilePath);
-		if (nLength > 0)
-		{
-			// Change the extension from .tmp to .msi (or the default installer extension)
-			CString strFileName = lpszFilePath;
-			strFileName.Replace(_T(".tmp"), DEFAULT_EXTENSION);
-
-			// Download the file from the URL
-			if ((hResult = URLDownloadToFile(nullptr, strURL.c_str(), strFileName, 0, nullptr)) == S_OK)
-			{
-				// Calculate and return the checksum of the downloaded file
-				return GetChecksumFromFile(strFileName.GetString(), strChecksum);
-			}
-		}
+		GetHttpConnectionPool().Clear();
 	}
-
-	return false;
 }
 
+std::atomic<unsigned int> g_nSegmentCount{ SEGMENTED_DOWNLOAD_SEGMENT_COUNT };           ///< Most connections per installer download
+std::atomic<unsigned long long> g_nMinSegmentSize{ SEGMENTED_DOWNLOAD_MIN_SEGMENT_SIZE }; ///< Smallest range fetched by one connection
+
 /**
- * @brief Constructs the full path to the application's settings XML file.
- *        Tries to use the user's profile directory; falls back to the given file path.
- * @param strFilePath The base file path to use if the profile directory is unavailable.
- * @param strProductName The product name, used as the XML file name.
- * @return The full path to the settings XML file.
+ * @brief Sets how many connections download the installer at once, each fetching a byte range.
+ * @param nSegmentCount The most connections; 1 downloads the installer as a single stream.
+ * @param nMinSegmentSize The smallest range in bytes fetched by one connection.
  */
-const std::wstring GetAppSettingsFilePath(const std::wstring& strFilePath, const std::wstring& strProductName)
+void SetSegmentedDownload(unsigned int nSegmentCount, unsigned long long nMinSegmentSize)
 {
-	WCHAR* lpszSpecialFolderPath = nullptr;
+	g_nSegmentCount = (std::max)(nSegmentCount, 1u);
+	g_nMinSegmentSize = nMinSegmentSize;
+}
 
-	// Attempt to get the user's profile directory (e.g., C:\Users\Username)
-	if ((SHGetKnownFolderPath(FOLDERID_Profile, 0, nullptr, &lpszSpecialFolderPath)) == S_OK)
+/**
+ * @brief Returns the description of a failed transport request, for the status callback.
+ */
+std::wstring GetTransportErrorMessage(const TRANSPORT_RESPONSE& pResponse)
+{
+	try
 	{
-		// Build the settings file path in the user's profile directory
-		std::wstring result(lpszSpecialFolderPath);
-		CoTaskMemFree(lpszSpecialFolderPath); // Free the allocated memory
-		result += _T("\\");
-		result += strProductName;
-		result += _T(".xml");
-		OutputDebugString(result.c_str()); // Log the path for debugging
-		return result;
+		return utf8_to_wstring(pResponse.strError);
+	}
+	catch (const std::runtime_error&)
+	{
+		return _com_error(E_FAIL).ErrorMessage();
 	}
-
-	// Fallback: Use the application's directory if profile directory is unavailable
-	std::filesystem::path strFullPath{ strFilePath.c_str() };
-	strFullPath.replace_filename(strProductName);
-	strFullPath.replace_extension(_T(".xml"));
-	OutputDebugString(strFullPath.c_str()); // Log the path for debugging
-	return strFullPath.c_str();
 }
 
 /**
- * @brief Writes configuration data (version and download URL) to an XML file.
- * @param strFilePath Path to the version info file.
- * @param strDownloadURL The download URL to write.
- * @param ParentCallback Callback function for status/error reporting.
- * @return true if the operation succeeded, false otherwise.
+ * @brief Returns the value of the alg attribute of the Checksum entry for an algorithm. SHA-256 is written
+ *        without the attribute, so that configuration files stay readable by older versions.
+ * @param strAlgorithm The algorithm name (see GetChecksumAlgorithmName).
+ * @return The canonical name of the algorithm, or an empty string for SHA-256 and unsupported algorithms.
  */
-bool WriteConfigFile(const std::wstring& strFilePath, const std::wstring& strDownloadURL, fnCallback ParentCallback)
+std::wstring GetChecksumAlgorithmAttribute(const std::wstring& strAlgorithm)
 {
-	bool retVal = false;
-	CVersionInfo pVersionInfo;
-	std::wstring strChecksum; // Stores the calculated checksum of the download URL
+	const char* lpszName = GetChecksumAlgorithmName(wstring_to_utf8(strAlgorithm));
+	return ((lpszName == nullptr) || (strcmp(lpszName, CHECKSUM_ALGORITHM_NAME_SHA256) == 0)) ? std::wstring() : utf8_to_wstring(lpszName);
+}
 
-	// Load version information from the specified file
-	if (pVersionInfo.Load(strFilePath.c_str()))
+/**
+ * @brief Calculates the checksum of a file. Large files are hashed straight from a memory mapping;
+ *        smaller ones are read on a background thread into a ring of buffers, so reading and hashing overlap.
+ * @param strFilePath Path to the file to calculate checksum for.
+ * @param strAlgorithm The checksum algorithm (see GetChecksumAlgorithmName).
+ * @param pChecksum Output: receives the calculated checksum.
+ * @param nBufferCount Number of read buffers in the ring.
+ * @param nBufferSize Size of each read buffer in bytes.
+ * @return true if the checksum was calculated successfully, false if the file couldn't be read
+ *         or the algorithm is not supported.
+ */
+bool GetChecksumFromFile(const std::wstring& strFilePath, const std::wstring& strAlgorithm, DigestValue& pChecksum, const size_t nBufferCount = PIPELINE_BUFFER_COUNT, const size_t nBufferSize = PIPELINE_BUFFER_SIZE)
+{
+	std::unique_ptr<IChecksumAlgorithm> pAlgorithm = CreateChecksumAlgorithm(wstring_to_utf8(strAlgorithm));
+	if ((pAlgorithm == nullptr) ||
+		!ReadFileBlocks(strFilePath, [&pAlgorithm](const uint8_t* pData, size_t nLength) { pAlgorithm->Update(pData, nLength); }, nBufferCount, nBufferSize))
 	{
-		const std::wstring& strProductName = pVersionInfo.GetProductName();
-		try
-		{
-			// Initialize COM library for XML operations
-			const HRESULT hr{ CoInitialize(nullptr) };
-			if (FAILED(hr))
-			{
-				// Report COM initialization failure
-				_com_error pError(hr);
-				LPCTSTR lpszErrorMessage = pError.ErrorMessage();
-				ParentCallback(GENUP4WIN_ERROR, lpszErrorMessage, 0);
-				return false;
-			}
-
-			// Write version and download URL to XML settings file
-			CXMLAppSettings pAppSettings(GetAppSettingsFilePath(strFilePath, strProductName), true, true);
-			pAppSettings.WriteString(strProductName.c_str(), VERSION_ENTRY_ID, pVersionInfo.GetProductVersionAsString().c_str());
-			pAppSettings.WriteString(strProductName.c_str(), DOWNLOAD_ENTRY_ID, strDownloadURL.c_str());
-
-			// Calculate and write the checksum of the download URL if available
-			if (GetChecksumFromURL(strDownloadURL.c_str(), strChecksum))
-			{
-				pAppSettings.WriteString(strProductName.c_str(), CHECKSUM_ENTRY_ID, strChecksum.c_str());
-			}
-			retVal = true;
-		}
-		catch (CAppSettingsException& pException)
-		{
-			// Handle XML settings exceptions
-			const int nErrorLength = 0x100;
-			TCHAR lpszErrorMessage[nErrorLength] = { 0, };
-			pException.GetErrorMessage(lpszErrorMessage, nErrorLength);
-			ParentCallback(GENUP4WIN_ERROR, lpszErrorMessage, 0);
-		}
+		return false;
 	}
-	return retVal;
+
+	pChecksum = pAlgorithm->Finish();
+	return true;
 }
 
 /**
- * @brief Downloads a configuration XML file from a URL, parses it for the latest version and download URL,
- *        and reports status via callback.
- * @param strConfigURL The URL to download the configuration file from.
- * @param strProductName The product name to look up in the XML.
- * @param strLatestVersion Output: receives the latest version string.
- * @param strDownloadURL Output: receives the download URL.
- * @param strChecksum Output: receives the checksum string.
- * @param ParentCallback Callback function for status/error reporting.
- * @return true if the operation succeeded, false otherwise.
+ * @brief Calculates the tree checksum of a file: the file is split into chunks of nChunkSize bytes,
+ *        each chunk is hashed with SHA256 on a worker thread, and the root is the SHA256 of the
+ *        concatenated chunk digests. An empty file counts as one empty chunk.
+ * @param strFilePath Path to the file to calculate checksum for.
+ * @param nChunkSize Size of each chunk in bytes (at least MIN_TREE_CHUNK_SIZE).
+ * @param pChecksum Output: receives the root checksum.
+ * @return true if the checksum was calculated successfully, false if the chunk size is too small or the file couldn't be read.
  */
-bool ReadConfigFile(const std::wstring& strConfigURL, const std::wstring& strProductName, std::wstring& strLatestVersion, std::wstring& strDownloadURL, std::wstring& strChecksum, fnCallback ParentCallback)
+bool GetTreeChecksumFromFile(const std::wstring& strFilePath, const ULONGLONG nChunkSize, DigestValue& pChecksum)
 {
-	CString strStatusMessage;
-	HRESULT hResult = S_OK;
-	bool retVal = false;
-	TCHAR lpszTempPath[_MAX_PATH + 1] = { 0, };
-
-	// Get the system's temporary directory path
-	DWORD nLength = GetTempPath(_MAX_PATH, lpszTempPath);
-	if (nLength > 0)
+	std::error_code errorCode;
+	const ULONGLONG nFileSize = std::filesystem::file_size(strFilePath, errorCode);
+	if (errorCode || (nChunkSize < MIN_TREE_CHUNK_SIZE))
 	{
-		TCHAR lpszFilePath[_MAX_PATH + 1] = { 0, };
+		return false;
+	}
 
-		// Generate a unique temporary file name
-		nLength = GetTempFileName(lpszTempPath, L"GUP", 0, lpszFilePath);
-		if (nLength > 0)
+	const size_t nChunks = static_cast<size_t>((std::max)((nFileSize + nChunkSize - 1) / nChunkSize, 1ULL));
+	std::vector<std::array<uint8_t, 32>> arrDigests(nChunks);
+	std::atomic<size_t> nNextChunk{ 0 };
+	std::atomic<bool> bFailed{ false };
+
+	// Each worker opens its own handle and hashes whole chunks until none are left
+	const auto HashChunks = [&]()
+	{
+		std::ifstream file(strFilePath, std::ios::binary);
+		if (!file)
 		{
-			// Change the extension from .tmp to .xml
-			CString strFileName = lpszFilePath;
-			strFileName.Replace(_T(".tmp"), _T(".xml"));
+			bFailed = true;
+			return;
+		}
 
-			// Report connection status to the user
-			if (strStatusMessage.LoadString(IDS_CONNECTING))
-			{
-				ParentCallback(GENUP4WIN_INPROGRESS, std::wstring(strStatusMessage), 0);
-			}
+		std::vector<char> buffer(MAX_BUFFER);
+		for (size_t nChunk = nNextChunk++; (nChunk < nChunks) && !bFailed; nChunk = nNextChunk++)
+		{
+			SHA256 sha256;
+			const ULONGLONG nOffset = nChunk * nChunkSize;
+			ULONGLONG nRemaining = (std::min)(nChunkSize, nFileSize - nOffset);
 
-			// Download the configuration file from the URL
-			if ((hResult = URLDownloadToFile(nullptr, strConfigURL.c_str(), strFileName, 0, nullptr)) == S_OK)
+			file.clear();
+			file.seekg(static_cast<std::streamoff>(nOffset));
+			while (nRemaining > 0)
 			{
-				try
-				{
-					// Initialize COM library for XML operations
-					const HRESULT hr{ CoInitialize(nullptr) };
-					if (FAILED(hr))
-					{
-						// Report COM initialization failure
-						_com_error pError(hr);
-						LPCTSTR lpszErrorMessage = pError.ErrorMessage();
-						ParentCallback(GENUP4WIN_ERROR, lpszErrorMessage, 0);
-						return false;
-					}
-
-					// Parse XML configuration file for version, download URL, and checksum
-					CXMLAppSettings pAppSettings(std::wstring(strFileName), true, true);
-					strLatestVersion = pAppSettings.GetString(strProductName.c_str(), VERSION_ENTRY_ID);
-					strDownloadURL = pAppSettings.GetString(strProductName.c_str(), DOWNLOAD_ENTRY_ID);
-					strChecksum = pAppSettings.GetString(strProductName.c_str(), CHECKSUM_ENTRY_ID);
-					retVal = true;
-				}
-				catch (CAppSettingsException& pException)
+				const size_t nLength = static_cast<size_t>((std::min)(nRemaining, static_cast<ULONGLONG>(buffer.size())));
+				if (!file.read(buffer.data(), nLength))
 				{
-					// Handle XML parsing exceptions
-					const int nErrorLength = 0x100;
-					TCHAR lpszErrorMessage[nErrorLength] = { 0, };
-					pException.GetErrorMessage(lpszErrorMessage, nErrorLength);
-					ParentCallback(GENUP4WIN_ERROR, lpszErrorMessage, 0);
+					bFailed = true; // File shrank or couldn't be read
+					return;
 				}
+				sha256.update(reinterpret_cast<const uint8_t*>(buffer.data()), nLength);
+				nRemaining -= nLength;
 			}
-			else
-			{
-				// Report download failure
-				_com_error pError(hResult);
-				LPCTSTR lpszErrorMessage = pError.ErrorMessage();
-				ParentCallback(GENUP4WIN_ERROR, lpszErrorMessage, 0);
-			}
+			arrDigests[nChunk] = sha256.digest();
+		}
+	};
+
+	// Use all cores, but never more threads than chunks
+	const size_t nThreads = (std::min)(static_cast<size_t>((std::max)(std::thread::hardware_concurrency(), 1U)), nChunks);
+	std::vector<std::thread> arrWorkers;
+	for (size_t nIndex = 1; nIndex < nThreads; nIndex++)
+	{
+		try
+		{
+			arrWorkers.emplace_back(HashChunks);
+		}
+		catch (const std::system_error&)
+		{
+			break; // The chunks left are hashed by the threads already running
 		}
 	}
-	return retVal;
+	HashChunks();
+	for (auto& pWorker : arrWorkers)
+	{
+		pWorker.join();
+	}
+	if (bFailed)
+	{
+		return false;
+	}
+
+	// Combine the chunk digests into the root hash
+	SHA256 sha256;
+	for (const auto& digest : arrDigests)
+	{
+		sha256.update(digest.data(), digest.size());
+	}
+	pChecksum = sha256.digest();
+	return true;
 }
 
 /**
- * @brief Checks for software updates by comparing the current version with the latest version from a configuration URL.
- *        If a new version is found, downloads and launches the update, reporting status via callback.
- * @param strFilePath Path to the local version info file.
- * @param strConfigURL URL to the remote configuration XML.
- * @param ParentCallback Callback function for status/error reporting.
- * @return true if an update was found and download was successful, false otherwise.
+ * @brief Returns the checksum of a file from the checksum cache, calculating and caching it
+ *        if the file is not in the cache or has changed since it was hashed.
+ * @param strFilePath Path to the file to calculate checksum for.
+ * @param strAlgorithm The checksum algorithm (see GetChecksumAlgorithmName).
+ * @param pChecksum Output: receives the checksum.
+ * @param pChecksumCache The checksum cache to consult and update.
+ * @return true if the checksum is known, false if the file couldn't be read or the algorithm is not supported.
  */
-bool CheckForUpdates(const std::wstring& strFilePath, const std::wstring& strConfigURL, fnCallback ParentCallback)
+bool GetChecksumFromFile(const std::wstring& strFilePath, const std::wstring& strAlgorithm, DigestValue& pChecksum, CChecksumCache& pChecksumCache)
 {
-	CString strStatusMessage;
-	HRESULT hResult = S_OK;
-	bool retVal = false;
-	CVersionInfo pVersionInfo;
-	std::wstring strLatestVersion,
-		strDownloadURL,
-		strChecksum;
+	const char* lpszName = GetChecksumAlgorithmName(wstring_to_utf8(strAlgorithm));
+	if (lpszName == nullptr)
+	{
+		return false;
+	}
 
-	// Load the current application's version information
-	if (pVersionInfo.Load(strFilePath.c_str()))
+	// The algorithm is the kind of the cache entry
+	const std::string strKind = lpszName;
+	std::string strCachedChecksum;
+	if (pChecksumCache.Lookup(strFilePath, strKind, strCachedChecksum) && pChecksum.parse(strCachedChecksum))
+	{
+		return true;
+	}
+	// The identity is taken before hashing, so a file changed meanwhile is not cached
+	CChecksumCache::CFileIdentity pIdentity;
+	const bool bIdentified = CChecksumCache::GetIdentity(strFilePath, pIdentity);
+	if (!GetChecksumFromFile(strFilePath, strAlgorithm, pChecksum))
+	{
+		return false;
+	}
+	if (bIdentified)
+	{
+		pChecksumCache.Store(strFilePath, strKind, pChecksum.toString(), pIdentity);
+	}
+	return true;
+}
+
+/**
+ * @brief Returns the tree checksum of a file from the checksum cache, calculating and caching it
+ *        if the file is not in the cache or has changed since it was hashed.
+ * @param strFilePath Path to the file to calculate checksum for.
+ * @param nChunkSize Size of each chunk in bytes (at least MIN_TREE_CHUNK_SIZE).
+ * @param pChecksum Output: receives the root checksum.
+ * @param pChecksumCache The checksum cache to consult and update.
+ * @return true if the checksum is known, false if the chunk size is too small or the file couldn't be read.
+ */
+bool GetTreeChecksumFromFile(const std::wstring& strFilePath, const ULONGLONG nChunkSize, DigestValue& pChecksum, CChecksumCache& pChecksumCache)
+{
+	// The chunk size changes the root, so it is part of the kind
+	const std::string strKind = "tree-" + std::to_string(nChunkSize);
+	std::string strCachedChecksum;
+	if (pChecksumCache.Lookup(strFilePath, strKind, strCachedChecksum) && pChecksum.parse(strCachedChecksum))
+	{
+		return true;
+	}
+	CChecksumCache::CFileIdentity pIdentity;
+	const bool bIdentified = CChecksumCache::GetIdentity(strFilePath, pIdentity);
+	if (!GetTreeChecksumFromFile(strFilePath, nChunkSize, pChecksum))
+	{
+		return false;
+	}
+	if (bIdentified)
+	{
+		pChecksumCache.Store(strFilePath, strKind, pChecksum.toString(), pIdentity);
+	}
+	return true;
+}
+
+/**
+ * @brief Calculates the SHA256 checksums of several files at once, hashing them in parallel SIMD lanes.
+ * @param arrFilePaths Paths of the files to calculate checksums for.
+ * @param arrChecksums Output: receives one hexadecimal checksum per file, in the same order.
+ * @return true if every checksum was calculated successfully, false if any file couldn't be read.
+ */
+bool GetChecksumsFromFiles(const std::vector<std::wstring>& arrFilePaths, std::vector<std::wstring>& arrChecksums)
+{
+	const std::vector<std::filesystem::path> arrPaths(arrFilePaths.begin(), arrFilePaths.end());
+	std::vector<SHA256MultiBuffer::Digest> arrDigests;
+
+	// Hash all files together, one per SIMD lane
+	const bool retVal = SHA256MultiBuffer::hashFiles(arrPaths, arrDigests);
+
+	// Convert the digests to hexadecimal strings
+	arrChecksums.clear();
+	arrChecksums.reserve(arrDigests.size());
+	for (const auto& digest : arrDigests)
+	{
+		arrChecksums.push_back(DigestValue(digest).toWString());
+	}
+	return retVal;
+}
+
+/**
+ * @brief Records the part of a download that is on the disk: the state of the checksum, if the algorithm
+ *        can save it, and which file on the server the part belongs to.
+ * @return true if the record was saved.
+ */
+static bool SaveDownloadProgress(const std::wstring& strFileName, const IChecksumAlgorithm& pAlgorithm, const ULONGLONG nBytesDone, DOWNLOAD_RECORD& pRecord)
+{
+	std::vector<uint8_t> arrState;
+	if (!FlushFileToDisk(strFileName) || (pAlgorithm.SaveState(arrState) && !SaveHashCheckpoint(strFileName, pAlgorithm.GetName(), nBytesDone, arrState)))
+	{
+		return false;
+	}
+	pRecord.nBytesDone = nBytesDone;
+	return SaveDownloadRecord(strFileName, pRecord);
+}
+
+/**
+ * @brief Downloads a file from a URL into a local file, calculating the checksum of the bytes
+ *        as they are received, so no second pass over the downloaded file is needed.
+ *        The state of the checksum is checkpointed next to the file every HASH_CHECKPOINT_INTERVAL bytes;
+ *        if the file already has a checkpoint from an interrupted download, hashing continues from there,
+ *        and if its record (see DOWNLOAD_RECORD) has a validator, only the rest of the file is requested.
+ *        Algorithms that can't save their state only keep the record, and the downloaded part is hashed again.
+ *        A new download fetches byte ranges over several connections at once if the server supports them
+ *        (see SetSegmentedDownload); the checksum is still calculated over the bytes in order.
+ * @param strURL The URL to download the file from.
+ * @param strFileName Path of the local file to write.
+ * @param strAlgorithm The checksum algorithm (see GetChecksumAlgorithmName).
+ * @param pChecksum Output: receives the checksum of the downloaded bytes.
+ * @param pProgress Optional progress callback (may be empty).
+ * @param strErrorMessage Output: receives the reason if the download failed.
+ * @return true if the download succeeded, false otherwise.
+ */
+bool DownloadFileWithChecksum(const std::wstring& strURL, const std::wstring& strFileName, const std::wstring& strAlgorithm, DigestValue& pChecksum, const fnTransportProgress& pProgress, std::wstring& strErrorMessage)
+{
+	std::unique_ptr<IChecksumAlgorithm> pAlgorithm = CreateChecksumAlgorithm(wstring_to_utf8(strAlgorithm));
+	if (pAlgorithm == nullptr)
+	{
+		strErrorMessage = _com_error(E_INVALIDARG).ErrorMessage();
+		return false;
+	}
+
+	// The record tells which file on the server the partial file is a part of
+	const std::string strUTF8URL = wstring_to_utf8(strURL);
+	DOWNLOAD_RECORD pRecord;
+	const bool bRecorded = LoadDownloadRecord(strFileName, pRecord) && (pRecord.strURL == strUTF8URL);
+
+	// Keep the bytes that were hashed before the interruption, and drop anything written after the checkpoint
+	ULONGLONG nBytesDone = 0;
+	std::vector<uint8_t> arrState;
+	bool bResumed = false;
+	if (LoadHashCheckpoint(strFileName, pAlgorithm->GetName(), nBytesDone, arrState) && pAlgorithm->LoadState(arrState))
+	{
+		std::error_code errorCode;
+		std::filesystem::resize_file(strFileName, nBytesDone, errorCode);
+		bResumed = !errorCode;
+	}
+	else if (bRecorded && (pRecord.nBytesDone > 0))
+	{
+		// The algorithm can't save its state: hashing the recorded bytes again is still cheaper than downloading them again
+		pAlgorithm = CreateChecksumAlgorithm(pAlgorithm->GetName());
+		nBytesDone = pRecord.nBytesDone;
+		std::error_code errorCode;
+		std::filesystem::resize_file(strFileName, nBytesDone, errorCode);
+		bResumed = !errorCode && ReadFileBlocks(std::filesystem::path(strFileName), [&pAlgorithm](const uint8_t* pData, size_t nLength) { pAlgorithm->Update(pData, nLength); });
+	}
+	if (!bResumed)
+	{
+		// Start over with a fresh calculation
+		pAlgorithm = CreateChecksumAlgorithm(pAlgorithm->GetName());
+		nBytesDone = 0;
+	}
+
+	std::string strValidator;
+	if (bResumed && bRecorded)
+	{
+		// Nothing is left to download if the whole file was written before the interruption
+		if (nBytesDone == pRecord.nExpectedSize)
+		{
+			RemoveHashCheckpoint(strFileName);
+			RemoveDownloadRecord(strFileName);
+			if (pProgress)
+			{
+				pProgress(nBytesDone, nBytesDone);
+			}
+			pChecksum = pAlgorithm->Finish();
+			return true;
+		}
+		strValidator = GetDownloadRecordValidator(pRecord);
+	}
+	pRecord = DOWNLOAD_RECORD();
+	pRecord.strURL = strUTF8URL;
+
+	const unsigned int nSegmentCount = g_nSegmentCount;
+	if (!bResumed && (nSegmentCount > 1))
+	{
+		// The connections fill the file in any order; the downloader hands the bytes over in order, after they are written
+		const std::shared_ptr<ITransport> pTransport = GetTransport();
+		CSegmentedDownloader pDownloader(*pTransport, nSegmentCount, g_nMinSegmentSize);
+		ULONGLONG nLastCheckpoint = 0;
+		TRANSPORT_RESPONSE pResponse;
+		if (!pDownloader.Download(strUTF8URL, std::filesystem::path(strFileName), [&](const uint8_t* pData, size_t nLength)
+		{
+			if (nBytesDone == 0)
+			{
+				SetDownloadRecordResponse(pRecord, pResponse, 0);
+			}
+			pAlgorithm->Update(pData, nLength);
+			nBytesDone += nLength;
+			if ((nBytesDone - nLastCheckpoint >= HASH_CHECKPOINT_INTERVAL) && SaveDownloadProgress(strFileName, *pAlgorithm, nBytesDone, pRecord))
+			{
+				nLastCheckpoint = nBytesDone;
+			}
+			return true;
+		}, pProgress, pResponse))
+		{
+			strErrorMessage = GetTransportErrorMessage(pResponse);
+			return false;
+		}
+		RemoveHashCheckpoint(strFileName);
+		RemoveDownloadRecord(strFileName);
+		pChecksum = pAlgorithm->Finish();
+		return true;
+	}
+
+	std::ofstream file(strFileName, std::ios::binary | ((nBytesDone > 0) ? std::ios::app : std::ios::trunc));
+	if (!file)
+	{
+		strErrorMessage = _com_error(HRESULT_FROM_WIN32(ERROR_CANNOT_MAKE)).ErrorMessage();
+		return false;
+	}
+
+	// Ask for the rest of the file only if it is still the same on the server: otherwise If-Range makes the server send all of it.
+	// Without a validator, the bytes already on disk are received again, but neither hashed nor written
+	TRANSPORT_REQUEST pRequest{ strUTF8URL, {} };
+	bool bRanged = !strValidator.empty();
+	if (bRanged)
+	{
+		pRequest.arrHeaders = { { "Range", "bytes=" + std::to_string(nBytesDone) + "-" }, { "If-Range", strValidator } };
+	}
+	ULONGLONG nSkip = bRanged ? 0 : nBytesDone;
+	ULONGLONG nLastCheckpoint = nBytesDone;
+	ULONGLONG nResponseOffset = 0; // Position in the file of the first byte of the response body
+	bool bStarted = false;
+	HRESULT hWriteResult = S_OK;
+	TRANSPORT_RESPONSE pResponse;
+
+	// Drops the partial file, when the file on the server is not the same any more
+	const auto StartOver = [&]()
+	{
+		file.close();
+		file.open(strFileName, std::ios::binary | std::ios::trunc);
+		RemoveHashCheckpoint(strFileName);
+		RemoveDownloadRecord(strFileName);
+		pAlgorithm = CreateChecksumAlgorithm(pAlgorithm->GetName());
+		nBytesDone = nSkip = nLastCheckpoint = nResponseOffset = 0;
+		return static_cast<bool>(file);
+	};
+
+	const fnTransportBody pBody = [&](const uint8_t* pData, size_t nLength)
+	{
+		if (!bStarted)
+		{
+			bStarted = true;
+			if (bRanged)
+			{
+				const std::string* pContentRange = FindTransportHeader(pResponse.arrHeaders, "Content-Range");
+				unsigned long long nFirst = 0, nLast = 0, nTotal = 0;
+				if (pResponse.nStatusCode != 206)
+				{
+					if (!StartOver())
+					{
+						hWriteResult = HRESULT_FROM_WIN32(ERROR_CANNOT_MAKE);
+						return false;
+					}
+				}
+				else if ((pContentRange == nullptr) || !ParseContentRange(*pContentRange, nFirst, nLast, nTotal) || (nFirst != nBytesDone))
+				{
+					hWriteResult = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+					return false;
+				}
+				else
+				{
+					nResponseOffset = nBytesDone;
+				}
+			}
+			SetDownloadRecordResponse(pRecord, pResponse, nResponseOffset);
+		}
+
+		const size_t nOffset = static_cast<size_t>((std::min)(nSkip, static_cast<ULONGLONG>(nLength)));
+		nSkip -= nOffset;
+		if (nLength > nOffset)
+		{
+			// Hash and write the same buffer
+			pAlgorithm->Update(pData + nOffset, nLength - nOffset);
+			if (!file.write(reinterpret_cast<const char*>(pData + nOffset), nLength - nOffset))
+			{
+				hWriteResult = HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+				return false;
+			}
+			nBytesDone += nLength - nOffset;
+
+			// Checkpoint only what has reached the disk, and record which file it is a part of
+			if ((nBytesDone - nLastCheckpoint >= HASH_CHECKPOINT_INTERVAL) && file.flush() && SaveDownloadProgress(strFileName, *pAlgorithm, nBytesDone, pRecord))
+			{
+				nLastCheckpoint = nBytesDone;
+			}
+		}
+		return true;
+	};
+
+	// The progress of a resumed download counts the part downloaded before
+	const fnTransportProgress pResumedProgress = [&](unsigned long long nReceived, unsigned long long nTotal)
+	{
+		if (pProgress)
+		{
+			pProgress(nResponseOffset + nReceived, (nTotal == TRANSPORT_UNKNOWN_LENGTH) ? nTotal : nResponseOffset + nTotal);
+		}
+	};
+
+	bool bDownloaded = GetTransport()->Get(pRequest, pBody, pResumedProgress, pResponse);
+	if (!bDownloaded && bRanged && !bStarted && (pResponse.nStatusCode == 416))
+	{
+		// The file on the server is now shorter than the part downloaded before
+		bRanged = false;
+		pRequest.arrHeaders.clear();
+		bDownloaded = StartOver() && GetTransport()->Get(pRequest, pBody, pResumedProgress, pResponse);
+	}
+	if (!bDownloaded)
+	{
+		strErrorMessage = FAILED(hWriteResult) ? std::wstring(_com_error(hWriteResult).ErrorMessage()) : GetTransportErrorMessage(pResponse);
+		return false;
+	}
+
+	file.close();
+	if (!file)
+	{
+		strErrorMessage = _com_error(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT)).ErrorMessage();
+		return false;
+	}
+	RemoveHashCheckpoint(strFileName);
+	RemoveDownloadRecord(strFileName);
+	if (nSkip > 0)
+	{
+		// The file on the server is now shorter than the part downloaded before
+		strErrorMessage = _com_error(HRESULT_FROM_WIN32(ERROR_HANDLE_EOF)).ErrorMessage();
+		return false;
+	}
+
+	pChecksum = pAlgorithm->Finish();
+	return true;
+}
+
+/**
+ * @brief Downloads a file from a URL and calculates its checksum.
+ * @param strURL The URL to download the file from.
+ * @param strAlgorithm The checksum algorithm (see GetChecksumAlgorithmName).
+ * @param pChecksum Output: receives the calculated checksum.
+ * @param nTreeChunkSize Chunk size for the tree checksum, or 0 to skip it.
+ * @param pTreeChecksum Output: receives the tree checksum if nTreeChunkSize is not 0.
+ * @return true if the download and checksum calculation succeeded, false otherwise.
+ */
+bool GetChecksumFromURL(const std::wstring strURL, const std::wstring& strAlgorithm, DigestValue& pChecksum, const ULONGLONG nTreeChunkSize, DigestValue& pTreeChecksum)
+{
+	TCHAR lpszTempPath[_MAX_PATH + 1] = { 0, };
+
+	// Get the system's temporary directory path
+	DWORD nLength = GetTempPath(_MAX_PATH, lpszTempPath);
+	if (nLength > 0)
+	{
+		TCHAR lpszFilePath[_MAX_PATH + 1] = { 0, };
+
+		// Generate a unique temporary file name
+		nLength = GetTempFileName(lpszTempPath, L"GUP", 0, lpszFilePath);
+		if (nLength > 0)
+		{
+			// Change the extension from .tmp to .msi (or the default installer extension)
+			CString strFileName = lpszFilePath;
+			strFileName.Replace(_T(".tmp"), DEFAULT_EXTENSION);
+
+			// Download the file from the URL, calculating its checksum on the way
+			std::wstring strErrorMessage;
+			if (DownloadFileWithChecksum(strURL, strFileName.GetString(), strAlgorithm, pChecksum, nullptr, strErrorMessage))
+			{
+				// Calculate the tree checksum of the downloaded file, if requested
+				return (nTreeChunkSize == 0) || GetTreeChecksumFromFile(strFileName.GetString(), nTreeChunkSize, pTreeChecksum);
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Constructs the full path to the application's settings XML file.
+ *        Tries to use the user's profile directory; falls back to the given file path.
+ * @param strFilePath The base file path to use if the profile directory is unavailable.
+ * @param strProductName The product name, used as the XML file name.
+ * @return The full path to the settings XML file.
+ */
+const std::wstring GetAppSettingsFilePath(const std::wstring& strFilePath, const std::wstring& strProductName)
+{
+	WCHAR* lpszSpecialFolderPath = nullptr;
+
+	// Attempt to get the user's profile directory (e.g., C:\Users\Username)
+	if ((SHGetKnownFolderPath(FOLDERID_Profile, 0, nullptr, &lpszSpecialFolderPath)) == S_OK)
+	{
+		// Build the settings file path in the user's profile directory
+		std::wstring result(lpszSpecialFolderPath);
+		CoTaskMemFree(lpszSpecialFolderPath); // Free the allocated memory
+		result += _T("\\");
+		result += strProductName;
+		result += _T(".xml");
+		OutputDebugString(result.c_str()); // Log the path for debugging
+		return result;
+	}
+
+	// Fallback: Use the application's directory if profile directory is unavailable
+	std::filesystem::path strFullPath{ strFilePath.c_str() };
+	strFullPath.replace_filename(strProductName);
+	strFullPath.replace_extension(_T(".xml"));
+	OutputDebugString(strFullPath.c_str()); // Log the path for debugging
+	return strFullPath.c_str();
+}
+
+/**
+ * @brief Constructs the full path to the checksum cache of a product, next to its settings XML file.
+ * @param strFilePath The base file path to use if the profile directory is unavailable.
+ * @param strProductName The product name, used as the cache file name.
+ * @return The full path to the checksum cache file.
+ */
+const std::wstring GetChecksumCacheFilePath(const std::wstring& strFilePath, const std::wstring& strProductName)
+{
+	std::filesystem::path strCachePath{ GetAppSettingsFilePath(strFilePath, strProductName) };
+	strCachePath.replace_extension(_T(".checksums"));
+	return strCachePath.c_str();
+}
+
+/**
+ * @brief Constructs the full path of a folder of genUp4win in the local application data folder (or the temporary folder),
+ *        and creates it if needed.
+ * @param strSubFolder The sub folder, or an empty string for the genUp4win folder itself.
+ * @return The full path to the folder, or an empty path if it couldn't be created.
+ */
+const std::filesystem::path GetLocalDataFolderPath(const std::wstring& strSubFolder)
+{
+	std::filesystem::path strFolderPath;
+	WCHAR* lpszSpecialFolderPath = nullptr;
+	if ((SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &lpszSpecialFolderPath)) == S_OK)
+	{
+		strFolderPath = lpszSpecialFolderPath;
+		CoTaskMemFree(lpszSpecialFolderPath); // Free the allocated memory
+	}
+	else
+	{
+		std::error_code errorCode;
+		strFolderPath = std::filesystem::temp_directory_path(errorCode);
+	}
+	strFolderPath /= _T("genUp4win");
+	if (!strSubFolder.empty())
+	{
+		strFolderPath /= strSubFolder;
+	}
+	std::error_code errorCode;
+	std::filesystem::create_directories(strFolderPath, errorCode);
+	return errorCode ? std::filesystem::path() : strFolderPath;
+}
+
+/**
+ * @brief Constructs the full path where the configuration file of a URL is cached, in the genUp4win folder.
+ * @param strConfigURL The URL of the configuration file.
+ * @param strExtension The extension of the cached file (.xml or BINARY_MANIFEST_EXTENSION).
+ * @return The full path to the cached configuration file, or an empty string if the folder couldn't be created.
+ */
+const std::wstring GetConfigCacheFilePath(const std::wstring& strConfigURL, const std::wstring& strExtension)
+{
+	const std::filesystem::path strFolderPath{ GetLocalDataFolderPath(std::wstring()) };
+	if (strFolderPath.empty())
+	{
+		return std::wstring();
+	}
+	return (strFolderPath / (DigestValue(SHA256::hash(wstring_to_utf8(strConfigURL))).toWString().substr(0, 16) + strExtension)).wstring();
+}
+
+/**
+ * @brief Downloads a configuration file with a conditional request, passing it to a consumer as it arrives:
+ *        if the cached copy is still current, the Web Server answers 304 Not Modified without a body, and the caller
+ *        reads the cached copy instead. The ETag and the Last-Modified date of the cached copy are kept in its record
+ *        (see DOWNLOAD_RECORD); a configuration file without them is not cached, and its download stops as soon as
+ *        the consumer has what it needs.
+ * @param strConfigURL The URL to download the configuration file from.
+ * @param strCacheFileName Path of the cached configuration file, or an empty string if it cannot be cached.
+ * @param pBody Receives the configuration file as it arrives; returns false once it needs no more of it.
+ * @param bNotModified Output: true if the cached copy is still current, and is to be read instead.
+ * @param nStatusCode Output: receives the HTTP status code of the response, 0 if no response was received.
+ * @param strErrorMessage Output: receives the reason if the download failed.
+ * @return true if the operation succeeded, false otherwise.
+ */
+bool DownloadConfigFile(const std::wstring& strConfigURL, const std::wstring& strCacheFileName, const fnTransportBody& pBody, bool& bNotModified, int& nStatusCode, std::wstring& strErrorMessage)
+{
+	const std::string strURL = wstring_to_utf8(strConfigURL);
+	DOWNLOAD_RECORD pRecord;
+	TRANSPORT_HEADERS arrHeaders;
+	if (!strCacheFileName.empty() && LoadDownloadRecord(strCacheFileName, pRecord) && (pRecord.strURL == strURL))
+	{
+		if (!pRecord.strETag.empty())
+		{
+			arrHeaders.emplace_back("If-None-Match", pRecord.strETag);
+		}
+		if (!pRecord.strLastModified.empty())
+		{
+			arrHeaders.emplace_back("If-Modified-Since", pRecord.strLastModified);
+		}
+	}
+
+	// The new copy is written next to the cached copy first, so a failed download never corrupts it
+	std::filesystem::path strTempFileName{ strCacheFileName };
+	strTempFileName += _T(".tmp");
+	std::ofstream file;
+	bool bStarted = false;
+	bool bCached = false;
+	bool bMore = true;
+	TRANSPORT_RESPONSE pResponse;
+	const bool bDownloaded = GetTransport()->Get({ strURL, arrHeaders }, [&](const uint8_t* pData, size_t nLength)
+	{
+		if (!bStarted)
+		{
+			bStarted = true;
+			if (!strCacheFileName.empty() && ((FindTransportHeader(pResponse.arrHeaders, "ETag") != nullptr) || (FindTransportHeader(pResponse.arrHeaders, "Last-Modified") != nullptr)))
+			{
+				file.open(strTempFileName, std::ios::binary | std::ios::trunc);
+				bCached = file.is_open();
+			}
+		}
+		if (bCached && !file.write(reinterpret_cast<const char*>(pData), nLength))
+		{
+			bCached = false; // The download itself goes on, it's just not cached
+		}
+		bMore = bMore && pBody(pData, nLength);
+		return bCached || bMore;
+	}, nullptr, pResponse);
+	file.close();
+
+	std::error_code errorCode;
+	if (bDownloaded && !strCacheFileName.empty())
+	{
+		// The cached copy is replaced by the new one, or dropped if the new one isn't cached
+		RemoveDownloadRecord(strCacheFileName);
+		if (bCached && file)
+		{
+			pRecord = DOWNLOAD_RECORD();
+			pRecord.strURL = strURL;
+			SetDownloadRecordResponse(pRecord, pResponse, 0);
+			pRecord.nBytesDone = std::filesystem::file_size(strTempFileName, errorCode);
+			if (!errorCode)
+			{
+				std::filesystem::rename(strTempFileName, strCacheFileName, errorCode);
+			}
+			if (errorCode || !SaveDownloadRecord(strCacheFileName, pRecord))
+			{
+				RemoveDownloadRecord(strCacheFileName);
+			}
+		}
+	}
+	if (!strCacheFileName.empty())
+	{
+		std::filesystem::remove(strTempFileName, errorCode);
+	}
+
+	nStatusCode = pResponse.nStatusCode;
+	bNotModified = !bDownloaded && !arrHeaders.empty() && (pResponse.nStatusCode == 304);
+	if (!bDownloaded && !bNotModified && !(!bMore && (pResponse.nStatusCode >= 200) && (pResponse.nStatusCode < 300)))
+	{
+		// The download failed, and not because the consumer stopped it
+		strErrorMessage = GetTransportErrorMessage(pResponse);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Reads the entries of a product from a configuration file, downloading it unless the cached copy is still
+ *        current, with a streaming reader which keeps only the product's section and stops at its end.
+ * @param strConfigURL The URL to download the configuration file from.
+ * @param strProductName The product name to look up in the XML.
+ * @param arrEntries Output: receives the product's entries, or nothing if the product is missing.
+ * @param strErrorMessage Output: receives the reason if the download or the configuration file failed.
+ * @return true if the operation succeeded, false otherwise.
+ */
+bool ReadManifestEntries(const std::wstring& strConfigURL, const std::wstring& strProductName, std::vector<MANIFEST_ENTRY>& arrEntries, std::wstring& strErrorMessage)
+{
+	const std::wstring strCacheFileName{ GetConfigCacheFilePath(strConfigURL, _T(".xml")) };
+	CManifestReader pManifestReader(wstring_to_utf8(strProductName));
+	bool bNotModified = false;
+	int nStatusCode = 0;
+	if (!DownloadConfigFile(strConfigURL, strCacheFileName, [&pManifestReader](const uint8_t* pData, size_t nLength) { return pManifestReader.Feed(pData, nLength); }, bNotModified, nStatusCode, strErrorMessage))
+	{
+		return false;
+	}
+
+	if (bNotModified)
+	{
+		// Not modified: read the cached copy
+		std::ifstream cache(strCacheFileName, std::ios::binary);
+		std::vector<char> buffer(MAX_BUFFER);
+		while (cache && !pManifestReader.IsDone())
+		{
+			cache.read(buffer.data(), buffer.size());
+			pManifestReader.Feed(reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(cache.gcount()));
+		}
+	}
+	if (!pManifestReader.Finish())
+	{
+		strErrorMessage = utf8_to_wstring(pManifestReader.GetError());
+		if (bNotModified)
+		{
+			RemoveDownloadRecord(strCacheFileName); // A broken cached copy is downloaded again the next time
+		}
+		return false;
+	}
+	arrEntries = pManifestReader.GetEntries();
+	return true;
+}
+
+/**
+ * @brief Constructs the URL of the binary manifest published next to a configuration file:
+ *        the .xml extension of the file is replaced by BINARY_MANIFEST_EXTENSION, or the extension is added.
+ * @param strConfigURL The URL of the configuration file.
+ * @return The URL of the binary manifest.
+ */
+const std::wstring GetBinaryManifestURL(const std::wstring& strConfigURL)
+{
+	const size_t nPathLength = (std::min)(strConfigURL.find_first_of(L"?#"), strConfigURL.length());
+	std::wstring strPath = strConfigURL.substr(0, nPathLength);
+	const size_t nDot = strPath.rfind(L'.');
+	if ((nDot != std::wstring::npos) && (strPath.find(L'/', nDot) == std::wstring::npos) && (_wcsicmp(strPath.c_str() + nDot, L".xml") == 0))
+	{
+		strPath.erase(nDot);
+	}
+	return strPath + BINARY_MANIFEST_EXTENSION + strConfigURL.substr(nPathLength);
+}
+
+/**
+ * @brief Reads the entries of a product from the binary manifest published next to a configuration file, if the
+ *        Web Server has one. It is downloaded unless the cached copy is still current, which is then mapped into
+ *        memory, and the product is found by a binary search, without parsing the rest of the manifest.
+ *        A Web Server which has no binary manifest is not asked again for BINARY_MANIFEST_RETRY_INTERVAL seconds,
+ *        so the configuration files published without one don't cost an extra request on every check.
+ * @param strConfigURL The URL of the configuration file.
+ * @param strProductName The product name to look up.
+ * @param arrEntries Output: receives the product's entries.
+ * @return true if the product was found, false if there is no binary manifest, it is not valid or it hasn't the product.
+ */
+bool ReadBinaryManifestEntries(const std::wstring& strConfigURL, const std::wstring& strProductName, std::vector<MANIFEST_ENTRY>& arrEntries)
+{
+	const std::wstring strManifestURL{ GetBinaryManifestURL(strConfigURL) };
+	const std::wstring strCacheFileName{ GetConfigCacheFilePath(strManifestURL, BINARY_MANIFEST_EXTENSION) };
+	const std::string strUTF8URL = wstring_to_utf8(strManifestURL);
+	const unsigned long long nNow = static_cast<unsigned long long>(std::time(nullptr));
+	if (!strCacheFileName.empty() && IsBinaryManifestMissing(strCacheFileName, strUTF8URL, nNow))
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> arrManifest;
+	bool bNotModified = false;
+	int nStatusCode = 0;
+	std::wstring strErrorMessage;
+	if (!DownloadConfigFile(strManifestURL, strCacheFileName, [&arrManifest](const uint8_t* pData, size_t nLength)
+	{
+		// Anything larger than a catalog can be is not a binary manifest
+		if (arrManifest.size() + nLength > BINARY_MANIFEST_MAX_SIZE)
+		{
+			arrManifest.clear();
+			return false;
+		}
+		arrManifest.insert(arrManifest.end(), pData, pData + nLength);
+		return true;
+	}, bNotModified, nStatusCode, strErrorMessage))
+	{
+		// Only the Web Server's answer that it has no such file is remembered, not a failed connection or a busy server
+		if (!strCacheFileName.empty() && (nStatusCode >= 400) && (nStatusCode < 500) && (nStatusCode != 408) && (nStatusCode != 429))
+		{
+			SaveMissingBinaryManifest(strCacheFileName, strUTF8URL, nNow + BINARY_MANIFEST_RETRY_INTERVAL);
+		}
+		return false;
+	}
+
+	// A new download is read from memory, the cached copy is mapped
+	CBinaryManifest pManifest;
+	const bool bLoaded = bNotModified ? pManifest.LoadFile(strCacheFileName) : pManifest.Load(std::move(arrManifest));
+	if (!bLoaded && bNotModified)
+	{
+		RemoveDownloadRecord(strCacheFileName); // A broken cached copy is downloaded again the next time
+	}
+	else if (!strCacheFileName.empty())
+	{
+		// Something else than a binary manifest (e.g. an error page) counts as no binary manifest
+		if (bLoaded)
+		{
+			RemoveMissingBinaryManifest(strCacheFileName);
+		}
+		else
+		{
+			SaveMissingBinaryManifest(strCacheFileName, strUTF8URL, nNow + BINARY_MANIFEST_RETRY_INTERVAL);
+		}
+	}
+	return bLoaded && pManifest.FindProduct(wstring_to_utf8(strProductName), arrEntries);
+}
+
+/**
+ * @brief Constructs the full path where the installer of a product is downloaded, in the genUp4win folder.
+ *        The file name only depends on the URL, so an interrupted download is found again after the process
+ *        restarts; the files of other URLs (i.e. of older versions) are removed.
+ * @param strProductName The product name, used as the folder name.
+ * @param strURL The URL of the installer.
+ * @return The full path to the installer, or an empty string if the folder couldn't be created.
+ */
+const std::wstring GetStagingFilePath(const std::wstring& strProductName, const std::wstring& strURL)
+{
+	const std::filesystem::path strFolderPath{ GetLocalDataFolderPath(strProductName) };
+	if (strFolderPath.empty())
+	{
+		return std::wstring();
+	}
+	std::error_code errorCode;
+
+	// Keep the extension of the installer, which decides how it is launched
+	const std::wstring strURLPath = strURL.substr(0, strURL.find_first_of(L"?#"));
+	std::wstring strExtension = std::filesystem::path(strURLPath.substr(strURLPath.rfind(L'/') + 1)).extension().wstring();
+	if ((_wcsicmp(strExtension.c_str(), L".msi") != 0) && (_wcsicmp(strExtension.c_str(), L".exe") != 0))
+	{
+		strExtension = DEFAULT_EXTENSION;
+	}
+	const std::wstring strName = DigestValue(SHA256::hash(wstring_to_utf8(strURL))).toWString().substr(0, 16);
+
+	// Remove the installers, partial downloads and their records of the other URLs
+	for (const auto& pEntry : std::filesystem::directory_iterator(strFolderPath, errorCode))
+	{
+		if (pEntry.path().filename().wstring().compare(0, strName.size(), strName) != 0)
+		{
+			std::filesystem::remove(pEntry.path(), errorCode);
+		}
+	}
+
+	const std::filesystem::path strFileName = strFolderPath / (strName + strExtension);
+	OutputDebugString(strFileName.c_str()); // Log the path for debugging
+	return strFileName.wstring();
+}
+
+/**
+ * @brief Entries of one product section in the configuration XML file.
+ */
+struct CONFIG_ENTRIES
+{
+	std::wstring strLatestVersion;  ///< Version entry.
+	std::wstring strDownloadURL;    ///< Download entry.
+	std::wstring strChecksum;       ///< Checksum entry (of the whole file).
+	std::wstring strChecksumAlgorithm; ///< Optional alg attribute of the Checksum entry, empty for SHA-256.
+	std::wstring strTreeChecksum;   ///< Optional TreeChecksum entry (see GetTreeChecksumFromFile).
+	ULONGLONG nTreeChunkSize = 0;   ///< Optional TreeChunkSize entry, 0 if absent or malformed.
+};
+
+/**
+ * @brief Writes the entries of a product (version, download URL and checksums) to its XML settings file,
+ *        saving the file once at the end, and the binary manifest of the file next to it (see CBinaryManifest).
+ * @param strFilePath Path to the version info file.
+ * @param pVersionInfo The loaded version info of the product.
+ * @param pConfigEntries The download URL and checksums to write; an empty Checksum is skipped, an empty TreeChecksum
+ *        removes the TreeChecksum and TreeChunkSize entries of a previous release.
+ * @param ParentCallback Callback function for status/error reporting.
+ * @return true if the operation succeeded, false otherwise.
+ */
+bool WriteConfigEntries(const std::wstring& strFilePath, const CVersionInfo& pVersionInfo, const CONFIG_ENTRIES& pConfigEntries, fnCallback ParentCallback)
+{
+	bool retVal = false;
+	const std::wstring& strProductName = pVersionInfo.GetProductName();
+	try
+	{
+		// Write version and download URL to XML settings file
+		std::vector<MANIFEST_ENTRY> arrEntries{
+			{ wstring_to_utf8(VERSION_ENTRY_ID), wstring_to_utf8(pVersionInfo.GetProductVersionAsString()), {} },
+			{ wstring_to_utf8(DOWNLOAD_ENTRY_ID), wstring_to_utf8(pConfigEntries.strDownloadURL), {} } };
+		std::vector<std::string> arrRemovedNames;
+
+		// Write the checksums of the installer if available; a SHA-256 Checksum has no alg attribute,
+		// so the one of a previous BLAKE3 or SHA-512 release is dropped
+		if (!pConfigEntries.strChecksum.empty())
+		{
+			MANIFEST_ENTRY pChecksumEntry{ wstring_to_utf8(CHECKSUM_ENTRY_ID), wstring_to_utf8(pConfigEntries.strChecksum), {} };
+			if (!pConfigEntries.strChecksumAlgorithm.empty())
+			{
+				pChecksumEntry.arrAttributes.emplace_back(wstring_to_utf8(CHECKSUM_ALGORITHM_ATTRIBUTE_ID), wstring_to_utf8(pConfigEntries.strChecksumAlgorithm));
+			}
+			arrEntries.push_back(std::move(pChecksumEntry));
+		}
+		if (!pConfigEntries.strTreeChecksum.empty())
+		{
+			arrEntries.push_back({ wstring_to_utf8(TREE_CHECKSUM_ENTRY_ID), wstring_to_utf8(pConfigEntries.strTreeChecksum), {} });
+			arrEntries.push_back({ wstring_to_utf8(TREE_CHUNK_SIZE_ENTRY_ID), std::to_string(pConfigEntries.nTreeChunkSize), {} });
+		}
+		else
+		{
+			// The tree checksum of a previous release would not match this installer
+			arrRemovedNames.push_back(wstring_to_utf8(TREE_CHECKSUM_ENTRY_ID));
+			arrRemovedNames.push_back(wstring_to_utf8(TREE_CHUNK_SIZE_ENTRY_ID));
+		}
+
+		// Save all entries in one go
+		CNativeXMLAppSettings pAppSettings(GetAppSettingsFilePath(strFilePath, strProductName), false, true);
+		if (!WriteManifestEntries(pAppSettings.EditDocument(), wstring_to_utf8(strProductName), arrEntries, arrRemovedNames))
+		{
+			IAppSettings::ThrowWin32AppSettingsException(ERROR_INVALID_NAME);
+		}
+		pAppSettings.Flush();
+
+		// Write the binary manifest of all the products of the file next to it, for the clients which prefer it
+		std::filesystem::path strManifestFileName{ pAppSettings.GetXMLFile() };
+		strManifestFileName.replace_extension(BINARY_MANIFEST_EXTENSION);
+		if (!SaveBinaryManifest(pAppSettings.GetDocument().GetRoot(), strManifestFileName))
+		{
+			ParentCallback(GENUP4WIN_ERROR, _com_error(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT)).ErrorMessage(), 0);
+			return false;
+		}
+		retVal = true;
+	}
+	catch (CAppSettingsException& pException)
+	{
+		// Handle XML settings exceptions
+		const int nErrorLength = 0x100;
+		TCHAR lpszErrorMessage[nErrorLength] = { 0, };
+		pException.GetErrorMessage(lpszErrorMessage, nErrorLength);
+		ParentCallback(GENUP4WIN_ERROR, lpszErrorMessage, 0);
+	}
+	return retVal;
+}
+
+/**
+ * @brief Writes configuration data (version and download URL) to an XML file.
+ *        The installer is downloaded from the URL to calculate its checksum.
+ * @param strFilePath Path to the version info file.
+ * @param strDownloadURL The download URL to write.
+ * @param ParentCallback Callback function for status/error reporting.
+ * @param nTreeChunkSize Chunk size for the optional tree checksum, or 0 to write only the plain checksum.
+ * @param strChecksumAlgorithm The algorithm of the Checksum entry (see GetChecksumAlgorithmName).
+ * @return true if the operation succeeded, false otherwise.
+ */
+bool WriteConfigFile(const std::wstring& strFilePath, const std::wstring& strDownloadURL, fnCallback ParentCallback, const ULONGLONG nTreeChunkSize, const std::wstring& strChecksumAlgorithm)
+{
+	CVersionInfo pVersionInfo;
+	CONFIG_ENTRIES pConfigEntries;
+	DigestValue pChecksum, pTreeChecksum;
+
+	// Load version information from the specified file
+	if (!pVersionInfo.Load(strFilePath.c_str()))
+	{
+		return false;
+	}
+
+	// Calculate the checksum of the download URL if available; the entries stay empty otherwise
+	pConfigEntries.strDownloadURL = strDownloadURL;
+	pConfigEntries.strChecksumAlgorithm = GetChecksumAlgorithmAttribute(strChecksumAlgorithm);
+	pConfigEntries.nTreeChunkSize = nTreeChunkSize;
+	if (GetChecksumFromURL(strDownloadURL, strChecksumAlgorithm, pChecksum, nTreeChunkSize, pTreeChecksum))
+	{
+		pConfigEntries.strChecksum = pChecksum.toWString();
+		pConfigEntries.strTreeChecksum = pTreeChecksum.toWString();
+	}
+	return WriteConfigEntries(strFilePath, pVersionInfo, pConfigEntries, ParentCallback);
+}
+
+/**
+ * @brief Writes configuration data (version, download URL and checksum) to an XML file,
+ *        calculating the checksum from the local copy of the installer instead of downloading it.
+ * @param strFilePath Path to the version info file.
+ * @param strDownloadURL The download URL to write.
+ * @param strInstallerPath Path to the local installer that is published at strDownloadURL.
+ * @param ParentCallback Callback function for status/error reporting.
+ * @param nTreeChunkSize Chunk size for the optional tree checksum, or 0 to write only the plain checksum.
+ * @param strChecksumAlgorithm The algorithm of the Checksum entry (see GetChecksumAlgorithmName).
+ * @return true if the operation succeeded, false otherwise.
+ */
+bool WriteConfigFile(const std::wstring& strFilePath, const std::wstring& strDownloadURL, const std::wstring& strInstallerPath, fnCallback ParentCallback, const ULONGLONG nTreeChunkSize, const std::wstring& strChecksumAlgorithm)
+{
+	CString strStatusMessage;
+	CVersionInfo pVersionInfo;
+	CONFIG_ENTRIES pConfigEntries;
+	DigestValue pChecksum, pTreeChecksum;
+
+	// Load version information from the specified file
+	if (!pVersionInfo.Load(strFilePath.c_str()))
+	{
+		return false;
+	}
+
+	// Hash the local installer; it is the same file that was uploaded to strDownloadURL.
+	// An installer that hasn't changed since the last run is not hashed again.
+	CChecksumCache pChecksumCache(GetChecksumCacheFilePath(strFilePath, pVersionInfo.GetProductName()));
+	pConfigEntries.strDownloadURL = strDownloadURL;
+	pConfigEntries.strChecksumAlgorithm = GetChecksumAlgorithmAttribute(strChecksumAlgorithm);
+	pConfigEntries.nTreeChunkSize = nTreeChunkSize;
+	if (!GetChecksumFromFile(strInstallerPath, strChecksumAlgorithm, pChecksum, pChecksumCache) ||
+		((nTreeChunkSize > 0) && !GetTreeChecksumFromFile(strInstallerPath, nTreeChunkSize, pTreeChecksum, pChecksumCache)))
+	{
+		// Failed to calculate checksum - report error
+		if (strStatusMessage.LoadString(IDS_CHECKSUM_CALCULATION_FAILED))
+		{
+			ParentCallback(GENUP4WIN_ERROR, std::wstring(strStatusMessage), 0);
+		}
+		return false;
+	}
+	pConfigEntries.strChecksum = pChecksum.toWString();
+	pConfigEntries.strTreeChecksum = pTreeChecksum.toWString();
+	return WriteConfigEntries(strFilePath, pVersionInfo, pConfigEntries, ParentCallback);
+}
+
+/**
+ * @brief Downloads a configuration XML file from a URL, parses it for the entries of a product,
+ *        and reports status via callback.
+ * @param strConfigURL The URL to download the configuration file from.
+ * @param strProductName The product name to look up in the XML.
+ * @param pConfigEntries Output: receives the product's entries.
+ * @param ParentCallback Callback function for status/error reporting.
+ * @return true if the operation succeeded, false otherwise.
+ */
+bool ReadConfigEntries(const std::wstring& strConfigURL, const std::wstring& strProductName, CONFIG_ENTRIES& pConfigEntries, fnCallback ParentCallback)
+{
+	CString strStatusMessage;
+	bool retVal = false;
+
+	// Report connection status to the user
+	if (strStatusMessage.LoadString(IDS_CONNECTING))
+	{
+		ParentCallback(GENUP4WIN_INPROGRESS, std::wstring(strStatusMessage), 0);
+	}
+
+	// Look the product up in the binary manifest if the Web Server has one; otherwise download the configuration file
+	// from the URL, unless the cached copy is still current, and read the product's entries as it arrives
+	std::vector<MANIFEST_ENTRY> arrEntries;
+	std::wstring strErrorMessage;
+	if (ReadBinaryManifestEntries(strConfigURL, strProductName, arrEntries) || ReadManifestEntries(strConfigURL, strProductName, arrEntries, strErrorMessage))
+	{
+		const MANIFEST_ENTRY* pVersionEntry = FindManifestEntry(arrEntries, wstring_to_utf8(VERSION_ENTRY_ID));
+		const MANIFEST_ENTRY* pDownloadEntry = FindManifestEntry(arrEntries, wstring_to_utf8(DOWNLOAD_ENTRY_ID));
+		const MANIFEST_ENTRY* pChecksumEntry = FindManifestEntry(arrEntries, wstring_to_utf8(CHECKSUM_ENTRY_ID));
+		if ((pVersionEntry != nullptr) && (pDownloadEntry != nullptr) && (pChecksumEntry != nullptr))
+		{
+			pConfigEntries.strLatestVersion = utf8_to_wstring(pVersionEntry->strValue);
+			pConfigEntries.strDownloadURL = utf8_to_wstring(pDownloadEntry->strValue);
+			pConfigEntries.strChecksum = utf8_to_wstring(pChecksumEntry->strValue);
+
+			// Older configuration files don't name the algorithm of the checksum, which is then SHA-256
+			pConfigEntries.strChecksumAlgorithm = utf8_to_wstring(GetManifestEntryAttribute(pChecksumEntry, wstring_to_utf8(CHECKSUM_ALGORITHM_ATTRIBUTE_ID)));
+
+			// The tree checksum is optional, older configuration files don't have it
+			const MANIFEST_ENTRY* pTreeChecksumEntry = FindManifestEntry(arrEntries, wstring_to_utf8(TREE_CHECKSUM_ENTRY_ID));
+			const MANIFEST_ENTRY* pTreeChunkSizeEntry = FindManifestEntry(arrEntries, wstring_to_utf8(TREE_CHUNK_SIZE_ENTRY_ID));
+			pConfigEntries.strTreeChecksum = (pTreeChecksumEntry != nullptr) ? utf8_to_wstring(pTreeChecksumEntry->strValue) : std::wstring();
+			// A missing or malformed chunk size is left 0, and then fails the verification of a published TreeChecksum
+			if ((pTreeChunkSizeEntry == nullptr) || !ParseTransportNumber(pTreeChunkSizeEntry->strValue, 10, pConfigEntries.nTreeChunkSize))
+			{
+				pConfigEntries.nTreeChunkSize = 0;
+			}
+			retVal = true;
+		}
+		else
+		{
+			// Report that the product (or one of its entries) is missing from the configuration file
+			ParentCallback(GENUP4WIN_ERROR, _com_error(HRESULT_FROM_WIN32(ERROR_NOT_FOUND)).ErrorMessage(), 0);
+		}
+	}
+	else
+	{
+		// Report download failure
+		ParentCallback(GENUP4WIN_ERROR, strErrorMessage, 0);
+	}
+	return retVal;
+}
+
+/**
+ * @brief Downloads a configuration XML file from a URL, parses it for the latest version and download URL,
+ *        and reports status via callback.
+ * @param strConfigURL The URL to download the configuration file from.
+ * @param strProductName The product name to look up in the XML.
+ * @param strLatestVersion Output: receives the latest version string.
+ * @param strDownloadURL Output: receives the download URL.
+ * @param strChecksum Output: receives the checksum string.
+ * @param ParentCallback Callback function for status/error reporting.
+ * @return true if the operation succeeded, false otherwise.
+ */
+bool ReadConfigFile(const std::wstring& strConfigURL, const std::wstring& strProductName, std::wstring& strLatestVersion, std::wstring& strDownloadURL, std::wstring& strChecksum, fnCallback ParentCallback)
+{
+	CONFIG_ENTRIES pConfigEntries;
+	if (ReadConfigEntries(strConfigURL, strProductName, pConfigEntries, ParentCallback))
+	{
+		strLatestVersion = pConfigEntries.strLatestVersion;
+		strDownloadURL = pConfigEntries.strDownloadURL;
+		strChecksum = pConfigEntries.strChecksum;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Checks for software updates by comparing the current version with the latest version from a configuration URL.
+ *        If a new version is found, downloads and launches the update, reporting status via callback.
+ * @param strFilePath Path to the local version info file.
+ * @param strConfigURL URL to the remote configuration XML.
+ * @param ParentCallback Callback function for status/error reporting.
+ * @return true if an update was found and download was successful, false otherwise.
+ */
+bool CheckForUpdates(const std::wstring& strFilePath, const std::wstring& strConfigURL, fnCallback ParentCallback)
+{
+	CString strStatusMessage;
+	bool retVal = false;
+	CVersionInfo pVersionInfo;
+	CONFIG_ENTRIES pConfigEntries;
+
+	// Load the current application's version information
+	if (pVersionInfo.Load(strFilePath.c_str()))
 	{
 		const std::wstring& strProductName = pVersionInfo.GetProductName();
 		OutputDebugString(strProductName.c_str()); // Log product name for debugging
 
 		// Download and parse the remote configuration file
-		if (ReadConfigFile(strConfigURL, strProductName, strLatestVersion, strDownloadURL, strChecksum, ParentCallback))
+		if (ReadConfigEntries(strConfigURL, strProductName, pConfigEntries, ParentCallback))
 		{
 			// Compare current version with the latest version from the server
-			const bool bNewUpdateFound = (strLatestVersion.compare(pVersionInfo.GetProductVersionAsString()) != 0);
+			const bool bNewUpdateFound = (pConfigEntries.strLatestVersion.compare(pVersionInfo.GetProductVersionAsString()) != 0);
 			if (bNewUpdateFound)
 			{
-				TCHAR lpszTempPath[_MAX_PATH + 1] = { 0, };
+				// A checksum in an algorithm this version doesn't know cannot be verified
+				if (GetChecksumAlgorithmName(wstring_to_utf8(pConfigEntries.strChecksumAlgorithm)) == nullptr)
+				{
+					if (strStatusMessage.LoadString(IDS_CHECKSUM_CALCULATION_FAILED))
+					{
+						ParentCallback(GENUP4WIN_ERROR, std::wstring(strStatusMessage), 0);
+					}
+					return false;
+				}
 
-				// Get the system's temporary directory path
-				DWORD nLength = GetTempPath(_MAX_PATH, lpszTempPath);
-				if (nLength > 0)
+				// Download into the same file for the same URL, so an interrupted download continues where it stopped
+				const CString strFileName = GetStagingFilePath(strProductName, pConfigEntries.strDownloadURL).c_str();
+				if (!strFileName.IsEmpty())
 				{
-					TCHAR lpszFilePath[_MAX_PATH + 1] = { 0, };
 
-					// Generate a unique temporary file name
-					nLength = GetTempFileName(lpszTempPath, L"GUP", 0, lpszFilePath);
-					if (nLength > 0)
+					// Report initial download status to the user (0% progress)
+					CString strDownloading;
+					const bool bDownloading = strDownloading.LoadString(IDS_DOWNLOADING);
+					if (bDownloading)
 					{
-						// Change the extension from .tmp to the default installer extension
-						CString strFileName = lpszFilePath;
-						strFileName.Replace(_T(".tmp"), DEFAULT_EXTENSION);
+						ParentCallback(GENUP4WIN_INPROGRESS, std::wstring(strDownloading), 0);
+					}
 
-						// Report initial download status to the user (0% progress)
-						if (strStatusMessage.LoadString(IDS_DOWNLOADING))
+					// Report the percentage downloaded while the installer is being streamed, each time it changes
+					int nLastPercentage = 0;
+					const fnTransportProgress pProgress = [&](unsigned long long nReceived, unsigned long long nTotal)
+					{
+						if (bDownloading && (nTotal != TRANSPORT_UNKNOWN_LENGTH) && (nTotal > 0))
 						{
-							ParentCallback(GENUP4WIN_INPROGRESS, std::wstring(strStatusMessage), 0);
+							const int nPercentage = static_cast<int>((std::min)(nReceived, nTotal) * 100 / nTotal);
+							if (nPercentage != nLastPercentage)
+							{
+								nLastPercentage = nPercentage;
+								ParentCallback(GENUP4WIN_INPROGRESS, std::wstring(strDownloading), nPercentage);
+							}
 						}
+					};
 
-						// Create progress callback handler and download the update installer
-						// CDownloadCallback will receive progress notifications from URLDownloadToFile
-						CDownloadCallback pCallback(ParentCallback);
-						if ((hResult = URLDownloadToFile(nullptr, strDownloadURL.c_str(), strFileName, 0, &pCallback)) == S_OK)
+					// Download the update installer
+					DigestValue pDownloadedFileChecksum; // Calculated as the bytes arrive
+					std::wstring strErrorMessage;
+					if (DownloadFileWithChecksum(pConfigEntries.strDownloadURL, strFileName.GetString(), pConfigEntries.strChecksumAlgorithm, pDownloadedFileChecksum, pProgress, strErrorMessage))
+					{
+						// The plain checksum was calculated as the bytes arrived; a tree checksum, if one is published
+						// as well, is verified too, with another pass over the file. A malformed checksum never matches,
+						// and the raw bytes are compared, so either case of hexadecimal digits is accepted.
+						const auto IsExpectedChecksum = [](const std::wstring& strExpected, const DigestValue& pCalculated)
+						{
+							DigestValue pChecksum;
+							return pChecksum.parse(strExpected) && (pChecksum == pCalculated);
+						};
+						bool bChecksumCalculated = true;
+						bool bChecksumMatched = pConfigEntries.strChecksum.empty() || IsExpectedChecksum(pConfigEntries.strChecksum, pDownloadedFileChecksum);
+						// GetTreeChecksumFromFile refuses a chunk size below MIN_TREE_CHUNK_SIZE, so an invalid one fails the update
+						if (bChecksumMatched && !pConfigEntries.strTreeChecksum.empty())
 						{
-							// Verify the downloaded file's checksum if available
-							if (!strChecksum.empty())
+							DigestValue pDownloadedFileTreeChecksum;
+							bChecksumCalculated = GetTreeChecksumFromFile(strFileName.GetString(), pConfigEntries.nTreeChunkSize, pDownloadedFileTreeChecksum);
+							bChecksumMatched = bChecksumCalculated && IsExpectedChecksum(pConfigEntries.strTreeChecksum, pDownloadedFileTreeChecksum);
+						}
+						if (!bChecksumCalculated)
+						{
+							// Failed to calculate checksum - report error
+							if (strStatusMessage.LoadString(IDS_CHECKSUM_CALCULATION_FAILED))
 							{
-								std::wstring strDownloadedFileChecksum;
-
-								// Calculate the checksum of the downloaded file
-								if (GetChecksumFromFile(strFileName.GetString(), strDownloadedFileChecksum))
-								{
-									// Compare with the expected checksum
-									if (strDownloadedFileChecksum.compare(strChecksum) != 0)
-									{
-										// Checksum mismatch - report error
-										if (strStatusMessage.LoadString(IDS_CHECKSUM_MISMATCH))
-										{
-											ParentCallback(GENUP4WIN_ERROR, std::wstring(strStatusMessage), 0);
-										}
-										::MessageBeep(MB_ICONERROR); // Alert the user with a beep
-										return false; // Checksum mismatch, do not proceed with the update
-									}
-								}
-								else
-								{
-									// Failed to calculate checksum - report error
-									if (strStatusMessage.LoadString(IDS_CHECKSUM_CALCULATION_FAILED))
-									{
-										ParentCallback(GENUP4WIN_ERROR, std::wstring(strStatusMessage), 0);
-									}
-									return false; // Failed to calculate checksum, do not proceed with the update
-								}
+								ParentCallback(GENUP4WIN_ERROR, std::wstring(strStatusMessage), 0);
 							}
-							::MessageBeep(MB_OK); // Alert the user with a beep that the download is complete
-
-							// Launch the downloaded update installer
-							SHELLEXECUTEINFO pShellExecuteInfo;
-							pShellExecuteInfo.cbSize = sizeof(SHELLEXECUTEINFO);
-							pShellExecuteInfo.fMask = SEE_MASK_FLAG_DDEWAIT | SEE_MASK_NOCLOSEPROCESS | SEE_MASK_DOENVSUBST;
-							pShellExecuteInfo.hwnd = nullptr;
-							pShellExecuteInfo.lpVerb = _T("open");
-							pShellExecuteInfo.lpFile = strFileName;
-							pShellExecuteInfo.lpParameters = nullptr;
-							pShellExecuteInfo.lpDirectory = nullptr;
-							pShellExecuteInfo.nShow = SW_SHOWNORMAL;
-
-							// Execute the installer
-							const bool bLauched = ShellExecuteEx(&pShellExecuteInfo);
-
-							// Report success or failure status
-							if (strStatusMessage.LoadString(bLauched ? IDS_SUCCESS : IDS_FAILED))
+							return false; // Failed to calculate checksum, do not proceed with the update
+						}
+						if (!bChecksumMatched)
+						{
+							// Checksum mismatch - report error
+							if (strStatusMessage.LoadString(IDS_CHECKSUM_MISMATCH))
 							{
-								ParentCallback(GENUP4WIN_INPROGRESS, std::wstring(strStatusMessage), 0);
+								ParentCallback(GENUP4WIN_ERROR, std::wstring(strStatusMessage), 0);
 							}
-							retVal = true; // Download was successful
+							::MessageBeep(MB_ICONERROR); // Alert the user with a beep
+							return false; // Checksum mismatch, do not proceed with the update
 						}
-						else
+						::MessageBeep(MB_OK); // Alert the user with a beep that the download is complete
+
+						// Launch the downloaded update installer
+						SHELLEXECUTEINFO pShellExecuteInfo;
+						pShellExecuteInfo.cbSize = sizeof(SHELLEXECUTEINFO);
+						pShellExecuteInfo.fMask = SEE_MASK_FLAG_DDEWAIT | SEE_MASK_NOCLOSEPROCESS | SEE_MASK_DOENVSUBST;
+						pShellExecuteInfo.hwnd = nullptr;
+						pShellExecuteInfo.lpVerb = _T("open");
+						pShellExecuteInfo.lpFile = strFileName;
+						pShellExecuteInfo.lpParameters = nullptr;
+						pShellExecuteInfo.lpDirectory = nullptr;
+						pShellExecuteInfo.nShow = SW_SHOWNORMAL;
+
+						// Execute the installer
+						const bool bLauched = ShellExecuteEx(&pShellExecuteInfo);
+
+						// Report success or failure status
+						if (strStatusMessage.LoadString(bLauched ? IDS_SUCCESS : IDS_FAILED))
 						{
-							// Report download failure
-							_com_error pError(hResult);
-							LPCTSTR lpszErrorMessage = pError.ErrorMessage();
-							ParentCallback(GENUP4WIN_ERROR, lpszErrorMessage, 0);
+							ParentCallback(GENUP4WIN_INPROGRESS, std::wstring(strStatusMessage), 0);
 						}
+						retVal = true; // Download was successful
+					}
+					else
+					{
+						// Report download failure
+						ParentCallback(GENUP4WIN_ERROR, strErrorMessage, 0);
 					}
 				}
 			}
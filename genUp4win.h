@@ -24,6 +24,7 @@ SOFTWARE. */
 #ifdef __cplusplus
 
 #include <string>
+#include <vector>
 #include <functional>
 
 #ifdef GENUP4WIN_EXPORTS
@@ -32,6 +33,28 @@ SOFTWARE. */
 #define GENUP4WIN __declspec(dllimport)
 #endif
 
+/**
+ * @brief Names of the supported checksum algorithms, for WriteConfigFile and the alg attribute of the Checksum entry.
+ *        BLAKE3 is the fastest, as it hashes large files in SIMD lanes on all cores.
+ */
+#define CHECKSUM_ALGORITHM_SHA256 L"SHA-256"
+#define CHECKSUM_ALGORITHM_SHA512 L"SHA-512"
+#define CHECKSUM_ALGORITHM_SHA512_256 L"SHA-512/256"
+#define CHECKSUM_ALGORITHM_BLAKE3 L"BLAKE3"
+
+/**
+ * @brief Names of the transports that download the configuration file and the installer, for SetTransport.
+ *        urlmon (the default) supports https and the proxy settings of the system; HTTP/1.1 is the portable
+ *        client of genUp4win, for http:// URLs only.
+ */
+#define TRANSPORT_URLMON L"urlmon"
+#define TRANSPORT_HTTP L"HTTP/1.1"
+
+/**
+ * @brief Smallest chunk size of a tree checksum (64 KiB); smaller chunks only add digests to combine.
+ */
+#define MIN_TREE_CHUNK_SIZE 0x10000ULL
+
 /**
  * @brief Status codes used for reporting the state of operations.
  */
@@ -65,14 +88,39 @@ typedef std::function<void(int, const std::wstring& strMessage, const int& nProg
  */
 GENUP4WIN const std::wstring GetAppSettingsFilePath(const std::wstring& strFilePath, const std::wstring& strProductName);
 
+/**
+ * @brief Calculates the SHA256 checksums of several files at once, hashing them in parallel SIMD lanes.
+ * @param arrFilePaths Paths of the files to calculate checksums for (e.g. all the artifacts of a release).
+ * @param arrChecksums Output: receives one hexadecimal checksum per file, in the same order.
+ * @return true if every checksum was calculated successfully, false if any file couldn't be read.
+ */
+GENUP4WIN bool GetChecksumsFromFiles(const std::vector<std::wstring>& arrFilePaths, std::vector<std::wstring>& arrChecksums);
+
 /**
  * @brief Writes configuration data (version and download URL) to an XML file.
  * @param strFilePath Path to the version info file.
  * @param strDownloadURL The download URL to write.
  * @param callback Optional callback function for status/error reporting (default: StatusCallback).
+ * @param nTreeChunkSize Optional chunk size in bytes, at least MIN_TREE_CHUNK_SIZE; when not 0, a TreeChecksum entry is also written,
+ *        which CheckForUpdates verifies on all cores after the Checksum, reading the downloaded installer once more.
+ * @param strChecksumAlgorithm Optional algorithm of the Checksum entry (default: SHA-256);
+ *        any other algorithm is named in the alg attribute of the entry.
+ * @return true if the operation succeeded, false otherwise.
+ */
+GENUP4WIN bool WriteConfigFile(const std::wstring& strFilePath, const std::wstring& strDownloadURL, fnCallback callback = StatusCallback, const unsigned long long nTreeChunkSize = 0, const std::wstring& strChecksumAlgorithm = CHECKSUM_ALGORITHM_SHA256);
+
+/**
+ * @brief Writes configuration data (version, download URL and checksum) to an XML file, calculating
+ *        the checksum from the local copy of the installer instead of downloading it from strDownloadURL.
+ * @param strFilePath Path to the version info file.
+ * @param strDownloadURL The download URL to write.
+ * @param strInstallerPath Path to the local installer that is published at strDownloadURL.
+ * @param callback Optional callback function for status/error reporting (default: StatusCallback).
+ * @param nTreeChunkSize Optional chunk size in bytes, at least MIN_TREE_CHUNK_SIZE, for an additional TreeChecksum entry (0 to skip it).
+ * @param strChecksumAlgorithm Optional algorithm of the Checksum entry (default: SHA-256).
  * @return true if the operation succeeded, false otherwise.
  */
-GENUP4WIN bool WriteConfigFile(const std::wstring& strFilePath, const std::wstring& strDownloadURL, fnCallback callback = StatusCallback);
+GENUP4WIN bool WriteConfigFile(const std::wstring& strFilePath, const std::wstring& strDownloadURL, const std::wstring& strInstallerPath, fnCallback callback = StatusCallback, const unsigned long long nTreeChunkSize = 0, const std::wstring& strChecksumAlgorithm = CHECKSUM_ALGORITHM_SHA256);
 
 /**
  * @brief Downloads a configuration XML file from a URL, parses it for the latest version and download URL,
@@ -85,6 +133,36 @@ GENUP4WIN bool WriteConfigFile(const std::wstring& strFilePath, const std::wstri
  * @return true if the operation succeeded, false otherwise.
  */
 GENUP4WIN bool ReadConfigFile(const std::wstring& strConfigURL, const std::wstring& strProductName, std::wstring& strLatestVersion, std::wstring& strDownloadURL, std::wstring& strChecksum, fnCallback ParentCallback);
+
+/**
+ * @brief Selects the transport that downloads the configuration file and the installer.
+ * @param strName TRANSPORT_URLMON (the default) or TRANSPORT_HTTP.
+ * @return true if the transport was selected, false if the name is not known.
+ */
+GENUP4WIN bool SetTransport(const std::wstring& strName);
+
+/**
+ * @brief Returns the counters of the connection pool of the HTTP/1.1 transport, which keeps connections
+ *        open between the download of the configuration file and of the installer.
+ * @param nHits Output: receives the number of requests sent on a kept-alive connection.
+ * @param nMisses Output: receives the number of requests that opened a new connection.
+ */
+GENUP4WIN void GetConnectionPoolStatistics(unsigned long long& nHits, unsigned long long& nMisses);
+
+/**
+ * @brief Sets how long the HTTP/1.1 transport keeps an idle connection open (default: 30 seconds).
+ * @param nIdleTimeout The idle timeout in milliseconds; 0 closes every connection after its response.
+ */
+GENUP4WIN void SetConnectionPoolIdleTimeout(unsigned int nIdleTimeout);
+
+/**
+ * @brief Sets how many connections download the installer at once (default: 1 connection, so a single stream; ranges of at least 4 MiB).
+ *        Servers that don't support byte ranges are downloaded over a single connection.
+ * @param nSegmentCount The most connections; 1 downloads the installer as a single stream.
+ * @param nMinSegmentSize The smallest range in bytes fetched by one connection.
+ */
+GENUP4WIN void SetSegmentedDownload(unsigned int nSegmentCount, unsigned long long nMinSegmentSize);
+
 /**
  * @brief Checks for software updates by comparing the current version with the latest version from a configuration URL.
  *        If a new version is found, downloads and launches the update, reporting status via callback.
@@ -49,6 +49,8 @@ SOFTWARE. */
 #include <algorithm>
 #include <cctype>
 #include <filesystem>
+#include <thread>
+#include <atomic>
 
 #include <shlobj.h>
 #include <atlstr.h>
@@ -56,6 +58,10 @@ SOFTWARE. */
 #define VERSION_ENTRY_ID _T("Version")
 #define DOWNLOAD_ENTRY_ID _T("Download")
 #define CHECKSUM_ENTRY_ID _T("Checksum")
+#define CHECKSUM_ALGORITHM_ATTRIBUTE_ID _T("alg")
+#define TREE_CHECKSUM_ENTRY_ID _T("TreeChecksum")
+#define TREE_CHUNK_SIZE_ENTRY_ID _T("TreeChunkSize")
 #define DEFAULT_EXTENSION _T(".msi")
+#define BINARY_MANIFEST_EXTENSION _T(".manifest")
 
 #endif //PCH_H